@@ -4,4 +4,5 @@ QTC_LIB_DEPENDS += \
     utils
 QTC_PLUGIN_DEPENDS += \
     coreplugin \
+    texteditor \
     projectexplorer
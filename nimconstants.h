@@ -42,6 +42,19 @@ const char C_NIMPROJECT_EXCLUDEDFILES[] = "Rust.RustProjectExcludedFiles";
 
 // RustBuildConfiguration
 const char C_NIMBUILDCONFIGURATION_ID[] = "Rust.RustBuildConfiguration";
+const QString C_NIMBUILDCONFIGURATION_CRATEMEMORYPEAKS = QStringLiteral("Rust.RustBuildConfiguration.CrateMemoryPeaks");
+const QString C_NIMBUILDCONFIGURATION_RESOURCELIMITS = QStringLiteral("Rust.RustBuildConfiguration.ResourceLimits");
+const QString C_NIMBUILDCONFIGURATION_SHAREDARTIFACTCACHE = QStringLiteral("Rust.RustBuildConfiguration.SharedArtifactCache");
+const QString C_NIMBUILDCONFIGURATION_BRANCHSNAPSHOTS = QStringLiteral("Rust.RustBuildConfiguration.BranchSnapshots");
+const QString C_NIMBUILDCONFIGURATION_RAMTARGETDIRECTORY = QStringLiteral("Rust.RustBuildConfiguration.RamTargetDirectory");
+const QString C_NIMBUILDCONFIGURATION_RAMTARGETDIRECTORYLIMIT = QStringLiteral("Rust.RustBuildConfiguration.RamTargetDirectoryLimit");
+const QString C_NIMBUILDCONFIGURATION_PROFILEVARIANTS = QStringLiteral("Rust.RustBuildConfiguration.ProfileVariants");
+const QString C_NIMBUILDCONFIGURATION_PROFILEVARIANTWORKLOAD = QStringLiteral("Rust.RustBuildConfiguration.ProfileVariantWorkload");
+const QString C_NIMBUILDCONFIGURATION_RELEASEDEBUGINFO = QStringLiteral("Rust.RustBuildConfiguration.ReleaseDebugInfo");
+const QString C_NIMBUILDCONFIGURATION_LINKER = QStringLiteral("Rust.RustBuildConfiguration.Linker");
+const QString C_NIMBUILDCONFIGURATION_MEASURELINKTIME = QStringLiteral("Rust.RustBuildConfiguration.MeasureLinkTime");
+const QString C_NIMBUILDCONFIGURATION_LINKTIMES = QStringLiteral("Rust.RustBuildConfiguration.LinkTimes");
+const QString C_NIMBUILDCONFIGURATION_SWITCHREBUILDSECONDS = QStringLiteral("Rust.RustBuildConfiguration.SwitchRebuildSeconds");
 
 // RustCompilerBuildStep
 const char C_NIMCOMPILERBUILDSTEP_ID[] = "Rust.RustCompilerBuildStep";
@@ -49,6 +62,12 @@ const char C_NIMCOMPILERBUILDSTEP_DISPLAY[] = QT_TRANSLATE_NOOP("RustCompilerBui
 const QString C_NIMCOMPILERBUILDSTEP_USERCOMPILEROPTIONS = QStringLiteral("Rust.RustCompilerBuildStep.UserCompilerOptions");
 const QString C_NIMCOMPILERBUILDSTEP_BUILDTYPE = QStringLiteral("Rust.RustCompilerBuildStep.BuildType");
 const QString C_NIMCOMPILERBUILDSTEP_TARGETNIMFILE = QStringLiteral("Rust.RustCompilerBuildStep.TargetRustFile");
+const QString C_NIMCOMPILERBUILDSTEP_ADAPTIVEJOBS = QStringLiteral("Rust.RustCompilerBuildStep.AdaptiveJobs");
+const QString C_NIMCOMPILERBUILDSTEP_EXPLAINREBUILDS = QStringLiteral("Rust.RustCompilerBuildStep.ExplainRebuilds");
+const QString C_NIMCOMPILERBUILDSTEP_REBUILDCAUSES = QStringLiteral("Rust.RustCompilerBuildStep.RebuildCauses");
+const QString C_NIMCOMPILERBUILDSTEP_UNITTIMINGS = QStringLiteral("Rust.RustCompilerBuildStep.UnitTimings");
+const QString C_NIMCOMPILERBUILDSTEP_REMARKCRATES = QStringLiteral("Rust.RustCompilerBuildStep.RemarkCrates");
+const QString C_NIMCOMPILERBUILDSTEP_SELECTIVECLEAN = QStringLiteral("Rust.RustCompilerBuildStep.SelectiveClean");
 
 // RustCompilerBuildStepWidget
 const char C_NIMCOMPILERBUILDSTEPWIDGET_DISPLAY[] = QT_TRANSLATE_NOOP("RustCompilerBuildStepConfigWidget", "Rust build step");
@@ -57,6 +76,45 @@ const char C_NIMCOMPILERCLEANSTEPWIDGET_DISPLAY[] = QT_TRANSLATE_NOOP("RustCompi
 // RustCompilerCleanStep
 const char C_NIMCOMPILERCLEANSTEP_ID[] = "Rust.RustCompilerCleanStep";
 
+// RustRunConfiguration
+const QString C_NIMRUNCONFIGURATION_REPEATEDRUNS = QStringLiteral("Rust.RustRunConfiguration.RepeatedRuns");
+const QString C_NIMRUNCONFIGURATION_WARMUPRUNS = QStringLiteral("Rust.RustRunConfiguration.WarmupRuns");
+const QString C_NIMRUNCONFIGURATION_DROPCACHES = QStringLiteral("Rust.RustRunConfiguration.DropCaches");
+
+// RustPgoTrainingRunConfiguration
+const char C_NIMPGOTRAININGRUNCONFIGURATION_ID[] = "Rust.PgoTrainingRunConfiguration";
+const char C_NIMBENCHRUNCONFIGURATION_ID[] = "Rust.BenchRunConfiguration:";
+
+// Profiling
+const char C_NIMPERF_RUN_MODE[] = "Rust.PerfRunMode";
+const char C_NIMPERF_HOTLINES_RUN_MODE[] = "Rust.PerfHotLinesRunMode";
+const char C_NIMPERF_OFFCPU_RUN_MODE[] = "Rust.PerfOffCpuRunMode";
+const char C_NIMREPEATED_RUN_MODE[] = "Rust.RepeatedRunMode";
+const char C_NIMPERF_STAT_RUN_MODE[] = "Rust.PerfStatRunMode";
+const char C_NIMHEAPTRACK_RUN_MODE[] = "Rust.HeaptrackRunMode";
+
+// Rust menu
+const char M_RUST[] = "Rust.Menu";
+const char A_ANALYZE_TARGET_DIRECTORY[] = "Rust.AnalyzeTargetDirectory";
+const char A_BENCHMARK_RAM_TARGET_DIRECTORY[] = "Rust.BenchmarkRamTargetDirectory";
+const char A_DEPENDENCY_COMPILE_COST[] = "Rust.DependencyCompileCost";
+const char A_COMPARE_PROFILE_VARIANTS[] = "Rust.CompareProfileVariants";
+const char A_PROFILE_GUIDED_OPTIMIZATION[] = "Rust.ProfileGuidedOptimization";
+const char A_LINK_TIME_HISTORY[] = "Rust.LinkTimeHistory";
+const char A_PROFILE_WITH_PERF[] = "Rust.ProfileWithPerf";
+const char A_ANNOTATE_HOT_LINES[] = "Rust.AnnotateHotLines";
+const char A_PROFILE_OFF_CPU[] = "Rust.ProfileOffCpu";
+const char A_BENCHMARK_REPEATED_RUNS[] = "Rust.BenchmarkRepeatedRuns";
+const char A_COUNT_HARDWARE_EVENTS[] = "Rust.CountHardwareEvents";
+const char A_PROFILE_HEAP_ALLOCATIONS[] = "Rust.ProfileHeapAllocations";
+const char A_ANALYZE_BINARY_SIZE[] = "Rust.AnalyzeBinarySize";
+const char A_COMPARE_BINARY_SIZE[] = "Rust.CompareBinarySize";
+const char A_SHOW_GENERATED_CODE[] = "Rust.ShowGeneratedCode";
+const char A_SHOW_OPTIMIZATION_REMARKS[] = "Rust.ShowOptimizationRemarks";
+const char A_BISECT_PERFORMANCE[] = "Rust.BisectPerformance";
+const char A_RUN_TESTS[] = "Rust.RunTests";
+const char A_RERUN_FAILED_TESTS[] = "Rust.RerunFailedTests";
+
 const char C_NIMLANGUAGE_ID[] = "Rust";
 const char C_NIMLANGUAGE_NAME[] = QT_TRANSLATE_NOOP("RustCodeStylePreferencesFactory", "Rust");
 
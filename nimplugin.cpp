@@ -26,39 +26,323 @@
 #include "nimplugin.h"
 
 #include "nimconstants.h"
+#include "project/nimbisection.h"
 #include "project/nimbuildconfiguration.h"
+#include "project/nimcargomessages.h"
+#include "project/nimcommandsequence.h"
 #include "project/nimcompilerbuildstep.h"
+#include "project/nimdependencycost.h"
+#include "project/nimpgopipeline.h"
+#include "project/nimprofilevariants.h"
 #include "project/nimproject.h"
+#include "project/nimramtargetdirectory.h"
 #include "project/nimrunconfiguration.h"
+#include "project/nimtargetdirectory.h"
+#include "project/nimtestpane.h"
 #include "project/nimtoolchainfactory.h"
+#include "profiler/nimbenchmarks.h"
+#include "profiler/nimcounters.h"
+#include "profiler/nimheapprofile.h"
+#include "profiler/nimperfrecorder.h"
+#include "profiler/nimprofilerpane.h"
+#include "profiler/nimrepeatedruns.h"
 #include "settings/nimsettings.h"
 
+#include <coreplugin/actionmanager/actioncontainer.h>
+#include <coreplugin/actionmanager/actionmanager.h>
+#include <coreplugin/coreconstants.h>
 #include <coreplugin/fileiconprovider.h>
+#include <coreplugin/icore.h>
+#include <coreplugin/messagemanager.h>
+#include <projectexplorer/projectexplorer.h>
 #include <projectexplorer/projectmanager.h>
+#include <projectexplorer/session.h>
+#include <projectexplorer/target.h>
 #include <projectexplorer/toolchainmanager.h>
 #include <projectexplorer/runcontrol.h>
+#include <texteditor/texteditor.h>
+#include <utils/qtcassert.h>
+
+#include <QAction>
+#include <QFileDialog>
+#include <QMenu>
+#include <QPointer>
 
 using namespace Utils;
 using namespace ProjectExplorer;
 
 namespace Nim {
 
+static NimBuildConfiguration *activeBuildConfiguration()
+{
+    Project *project = SessionManager::startupProject();
+    if (!project || !project->activeTarget())
+        return nullptr;
+    return qobject_cast<NimBuildConfiguration *>(project->activeTarget()->activeBuildConfiguration());
+}
+
 class NimPluginPrivate
 {
 public:
+    NimPluginPrivate();
+
     NimSettings settings;
     NimBuildConfigurationFactory buildConfigFactory;
     NimRunConfigurationFactory nimRunConfigFactory;
+    NimPgoTrainingRunConfigurationFactory pgoTrainingRunConfigFactory;
+    NimBenchRunConfigurationFactory benchRunConfigFactory;
     RunWorkerFactory nimRunWorkerFactory {
         RunWorkerFactory::make<SimpleTargetRunner>(),
         {ProjectExplorer::Constants::NORMAL_RUN_MODE},
-        {nimRunConfigFactory.id()}
+        {nimRunConfigFactory.id(), pgoTrainingRunConfigFactory.id()}
+    };
+    RunWorkerFactory benchRunWorkerFactory {
+        RunWorkerFactory::make<NimBenchRunner>(),
+        {ProjectExplorer::Constants::NORMAL_RUN_MODE},
+        {benchRunConfigFactory.id()}
+    };
+    RunWorkerFactory repeatedRunWorkerFactory {
+        RunWorkerFactory::make<NimRepeatedRunner>(),
+        {Constants::C_NIMREPEATED_RUN_MODE},
+        {nimRunConfigFactory.id(), pgoTrainingRunConfigFactory.id()}
+    };
+    RunWorkerFactory perfStatRunWorkerFactory {
+        RunWorkerFactory::make<NimPerfStatRunner>(),
+        {Constants::C_NIMPERF_STAT_RUN_MODE},
+        {nimRunConfigFactory.id(), pgoTrainingRunConfigFactory.id(), benchRunConfigFactory.id()}
+    };
+    RunWorkerFactory heaptrackRunWorkerFactory {
+        RunWorkerFactory::make<NimHeaptrackRunner>(),
+        {Constants::C_NIMHEAPTRACK_RUN_MODE},
+        {nimRunConfigFactory.id(), pgoTrainingRunConfigFactory.id()}
     };
+    RunWorkerFactory perfRunWorkerFactory {
+        RunWorkerFactory::make<NimPerfRecordRunner>(),
+        {Constants::C_NIMPERF_RUN_MODE, Constants::C_NIMPERF_HOTLINES_RUN_MODE,
+         Constants::C_NIMPERF_OFFCPU_RUN_MODE},
+        {nimRunConfigFactory.id(), pgoTrainingRunConfigFactory.id()}
+    };
+    NimProfilerPane profilerPane;
+    NimTestPane testPane;
     NimCompilerBuildStepFactory buildStepFactory;
     NimCompilerCleanStepFactory cleanStepFactory;
     NimToolChainFactory toolChainFactory;
+    NimTargetDirectoryCollector targetDirectoryCollector;
+    NimTargetDirectoryBenchmark targetDirectoryBenchmark;
+    NimDependencyCostReport dependencyCostReport;
+    NimProfileVariantBenchmark profileVariantBenchmark;
+    NimPgoPipeline pgoPipeline;
+    NimPerformanceBisection performanceBisection;
+    NimCommandSequence binarySizeBuild;
+
+    void analyzeBinarySize(bool chooseBase);
 };
 
+// The output file path names Cargo's target directory, the build's JSON
+// messages name the executable, and an up-to-date build only prints them
+void NimPluginPrivate::analyzeBinarySize(bool chooseBase)
+{
+    NimBuildConfiguration *buildConfiguration = activeBuildConfiguration();
+    if (!buildConfiguration || binarySizeBuild.isRunning())
+        return;
+    NimCompilerBuildStep *buildStep = buildConfiguration->nimCompilerBuildStep();
+    if (!buildStep) {
+        Core::MessageManager::write(RustPlugin::tr("Analyzing the binary size needs a build step."));
+        return;
+    }
+
+    const QPointer<NimBuildConfiguration> configuration = buildConfiguration;
+    const QString binaryName = buildConfiguration->outFilePath().fileName();
+    CommandLine build = buildStep->cargoCommand("build");
+    build.addArg("--message-format=json-render-diagnostics");
+    binarySizeBuild.setWorkingDirectory(buildConfiguration->project()->projectDirectory());
+    binarySizeBuild.setEnvironment(buildStep->cargoEnvironment());
+    binarySizeBuild.addCommand(build, [configuration, binaryName, chooseBase](const NimCommandResult &result) {
+        const FilePath binary
+                = NimCargoMessages::binary(NimCargoMessages::executables(result.standardOutput),
+                                           binaryName).path;
+        if (!configuration)
+            return;
+        if (binary.isEmpty() || !binary.exists()) {
+            Core::MessageManager::write(RustPlugin::tr("The build produced no binary to analyze."));
+            return;
+        }
+        FilePath baseBinary;
+        if (chooseBase) {
+            baseBinary = FilePath::fromString(
+                        QFileDialog::getOpenFileName(Core::ICore::dialogParent(),
+                                                     RustPlugin::tr("Compare Binary Size With"),
+                                                     binary.parentDir().toString()));
+            if (baseBinary.isEmpty())
+                return;
+        }
+        NimProfilerPane::instance()->analyzeBinarySize(
+                    binary, NimBinarySize::reportFile(configuration->buildDirectory(), binary), baseBinary);
+    });
+    Core::MessageManager::write(RustPlugin::tr("Building %1 to analyze its size...").arg(binaryName));
+    binarySizeBuild.start();
+}
+
+NimPluginPrivate::NimPluginPrivate()
+{
+    Core::ActionContainer *menu = Core::ActionManager::createMenu(Constants::M_RUST);
+    menu->menu()->setTitle(RustPlugin::tr("&Rust"));
+    Core::ActionManager::actionContainer(Core::Constants::M_TOOLS)->addMenu(menu);
+
+    QObject::connect(&binarySizeBuild, &NimCommandSequence::message, [](const QString &message) {
+        Core::MessageManager::write(message);
+    });
+
+    auto runTests = new QAction(RustPlugin::tr("Run Tests"), menu);
+    menu->addAction(Core::ActionManager::registerAction(runTests, Constants::A_RUN_TESTS));
+    QObject::connect(runTests, &QAction::triggered, [this] {
+        testPane.runTests(false);
+    });
+
+    auto rerunFailedTests = new QAction(RustPlugin::tr("Rerun Failed Tests"), menu);
+    menu->addAction(Core::ActionManager::registerAction(rerunFailedTests, Constants::A_RERUN_FAILED_TESTS));
+    QObject::connect(rerunFailedTests, &QAction::triggered, [this] {
+        testPane.runTests(true);
+    });
+
+    auto analyzeTargetDirectory = new QAction(RustPlugin::tr("Analyze Target Directory..."), menu);
+    menu->addAction(Core::ActionManager::registerAction(analyzeTargetDirectory,
+                                                        Constants::A_ANALYZE_TARGET_DIRECTORY));
+    QObject::connect(analyzeTargetDirectory, &QAction::triggered, [this] {
+        targetDirectoryCollector.run(activeBuildConfiguration());
+    });
+
+    auto benchmarkRamTargetDirectory = new QAction(RustPlugin::tr("Benchmark RAM Target Directory..."), menu);
+    menu->addAction(Core::ActionManager::registerAction(benchmarkRamTargetDirectory,
+                                                        Constants::A_BENCHMARK_RAM_TARGET_DIRECTORY));
+    QObject::connect(benchmarkRamTargetDirectory, &QAction::triggered, [this] {
+        targetDirectoryBenchmark.run(activeBuildConfiguration());
+    });
+
+    auto dependencyCompileCost = new QAction(RustPlugin::tr("Dependency Compile Cost..."), menu);
+    menu->addAction(Core::ActionManager::registerAction(dependencyCompileCost,
+                                                        Constants::A_DEPENDENCY_COMPILE_COST));
+    QObject::connect(dependencyCompileCost, &QAction::triggered, [this] {
+        dependencyCostReport.run(activeBuildConfiguration());
+    });
+
+    auto compareProfileVariants = new QAction(RustPlugin::tr("Compare Profile Variants..."), menu);
+    menu->addAction(Core::ActionManager::registerAction(compareProfileVariants,
+                                                        Constants::A_COMPARE_PROFILE_VARIANTS));
+    QObject::connect(compareProfileVariants, &QAction::triggered, [this] {
+        profileVariantBenchmark.run(activeBuildConfiguration());
+    });
+
+    auto profileGuidedOptimization = new QAction(RustPlugin::tr("Profile-Guided Optimization..."), menu);
+    menu->addAction(Core::ActionManager::registerAction(profileGuidedOptimization,
+                                                        Constants::A_PROFILE_GUIDED_OPTIMIZATION));
+    QObject::connect(profileGuidedOptimization, &QAction::triggered, [this] {
+        pgoPipeline.run(activeBuildConfiguration());
+    });
+
+    auto bisectPerformance = new QAction(RustPlugin::tr("Bisect Performance Regression..."), menu);
+    menu->addAction(Core::ActionManager::registerAction(bisectPerformance, Constants::A_BISECT_PERFORMANCE));
+    QObject::connect(bisectPerformance, &QAction::triggered, [this] {
+        performanceBisection.run(activeBuildConfiguration());
+    });
+
+    auto profileWithPerf = new QAction(RustPlugin::tr("Profile with perf"), menu);
+    menu->addAction(Core::ActionManager::registerAction(profileWithPerf,
+                                                        Constants::A_PROFILE_WITH_PERF));
+    QObject::connect(profileWithPerf, &QAction::triggered, [] {
+        ProjectExplorerPlugin::runStartupProject(Constants::C_NIMPERF_RUN_MODE);
+    });
+
+    auto annotateHotLines = new QAction(RustPlugin::tr("Annotate Hot Lines with perf"), menu);
+    menu->addAction(Core::ActionManager::registerAction(annotateHotLines,
+                                                        Constants::A_ANNOTATE_HOT_LINES));
+    QObject::connect(annotateHotLines, &QAction::triggered, [] {
+        ProjectExplorerPlugin::runStartupProject(Constants::C_NIMPERF_HOTLINES_RUN_MODE);
+    });
+
+    auto profileOffCpu = new QAction(RustPlugin::tr("Profile Off-CPU Time with perf"), menu);
+    menu->addAction(Core::ActionManager::registerAction(profileOffCpu, Constants::A_PROFILE_OFF_CPU));
+    QObject::connect(profileOffCpu, &QAction::triggered, [] {
+        ProjectExplorerPlugin::runStartupProject(Constants::C_NIMPERF_OFFCPU_RUN_MODE);
+    });
+
+    auto profileHeapAllocations = new QAction(RustPlugin::tr("Profile Heap Allocations with heaptrack"), menu);
+    menu->addAction(Core::ActionManager::registerAction(profileHeapAllocations,
+                                                        Constants::A_PROFILE_HEAP_ALLOCATIONS));
+    QObject::connect(profileHeapAllocations, &QAction::triggered, [] {
+        ProjectExplorerPlugin::runStartupProject(Constants::C_NIMHEAPTRACK_RUN_MODE);
+    });
+
+    auto benchmarkRepeatedRuns = new QAction(RustPlugin::tr("Benchmark Repeated Runs"), menu);
+    menu->addAction(Core::ActionManager::registerAction(benchmarkRepeatedRuns,
+                                                        Constants::A_BENCHMARK_REPEATED_RUNS));
+    QObject::connect(benchmarkRepeatedRuns, &QAction::triggered, [] {
+        ProjectExplorerPlugin::runStartupProject(Constants::C_NIMREPEATED_RUN_MODE);
+    });
+
+    auto countHardwareEvents = new QAction(RustPlugin::tr("Count Hardware Events with perf stat"), menu);
+    menu->addAction(Core::ActionManager::registerAction(countHardwareEvents,
+                                                        Constants::A_COUNT_HARDWARE_EVENTS));
+    QObject::connect(countHardwareEvents, &QAction::triggered, [] {
+        ProjectExplorerPlugin::runStartupProject(Constants::C_NIMPERF_STAT_RUN_MODE);
+    });
+
+    auto analyzeSize = new QAction(RustPlugin::tr("Analyze Binary Size"), menu);
+    menu->addAction(Core::ActionManager::registerAction(analyzeSize, Constants::A_ANALYZE_BINARY_SIZE));
+    QObject::connect(analyzeSize, &QAction::triggered, [this] { analyzeBinarySize(false); });
+
+    auto compareSize = new QAction(RustPlugin::tr("Compare Binary Size With..."), menu);
+    menu->addAction(Core::ActionManager::registerAction(compareSize, Constants::A_COMPARE_BINARY_SIZE));
+    QObject::connect(compareSize, &QAction::triggered, [this] { analyzeBinarySize(true); });
+
+    auto showGeneratedCode = new QAction(RustPlugin::tr("Show Generated Code"), menu);
+    menu->addAction(Core::ActionManager::registerAction(showGeneratedCode, Constants::A_SHOW_GENERATED_CODE));
+    QObject::connect(showGeneratedCode, &QAction::triggered, [] {
+        NimBuildConfiguration *buildConfiguration = activeBuildConfiguration();
+        TextEditor::BaseTextEditor *editor = TextEditor::BaseTextEditor::currentTextEditor();
+        if (!buildConfiguration || !editor)
+            return;
+        // The function named at the cursor, or else the one the line is in
+        QTextCursor cursor = editor->editorWidget()->textCursor();
+        const int line = cursor.blockNumber() + 1;
+        cursor.select(QTextCursor::WordUnderCursor);
+        NimProfilerPane::instance()->inspectGeneratedCode(buildConfiguration, editor->document()->filePath(),
+                                                          line, cursor.selectedText());
+    });
+
+    auto showRemarks = new QAction(RustPlugin::tr("Show Optimization Remarks"), menu);
+    menu->addAction(Core::ActionManager::registerAction(showRemarks, Constants::A_SHOW_OPTIMIZATION_REMARKS));
+    QObject::connect(showRemarks, &QAction::triggered, [] {
+        NimBuildConfiguration *buildConfiguration = activeBuildConfiguration();
+        if (!buildConfiguration)
+            return;
+        NimCompilerBuildStep *step = buildConfiguration->nimCompilerBuildStep();
+        QTC_ASSERT(step, return);
+        if (step->remarkCrates().isEmpty()) {
+            Core::MessageManager::write(RustPlugin::tr("No crates are selected for optimization remarks. "
+                                                       "List them under \"Optimization remarks for\" "
+                                                       "in the build step and build the project."));
+            return;
+        }
+        NimProfilerPane::instance()->showOptimizationRemarks(step->remarksDirectory(),
+                                                             buildConfiguration->project()->projectDirectory());
+    });
+
+    auto linkTimeHistory = new QAction(RustPlugin::tr("Show Link Time History"), menu);
+    menu->addAction(Core::ActionManager::registerAction(linkTimeHistory,
+                                                        Constants::A_LINK_TIME_HISTORY));
+    QObject::connect(linkTimeHistory, &QAction::triggered, [] {
+        NimBuildConfiguration *buildConfiguration = activeBuildConfiguration();
+        if (!buildConfiguration)
+            return;
+        const QStringList summary = NimLinkTimes::summary(buildConfiguration->linkTimeHistory());
+        Core::MessageManager::write(summary.isEmpty()
+                                        ? RustPlugin::tr("No link times were recorded. Enable "
+                                                         "\"Measure link time\" in the build settings.")
+                                        : summary.join('\n'));
+    });
+}
+
 RustPlugin::~RustPlugin()
 {
     delete d;
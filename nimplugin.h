@@ -45,6 +45,34 @@ public:
 private slots:
     void testNimParser_data();
     void testNimParser();
+
+    void testRustDemangler_data();
+    void testRustDemangler();
+    void testRustDemanglerFuzz();
+    void testRustDemanglerBenchmark();
+
+    void testCodegenParsers();
+    void testBinarySize();
+    void testHotLines();
+    void testStackFolder_data();
+    void testStackFolder();
+    void testOffCpuProfile();
+    void testOptimizationRemarks();
+
+    void testBenchmarkParser();
+    void testRunStatistics();
+    void testCounterParser();
+    void testHeapProfile();
+    void testTestRunner();
+    void testPerformanceBisection();
+    void testTargetDirectoryPrune();
+    void testRecommendedJobs();
+    void testLinkTimes();
+    void testDependencyCost();
+    void testProfileVariants();
+
+    void testFingerprintParser_data();
+    void testFingerprintParser();
 #endif
 
 private:
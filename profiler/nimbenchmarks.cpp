@@ -0,0 +1,342 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+
+#include "nimbenchmarks.h"
+#include "nimprofilerpane.h"
+
+#include "../project/nimdatadirectory.h"
+#include "../project/nimgit.h"
+
+#include <coreplugin/messagemanager.h>
+#include <projectexplorer/buildconfiguration.h>
+#include <projectexplorer/project.h>
+#include <projectexplorer/runconfiguration.h>
+#include <projectexplorer/target.h>
+#include <utils/qtcassert.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QRegularExpression>
+
+#include <cmath>
+#include <limits>
+
+using namespace ProjectExplorer;
+using namespace Utils;
+
+namespace Nim {
+
+const double CONFIDENCE_Z = 1.96;
+const double MIN_SIGNIFICANT_CHANGE = 0.02;
+
+static double toNanoseconds(double value, const QString &unit)
+{
+    if (unit == "ps")
+        return value / 1e3;
+    if (unit == "ns")
+        return value;
+    // Criterion writes the micro sign, some fonts make it a mu
+    if (unit == QString::fromUtf8("µs") || unit == QString::fromUtf8("μs") || unit == "us")
+        return value * 1e3;
+    if (unit == "ms")
+        return value * 1e6;
+    if (unit == "s")
+        return value * 1e9;
+    return -1;
+}
+
+static QString currentCommit(const FilePath &projectDirectory)
+{
+    const QString commit = NimGit::output(projectDirectory, {"rev-parse", "--short=12", "HEAD"});
+    if (commit.isEmpty())
+        return QString("-");
+    const bool dirty = !NimGit::output(projectDirectory,
+                                       {"status", "--porcelain", "--untracked-files=no"}).isEmpty();
+    return dirty ? commit + "-dirty" : commit;
+}
+
+// NimBenchmarkRun
+
+QString NimBenchmarkRun::displayName() const
+{
+    return QString("%1 (%2)").arg(commit, finished.toString(Qt::SystemLocaleShortDate));
+}
+
+// NimBenchmarks
+
+QVector<NimBenchmarkResult> NimBenchmarks::parseOutput(const QString &output)
+{
+    static const QRegularExpression criterion(
+                R"(^(.*?)\s*time:\s+\[(\S+) (\S+) (\S+) (\S+) (\S+) (\S+)\])");
+    static const QRegularExpression libtest(
+                R"(^test (.+?) \.\.\. bench:\s+([\d,.]+) ns/iter \(\+/- ([\d,.]+)\))");
+
+    QVector<NimBenchmarkResult> results;
+    QString previousLine;
+    for (QString line : output.split('\n')) {
+        line = line.trimmed();
+        QRegularExpressionMatch match = criterion.match(line);
+        if (match.hasMatch()) {
+            NimBenchmarkResult result;
+            // Long names get a line of their own
+            result.name = match.captured(1).isEmpty() ? previousLine : match.captured(1);
+            result.lowerBound = toNanoseconds(match.captured(2).toDouble(), match.captured(3));
+            result.estimate = toNanoseconds(match.captured(4).toDouble(), match.captured(5));
+            result.upperBound = toNanoseconds(match.captured(6).toDouble(), match.captured(7));
+            if (!result.name.isEmpty() && result.lowerBound >= 0 && result.estimate >= 0
+                    && result.upperBound >= 0) {
+                results.append(result);
+            }
+            previousLine.clear();
+            continue;
+        }
+        match = libtest.match(line);
+        if (match.hasMatch()) {
+            NimBenchmarkResult result;
+            result.name = match.captured(1);
+            result.estimate = match.captured(2).remove(',').toDouble();
+            const double deviation = match.captured(3).remove(',').toDouble();
+            result.lowerBound = qMax(0.0, result.estimate - deviation);
+            result.upperBound = result.estimate + deviation;
+            results.append(result);
+            previousLine.clear();
+            continue;
+        }
+        if (!line.isEmpty())
+            previousLine = line;
+    }
+    return results;
+}
+
+FilePath NimBenchmarks::historyFile(RunConfiguration *benchmark)
+{
+    return NimDataDirectory::forRunConfiguration(benchmark, "bench", ".history");
+}
+
+QVector<NimBenchmarkRun> NimBenchmarks::readHistory(const FilePath &path)
+{
+    QVector<NimBenchmarkRun> history;
+    QFile file(path.toString());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return history;
+    while (!file.atEnd()) {
+        const QStringList fields = QString::fromUtf8(file.readLine()).trimmed().split('\t');
+        if (fields.size() != 6)
+            continue;
+        const QDateTime finished = QDateTime::fromString(fields.at(1), Qt::ISODate);
+        if (history.isEmpty() || history.last().commit != fields.at(0) || history.last().finished != finished) {
+            history.append(NimBenchmarkRun());
+            history.last().commit = fields.at(0);
+            history.last().finished = finished;
+        }
+        NimBenchmarkResult result;
+        result.estimate = fields.at(2).toDouble();
+        result.lowerBound = fields.at(3).toDouble();
+        result.upperBound = fields.at(4).toDouble();
+        result.name = fields.at(5);
+        history.last().results.append(result);
+    }
+    return history;
+}
+
+bool NimBenchmarks::appendToHistory(const FilePath &path, const NimBenchmarkRun &run)
+{
+    QDir().mkpath(path.parentDir().toString());
+    QFile file(path.toString());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+        return false;
+    const QByteArray prefix = run.commit.toUtf8() + '\t' + run.finished.toString(Qt::ISODate).toUtf8() + '\t';
+    for (const NimBenchmarkResult &result : run.results) {
+        file.write(prefix + QByteArray::number(result.estimate, 'g', 10) + '\t'
+                   + QByteArray::number(result.lowerBound, 'g', 10) + '\t'
+                   + QByteArray::number(result.upperBound, 'g', 10) + '\t'
+                   + result.name.toUtf8() + '\n');
+    }
+    return true;
+}
+
+int NimBenchmarks::defaultBaseline(const QVector<NimBenchmarkRun> &history)
+{
+    if (history.size() < 2)
+        return -1;
+    const QString commit = history.last().commit;
+    for (int i = history.size() - 2; i >= 0; --i) {
+        if (history.at(i).commit != commit)
+            return i;
+    }
+    return history.size() - 2;
+}
+
+QVector<NimBenchmarkComparison> NimBenchmarks::compare(const NimBenchmarkRun &run,
+                                                       const NimBenchmarkRun &baseline)
+{
+    QHash<QString, NimBenchmarkResult> baselineResults;
+    for (const NimBenchmarkResult &result : baseline.results)
+        baselineResults.insert(result.name, result);
+
+    // The standard error from the half width of the interval
+    auto standardError = [](const NimBenchmarkResult &result) {
+        return (result.upperBound - result.lowerBound) / (2 * CONFIDENCE_Z);
+    };
+    QVector<NimBenchmarkComparison> comparisons;
+    for (const NimBenchmarkResult &result : run.results) {
+        NimBenchmarkComparison comparison;
+        comparison.result = result;
+        const auto base = baselineResults.constFind(result.name);
+        if (base == baselineResults.cend() || base->estimate <= 0) {
+            comparisons.append(comparison);
+            continue;
+        }
+        comparison.baseline = *base;
+        const double difference = result.estimate - base->estimate;
+        comparison.change = difference / base->estimate;
+        const double error = std::hypot(standardError(result), standardError(*base));
+        const double z = error > 0 ? difference / error
+                                   : difference != 0 ? std::copysign(std::numeric_limits<double>::infinity(),
+                                                                     difference)
+                                                     : 0;
+        if (std::abs(z) <= CONFIDENCE_Z || std::abs(comparison.change) < MIN_SIGNIFICANT_CHANGE)
+            comparison.verdict = NimBenchmarkComparison::Unchanged;
+        else
+            comparison.verdict = difference > 0 ? NimBenchmarkComparison::Regressed
+                                                : NimBenchmarkComparison::Improved;
+        comparisons.append(comparison);
+    }
+    return comparisons;
+}
+
+QString NimBenchmarks::formatDuration(double nanoseconds)
+{
+    if (nanoseconds < 1e3)
+        return QString("%1 ns").arg(nanoseconds, 0, 'g', 4);
+    if (nanoseconds < 1e6)
+        return QString::fromUtf8("%1 µs").arg(nanoseconds / 1e3, 0, 'g', 4);
+    if (nanoseconds < 1e9)
+        return QString("%1 ms").arg(nanoseconds / 1e6, 0, 'g', 4);
+    return QString("%1 s").arg(nanoseconds / 1e9, 0, 'g', 4);
+}
+
+// NimBenchRunner
+
+NimBenchRunner::NimBenchRunner(RunControl *runControl)
+    : SimpleTargetRunner(runControl)
+{
+    setId("NimBenchRunner");
+
+    setStarter([this, runControl] {
+        // Taken before the run, the tree may change while it takes
+        m_commit = currentCommit(runControl->project()->projectDirectory());
+        m_output.clear();
+        doStart(runControl->runnable(), device());
+    });
+
+    connect(runControl, &RunControl::appendMessage, this, [this](const QString &message, OutputFormat format) {
+        if (format == StdOutFormat)
+            m_output += message;
+    });
+
+    connect(this, &RunWorker::stopped, this, [this, runControl] {
+        NimBenchmarkRun run;
+        run.commit = m_commit;
+        run.finished = QDateTime::currentDateTime();
+        run.results = NimBenchmarks::parseOutput(m_output);
+        m_output.clear();
+        if (run.results.isEmpty()) {
+            Core::MessageManager::write(tr("No benchmark results were found in the output of %1.")
+                                            .arg(runControl->displayName()));
+            return;
+        }
+        const FilePath history = NimBenchmarks::historyFile(runControl->runConfiguration());
+        if (!NimBenchmarks::appendToHistory(history, run)) {
+            Core::MessageManager::write(tr("Could not write %1.").arg(history.toUserOutput()));
+            return;
+        }
+        if (NimProfilerPane::instance())
+            NimProfilerPane::instance()->addBenchmarkRun(runControl->displayName(), history);
+    });
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QTest>
+
+namespace Nim {
+
+void RustPlugin::testBenchmarkParser()
+{
+    const QString output = QString::fromUtf8(
+                "running 2 tests\n"
+                "test bench_parse ... bench:       1,234 ns/iter (+/- 56)\n"
+                "test bench_small ... bench:          12.50 ns/iter (+/- 0.25)\n"
+                "\n"
+                "fib 20                  time:   [26.029 µs 26.251 µs 26.505 µs]\n"
+                "                        change: [-1.1% +0.3% +1.6%] (p = 0.67 > 0.05)\n"
+                "                        No change in performance detected.\n"
+                "group/a rather long benchmark name\n"
+                "                        time:   [1.5000 ms 1.6000 ms 1.7000 ms]\n"
+                "                        thrpt:  [610.35 MiB/s 625.00 MiB/s 640.00 MiB/s]\n");
+    const QVector<NimBenchmarkResult> results = NimBenchmarks::parseOutput(output);
+    QCOMPARE(results.size(), 4);
+    QCOMPARE(results.at(0).name, QString("bench_parse"));
+    QCOMPARE(results.at(0).estimate, 1234.0);
+    QCOMPARE(results.at(0).upperBound, 1290.0);
+    QCOMPARE(results.at(1).estimate, 12.5);
+    QCOMPARE(results.at(2).name, QString("fib 20"));
+    QCOMPARE(results.at(2).lowerBound, 26029.0);
+    QCOMPARE(results.at(2).estimate, 26251.0);
+    QCOMPARE(results.at(3).name, QString("group/a rather long benchmark name"));
+    QCOMPARE(results.at(3).estimate, 1.6e6);
+
+    NimBenchmarkRun baseline;
+    baseline.results = results;
+    NimBenchmarkRun run = baseline;
+    run.results[0].estimate *= 1.5;  // far outside the deviation
+    run.results[0].lowerBound *= 1.5;
+    run.results[0].upperBound *= 1.5;
+    run.results[2].estimate *= 1.005;  // within the interval
+    run.results[3].estimate /= 2;
+    run.results[3].lowerBound /= 2;
+    run.results[3].upperBound /= 2;
+    run.results.append({"new", 1, 1, 1});
+    const QVector<NimBenchmarkComparison> comparisons = NimBenchmarks::compare(run, baseline);
+    QCOMPARE(comparisons.size(), 5);
+    QCOMPARE(comparisons.at(0).verdict, NimBenchmarkComparison::Regressed);
+    QCOMPARE(comparisons.at(1).verdict, NimBenchmarkComparison::Unchanged);
+    QCOMPARE(comparisons.at(2).verdict, NimBenchmarkComparison::Unchanged);
+    QCOMPARE(comparisons.at(3).verdict, NimBenchmarkComparison::Improved);
+    QCOMPARE(comparisons.at(4).verdict, NimBenchmarkComparison::Added);
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
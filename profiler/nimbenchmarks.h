@@ -0,0 +1,112 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+
+#pragma once
+
+#include <projectexplorer/runcontrol.h>
+#include <utils/fileutils.h>
+
+#include <QDateTime>
+#include <QVector>
+
+namespace Nim {
+
+class NimBenchmarkResult
+{
+public:
+    QString name;
+    // Nanoseconds per iteration, with the bounds of criterion's confidence
+    // interval or libtest's deviation
+    double estimate = 0;
+    double lowerBound = 0;
+    double upperBound = 0;
+};
+
+class NimBenchmarkRun
+{
+public:
+    QString commit;  // abbreviated, with "-dirty" for uncommitted changes
+    QDateTime finished;
+    QVector<NimBenchmarkResult> results;
+
+    QString displayName() const;
+};
+
+class NimBenchmarkComparison
+{
+public:
+    enum Verdict { Unchanged, Regressed, Improved, Added };
+
+    NimBenchmarkResult result;
+    NimBenchmarkResult baseline;
+    double change = 0;  // relative to the baseline
+    Verdict verdict = Added;
+};
+
+// Results of cargo bench, kept per bench target in
+// <data directory>/bench/<target>.history, one result per line:
+//   <commit> <finished> <estimate> <lower bound> <upper bound> <name>
+class NimBenchmarks
+{
+public:
+    // Parses criterion's and libtest's reports:
+    //   fib 20                  time:   [26.029 µs 26.251 µs 26.505 µs]
+    //   test bench_fib ... bench:       1,234 ns/iter (+/- 56)
+    static QVector<NimBenchmarkResult> parseOutput(const QString &output);
+
+    static Utils::FilePath historyFile(ProjectExplorer::RunConfiguration *benchmark);
+    // Oldest run first
+    static QVector<NimBenchmarkRun> readHistory(const Utils::FilePath &path);
+    static bool appendToHistory(const Utils::FilePath &path, const NimBenchmarkRun &run);
+
+    // The latest earlier run of another commit, or else the one before
+    // the latest run, -1 without earlier runs
+    static int defaultBaseline(const QVector<NimBenchmarkRun> &history);
+
+    // A change is significant when the intervals, taken as 95% confidence
+    // intervals, tell it apart from noise and it exceeds a small threshold
+    static QVector<NimBenchmarkComparison> compare(const NimBenchmarkRun &run,
+                                                   const NimBenchmarkRun &baseline);
+
+    static QString formatDuration(double nanoseconds);
+};
+
+// Runs cargo bench for a bench run configuration, records the results with
+// the commit they were measured at and hands them to the profiler pane
+class NimBenchRunner : public ProjectExplorer::SimpleTargetRunner
+{
+    Q_OBJECT
+
+public:
+    explicit NimBenchRunner(ProjectExplorer::RunControl *runControl);
+
+private:
+    QString m_commit;
+    QString m_output;
+};
+
+} // namespace Nim
@@ -0,0 +1,157 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+
+#include "nimbenchmarkwidget.h"
+
+#include <utils/theme/theme.h>
+
+#include <QComboBox>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QTreeWidget>
+
+#include <algorithm>
+
+namespace Nim {
+
+enum BenchmarkColumn { BenchmarkNameColumn, TimeColumn, BaselineColumn, ChangeColumn, VerdictColumn };
+
+static QString verdictName(NimBenchmarkComparison::Verdict verdict)
+{
+    switch (verdict) {
+    case NimBenchmarkComparison::Regressed:
+        return NimBenchmarkWidget::tr("Regressed");
+    case NimBenchmarkComparison::Improved:
+        return NimBenchmarkWidget::tr("Improved");
+    case NimBenchmarkComparison::Added:
+        return NimBenchmarkWidget::tr("New");
+    case NimBenchmarkComparison::Unchanged:
+        break;
+    }
+    return NimBenchmarkWidget::tr("No change");
+}
+
+NimBenchmarkWidget::NimBenchmarkWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_baselineComboBox(new QComboBox)
+    , m_summaryLabel(new QLabel)
+    , m_tree(new QTreeWidget)
+{
+    m_baselineComboBox->setToolTip(tr("Baseline"));
+    m_baselineComboBox->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+    m_tree->setHeaderLabels({tr("Benchmark"), tr("Time"), tr("Baseline"), tr("Change"), tr("Verdict")});
+    m_tree->setRootIsDecorated(false);
+    m_tree->setUniformRowHeights(true);
+    m_tree->header()->setSectionResizeMode(BenchmarkNameColumn, QHeaderView::Stretch);
+    m_tree->header()->setStretchLastSection(false);
+
+    auto toolBar = new QHBoxLayout;
+    toolBar->addWidget(m_baselineComboBox);
+    toolBar->addWidget(m_summaryLabel, 1);
+    auto layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(toolBar);
+    layout->addWidget(m_tree);
+
+    connect(m_baselineComboBox, QOverload<int>::of(&QComboBox::activated), this, &NimBenchmarkWidget::updateTree);
+}
+
+void NimBenchmarkWidget::setHistory(const QVector<NimBenchmarkRun> &history)
+{
+    m_history = history;
+    m_baselineComboBox->clear();
+    m_baselineComboBox->addItem(tr("No baseline"), -1);
+    // Newest first, without the run shown
+    for (int i = history.size() - 2; i >= 0; --i)
+        m_baselineComboBox->addItem(tr("Compared with %1").arg(history.at(i).displayName()), i);
+    m_baselineComboBox->setCurrentIndex(qMax(0, m_baselineComboBox->findData(
+                                                    NimBenchmarks::defaultBaseline(history))));
+    updateTree();
+}
+
+void NimBenchmarkWidget::clear()
+{
+    setHistory({});
+}
+
+void NimBenchmarkWidget::updateTree()
+{
+    m_tree->clear();
+    m_summaryLabel->clear();
+    if (m_history.isEmpty())
+        return;
+    const NimBenchmarkRun &run = m_history.last();
+    const int baselineIndex = m_baselineComboBox->currentData().toInt();
+    const bool compared = baselineIndex >= 0 && baselineIndex < m_history.size();
+    m_tree->setColumnHidden(BaselineColumn, !compared);
+    m_tree->setColumnHidden(ChangeColumn, !compared);
+    m_tree->setColumnHidden(VerdictColumn, !compared);
+
+    QVector<NimBenchmarkComparison> comparisons
+            = NimBenchmarks::compare(run, compared ? m_history.at(baselineIndex) : NimBenchmarkRun());
+    std::stable_sort(comparisons.begin(), comparisons.end(),
+                     [](const NimBenchmarkComparison &a, const NimBenchmarkComparison &b) {
+        return (a.verdict == NimBenchmarkComparison::Regressed) > (b.verdict == NimBenchmarkComparison::Regressed);
+    });
+
+    int regressed = 0;
+    int improved = 0;
+    for (const NimBenchmarkComparison &comparison : qAsConst(comparisons)) {
+        auto item = new QTreeWidgetItem(m_tree);
+        item->setText(BenchmarkNameColumn, comparison.result.name);
+        item->setToolTip(BenchmarkNameColumn, comparison.result.name);
+        item->setText(TimeColumn, NimBenchmarks::formatDuration(comparison.result.estimate));
+        item->setToolTip(TimeColumn, tr("%1 to %2")
+                                         .arg(NimBenchmarks::formatDuration(comparison.result.lowerBound),
+                                              NimBenchmarks::formatDuration(comparison.result.upperBound)));
+        for (int column = TimeColumn; column <= ChangeColumn; ++column)
+            item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+        if (!compared || comparison.verdict == NimBenchmarkComparison::Added) {
+            item->setText(VerdictColumn, compared ? verdictName(comparison.verdict) : QString());
+            continue;
+        }
+        item->setText(BaselineColumn, NimBenchmarks::formatDuration(comparison.baseline.estimate));
+        item->setText(ChangeColumn, QString("%1%2%").arg(comparison.change > 0 ? "+" : "")
+                                                    .arg(100 * comparison.change, 0, 'f', 1));
+        item->setText(VerdictColumn, verdictName(comparison.verdict));
+        if (comparison.verdict == NimBenchmarkComparison::Regressed) {
+            ++regressed;
+            item->setForeground(VerdictColumn, Utils::creatorTheme()->color(Utils::Theme::TextColorError));
+            item->setForeground(ChangeColumn, Utils::creatorTheme()->color(Utils::Theme::TextColorError));
+        } else if (comparison.verdict == NimBenchmarkComparison::Improved) {
+            ++improved;
+        }
+    }
+    m_summaryLabel->setText(compared ? tr("%1: %2 regressed, %3 improved of %n benchmarks", nullptr,
+                                          comparisons.size())
+                                           .arg(run.displayName()).arg(regressed).arg(improved)
+                                     : tr("%1: %n benchmarks", nullptr, comparisons.size())
+                                           .arg(run.displayName()));
+}
+
+} // namespace Nim
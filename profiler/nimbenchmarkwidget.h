@@ -0,0 +1,63 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+
+#pragma once
+
+#include "nimbenchmarks.h"
+
+#include <QWidget>
+
+QT_BEGIN_NAMESPACE
+class QComboBox;
+class QLabel;
+class QTreeWidget;
+QT_END_NAMESPACE
+
+namespace Nim {
+
+// Shows the latest benchmark run of a bench target compared with a chosen
+// earlier run, regressions first
+class NimBenchmarkWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit NimBenchmarkWidget(QWidget *parent = nullptr);
+
+    void setHistory(const QVector<NimBenchmarkRun> &history);
+    void clear();
+
+private:
+    void updateTree();
+
+    QVector<NimBenchmarkRun> m_history;
+    QComboBox *m_baselineComboBox;
+    QLabel *m_summaryLabel;
+    QTreeWidget *m_tree;
+};
+
+} // namespace Nim
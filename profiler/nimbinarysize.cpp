@@ -0,0 +1,376 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+
+#include "nimbinarysize.h"
+#include "nimelffile.h"
+#include "nimrustdemangler.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+using namespace Utils;
+
+namespace Nim {
+
+const char NON_RUST_CRATE[] = "[non-Rust]";
+
+static bool isIdentifierChar(QChar c)
+{
+    return c.isLetterOrNumber() || c == '_';
+}
+
+NimBinarySize NimBinarySize::analyze(const FilePath &binary)
+{
+    NimElfFile elf;
+    if (!elf.open(binary.toString())) {
+        NimBinarySize result;
+        result.errorString = elf.errorString();
+        return result;
+    }
+    NimBinarySize result = fromSymbols(elf.functionSymbols());
+    result.binary = binary;
+    result.textSize = elf.section(".text").size();
+    if (result.crates.isEmpty())
+        result.errorString = QCoreApplication::translate("Nim::NimBinarySize", "%1 has no function symbols.")
+                                 .arg(binary.toUserOutput());
+    return result;
+}
+
+NimBinarySize NimBinarySize::fromSymbols(const QVector<NimElfSymbol> &symbols)
+{
+    // Aliases share the code
+    QVector<QByteArray> names;
+    QVector<qint64> sizes;
+    QSet<quint64> addresses;
+    for (const NimElfSymbol &symbol : symbols) {
+        if (symbol.size == 0 || addresses.contains(symbol.address))
+            continue;
+        addresses.insert(symbol.address);
+        names.append(symbol.name);
+        sizes.append(qint64(symbol.size));
+    }
+    const QStringList demangled = NimRustDemangler::demangleAll(names);
+
+    QHash<QString, int> crateIndex;
+    QVector<QHash<QString, int>> functionIndex;
+    NimBinarySize result;
+    for (int i = 0; i < demangled.size(); ++i) {
+        const QString &name = demangled.at(i);
+        // Rust symbols never demangle to themselves
+        const bool rust = name != QString::fromUtf8(names.at(i));
+        const QString crate = rust ? crateName(name) : QString(NON_RUST_CRATE);
+        int index = crateIndex.value(crate, -1);
+        if (index < 0) {
+            index = result.crates.size();
+            crateIndex.insert(crate, index);
+            result.crates.append(NimSizeEntry());
+            result.crates.last().name = crate;
+            functionIndex.append(QHash<QString, int>());
+        }
+        NimSizeEntry &crateEntry = result.crates[index];
+        const QString function = rust ? genericName(name) : name;
+        int functionIndexInCrate = functionIndex.at(index).value(function, -1);
+        if (functionIndexInCrate < 0) {
+            functionIndexInCrate = crateEntry.functions.size();
+            functionIndex[index].insert(function, functionIndexInCrate);
+            crateEntry.functions.append(NimSizeEntry());
+            crateEntry.functions.last().name = function;
+        }
+        NimSizeEntry &functionEntry = crateEntry.functions[functionIndexInCrate];
+        functionEntry.size += sizes.at(i);
+        ++functionEntry.copies;
+        crateEntry.size += sizes.at(i);
+        ++crateEntry.copies;
+    }
+
+    auto largestFirst = [](const NimSizeEntry &a, const NimSizeEntry &b) { return a.size > b.size; };
+    for (NimSizeEntry &crate : result.crates)
+        std::sort(crate.functions.begin(), crate.functions.end(), largestFirst);
+    std::sort(result.crates.begin(), result.crates.end(), largestFirst);
+    return result;
+}
+
+static void compareEntries(QVector<NimSizeEntry> &entries, const QVector<NimSizeEntry> &baseEntries)
+{
+    QHash<QString, int> index;
+    for (int i = 0; i < entries.size(); ++i)
+        index.insert(entries.at(i).name, i);
+    for (const NimSizeEntry &base : baseEntries) {
+        int i = index.value(base.name, -1);
+        // Gone since the base build
+        if (i < 0) {
+            i = entries.size();
+            entries.append(NimSizeEntry());
+            entries.last().name = base.name;
+        }
+        NimSizeEntry &entry = entries[i];
+        entry.baseSize = base.size;
+        entry.baseCopies = base.copies;
+        compareEntries(entry.functions, base.functions);
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const NimSizeEntry &a, const NimSizeEntry &b) {
+        return qAbs(a.size - a.baseSize) > qAbs(b.size - b.baseSize);
+    });
+}
+
+void NimBinarySize::compareWith(const NimBinarySize &base)
+{
+    baseTextSize = base.textSize;
+    baseName = base.binary.toUserOutput();
+    compareEntries(crates, base.crates);
+}
+
+qint64 NimBinarySize::attributedSize() const
+{
+    qint64 size = 0;
+    for (const NimSizeEntry &crate : crates)
+        size += crate.size;
+    return size;
+}
+
+// The identifier before the first "::", which is the crate for paths like
+// alloc::vec::Vec, and the crate of the type for impls like
+// <alloc::vec::Vec<u8> as core::ops::Drop>::drop or <[u8] as core::fmt::Debug>::fmt
+QString NimBinarySize::crateName(const QString &function)
+{
+    for (int separator = function.indexOf("::"); separator > 0; separator = function.indexOf("::", separator + 2)) {
+        int start = separator;
+        while (start > 0 && isIdentifierChar(function.at(start - 1)))
+            --start;
+        if (start < separator)
+            return function.mid(start, separator - start);
+    }
+    return function;
+}
+
+// Generic arguments follow a path, like in Vec<u8> or drop_in_place::<u8>,
+// while qualified paths like <Vec<u8> as Drop>::drop start one. The arrow
+// of fn() -> u8 is no bracket.
+QString NimBinarySize::genericName(const QString &function)
+{
+    QString result;
+    result.reserve(function.size());
+    QVector<bool> brackets;  // true for generic arguments
+    int genericDepth = 0;
+    for (int i = 0; i < function.size(); ++i) {
+        const QChar c = function.at(i);
+        if (c == '<') {
+            const bool generic = i > 0 && (isIdentifierChar(function.at(i - 1)) || function.at(i - 1) == ':');
+            brackets.append(generic);
+            if (generic) {
+                if (genericDepth == 0 && result.endsWith("::"))
+                    result.chop(2);
+                ++genericDepth;
+                continue;
+            }
+        } else if (c == '>' && !brackets.isEmpty() && function.at(i - 1) != '-') {
+            const bool generic = brackets.takeLast();
+            if (generic) {
+                --genericDepth;
+                continue;
+            }
+        }
+        if (genericDepth == 0)
+            result.append(c);
+    }
+    return result;
+}
+
+FilePath NimBinarySize::reportFile(const FilePath &buildDirectory, const FilePath &binary)
+{
+    return buildDirectory.pathAppended("size/" + binary.fileName() + ".size");
+}
+
+// The size of .text on the first line, then one line per function:
+//   text	123456
+//   4096	3	core	core::ptr::drop_in_place
+NimBinarySize NimBinarySize::read(const FilePath &path)
+{
+    NimBinarySize result;
+    QFile file(path.toString());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return result;
+    result.binary = path;
+    QHash<QString, int> crateIndex;
+    while (!file.atEnd()) {
+        const QStringList fields = QString::fromUtf8(file.readLine()).trimmed().split('\t');
+        if (fields.size() == 2 && fields.first() == "text") {
+            result.textSize = fields.at(1).toLongLong();
+            continue;
+        }
+        if (fields.size() != 4)
+            continue;
+        int index = crateIndex.value(fields.at(2), -1);
+        if (index < 0) {
+            index = result.crates.size();
+            crateIndex.insert(fields.at(2), index);
+            result.crates.append(NimSizeEntry());
+            result.crates.last().name = fields.at(2);
+        }
+        NimSizeEntry function;
+        function.name = fields.at(3);
+        function.size = fields.at(0).toLongLong();
+        function.copies = fields.at(1).toInt();
+        NimSizeEntry &crate = result.crates[index];
+        crate.size += function.size;
+        crate.copies += function.copies;
+        crate.functions.append(function);
+    }
+    return result;
+}
+
+bool NimBinarySize::write(const FilePath &path) const
+{
+    QDir().mkpath(path.parentDir().toString());
+    QFile file(path.toString());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+    file.write("text\t" + QByteArray::number(textSize) + '\n');
+    for (const NimSizeEntry &crate : crates) {
+        for (const NimSizeEntry &function : crate.functions) {
+            // Only in the base build
+            if (function.copies == 0)
+                continue;
+            file.write(QByteArray::number(function.size) + '\t' + QByteArray::number(function.copies) + '\t'
+                       + crate.name.toUtf8() + '\t' + function.name.toUtf8() + '\n');
+        }
+    }
+    return true;
+}
+
+// NimBinarySizeAnalyzer
+
+NimBinarySizeAnalyzer::NimBinarySizeAnalyzer(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<NimBinarySize>();
+    connect(&m_watcher, &QFutureWatcher<NimBinarySize>::finished, this, [this] {
+        const NimBinarySize size = m_watcher.result();
+        if (size.errorString.isEmpty())
+            emit finished(size);
+        else
+            emit failed(size.errorString);
+    });
+}
+
+NimBinarySizeAnalyzer::~NimBinarySizeAnalyzer()
+{
+    m_watcher.waitForFinished();
+}
+
+bool NimBinarySizeAnalyzer::isRunning() const
+{
+    return m_watcher.isRunning();
+}
+
+void NimBinarySizeAnalyzer::analyze(const FilePath &binary, const FilePath &reportFile,
+                                    const FilePath &baseBinary)
+{
+    if (isRunning()) {
+        emit failed(tr("Another binary is being analyzed."));
+        return;
+    }
+    m_watcher.setFuture(QtConcurrent::run([binary, reportFile, baseBinary] {
+        NimBinarySize size = NimBinarySize::analyze(binary);
+        if (!size.errorString.isEmpty())
+            return size;
+        const NimBinarySize base = baseBinary.isEmpty() ? NimBinarySize::read(reportFile)
+                                                        : NimBinarySize::analyze(baseBinary);
+        if (!size.write(reportFile)) {
+            size.errorString = QCoreApplication::translate("Nim::NimBinarySizeAnalyzer",
+                                                           "Could not write %1.").arg(reportFile.toUserOutput());
+            return size;
+        }
+        if (base.crates.isEmpty())
+            return size;
+        size.compareWith(base);
+        if (baseBinary.isEmpty())
+            size.baseName = QCoreApplication::translate("Nim::NimBinarySizeAnalyzer", "the last analysis");
+        return size;
+    }));
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QTest>
+
+namespace Nim {
+
+void RustPlugin::testBinarySize()
+{
+    QCOMPARE(NimBinarySize::crateName("alloc::vec::Vec<u8>::push"), QString("alloc"));
+    QCOMPARE(NimBinarySize::crateName("<alloc::vec::Vec<u8> as core::ops::drop::Drop>::drop"), QString("alloc"));
+    QCOMPARE(NimBinarySize::crateName("<[u8] as core::fmt::Debug>::fmt"), QString("core"));
+    QCOMPARE(NimBinarySize::crateName("main"), QString("main"));
+
+    QCOMPARE(NimBinarySize::genericName("core::ptr::drop_in_place::<alloc::vec::Vec<u8>>"),
+             QString("core::ptr::drop_in_place"));
+    QCOMPARE(NimBinarySize::genericName("alloc::vec::Vec<T>::push"), QString("alloc::vec::Vec::push"));
+    QCOMPARE(NimBinarySize::genericName("<alloc::vec::Vec<u8> as core::ops::drop::Drop>::drop"),
+             QString("<alloc::vec::Vec as core::ops::drop::Drop>::drop"));
+    QCOMPARE(NimBinarySize::genericName("<[u8] as core::fmt::Debug>::fmt"),
+             QString("<[u8] as core::fmt::Debug>::fmt"));
+    QCOMPARE(NimBinarySize::genericName("<fn() -> u8 as core::ops::function::FnOnce<()>>::call_once"),
+             QString("<fn() -> u8 as core::ops::function::FnOnce>::call_once"));
+
+    // The hashes of legacy symbols differ per copy, aliases share the code
+    const QVector<NimElfSymbol> symbols = {
+        {"_ZN4core3ptr13drop_in_place17h0123456789abcdefE", 0x1000, 64},
+        {"_ZN4core3ptr13drop_in_place17hfedcba9876543210E", 0x2000, 32},
+        {"_ZN4core3ptr13drop_in_place17h1111111111111111E", 0x2000, 32},
+        {"memcpy", 0x3000, 16},
+        {"_RNvCs1234_7mycrate3foo", 0x4000, 8},
+        {"_RNvCs1234_7mycrate3bar", 0x5000, 0},
+    };
+    const NimBinarySize size = NimBinarySize::fromSymbols(symbols);
+    QCOMPARE(size.crates.size(), 3);
+    QCOMPARE(size.attributedSize(), qint64(120));
+    const NimSizeEntry &core = size.crates.at(0);
+    QCOMPARE(core.name, QString("core"));
+    QCOMPARE(core.size, qint64(96));
+    QCOMPARE(core.functions.size(), 1);
+    QCOMPARE(core.functions.first().name, QString("core::ptr::drop_in_place"));
+    QCOMPARE(core.functions.first().copies, 2);
+    QCOMPARE(size.crates.at(1).name, QString("[non-Rust]"));
+    QCOMPARE(size.crates.at(1).functions.first().name, QString("memcpy"));
+    QCOMPARE(size.crates.at(2).name, QString("mycrate"));
+    QCOMPARE(size.crates.at(2).functions.first().name, QString("mycrate::foo"));
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
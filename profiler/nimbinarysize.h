@@ -0,0 +1,107 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include <utils/fileutils.h>
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QVector>
+
+namespace Nim {
+
+class NimElfSymbol;
+
+// A crate with its functions, or a generic function with the number of its
+// monomorphized copies
+class NimSizeEntry
+{
+public:
+    QString name;
+    qint64 size = 0;
+    int copies = 0;
+    // In the build compared with, zero if there is no such entry
+    qint64 baseSize = 0;
+    int baseCopies = 0;
+    QVector<NimSizeEntry> functions;
+};
+
+// The code size of a binary by crate and generic function, from the symbol
+// table of the ELF file
+class NimBinarySize
+{
+public:
+    Utils::FilePath binary;
+    qint64 textSize = 0;
+    qint64 baseTextSize = 0;
+    QString baseName;  // empty without a comparison
+    // Largest first, or the largest changes first if compared
+    QVector<NimSizeEntry> crates;
+    QString errorString;
+
+    static NimBinarySize analyze(const Utils::FilePath &binary);
+    static NimBinarySize fromSymbols(const QVector<NimElfSymbol> &symbols);
+
+    void compareWith(const NimBinarySize &base);
+    qint64 attributedSize() const;
+
+    // The crate a function belongs to, by the first path in its name
+    static QString crateName(const QString &function);
+    // The function without its generic arguments, which all copies share
+    static QString genericName(const QString &function);
+
+    // The report of the last analysis of a binary, to compare the next one with
+    static Utils::FilePath reportFile(const Utils::FilePath &buildDirectory, const Utils::FilePath &binary);
+    static NimBinarySize read(const Utils::FilePath &path);
+    bool write(const Utils::FilePath &path) const;
+};
+
+// Analyzes a binary in a worker thread, compared with another binary or
+// else with the last analysis of the same binary, which it then replaces
+class NimBinarySizeAnalyzer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NimBinarySizeAnalyzer(QObject *parent = nullptr);
+    ~NimBinarySizeAnalyzer() override;
+
+    bool isRunning() const;
+    void analyze(const Utils::FilePath &binary, const Utils::FilePath &reportFile,
+                 const Utils::FilePath &baseBinary = Utils::FilePath());
+
+signals:
+    void finished(const Nim::NimBinarySize &size);
+    void failed(const QString &message);
+
+private:
+    QFutureWatcher<NimBinarySize> m_watcher;
+};
+
+} // namespace Nim
+
+Q_DECLARE_METATYPE(Nim::NimBinarySize)
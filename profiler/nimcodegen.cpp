@@ -0,0 +1,711 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+
+#include "nimcodegen.h"
+#include "nimbinarysize.h"
+#include "nimrustdemangler.h"
+
+#include "../nimconstants.h"
+#include "../project/nimbuildconfiguration.h"
+#include "../project/nimcompilerbuildstep.h"
+#include "../project/nimdatadirectory.h"
+#include "../project/nimpgopipeline.h"
+
+#include <coreplugin/messagemanager.h>
+#include <projectexplorer/project.h>
+#include <utils/qtcassert.h>
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QRegularExpression>
+#include <QSet>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <climits>
+
+using namespace Utils;
+
+namespace Nim {
+
+const int MAX_CACHED_OUTPUTS = 8;
+
+// Strings in assembler directives escape quotes, backslashes and other bytes as octal
+static QByteArray unquote(const QByteArray &quoted)
+{
+    QByteArray result;
+    for (int i = 1; i < quoted.size() && quoted.at(i) != '"'; ++i) {
+        if (quoted.at(i) != '\\' || i + 1 >= quoted.size()) {
+            result.append(quoted.at(i));
+            continue;
+        }
+        ++i;
+        int octal = 0;
+        int digits = 0;
+        while (digits < 3 && i < quoted.size() && quoted.at(i) >= '0' && quoted.at(i) <= '7') {
+            octal = octal * 8 + quoted.at(i++) - '0';
+            ++digits;
+        }
+        if (digits > 0) {
+            result.append(char(octal));
+            --i;
+        } else {
+            result.append(quoted.at(i));
+        }
+    }
+    return result;
+}
+
+static QString joinPath(const QByteArray &directory, const QByteArray &name)
+{
+    const QString file = QString::fromUtf8(name);
+    if (directory.isEmpty() || QDir::isAbsolutePath(file))
+        return QDir::cleanPath(file);
+    return QDir::cleanPath(QString::fromUtf8(directory) + '/' + file);
+}
+
+// Splits directive arguments, keeping quoted strings together
+static QList<QByteArray> arguments(const QByteArray &line)
+{
+    QList<QByteArray> result;
+    int i = 0;
+    while (i < line.size()) {
+        while (i < line.size() && (line.at(i) == ' ' || line.at(i) == '\t' || line.at(i) == ','))
+            ++i;
+        if (i >= line.size())
+            break;
+        const int start = i;
+        if (line.at(i) == '"') {
+            for (++i; i < line.size() && line.at(i) != '"'; ++i) {
+                if (line.at(i) == '\\')
+                    ++i;
+            }
+            ++i;
+        } else {
+            while (i < line.size() && line.at(i) != ' ' && line.at(i) != '\t' && line.at(i) != ',')
+                ++i;
+        }
+        result.append(line.mid(start, i - start));
+    }
+    return result;
+}
+
+// A function starts at the label of its symbol:
+//	.type	_ZN1p4main17ha86392753208aea0E,@function
+// _ZN1p4main17ha86392753208aea0E:
+//	.file	18 "/home/user/p" "src/main.rs"
+//	.loc	18 10 0
+//	pushq	%rbp
+QVector<NimCodegenFunction> NimCodegen::parseAssembly(const QByteArray &assembly)
+{
+    QVector<NimCodegenFunction> functions;
+    QHash<int, QString> files;
+    QSet<QByteArray> functionSymbols;
+    NimCodegenFunction *function = nullptr;
+    QString file;
+    int line = 0;
+
+    int start = 0;
+    while (start < assembly.size()) {
+        int end = assembly.indexOf('\n', start);
+        if (end < 0)
+            end = assembly.size();
+        const QByteArray text = assembly.mid(start, end - start);
+        start = end + 1;
+        if (text.isEmpty())
+            continue;
+
+        if (text.at(0) != '\t' && text.at(0) != ' ') {
+            const int colon = text.indexOf(':');
+            if (colon <= 0)
+                continue;
+            QByteArray label = text.left(colon);
+            if (label.startsWith('"'))
+                label = unquote(label);
+            if (functionSymbols.contains(label)) {
+                functions.append(NimCodegenFunction());
+                function = &functions.last();
+                function->name = NimRustDemangler::demangle(label);
+                file.clear();
+                line = 0;
+            } else if (function && label.startsWith(".Lfunc_end")) {
+                function = nullptr;
+            } else if (function && (!label.startsWith(".L") || label.startsWith(".LBB"))) {
+                // Basic blocks, but not the labels of the debug information
+                NimCodegenLine codeLine;
+                codeLine.text = QString::fromUtf8(label) + ':';
+                function->lines.append(codeLine);
+            }
+            continue;
+        }
+
+        const QByteArray trimmed = text.trimmed();
+        if (trimmed.startsWith(".type")) {
+            const QList<QByteArray> args = arguments(trimmed.mid(5));
+            if (args.size() == 2 && args.at(1).endsWith("function"))
+                functionSymbols.insert(args.at(0).startsWith('"') ? unquote(args.at(0)) : args.at(0));
+        } else if (trimmed.startsWith(".file\t") || trimmed.startsWith(".file ")) {
+            const QList<QByteArray> args = arguments(trimmed.mid(5));
+            bool ok = false;
+            const int index = args.value(0).toInt(&ok);
+            if (ok && args.size() >= 3 && args.at(2).startsWith('"'))
+                files.insert(index, joinPath(unquote(args.at(1)), unquote(args.at(2))));
+            else if (ok && args.size() >= 2)
+                files.insert(index, joinPath(QByteArray(), unquote(args.at(1))));
+        } else if (!function) {
+            continue;
+        } else if (trimmed.startsWith(".loc\t") || trimmed.startsWith(".loc ")) {
+            const QList<QByteArray> args = arguments(trimmed.mid(4));
+            file = files.value(args.value(0).toInt());
+            line = args.value(1).toInt();
+        } else if (!trimmed.startsWith('.') && !trimmed.startsWith('#')) {
+            NimCodegenLine codeLine;
+            codeLine.text = "    " + QString::fromUtf8(trimmed).replace('\t', ' ');
+            codeLine.file = line > 0 ? file : QString();
+            codeLine.line = line;
+            function->lines.append(codeLine);
+        }
+    }
+    return functions;
+}
+
+static QByteArray metadataField(const QByteArray &metadata, const char *name)
+{
+    const QByteArray key = QByteArray(name) + ": ";
+    int start = metadata.indexOf(key);
+    // Not the end of a longer field name like scopeLine
+    while (start > 0 && metadata.at(start - 1) != ' ' && metadata.at(start - 1) != '(')
+        start = metadata.indexOf(key, start + 1);
+    if (start < 0)
+        return QByteArray();
+    start += key.size();
+    if (start < metadata.size() && metadata.at(start) == '"')
+        return unquote(metadata.mid(start, metadata.indexOf('"', start + 1) + 1 - start));
+    int end = start;
+    while (end < metadata.size() && metadata.at(end) != ',' && metadata.at(end) != ')')
+        ++end;
+    return metadata.mid(start, end - start);
+}
+
+// LLVM IR names are quoted if they have characters like $, which are escaped as \XX
+static QByteArray irName(const QByteArray &text, int start)
+{
+    if (start >= text.size())
+        return QByteArray();
+    if (text.at(start) != '"') {
+        int end = start;
+        while (end < text.size() && text.at(end) != '(' && text.at(end) != ' ')
+            ++end;
+        return text.mid(start, end - start);
+    }
+    QByteArray name;
+    for (int i = start + 1; i < text.size() && text.at(i) != '"'; ++i) {
+        if (text.at(i) == '\\' && i + 2 < text.size()) {
+            name.append(char(text.mid(i + 1, 2).toInt(nullptr, 16)));
+            i += 2;
+        } else {
+            name.append(text.at(i));
+        }
+    }
+    return name;
+}
+
+// Instructions refer to their location by number:
+// define hidden void @_ZN1p4main17ha86392753208aea0E() unnamed_addr #0 !dbg !367 {
+//   %0 = load i64, ptr %self, align 8, !dbg !421
+// }
+// !421 = !DILocation(line: 1157, column: 15, scope: !422, inlinedAt: !425)
+// !422 = distinct !DILexicalBlock(scope: !367, file: !20, line: 1157, column: 9)
+// !20 = !DIFile(filename: "src/main.rs", directory: "/home/user/p")
+QVector<NimCodegenFunction> NimCodegen::parseLlvmIr(const QByteArray &ir)
+{
+    QVector<NimCodegenFunction> functions;
+    QVector<QVector<int>> locations;
+    QHash<int, QByteArray> metadata;
+    bool inFunction = false;
+
+    int start = 0;
+    while (start < ir.size()) {
+        int end = ir.indexOf('\n', start);
+        if (end < 0)
+            end = ir.size();
+        const QByteArray text = ir.mid(start, end - start);
+        start = end + 1;
+
+        if (inFunction) {
+            if (text == "}") {
+                inFunction = false;
+                continue;
+            }
+            // Debug intrinsics describe variables, not code
+            if (text.isEmpty() || text.contains("@llvm.dbg.") || text.contains("#dbg_"))
+                continue;
+            NimCodegenLine line;
+            int location = 0;
+            const int dbg = text.lastIndexOf(", !dbg !");
+            if (dbg >= 0) {
+                int numberEnd = dbg + 8;
+                while (numberEnd < text.size() && text.at(numberEnd) >= '0' && text.at(numberEnd) <= '9')
+                    ++numberEnd;
+                location = text.mid(dbg + 8, numberEnd - dbg - 8).toInt();
+                line.text = QString::fromUtf8(text.left(dbg) + text.mid(numberEnd));
+            } else {
+                line.text = QString::fromUtf8(text);
+            }
+            functions.last().lines.append(line);
+            locations.last().append(location);
+        } else if (text.startsWith("define ")) {
+            inFunction = text.endsWith('{');
+            const int at = text.indexOf('@');
+            if (!inFunction || at < 0)
+                continue;
+            functions.append(NimCodegenFunction());
+            functions.last().name = NimRustDemangler::demangle(irName(text, at + 1));
+            locations.append(QVector<int>());
+        } else if (text.startsWith('!')) {
+            const int equals = text.indexOf(" = ");
+            bool ok = false;
+            const int id = text.mid(1, equals - 1).toInt(&ok);
+            if (ok && (text.contains("!DILocation(") || text.contains("!DIFile(")
+                       || text.contains("!DISubprogram(") || text.contains("!DILexicalBlock"))) {
+                metadata.insert(id, text.mid(equals + 3));
+            }
+        }
+    }
+
+    auto reference = [](const QByteArray &field) {
+        return field.startsWith('!') ? field.mid(1).toInt() : -1;
+    };
+    QHash<int, QString> scopeFiles;
+    auto scopeFile = [&](int scope) {
+        auto it = scopeFiles.constFind(scope);
+        if (it != scopeFiles.constEnd())
+            return it.value();
+        const QByteArray file = metadata.value(reference(metadataField(metadata.value(scope), "file")));
+        const QString path = file.isEmpty() ? QString()
+                                            : joinPath(metadataField(file, "directory"),
+                                                       metadataField(file, "filename"));
+        scopeFiles.insert(scope, path);
+        return path;
+    };
+    for (int i = 0; i < functions.size(); ++i) {
+        QVector<NimCodegenLine> &lines = functions[i].lines;
+        for (int j = 0; j < lines.size(); ++j) {
+            // The outermost location is in the function itself
+            QByteArray location = metadata.value(locations.at(i).at(j));
+            for (int depth = 0; depth < 1000 && !location.isEmpty(); ++depth) {
+                const int inlinedAt = reference(metadataField(location, "inlinedAt"));
+                if (inlinedAt < 0)
+                    break;
+                location = metadata.value(inlinedAt);
+            }
+            if (location.isEmpty())
+                continue;
+            lines[j].line = metadataField(location, "line").toInt();
+            if (lines[j].line > 0)
+                lines[j].file = scopeFile(reference(metadataField(location, "scope")));
+        }
+    }
+    return functions;
+}
+
+// Closures belong to the function they are defined in
+static QString functionName(const QString &name)
+{
+    QString path = NimBinarySize::genericName(name);
+    static const QRegularExpression closure("::\\{\\{?closure(#\\d+)?\\}\\}?$");
+    while (path.contains(closure))
+        path.remove(closure);
+    return path.mid(path.lastIndexOf("::") + 2);
+}
+
+QVector<NimCodegenFunction> NimCodegen::find(const QVector<NimCodegenFunction> &functions,
+                                             const QString &name, const QString &file, int line)
+{
+    class Match
+    {
+    public:
+        int index;
+        bool containsLine;
+        int lines;
+    };
+    QVector<Match> byName;
+    QVector<Match> byLine;
+    const QString cleanFile = QDir::cleanPath(file);
+    for (int i = 0; i < functions.size(); ++i) {
+        int first = INT_MAX;
+        int last = 0;
+        for (const NimCodegenLine &codeLine : functions.at(i).lines) {
+            if (codeLine.line > 0 && codeLine.file == cleanFile) {
+                first = qMin(first, codeLine.line);
+                last = qMax(last, codeLine.line);
+            }
+        }
+        const Match match{i, first <= line && line <= last, first <= last ? last - first : INT_MAX};
+        if (!name.isEmpty() && functionName(functions.at(i).name) == name)
+            byName.append(match);
+        else if (match.containsLine)
+            byLine.append(match);
+    }
+
+    QVector<Match> &matches = byName.isEmpty() ? byLine : byName;
+    std::stable_sort(matches.begin(), matches.end(), [](const Match &a, const Match &b) {
+        if (a.containsLine != b.containsLine)
+            return a.containsLine;
+        return a.lines < b.lines;
+    });
+    QVector<NimCodegenFunction> result;
+    for (const Match &match : matches)
+        result.append(functions.at(match.index));
+    return result;
+}
+
+// NimCodegenInspector
+
+static FilePath packageManifest(const FilePath &file, const FilePath &projectDirectory)
+{
+    for (FilePath directory = file.parentDir(); directory.isChildOf(projectDirectory) || directory == projectDirectory;
+         directory = directory.parentDir()) {
+        const FilePath manifest = directory.pathAppended("Cargo.toml");
+        QFile manifestFile(manifest.toString());
+        if (manifestFile.open(QIODevice::ReadOnly) && manifestFile.readAll().contains("[package]"))
+            return manifest;
+        if (directory == projectDirectory)
+            break;
+    }
+    return FilePath();
+}
+
+static QString packageName(const FilePath &manifest)
+{
+    QFile file(manifest.toString());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return QString();
+    static const QRegularExpression name("^\\s*name\\s*=\\s*\"([^\"]+)\"");
+    bool inPackage = false;
+    while (!file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine());
+        if (line.startsWith('['))
+            inPackage = line.startsWith("[package]");
+        else if (inPackage) {
+            const QRegularExpressionMatch match = name.match(line);
+            if (match.hasMatch())
+                return match.captured(1);
+        }
+    }
+    return QString();
+}
+
+// Cargo keeps a fingerprint per compiled unit in <profile>/.fingerprint and
+// <triple>/<profile>/.fingerprint. Those of the other packages change
+// whenever a dependency is rebuilt, without reading its sources.
+static void addDependencyFingerprints(const FilePath &targetDirectory, const QString &package,
+                                      QCryptographicHash &hash)
+{
+    const QDir target(targetDirectory.toString());
+    QStringList fingerprintDirectories;
+    for (const QString &child : target.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) {
+        fingerprintDirectories.append(target.filePath(child + "/.fingerprint"));
+        const QDir nested(target.filePath(child));
+        for (const QString &profile : nested.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name))
+            fingerprintDirectories.append(nested.filePath(profile + "/.fingerprint"));
+    }
+    for (const QString &path : qAsConst(fingerprintDirectories)) {
+        const QDir fingerprints(path);
+        if (!fingerprints.exists())
+            continue;
+        // Units are called <package>-<hash>
+        for (const QString &unit : fingerprints.entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name)) {
+            if (unit.left(unit.lastIndexOf('-')) == package)
+                continue;
+            const QDir unitDirectory(fingerprints.filePath(unit));
+            for (const QString &name : unitDirectory.entryList(QDir::Files, QDir::Name)) {
+                // The other files are dependency lists, messages and timestamps
+                if (name.contains('.') || name.startsWith("dep-") || name.startsWith("output-"))
+                    continue;
+                QFile file(unitDirectory.filePath(name));
+                if (!file.open(QIODevice::ReadOnly))
+                    continue;
+                hash.addData(unit.toUtf8() + '/' + name.toUtf8() + '\0');
+                hash.addData(file.readAll());
+            }
+        }
+    }
+}
+
+NimCodegenInspector::NimCodegenInspector(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<NimCodegenView>();
+    connect(&m_sequence, &NimCommandSequence::message, this, [](const QString &message) {
+        Core::MessageManager::write(message);
+    });
+    connect(&m_watcher, &QFutureWatcher<Output>::finished, this, [this] {
+        const Output output = m_watcher.result();
+        if (!output.errorString.isEmpty()) {
+            emit failed(output.errorString);
+            return;
+        }
+        m_output = output;
+        show();
+    });
+    connect(&m_keyWatcher, &QFutureWatcher<QString>::finished, this, [this] {
+        emitCode(m_keyWatcher.result());
+    });
+}
+
+NimCodegenInspector::~NimCodegenInspector()
+{
+    m_keyWatcher.waitForFinished();
+    m_watcher.waitForFinished();
+}
+
+bool NimCodegenInspector::isRunning() const
+{
+    return m_sequence.isRunning() || m_keyWatcher.isRunning() || m_watcher.isRunning();
+}
+
+QStringList NimCodegenInspector::targetArguments(const FilePath &packageDirectory,
+                                                 const QString &packageName, const FilePath &file)
+{
+    const QStringList path = QDir(packageDirectory.toString()).relativeFilePath(file.toString()).split('/');
+    const QString target = path.size() == 2 ? QFileInfo(path.at(1)).completeBaseName() : path.value(1);
+    if (path.first() == "benches" && path.size() > 1)
+        return {"--bench", target};
+    if (path.first() == "examples" && path.size() > 1)
+        return {"--example", target};
+    if (path.first() == "tests" && path.size() > 1)
+        return {"--test", target};
+    if (path.first() == "src" && path.value(1) == "bin" && path.size() > 2)
+        return {"--bin", path.size() == 3 ? QFileInfo(path.at(2)).completeBaseName() : path.at(2)};
+    // Modules of the library, unless the package has none
+    if (path != QStringList({"src", "main.rs"}) && packageDirectory.pathAppended("src/lib.rs").exists())
+        return {"--lib"};
+    return {"--bin", packageName};
+}
+
+void NimCodegenInspector::inspect(NimBuildConfiguration *buildConfiguration, const FilePath &file,
+                                  int line, const QString &name)
+{
+    if (isRunning()) {
+        emit failed(tr("The generated code is still being looked up."));
+        return;
+    }
+    NimCompilerBuildStep *buildStep = buildConfiguration ? buildConfiguration->nimCompilerBuildStep() : nullptr;
+    QTC_ASSERT(buildStep, return);
+    const FilePath projectDirectory = buildConfiguration->project()->projectDirectory();
+    const FilePath manifest = packageManifest(file, projectDirectory);
+    const QString package = packageName(manifest);
+    if (package.isEmpty()) {
+        emit failed(tr("%1 does not belong to a package of the project.").arg(file.toUserOutput()));
+        return;
+    }
+    m_file = file;
+    m_line = line;
+    m_name = name;
+    m_package = package;
+    m_projectDirectory = projectDirectory;
+    m_codegenDirectory = NimDataDirectory::forBuildConfiguration(buildConfiguration).pathAppended("codegen");
+
+    m_command = buildStep->cargoCommand("rustc");
+    m_command.addArgs({"-p", package});
+    m_command.addArgs(targetArguments(manifest.parentDir(), package, file));
+    m_environment = buildStep->cargoEnvironment();
+
+    // Reading the sources takes a while on large packages
+    const FilePath packageDirectory = manifest.parentDir();
+    const FilePath buildDirectory = buildConfiguration->buildDirectory();
+    const FilePath targetDirectory = buildConfiguration->effectiveTargetDirectory();
+    const QByteArray settings = m_command.toUserOutput().toUtf8() + '\n'
+                                + m_environment.toStringList().join('\n').toUtf8();
+    m_keyWatcher.setFuture(QtConcurrent::run([packageDirectory, buildDirectory, targetDirectory,
+                                              package, settings] {
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(NimPgoPipeline::sourceHash(packageDirectory, buildDirectory).toUtf8());
+        addDependencyFingerprints(targetDirectory, package, hash);
+        hash.addData(settings);
+        return QString::fromLatin1(hash.result().toHex().left(16));
+    }));
+}
+
+void NimCodegenInspector::emitCode(const QString &key)
+{
+    if (key == m_output.key) {
+        show();
+        return;
+    }
+    const FilePath directory = m_codegenDirectory.pathAppended(key);
+    if (directory.pathAppended("code.s").exists() && directory.pathAppended("code.ll").exists()) {
+        parse(directory, key);
+        return;
+    }
+
+    // One codegen unit keeps all functions in one file, the line tables map them to the sources
+    QDir().mkpath(directory.toString());
+    CommandLine command = m_command;
+    command.addArgs({"--", "--emit=asm=" + directory.pathAppended("code.s").toString()
+                               + ",llvm-ir=" + directory.pathAppended("code.ll").toString(),
+                     "-C", "codegen-units=1", "-C", "debuginfo=1"});
+    m_sequence.setWorkingDirectory(m_projectDirectory);
+    m_sequence.setEnvironment(m_environment);
+    m_sequence.addCommand(command, [this, directory, key](const NimCommandResult &result) {
+        if (!result.success()) {
+            QDir(directory.toString()).removeRecursively();
+            return;
+        }
+        // Older outputs are for sources that have changed since
+        QDir codegen(directory.parentDir().toString());
+        const QFileInfoList outputs = codegen.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Time);
+        for (const QFileInfo &output : outputs.mid(MAX_CACHED_OUTPUTS))
+            QDir(output.absoluteFilePath()).removeRecursively();
+        parse(directory, key);
+    });
+    Core::MessageManager::write(tr("Emitting the assembly and LLVM IR of %1...").arg(m_package));
+    m_sequence.start();
+}
+
+void NimCodegenInspector::parse(const FilePath &directory, const QString &key)
+{
+    m_watcher.setFuture(QtConcurrent::run([directory, key] {
+        Output output;
+        output.key = key;
+        QFile assembly(directory.pathAppended("code.s").toString());
+        QFile ir(directory.pathAppended("code.ll").toString());
+        if (!assembly.open(QIODevice::ReadOnly) || !ir.open(QIODevice::ReadOnly)) {
+            output.errorString = QCoreApplication::translate("Nim::NimCodegenInspector",
+                                                             "Cargo did not emit the generated code to %1. "
+                                                             "Build the project and try again.")
+                                     .arg(directory.toUserOutput());
+            return output;
+        }
+        output.assembly = NimCodegen::parseAssembly(assembly.readAll());
+        output.llvmIr = NimCodegen::parseLlvmIr(ir.readAll());
+        return output;
+    }));
+}
+
+void NimCodegenInspector::show()
+{
+    NimCodegenView view;
+    view.sourceFile = QDir::cleanPath(m_file.toString());
+    view.sourceLine = m_line;
+    view.assembly = NimCodegen::find(m_output.assembly, m_name, view.sourceFile, m_line);
+    view.llvmIr = NimCodegen::find(m_output.llvmIr, m_name, view.sourceFile, m_line);
+    if (view.assembly.isEmpty() && view.llvmIr.isEmpty()) {
+        emit failed(tr("No code was generated for %1. Functions that are inlined everywhere or "
+                       "generic functions that are not used have no code of their own.")
+                        .arg(m_name.isEmpty() ? tr("line %1").arg(m_line) : m_name));
+        return;
+    }
+    emit finished(view);
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QTest>
+
+namespace Nim {
+
+// Trimmed from rustc 1.90 output for x86_64
+void RustPlugin::testCodegenParsers()
+{
+    const QByteArray assembly =
+            "\t.file\t\"p.ed43d3798304d1c1-cgu.0\"\n"
+            "\t.section\t.text._ZN1p4main17ha86392753208aea0E,\"ax\",@progbits\n"
+            "\t.type\t_ZN1p4main17ha86392753208aea0E,@function\n"
+            "_ZN1p4main17ha86392753208aea0E:\n"
+            ".Lfunc_begin7:\n"
+            "\t.file\t18 \"/tmp/p\" \"src/main.rs\"\n"
+            "\t.loc\t18 10 0\n"
+            "\t.cfi_startproc\n"
+            "\tpushq\t%rbp\n"
+            ".Ltmp77:\n"
+            "\t.file\t20 \"/rustc/lib/core/src\" \"option.rs\"\n"
+            "\t.loc\t20 1157 15 prologue_end\n"
+            "\tjno\t.LBB7_2\n"
+            "\t.p2align\t4\n"
+            ".LBB7_2:\n"
+            "\t.loc\t18 12 5\n"
+            "\tretq\n"
+            ".Lfunc_end7:\n"
+            "\t.size\t_ZN1p4main17ha86392753208aea0E, .Lfunc_end7-_ZN1p4main17ha86392753208aea0E\n";
+    const QVector<NimCodegenFunction> asmFunctions = NimCodegen::parseAssembly(assembly);
+    QCOMPARE(asmFunctions.size(), 1);
+    QCOMPARE(asmFunctions.first().name, QString("p::main"));
+    const QVector<NimCodegenLine> &asmLines = asmFunctions.first().lines;
+    QCOMPARE(asmLines.size(), 4);
+    QCOMPARE(asmLines.at(0).text, QString("    pushq %rbp"));
+    QCOMPARE(asmLines.at(0).file, QString("/tmp/p/src/main.rs"));
+    QCOMPARE(asmLines.at(0).line, 10);
+    QCOMPARE(asmLines.at(1).file, QString("/rustc/lib/core/src/option.rs"));
+    QCOMPARE(asmLines.at(1).line, 1157);
+    QCOMPARE(asmLines.at(2).text, QString(".LBB7_2:"));
+    QCOMPARE(asmLines.at(3).line, 12);
+
+    const QByteArray ir =
+            "define hidden void @\"_ZN1p4main28_$u7b$$u7b$closure$u7d$$u7d$17h9404786829d51665E\"() "
+            "unnamed_addr #0 !dbg !8 {\n"
+            "start:\n"
+            "  %0 = load i64, ptr %self, align 8, !dbg !21, !noundef !13\n"
+            "    #dbg_value(i64 %0, !30, !DIExpression(), !21)\n"
+            "  ret void, !dbg !22\n"
+            "}\n"
+            "declare void @llvm.lifetime.start.p0(i64 immarg, ptr nocapture)\n"
+            "!7 = !DIFile(filename: \"src/main.rs\", directory: \"/tmp/p\")\n"
+            "!8 = distinct !DISubprogram(name: \"main\", scope: !10, file: !7, line: 10, scopeLine: 10)\n"
+            "!9 = !DIFile(filename: \"/rustc/lib/core/src/option.rs\", directory: \"\")\n"
+            "!20 = distinct !DISubprogram(name: \"map\", scope: !10, file: !9, line: 1150, scopeLine: 1150)\n"
+            "!21 = !DILocation(line: 1157, column: 15, scope: !20, inlinedAt: !23)\n"
+            "!22 = !DILocation(line: 12, column: 2, scope: !8)\n"
+            "!23 = distinct !DILocation(line: 11, column: 23, scope: !8)\n";
+    const QVector<NimCodegenFunction> irFunctions = NimCodegen::parseLlvmIr(ir);
+    QCOMPARE(irFunctions.size(), 1);
+    QCOMPARE(irFunctions.first().name, QString("p::main::{{closure}}"));
+    const QVector<NimCodegenLine> &irLines = irFunctions.first().lines;
+    QCOMPARE(irLines.size(), 3);
+    QCOMPARE(irLines.at(1).text, QString("  %0 = load i64, ptr %self, align 8, !noundef !13"));
+    QCOMPARE(irLines.at(1).file, QString("/tmp/p/src/main.rs"));
+    QCOMPARE(irLines.at(1).line, 11);
+    QCOMPARE(irLines.at(2).line, 12);
+
+    // Closures belong to the function they are defined in
+    QCOMPARE(NimCodegen::find(irFunctions, "main", "/tmp/p/src/main.rs", 1).size(), 1);
+    QCOMPARE(NimCodegen::find(irFunctions, "other", "/tmp/p/src/main.rs", 11).size(), 1);
+    QCOMPARE(NimCodegen::find(irFunctions, "other", "/tmp/p/src/main.rs", 20).size(), 0);
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
@@ -0,0 +1,137 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+
+#pragma once
+
+#include "../project/nimcommandsequence.h"
+
+#include <utils/environment.h>
+#include <utils/fileutils.h>
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QVector>
+
+namespace Nim {
+
+class NimBuildConfiguration;
+
+class NimCodegenLine
+{
+public:
+    QString text;
+    QString file;  // empty without debug information
+    int line = 0;
+};
+
+class NimCodegenFunction
+{
+public:
+    QString name;  // demangled
+    QVector<NimCodegenLine> lines;
+};
+
+// Splits the output of rustc's --emit=asm and --emit=llvm-ir into functions
+// with the source line each line of code was generated from. For assembly
+// that is the line of the inlined function, for LLVM IR the line of the
+// call that was inlined.
+class NimCodegen
+{
+public:
+    static QVector<NimCodegenFunction> parseAssembly(const QByteArray &assembly);
+    static QVector<NimCodegenFunction> parseLlvmIr(const QByteArray &ir);
+
+    // The functions called name, or else those generated from the line,
+    // the ones containing the line first
+    static QVector<NimCodegenFunction> find(const QVector<NimCodegenFunction> &functions,
+                                            const QString &name, const QString &file, int line);
+};
+
+class NimCodegenView
+{
+public:
+    QString sourceFile;
+    int sourceLine = 0;
+    QVector<NimCodegenFunction> assembly;
+    QVector<NimCodegenFunction> llvmIr;
+};
+
+// Emits the assembly and LLVM IR of the crate a source file belongs to with
+// the flags of the build and looks up the functions at a line. The output
+// is kept per fingerprint of the package's sources, its dependencies and
+// the flags, so only the first lookup after a change compiles.
+class NimCodegenInspector : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NimCodegenInspector(QObject *parent = nullptr);
+    ~NimCodegenInspector() override;
+
+    bool isRunning() const;
+    void inspect(NimBuildConfiguration *buildConfiguration, const Utils::FilePath &file, int line,
+                 const QString &name);
+
+    // The cargo rustc target options for the target the file belongs to
+    static QStringList targetArguments(const Utils::FilePath &packageDirectory,
+                                       const QString &packageName, const Utils::FilePath &file);
+
+signals:
+    void finished(const Nim::NimCodegenView &view);
+    void failed(const QString &message);
+
+private:
+    class Output
+    {
+    public:
+        QString key;
+        QVector<NimCodegenFunction> assembly;
+        QVector<NimCodegenFunction> llvmIr;
+        QString errorString;
+    };
+
+    void emitCode(const QString &key);
+    void parse(const Utils::FilePath &directory, const QString &key);
+    void show();
+
+    NimCommandSequence m_sequence;
+    QFutureWatcher<QString> m_keyWatcher;
+    QFutureWatcher<Output> m_watcher;
+    Output m_output;
+    Utils::FilePath m_file;
+    int m_line = 0;
+    QString m_name;
+    QString m_package;
+    Utils::FilePath m_projectDirectory;
+    Utils::FilePath m_codegenDirectory;
+    Utils::CommandLine m_command;
+    Utils::Environment m_environment;
+};
+
+} // namespace Nim
+
+Q_DECLARE_METATYPE(Nim::NimCodegenView)
@@ -0,0 +1,199 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+
+#include "nimcodegenwidget.h"
+
+#include <texteditor/fontsettings.h>
+#include <texteditor/texteditorsettings.h>
+
+#include <QComboBox>
+#include <QFile>
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QSplitter>
+#include <QTextBlock>
+
+namespace Nim {
+
+enum CodeKind { AssemblyCode, LlvmIrCode };
+
+static QTextEdit::ExtraSelection lineSelection(QPlainTextEdit *edit, int blockNumber)
+{
+    QTextEdit::ExtraSelection selection;
+    selection.cursor = QTextCursor(edit->document()->findBlockByNumber(blockNumber));
+    selection.format.setBackground(QColor(255, 236, 139));
+    selection.format.setForeground(Qt::black);
+    selection.format.setProperty(QTextFormat::FullWidthSelection, true);
+    return selection;
+}
+
+// Moves the cursor without selecting anything, with the line in the middle
+static void showLine(QPlainTextEdit *edit, int blockNumber)
+{
+    edit->setTextCursor(QTextCursor(edit->document()->findBlockByNumber(blockNumber)));
+    edit->centerCursor();
+}
+
+NimCodegenWidget::NimCodegenWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_functionComboBox(new QComboBox)
+    , m_kindComboBox(new QComboBox)
+    , m_locationLabel(new QLabel)
+    , m_source(new QPlainTextEdit)
+    , m_code(new QPlainTextEdit)
+{
+    m_functionComboBox->setToolTip(tr("Function"));
+    m_functionComboBox->setSizeAdjustPolicy(QComboBox::AdjustToMinimumContentsLengthWithIcon);
+    m_functionComboBox->setMinimumContentsLength(40);
+    m_kindComboBox->addItem(tr("Assembly"), AssemblyCode);
+    m_kindComboBox->addItem(tr("LLVM IR"), LlvmIrCode);
+    m_locationLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+
+    const QFont font = TextEditor::TextEditorSettings::fontSettings().font();
+    for (QPlainTextEdit *edit : {m_source, m_code}) {
+        edit->setReadOnly(true);
+        edit->setLineWrapMode(QPlainTextEdit::NoWrap);
+        edit->setFont(font);
+        // Keep the cursor visible to show where the highlighting comes from
+        edit->setTextInteractionFlags(Qt::TextSelectableByMouse | Qt::TextSelectableByKeyboard);
+    }
+
+    auto splitter = new QSplitter;
+    splitter->addWidget(m_source);
+    splitter->addWidget(m_code);
+    auto toolBar = new QHBoxLayout;
+    toolBar->addWidget(m_functionComboBox, 1);
+    toolBar->addWidget(m_kindComboBox);
+    toolBar->addWidget(m_locationLabel, 1);
+    auto layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(toolBar);
+    layout->addWidget(splitter);
+
+    connect(m_kindComboBox, QOverload<int>::of(&QComboBox::activated), this, [this] {
+        updateFunctions();
+    });
+    connect(m_functionComboBox, QOverload<int>::of(&QComboBox::activated), this, &NimCodegenWidget::updateCode);
+    connect(m_code, &QPlainTextEdit::cursorPositionChanged, this, &NimCodegenWidget::highlightSource);
+    connect(m_source, &QPlainTextEdit::cursorPositionChanged, this, &NimCodegenWidget::highlightCode);
+}
+
+void NimCodegenWidget::setView(const NimCodegenView &view)
+{
+    m_view = view;
+    QFile file(view.sourceFile);
+    m_source->setPlainText(file.open(QIODevice::ReadOnly | QIODevice::Text) ? QString::fromUtf8(file.readAll())
+                                                                             : QString());
+    // Assembly shows best whether loops were vectorized and checks removed
+    m_kindComboBox->setCurrentIndex(view.assembly.isEmpty() ? LlvmIrCode : AssemblyCode);
+    updateFunctions();
+}
+
+void NimCodegenWidget::clear()
+{
+    setView(NimCodegenView());
+}
+
+const QVector<NimCodegenFunction> &NimCodegenWidget::functions() const
+{
+    return m_kindComboBox->currentData().toInt() == LlvmIrCode ? m_view.llvmIr : m_view.assembly;
+}
+
+void NimCodegenWidget::updateFunctions()
+{
+    m_functionComboBox->clear();
+    for (const NimCodegenFunction &function : functions())
+        m_functionComboBox->addItem(function.name);
+    updateCode();
+}
+
+void NimCodegenWidget::updateCode()
+{
+    const int index = m_functionComboBox->currentIndex();
+    QStringList text;
+    if (index >= 0 && index < functions().size()) {
+        for (const NimCodegenLine &line : functions().at(index).lines)
+            text.append(line.text);
+    }
+    m_synchronizing = true;
+    m_code->setPlainText(text.join('\n'));
+    m_synchronizing = false;
+    showLine(m_source, m_view.sourceLine - 1);
+}
+
+void NimCodegenWidget::highlightSource()
+{
+    if (m_synchronizing)
+        return;
+    const int index = m_functionComboBox->currentIndex();
+    const int block = m_code->textCursor().blockNumber();
+    m_code->setExtraSelections({});
+    m_source->setExtraSelections({});
+    m_locationLabel->clear();
+    if (index < 0 || index >= functions().size() || block >= functions().at(index).lines.size())
+        return;
+    const NimCodegenLine &line = functions().at(index).lines.at(block);
+    if (line.line == 0)
+        return;
+    if (line.file != m_view.sourceFile) {
+        m_locationLabel->setText(QString("%1:%2").arg(QFileInfo(line.file).fileName()).arg(line.line));
+        m_locationLabel->setToolTip(QString("%1:%2").arg(line.file).arg(line.line));
+        return;
+    }
+    m_synchronizing = true;
+    m_source->setExtraSelections({lineSelection(m_source, line.line - 1)});
+    showLine(m_source, line.line - 1);
+    m_synchronizing = false;
+}
+
+void NimCodegenWidget::highlightCode()
+{
+    if (m_synchronizing)
+        return;
+    const int index = m_functionComboBox->currentIndex();
+    const int sourceLine = m_source->textCursor().blockNumber() + 1;
+    m_source->setExtraSelections({});
+    m_locationLabel->clear();
+    QList<QTextEdit::ExtraSelection> selections;
+    if (index >= 0 && index < functions().size()) {
+        const QVector<NimCodegenLine> &lines = functions().at(index).lines;
+        for (int i = 0; i < lines.size(); ++i) {
+            if (lines.at(i).line == sourceLine && lines.at(i).file == m_view.sourceFile)
+                selections.append(lineSelection(m_code, i));
+        }
+    }
+    m_code->setExtraSelections(selections);
+    if (selections.isEmpty())
+        return;
+    m_synchronizing = true;
+    showLine(m_code, selections.first().cursor.blockNumber());
+    m_synchronizing = false;
+}
+
+} // namespace Nim
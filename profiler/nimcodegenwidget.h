@@ -0,0 +1,71 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+
+#pragma once
+
+#include "nimcodegen.h"
+
+#include <QWidget>
+
+QT_BEGIN_NAMESPACE
+class QComboBox;
+class QLabel;
+class QPlainTextEdit;
+QT_END_NAMESPACE
+
+namespace Nim {
+
+// Shows the assembly or LLVM IR of functions next to their source. Moving
+// the cursor on either side highlights the lines it maps to on the other,
+// code from other files, like inlined library functions, names its location.
+class NimCodegenWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit NimCodegenWidget(QWidget *parent = nullptr);
+
+    void setView(const NimCodegenView &view);
+    void clear();
+
+private:
+    const QVector<NimCodegenFunction> &functions() const;
+    void updateFunctions();
+    void updateCode();
+    void highlightSource();
+    void highlightCode();
+
+    NimCodegenView m_view;
+    QComboBox *m_functionComboBox;
+    QComboBox *m_kindComboBox;
+    QLabel *m_locationLabel;
+    QPlainTextEdit *m_source;
+    QPlainTextEdit *m_code;
+    bool m_synchronizing = false;
+};
+
+} // namespace Nim
@@ -0,0 +1,292 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimcounters.h"
+#include "nimbenchmarks.h"
+#include "nimperfrecorder.h"
+
+#include "../project/nimdatadirectory.h"
+#include "../project/nimrunconfiguration.h"
+
+#include <coreplugin/messagemanager.h>
+#include <projectexplorer/runconfiguration.h>
+#include <projectexplorer/target.h>
+#include <utils/qtcprocess.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QLocale>
+
+using namespace ProjectExplorer;
+using namespace Utils;
+
+namespace Nim {
+
+// NimCounters
+
+QStringList NimCounters::events()
+{
+    return {"task-clock", "page-faults", "cycles", "instructions", "branches", "branch-misses",
+            "cache-references", "cache-misses", "L1-dcache-loads", "L1-dcache-load-misses"};
+}
+
+QMap<QString, double> NimCounters::parseStatOutput(const QString &output)
+{
+    // <count>,<unit>,<event>,<time counted>,<share of the time counted>,...
+    // with events like "instructions:u" or "cpu_core/instructions/u"
+    QMap<QString, double> counters;
+    for (const QString &line : output.split('\n')) {
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+        const QStringList fields = line.split(',');
+        if (fields.size() < 3)
+            continue;
+        bool ok = false;
+        const double count = fields.at(0).toDouble(&ok);
+        if (!ok)  // <not counted> or <not supported>
+            continue;
+        QString event = fields.at(2);
+        if (event.count('/') >= 2)
+            event = event.section('/', 1, 1);
+        event = event.section(':', 0, 0);
+        if (!event.isEmpty())
+            counters[event] += count;
+    }
+    return counters;
+}
+
+FilePath NimCounters::historyFile(RunConfiguration *runConfiguration)
+{
+    return NimDataDirectory::forRunConfiguration(runConfiguration, "counters", ".history");
+}
+
+QVector<NimCounterRun> NimCounters::readHistory(const FilePath &path)
+{
+    QVector<NimCounterRun> history;
+    QFile file(path.toString());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return history;
+    while (!file.atEnd()) {
+        const QStringList fields = QString::fromUtf8(file.readLine()).trimmed().split('\t');
+        NimCounterRun run;
+        run.finished = QDateTime::fromString(fields.first(), Qt::ISODate);
+        if (!run.finished.isValid())
+            continue;
+        for (int i = 1; i < fields.size(); ++i) {
+            const int separator = fields.at(i).lastIndexOf('=');
+            if (separator > 0)
+                run.counters.insert(fields.at(i).left(separator), fields.at(i).mid(separator + 1).toDouble());
+        }
+        history.append(run);
+    }
+    return history;
+}
+
+bool NimCounters::appendToHistory(const FilePath &path, const NimCounterRun &run)
+{
+    QDir().mkpath(path.parentDir().toString());
+    QFile file(path.toString());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+        return false;
+    QByteArray line = run.finished.toString(Qt::ISODate).toUtf8();
+    for (auto it = run.counters.cbegin(); it != run.counters.cend(); ++it)
+        line += '\t' + it.key().toUtf8() + '=' + QByteArray::number(it.value(), 'f', 0);
+    return file.write(line + '\n') == line.size() + 1;
+}
+
+static double ratio(const NimCounterRun &run, const QString &event, const QString &base)
+{
+    const double count = run.counters.value(event, -1);
+    const double baseCount = run.counters.value(base, -1);
+    return count >= 0 && baseCount > 0 ? count / baseCount : -1;
+}
+
+static QString change(double value, double before)
+{
+    if (value < 0 || before <= 0)
+        return QString();
+    return QString(" (%1%2%)").arg(value >= before ? "+" : "").arg(100 * (value - before) / before, 0, 'f', 1);
+}
+
+QStringList NimCounters::summary(const NimCounterRun &run, const NimCounterRun *previous)
+{
+    auto tr = [](const char *text) { return QCoreApplication::translate("Nim::NimCounters", text); };
+    // The ratio of an event to its base tells more than the counts, which
+    // grow with the work done
+    struct Row {
+        QString event;
+        QString title;
+        QString base;
+        QString ratioText;
+        bool percent;
+    };
+    const QVector<Row> rows = {
+        {"instructions", tr("Instructions:"), "cycles", tr("%1 per cycle"), false},
+        {"cycles", tr("Cycles:"), QString(), QString(), false},
+        {"branch-misses", tr("Branch misses:"), "branches", tr("%1% of the branches"), true},
+        {"cache-misses", tr("Cache misses:"), "cache-references", tr("%1% of the references"), true},
+        {"L1-dcache-load-misses", tr("L1 data misses:"), "L1-dcache-loads", tr("%1% of the loads"), true},
+        {"page-faults", tr("Page faults:"), QString(), QString(), false},
+    };
+
+    QStringList lines;
+    const QLocale locale = QLocale::system();
+    for (const Row &row : rows) {
+        const double count = run.counters.value(row.event, -1);
+        if (count < 0)
+            continue;
+        QString line = QString("%1 %2").arg(row.title, -16).arg(locale.toString(qint64(count)), 16);
+        if (previous)
+            line += change(count, previous->counters.value(row.event, -1));
+        const double value = row.base.isEmpty() ? -1 : ratio(run, row.event, row.base);
+        if (value >= 0) {
+            line += ", " + row.ratioText.arg(row.percent ? 100 * value : value, 0, 'f', 2);
+            const double before = previous ? ratio(*previous, row.event, row.base) : -1;
+            if (before >= 0) {
+                line += tr(" (was %1)").arg(QString::number(row.percent ? 100 * before : before, 'f', 2)
+                                            + (row.percent ? "%" : ""));
+            }
+        }
+        lines << line;
+    }
+    const double milliseconds = run.counters.value("task-clock", -1);
+    if (milliseconds >= 0) {
+        QString line = QString("%1 %2").arg(tr("CPU time:"), -16)
+                .arg(NimBenchmarks::formatDuration(milliseconds * 1e6), 16);
+        if (previous)
+            line += change(milliseconds, previous->counters.value("task-clock", -1));
+        lines << line;
+    }
+    return lines;
+}
+
+// NimPerfStatRunner
+
+NimPerfStatRunner::NimPerfStatRunner(RunControl *runControl)
+    : SimpleTargetRunner(runControl)
+{
+    setId("NimPerfStatRunner");
+
+    setStarter([this, runControl] {
+        const FilePath perf = NimPerfRecordings::perfExecutable();
+        if (perf.isEmpty()) {
+            reportFailure(tr("perf was not found in PATH."));
+            return;
+        }
+        const FilePath history = NimCounters::historyFile(runControl->runConfiguration());
+        QDir().mkpath(history.parentDir().toString());
+        m_output = history.stringAppended(".stat");
+        QFile::remove(m_output.toString());
+
+        // Appending, since cargo bench may run perf stat more than once
+        const QStringList stat = {"stat", "-x", ",", "--append", "-o", m_output.toString(),
+                                  "-e", NimCounters::events().join(',')};
+        Runnable runnable = runControl->runnable();
+        if (qobject_cast<NimBenchRunConfiguration *>(runControl->runConfiguration())) {
+            QStringList runner = QStringList(perf.toString()) + stat + QStringList("--");
+            for (QString &argument : runner)
+                argument = '"' + argument.replace('\\', "\\\\").replace('"', "\\\"") + '"';
+            CommandLine command(runnable.executable,
+                                {"--config", "target.'cfg(all())'.runner=[" + runner.join(',') + ']'});
+            command.addArgs(runnable.commandLineArguments, CommandLine::Raw);
+            runnable.commandLineArguments = command.arguments();
+        } else {
+            CommandLine command(perf, stat);
+            command.addArgs({"--", runnable.executable.toString()});
+            command.addArgs(runnable.commandLineArguments, CommandLine::Raw);
+            runnable.executable = perf;
+            runnable.commandLineArguments = command.arguments();
+        }
+        doStart(runnable, device());
+    });
+
+    connect(this, &RunWorker::stopped, this, [this, runControl] {
+        QFile file(m_output.toString());
+        NimCounterRun run;
+        run.finished = QDateTime::currentDateTime();
+        if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+            run.counters = NimCounters::parseStatOutput(QString::fromUtf8(file.readAll()));
+        if (run.counters.isEmpty()) {
+            Core::MessageManager::write(tr("perf stat did not count any events for %1.")
+                                            .arg(runControl->displayName()));
+            return;
+        }
+        const FilePath history = NimCounters::historyFile(runControl->runConfiguration());
+        const QVector<NimCounterRun> previous = NimCounters::readHistory(history);
+        if (!NimCounters::appendToHistory(history, run))
+            Core::MessageManager::write(tr("Could not write %1.").arg(history.toUserOutput()));
+        const QStringList summary = NimCounters::summary(run, previous.isEmpty() ? nullptr
+                                                                                 : &previous.last());
+        appendMessage(tr("Counters of %1, with the change since the previous run:")
+                          .arg(runControl->displayName()) + '\n' + summary.join('\n') + '\n',
+                      NormalMessageFormat);
+    });
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QTest>
+
+namespace Nim {
+
+void RustPlugin::testCounterParser()
+{
+    const QString output = QString::fromUtf8(
+                "# started on Mon Jan  1 12:00:00 2024\n"
+                "\n"
+                "12.50,msec,task-clock:u,12500000,100.00,0.950,CPUs utilized\n"
+                "120,,page-faults:u,12500000,100.00,9.600,K/sec\n"
+                "30000000,,cpu_core/cycles/u,10000000,80.00,,\n"
+                "10000000,,cpu_atom/cycles/u,2500000,20.00,,\n"
+                "80000000,,cpu_core/instructions/u,10000000,80.00,2.00,insn per cycle\n"
+                "<not counted>,,cpu_atom/instructions/u,0,0.00,,\n"
+                "<not supported>,,L1-dcache-loads:u,0,100.00,,\n"
+                "# started on Mon Jan  1 12:00:01 2024\n"
+                "120,,page-faults:u,12500000,100.00,9.600,K/sec\n");
+    const QMap<QString, double> counters = NimCounters::parseStatOutput(output);
+    QCOMPARE(counters.value("task-clock"), 12.5);
+    QCOMPARE(counters.value("page-faults"), 240.0);
+    QCOMPARE(counters.value("cycles"), 4e7);
+    QCOMPARE(counters.value("instructions"), 8e7);
+    QVERIFY(!counters.contains("L1-dcache-loads"));
+
+    NimCounterRun previous;
+    previous.counters = counters;
+    NimCounterRun run = previous;
+    run.counters["cycles"] = 2e7;
+    const QStringList summary = NimCounters::summary(run, &previous);
+    QVERIFY(summary.first().contains("4.00 per cycle (was 2.00)"));
+    QVERIFY(summary.at(1).contains("(-50.0%)"));
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
@@ -0,0 +1,83 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include <projectexplorer/runcontrol.h>
+#include <utils/fileutils.h>
+
+#include <QDateTime>
+#include <QMap>
+#include <QVector>
+
+namespace Nim {
+
+// The counts of one run, by perf event name
+class NimCounterRun
+{
+public:
+    QDateTime finished;
+    QMap<QString, double> counters;
+};
+
+// Hardware and software counters from perf stat, kept per run configuration
+// in <data directory>/counters/<name>.history, one run per line:
+//   <finished> <event>=<count> <event>=<count> ...
+class NimCounters
+{
+public:
+    static QStringList events();
+
+    // Parses the output of perf stat -x, and adds up the counts of an event
+    // on the core types of hybrid CPUs and over several runs
+    static QMap<QString, double> parseStatOutput(const QString &output);
+
+    static Utils::FilePath historyFile(ProjectExplorer::RunConfiguration *runConfiguration);
+    // Oldest run first
+    static QVector<NimCounterRun> readHistory(const Utils::FilePath &path);
+    static bool appendToHistory(const Utils::FilePath &path, const NimCounterRun &run);
+
+    // The counts with the ratios that explain them, like instructions per
+    // cycle or the share of missed branches, and their change since the
+    // previous run
+    static QStringList summary(const NimCounterRun &run, const NimCounterRun *previous);
+};
+
+// Runs a run configuration under perf stat and prints the counters when it
+// has finished. Bench run configurations get perf stat as cargo's runner, so
+// that building the benchmarks is not counted.
+class NimPerfStatRunner : public ProjectExplorer::SimpleTargetRunner
+{
+    Q_OBJECT
+
+public:
+    explicit NimPerfStatRunner(ProjectExplorer::RunControl *runControl);
+
+private:
+    Utils::FilePath m_output;
+};
+
+} // namespace Nim
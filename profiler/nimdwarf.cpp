@@ -0,0 +1,766 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimdwarf.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace Nim {
+
+namespace {
+
+enum Tag : uint64_t {
+    TagInlinedSubroutine = 0x1d,
+};
+
+enum Attribute : uint64_t {
+    AtLowPc = 0x11,
+    AtHighPc = 0x12,
+    AtStmtList = 0x10,
+    AtCompDir = 0x1b,
+    AtRanges = 0x55,
+    AtCallFile = 0x58,
+    AtCallLine = 0x59,
+    AtStrOffsetsBase = 0x72,
+    AtAddrBase = 0x73,
+    AtRnglistsBase = 0x74,
+};
+
+enum Form : uint64_t {
+    FormAddr = 0x01, FormBlock2 = 0x03, FormBlock4 = 0x04, FormData2 = 0x05, FormData4 = 0x06,
+    FormData8 = 0x07, FormString = 0x08, FormBlock = 0x09, FormBlock1 = 0x0a, FormData1 = 0x0b,
+    FormFlag = 0x0c, FormSdata = 0x0d, FormStrp = 0x0e, FormUdata = 0x0f, FormRefAddr = 0x10,
+    FormRef1 = 0x11, FormRef2 = 0x12, FormRef4 = 0x13, FormRef8 = 0x14, FormRefUdata = 0x15,
+    FormIndirect = 0x16, FormSecOffset = 0x17, FormExprloc = 0x18, FormFlagPresent = 0x19,
+    FormStrx = 0x1a, FormAddrx = 0x1b, FormRefSup4 = 0x1c, FormStrpSup = 0x1d, FormData16 = 0x1e,
+    FormLineStrp = 0x1f, FormRefSig8 = 0x20, FormImplicitConst = 0x21, FormLoclistx = 0x22,
+    FormRnglistx = 0x23, FormRefSup8 = 0x24, FormStrx1 = 0x25, FormStrx2 = 0x26, FormStrx3 = 0x27,
+    FormStrx4 = 0x28, FormAddrx1 = 0x29, FormAddrx2 = 0x2a, FormAddrx3 = 0x2b, FormAddrx4 = 0x2c,
+};
+
+enum UnitType : uint64_t {
+    UnitCompile = 0x01,
+    UnitType = 0x02,
+    UnitPartial = 0x03,
+    UnitSkeleton = 0x04,
+    UnitSplitCompile = 0x05,
+    UnitSplitType = 0x06,
+};
+
+enum LineContentType : uint64_t {
+    LineContentPath = 0x1,
+    LineContentDirectoryIndex = 0x2,
+};
+
+class Reader
+{
+public:
+    Reader(const NimDwarfSection &section, uint64_t offset = 0)
+        : m_data(section.data), m_size(section.size), m_position(offset)
+    {
+        if (offset > m_size)
+            m_error = true;
+    }
+
+    bool ok() const { return !m_error; }
+    uint64_t position() const { return m_position; }
+    void seek(uint64_t position)
+    {
+        m_position = position;
+        if (position > m_size)
+            m_error = true;
+    }
+
+    uint64_t fixed(int bytes)
+    {
+        if (m_error || m_position + bytes > m_size) {
+            m_error = true;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i)
+            value |= uint64_t(uint8_t(m_data[m_position + i])) << (8 * i);
+        m_position += bytes;
+        return value;
+    }
+
+    uint64_t uleb()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; ; shift += 7) {
+            const uint64_t byte = fixed(1);
+            if (m_error)
+                return 0;
+            if (shift < 64)
+                value |= (byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+    }
+
+    int64_t sleb()
+    {
+        int64_t value = 0;
+        int shift = 0;
+        uint64_t byte = 0;
+        do {
+            byte = fixed(1);
+            if (m_error)
+                return 0;
+            if (shift < 64)
+                value |= int64_t(byte & 0x7f) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        if (shift < 64 && (byte & 0x40))
+            value |= -(int64_t(1) << shift);
+        return value;
+    }
+
+    const char *string()
+    {
+        const char *begin = m_data + m_position;
+        while (!m_error && fixed(1) != 0) {}
+        return m_error ? "" : begin;
+    }
+
+    void skip(uint64_t bytes)
+    {
+        if (m_position + bytes > m_size || m_position + bytes < m_position)
+            m_error = true;
+        else
+            m_position += bytes;
+    }
+
+    // Reads the length of a unit, which also tells whether the unit is in
+    // the 64-bit DWARF format. Returns the end of the unit.
+    uint64_t unitLength(bool *dwarf64)
+    {
+        uint64_t length = fixed(4);
+        *dwarf64 = length == 0xffffffff;
+        if (*dwarf64)
+            length = fixed(8);
+        const uint64_t end = m_position + length;
+        if (end > m_size || end < m_position)
+            m_error = true;
+        return end;
+    }
+
+private:
+    const char *m_data;
+    uint64_t m_size;
+    uint64_t m_position;
+    bool m_error = false;
+};
+
+static const char *stringAt(const NimDwarfSection &section, uint64_t offset)
+{
+    if (offset >= section.size)
+        return "";
+    // Sections end with a terminating zero, anything else is corrupt
+    const void *end = memchr(section.data + offset, 0, section.size - offset);
+    return end ? section.data + offset : "";
+}
+
+class AttributeSpec
+{
+public:
+    uint64_t name;
+    uint64_t form;
+    int64_t implicitConst;
+};
+
+class Abbreviation
+{
+public:
+    uint64_t tag = 0;
+    bool hasChildren = false;
+    std::vector<AttributeSpec> attributes;
+};
+
+class FormValue
+{
+public:
+    uint64_t form = 0;
+    uint64_t value = 0;
+    const char *string = nullptr;
+};
+
+static bool isConstantForm(uint64_t form)
+{
+    switch (form) {
+    case FormData1: case FormData2: case FormData4: case FormData8:
+    case FormSdata: case FormUdata: case FormImplicitConst:
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+class NimDwarfUnit
+{
+public:
+    uint64_t end = 0;
+    int version = 0;
+    bool dwarf64 = false;
+    int addressSize = 8;
+    uint64_t abbrevOffset = 0;
+    uint64_t diesOffset = 0;
+    uint64_t strOffsetsBase = 0;
+    uint64_t addrBase = 0;
+    uint64_t rnglistsBase = 0;
+    uint64_t baseAddress = 0;
+    std::string compDir;
+    std::vector<int> fileIds;  // by the file numbers of the unit's line program
+    std::unordered_map<uint64_t, Abbreviation> abbreviations;
+};
+
+using Unit = NimDwarfUnit;
+
+static bool readForm(Reader &reader, uint64_t form, int64_t implicitConst, const Unit &unit,
+                     const NimDwarfSections &sections, FormValue &value)
+{
+    value.form = form;
+    value.string = nullptr;
+    const int offsetSize = unit.dwarf64 ? 8 : 4;
+    switch (form) {
+    case FormAddr: value.value = reader.fixed(unit.addressSize); break;
+    case FormData1: case FormRef1: case FormFlag: case FormStrx1: case FormAddrx1:
+        value.value = reader.fixed(1); break;
+    case FormData2: case FormRef2: case FormStrx2: case FormAddrx2:
+        value.value = reader.fixed(2); break;
+    case FormStrx3: case FormAddrx3: value.value = reader.fixed(3); break;
+    case FormData4: case FormRef4: case FormRefSup4: case FormStrx4: case FormAddrx4:
+        value.value = reader.fixed(4); break;
+    case FormData8: case FormRef8: case FormRefSig8: case FormRefSup8:
+        value.value = reader.fixed(8); break;
+    case FormData16: reader.skip(16); break;
+    case FormSdata: value.value = uint64_t(reader.sleb()); break;
+    case FormUdata: case FormRefUdata: case FormStrx: case FormAddrx:
+    case FormLoclistx: case FormRnglistx:
+        value.value = reader.uleb(); break;
+    case FormString: value.string = reader.string(); break;
+    case FormStrp: value.string = stringAt(sections.str, reader.fixed(offsetSize)); break;
+    case FormLineStrp: value.string = stringAt(sections.lineStr, reader.fixed(offsetSize)); break;
+    case FormStrpSup: case FormSecOffset: value.value = reader.fixed(offsetSize); break;
+    case FormRefAddr: value.value = reader.fixed(unit.version <= 2 ? unit.addressSize : offsetSize); break;
+    case FormFlagPresent: value.value = 1; break;
+    case FormImplicitConst: value.value = uint64_t(implicitConst); break;
+    case FormExprloc: case FormBlock: reader.skip(reader.uleb()); break;
+    case FormBlock1: reader.skip(reader.fixed(1)); break;
+    case FormBlock2: reader.skip(reader.fixed(2)); break;
+    case FormBlock4: reader.skip(reader.fixed(4)); break;
+    case FormIndirect:
+        return readForm(reader, reader.uleb(), implicitConst, unit, sections, value);
+    default:
+        return false;
+    }
+    return reader.ok();
+}
+
+static const char *stringValue(const FormValue &value, const Unit &unit, const NimDwarfSections &sections)
+{
+    if (value.string)
+        return value.string;
+    switch (value.form) {
+    case FormStrx: case FormStrx1: case FormStrx2: case FormStrx3: case FormStrx4: {
+        const int offsetSize = unit.dwarf64 ? 8 : 4;
+        Reader offsets(sections.strOffsets, unit.strOffsetsBase + value.value * offsetSize);
+        const uint64_t offset = offsets.fixed(offsetSize);
+        return offsets.ok() ? stringAt(sections.str, offset) : "";
+    }
+    default:
+        return "";
+    }
+}
+
+static uint64_t addressValue(const FormValue &value, const Unit &unit, const NimDwarfSections &sections)
+{
+    switch (value.form) {
+    case FormAddrx: case FormAddrx1: case FormAddrx2: case FormAddrx3: case FormAddrx4: {
+        Reader addresses(sections.addr, unit.addrBase + value.value * unit.addressSize);
+        return addresses.fixed(unit.addressSize);
+    }
+    default:
+        return value.value;
+    }
+}
+
+static void readRanges(const FormValue &rangesValue, const Unit &unit, const NimDwarfSections &sections,
+                       std::vector<std::pair<uint64_t, uint64_t>> &ranges)
+{
+    const uint64_t allOnes = unit.addressSize == 8 ? ~uint64_t(0) : 0xffffffff;
+    uint64_t base = unit.baseAddress;
+
+    if (unit.version < 5) {
+        Reader reader(sections.ranges, rangesValue.value);
+        while (reader.ok()) {
+            const uint64_t begin = reader.fixed(unit.addressSize);
+            const uint64_t end = reader.fixed(unit.addressSize);
+            if (!reader.ok() || (begin == 0 && end == 0))
+                return;
+            if (begin == allOnes)
+                base = end;
+            else
+                ranges.emplace_back(base + begin, base + end);
+        }
+        return;
+    }
+
+    uint64_t offset = rangesValue.value;
+    if (rangesValue.form == FormRnglistx) {
+        const int offsetSize = unit.dwarf64 ? 8 : 4;
+        Reader offsets(sections.rnglists, unit.rnglistsBase + rangesValue.value * offsetSize);
+        offset = unit.rnglistsBase + offsets.fixed(offsetSize);
+        if (!offsets.ok())
+            return;
+    }
+    auto indexedAddress = [&](uint64_t index) {
+        Reader addresses(sections.addr, unit.addrBase + index * unit.addressSize);
+        return addresses.fixed(unit.addressSize);
+    };
+
+    Reader reader(sections.rnglists, offset);
+    while (reader.ok()) {
+        switch (reader.fixed(1)) {
+        case 0: // DW_RLE_end_of_list
+            return;
+        case 1: // DW_RLE_base_addressx
+            base = indexedAddress(reader.uleb());
+            break;
+        case 2: { // DW_RLE_startx_endx
+            const uint64_t begin = indexedAddress(reader.uleb());
+            ranges.emplace_back(begin, indexedAddress(reader.uleb()));
+            break;
+        }
+        case 3: { // DW_RLE_startx_length
+            const uint64_t begin = indexedAddress(reader.uleb());
+            ranges.emplace_back(begin, begin + reader.uleb());
+            break;
+        }
+        case 4: { // DW_RLE_offset_pair
+            const uint64_t begin = base + reader.uleb();
+            ranges.emplace_back(begin, base + reader.uleb());
+            break;
+        }
+        case 5: // DW_RLE_base_address
+            base = reader.fixed(unit.addressSize);
+            break;
+        case 6: { // DW_RLE_start_end
+            const uint64_t begin = reader.fixed(unit.addressSize);
+            ranges.emplace_back(begin, reader.fixed(unit.addressSize));
+            break;
+        }
+        case 7: { // DW_RLE_start_length
+            const uint64_t begin = reader.fixed(unit.addressSize);
+            ranges.emplace_back(begin, begin + reader.uleb());
+            break;
+        }
+        default:
+            return;
+        }
+    }
+}
+
+// Addresses of code the linker dropped are 0 or, with newer linkers, all ones
+static bool isTombstone(uint64_t address)
+{
+    return address == 0 || address >= ~uint64_t(1);
+}
+
+static std::string joinPath(const std::string &directory, const std::string &name)
+{
+    if (name.empty() || name.front() == '/' || directory.empty())
+        return name;
+    return directory.back() == '/' ? directory + name : directory + '/' + name;
+}
+
+int NimDwarfLineInfo::fileId(const std::string &path)
+{
+    const auto it = m_fileIds.find(path);
+    if (it != m_fileIds.end())
+        return it->second;
+    const int id = int(m_files.size());
+    m_files.push_back(path);
+    m_fileIds.emplace(path, id);
+    return id;
+}
+
+bool NimDwarfLineInfo::loadLineProgram(Unit &unit, uint64_t offset)
+{
+    Reader reader(m_sections.line, offset);
+    bool dwarf64 = false;
+    const uint64_t end = reader.unitLength(&dwarf64);
+    const int version = int(reader.fixed(2));
+    if (version < 2 || version > 5)
+        return false;
+    int addressSize = unit.addressSize;
+    if (version >= 5) {
+        addressSize = int(reader.fixed(1));
+        reader.fixed(1); // segment selector size
+    }
+    const uint64_t headerLength = reader.fixed(dwarf64 ? 8 : 4);
+    const uint64_t programStart = reader.position() + headerLength;
+    const uint64_t minimumInstructionLength = reader.fixed(1);
+    if (version >= 4)
+        reader.fixed(1); // maximum operations per instruction, only for VLIW
+    reader.fixed(1); // default is_stmt
+    const int lineBase = int8_t(reader.fixed(1));
+    const uint64_t lineRange = reader.fixed(1);
+    const uint64_t opcodeBase = reader.fixed(1);
+    std::vector<uint64_t> standardOpcodeLengths;
+    for (uint64_t i = 1; i < opcodeBase; ++i)
+        standardOpcodeLengths.push_back(reader.fixed(1));
+    if (!reader.ok() || lineRange == 0)
+        return false;
+
+    // File numbers start at 1 before DWARF 5, where file 0 is the primary source file
+    std::vector<std::string> directories;
+    unit.fileIds.clear();
+    if (version < 5) {
+        directories.push_back(unit.compDir);
+        while (reader.ok()) {
+            const std::string directory = reader.string();
+            if (directory.empty())
+                break;
+            directories.push_back(joinPath(unit.compDir, directory));
+        }
+        unit.fileIds.push_back(-1);
+        while (reader.ok()) {
+            const std::string name = reader.string();
+            if (name.empty())
+                break;
+            const uint64_t directory = reader.uleb();
+            reader.uleb(); // modification time
+            reader.uleb(); // size
+            unit.fileIds.push_back(fileId(joinPath(directory < directories.size()
+                                                   ? directories.at(directory) : std::string(), name)));
+        }
+    } else {
+        Unit lineUnit = unit;
+        lineUnit.dwarf64 = dwarf64;
+        lineUnit.addressSize = addressSize;
+        auto readEntries = [&](bool files) {
+            std::vector<std::pair<uint64_t, uint64_t>> format;
+            const uint64_t formatCount = reader.fixed(1);
+            for (uint64_t i = 0; i < formatCount && reader.ok(); ++i) {
+                const uint64_t contentType = reader.uleb();
+                format.emplace_back(contentType, reader.uleb());
+            }
+            const uint64_t count = reader.uleb();
+            for (uint64_t i = 0; i < count && reader.ok(); ++i) {
+                std::string path;
+                uint64_t directory = 0;
+                for (const auto &field : format) {
+                    FormValue value;
+                    if (!readForm(reader, field.second, 0, lineUnit, m_sections, value))
+                        return false;
+                    if (field.first == LineContentPath)
+                        path = stringValue(value, lineUnit, m_sections);
+                    else if (field.first == LineContentDirectoryIndex)
+                        directory = value.value;
+                }
+                if (files) {
+                    unit.fileIds.push_back(fileId(joinPath(directory < directories.size()
+                                                           ? directories.at(directory) : std::string(),
+                                                           path)));
+                } else {
+                    directories.push_back(joinPath(unit.compDir, path));
+                }
+            }
+            return reader.ok();
+        };
+        if (!readEntries(false) || !readEntries(true))
+            return false;
+    }
+
+    reader.seek(programStart);
+    uint64_t address = 0;
+    uint64_t file = 1;
+    int64_t line = 1;
+    bool validSequence = false;
+    bool havePrevious = false;
+    uint64_t previousAddress = 0;
+    uint64_t previousFile = 0;
+    int64_t previousLine = 0;
+
+    auto fileIdOf = [&unit](uint64_t file) {
+        return file < unit.fileIds.size() ? unit.fileIds.at(file) : -1;
+    };
+    auto emitRow = [&](bool endSequence) {
+        if (!havePrevious)
+            validSequence = !isTombstone(address);
+        if (havePrevious && validSequence && address > previousAddress && previousLine > 0) {
+            m_lines.push_back({previousAddress, address, fileIdOf(previousFile), int(previousLine)});
+        }
+        havePrevious = !endSequence;
+        previousAddress = address;
+        previousFile = file;
+        previousLine = line;
+        if (endSequence) {
+            address = 0;
+            file = 1;
+            line = 1;
+        }
+    };
+
+    while (reader.ok() && reader.position() < end) {
+        const uint64_t opcode = reader.fixed(1);
+        if (opcode >= opcodeBase) {
+            const uint64_t adjusted = opcode - opcodeBase;
+            address += (adjusted / lineRange) * minimumInstructionLength;
+            line += lineBase + int64_t(adjusted % lineRange);
+            emitRow(false);
+            continue;
+        }
+        switch (opcode) {
+        case 0: { // extended opcodes
+            const uint64_t length = reader.uleb();
+            const uint64_t next = reader.position() + length;
+            if (length == 0)
+                break;
+            switch (reader.fixed(1)) {
+            case 1: // DW_LNE_end_sequence
+                emitRow(true);
+                break;
+            case 2: // DW_LNE_set_address
+                address = reader.fixed(int(length - 1));
+                break;
+            default:
+                break;
+            }
+            reader.seek(next);
+            break;
+        }
+        case 1: // DW_LNS_copy
+            emitRow(false);
+            break;
+        case 2: // DW_LNS_advance_pc
+            address += reader.uleb() * minimumInstructionLength;
+            break;
+        case 3: // DW_LNS_advance_line
+            line += reader.sleb();
+            break;
+        case 4: // DW_LNS_set_file
+            file = reader.uleb();
+            break;
+        case 8: // DW_LNS_const_add_pc
+            address += ((255 - opcodeBase) / lineRange) * minimumInstructionLength;
+            break;
+        case 9: // DW_LNS_fixed_advance_pc
+            address += reader.fixed(2);
+            break;
+        default:
+            for (uint64_t i = 0; i < standardOpcodeLengths.at(opcode - 1); ++i)
+                reader.uleb();
+            break;
+        }
+    }
+    return reader.ok();
+}
+
+bool NimDwarfLineInfo::loadUnit(Unit &unit)
+{
+    // Abbreviations of the unit
+    Reader abbreviations(m_sections.abbrev, unit.abbrevOffset);
+    while (abbreviations.ok()) {
+        const uint64_t code = abbreviations.uleb();
+        if (code == 0)
+            break;
+        Abbreviation &abbreviation = unit.abbreviations[code];
+        abbreviation.tag = abbreviations.uleb();
+        abbreviation.hasChildren = abbreviations.fixed(1);
+        while (abbreviations.ok()) {
+            AttributeSpec spec;
+            spec.name = abbreviations.uleb();
+            spec.form = abbreviations.uleb();
+            spec.implicitConst = spec.form == FormImplicitConst ? abbreviations.sleb() : 0;
+            if (spec.name == 0 && spec.form == 0)
+                break;
+            abbreviation.attributes.push_back(spec);
+        }
+    }
+    if (!abbreviations.ok())
+        return false;
+
+    Reader reader(m_sections.info, unit.diesOffset);
+    std::vector<int> inlineDepths;  // of the open parents
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    bool root = true;
+    while (reader.ok() && reader.position() < unit.end) {
+        const uint64_t code = reader.uleb();
+        if (code == 0) {
+            if (!inlineDepths.empty())
+                inlineDepths.pop_back();
+            continue;
+        }
+        const auto it = unit.abbreviations.find(code);
+        if (it == unit.abbreviations.end())
+            return false;
+        const Abbreviation &abbreviation = it->second;
+
+        FormValue lowPc, highPc, rangesValue, compDir, callFile, callLine, stmtList;
+        for (const AttributeSpec &spec : abbreviation.attributes) {
+            FormValue value;
+            if (!readForm(reader, spec.form, spec.implicitConst, unit, m_sections, value))
+                return false;
+            switch (spec.name) {
+            case AtLowPc: lowPc = value; break;
+            case AtHighPc: highPc = value; break;
+            case AtRanges: rangesValue = value; break;
+            case AtCallFile: callFile = value; break;
+            case AtCallLine: callLine = value; break;
+            case AtStmtList: stmtList = value; break;
+            case AtCompDir: compDir = value; break;
+            case AtStrOffsetsBase: if (root) unit.strOffsetsBase = value.value; break;
+            case AtAddrBase: if (root) unit.addrBase = value.value; break;
+            case AtRnglistsBase: if (root) unit.rnglistsBase = value.value; break;
+            default: break;
+            }
+        }
+
+        if (root) {
+            // The bases above are needed to read the other attributes of the unit
+            root = false;
+            if (lowPc.form)
+                unit.baseAddress = addressValue(lowPc, unit, m_sections);
+            if (compDir.form)
+                unit.compDir = stringValue(compDir, unit, m_sections);
+            if (stmtList.form)
+                loadLineProgram(unit, stmtList.value);
+        }
+
+        const int parentDepth = inlineDepths.empty() ? 0 : inlineDepths.back();
+        const bool inlined = abbreviation.tag == TagInlinedSubroutine;
+        if (inlined && callLine.form) {
+            ranges.clear();
+            if (rangesValue.form) {
+                readRanges(rangesValue, unit, m_sections, ranges);
+            } else if (lowPc.form && highPc.form) {
+                const uint64_t low = addressValue(lowPc, unit, m_sections);
+                const uint64_t high = isConstantForm(highPc.form) ? low + highPc.value
+                                                                  : addressValue(highPc, unit, m_sections);
+                ranges.emplace_back(low, high);
+            }
+            NimDwarfLocation callSite;
+            callSite.file = callFile.value < unit.fileIds.size() ? unit.fileIds.at(callFile.value) : -1;
+            callSite.line = int(callLine.value);
+            for (const auto &range : ranges) {
+                if (!isTombstone(range.first) && range.second > range.first)
+                    m_inlines.push_back({range.first, range.second, parentDepth, callSite});
+            }
+        }
+        if (abbreviation.hasChildren)
+            inlineDepths.push_back(parentDepth + (inlined ? 1 : 0));
+    }
+    return reader.ok();
+}
+
+bool NimDwarfLineInfo::load(const NimDwarfSections &sections)
+{
+    m_sections = sections;
+    m_lines.clear();
+    m_inlines.clear();
+    m_files.clear();
+    m_fileIds.clear();
+    if (!sections.info.size || !sections.line.size) {
+        m_errorString = "no DWARF line tables";
+        return false;
+    }
+
+    Reader reader(sections.info);
+    while (reader.ok() && reader.position() < sections.info.size) {
+        Unit unit;
+        unit.end = reader.unitLength(&unit.dwarf64);
+        unit.version = int(reader.fixed(2));
+        uint64_t unitType = UnitCompile;
+        if (unit.version >= 5) {
+            unitType = reader.fixed(1);
+            unit.addressSize = int(reader.fixed(1));
+            unit.abbrevOffset = reader.fixed(unit.dwarf64 ? 8 : 4);
+            if (unitType == UnitSkeleton || unitType == UnitSplitCompile)
+                reader.skip(8); // dwo id
+            else if (unitType == UnitType || unitType == UnitSplitType)
+                reader.skip(8 + (unit.dwarf64 ? 8 : 4)); // type signature and offset
+        } else {
+            unit.abbrevOffset = reader.fixed(unit.dwarf64 ? 8 : 4);
+            unit.addressSize = int(reader.fixed(1));
+        }
+        if (!reader.ok() || unit.version < 2 || unit.version > 5) {
+            m_errorString = "unsupported DWARF unit";
+            return false;
+        }
+        unit.diesOffset = reader.position();
+        // A broken unit should not hide the others
+        if (unitType == UnitCompile || unitType == UnitPartial)
+            loadUnit(unit);
+        reader.seek(unit.end);
+    }
+
+    std::sort(m_lines.begin(), m_lines.end(), [](const LineRange &a, const LineRange &b) {
+        return a.low < b.low;
+    });
+    return true;
+}
+
+std::vector<NimDwarfAddressInfo> NimDwarfLineInfo::resolve(const std::vector<uint64_t> &addresses) const
+{
+    std::vector<NimDwarfAddressInfo> result(addresses.size());
+    std::vector<std::vector<const InlineRange *>> inlines(addresses.size());
+
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        auto it = std::upper_bound(m_lines.begin(), m_lines.end(), addresses.at(i),
+                                   [](uint64_t address, const LineRange &range) {
+            return address < range.low;
+        });
+        if (it == m_lines.begin())
+            continue;
+        --it;
+        if (addresses.at(i) < it->high) {
+            result[i].location.file = it->file;
+            result[i].location.line = it->line;
+        }
+    }
+
+    for (const InlineRange &range : m_inlines) {
+        auto it = std::lower_bound(addresses.begin(), addresses.end(), range.low);
+        for (; it != addresses.end() && *it < range.high; ++it)
+            inlines[size_t(it - addresses.begin())].push_back(&range);
+    }
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        std::sort(inlines[i].begin(), inlines[i].end(), [](const InlineRange *a, const InlineRange *b) {
+            return a->depth < b->depth;
+        });
+        for (const InlineRange *range : inlines[i])
+            result[i].callSites.push_back(range->callSite);
+    }
+    return result;
+}
+
+} // namespace Nim
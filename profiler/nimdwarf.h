@@ -0,0 +1,123 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Nim {
+
+class NimDwarfUnit;
+
+class NimDwarfSection
+{
+public:
+    const char *data = nullptr;
+    size_t size = 0;
+};
+
+class NimDwarfSections
+{
+public:
+    NimDwarfSection info;
+    NimDwarfSection abbrev;
+    NimDwarfSection line;
+    NimDwarfSection str;
+    NimDwarfSection lineStr;
+    NimDwarfSection strOffsets;
+    NimDwarfSection addr;
+    NimDwarfSection ranges;
+    NimDwarfSection rnglists;
+};
+
+class NimDwarfLocation
+{
+public:
+    int file = -1;  // index into NimDwarfLineInfo::files()
+    int line = 0;
+
+    bool isValid() const { return file >= 0 && line > 0; }
+};
+
+class NimDwarfAddressInfo
+{
+public:
+    // Where the instruction came from, inside the innermost inlined function
+    NimDwarfLocation location;
+    // The calls of the inlined functions the instruction belongs to, outermost
+    // first: the first one is a line of the function the address is in.
+    std::vector<NimDwarfLocation> callSites;
+};
+
+// Maps addresses to source lines with the DWARF 2 to 5 line tables of a
+// binary, and to the call sites of the inlined functions they belong to
+// with the DW_TAG_inlined_subroutine entries of the debug information.
+class NimDwarfLineInfo
+{
+public:
+    bool load(const NimDwarfSections &sections);
+    const std::string &errorString() const { return m_errorString; }
+
+    const std::vector<std::string> &files() const { return m_files; }
+
+    // addresses have to be sorted, the result has one entry per address
+    std::vector<NimDwarfAddressInfo> resolve(const std::vector<uint64_t> &addresses) const;
+
+private:
+    class LineRange
+    {
+    public:
+        uint64_t low;
+        uint64_t high;
+        int file;
+        int line;
+    };
+
+    class InlineRange
+    {
+    public:
+        uint64_t low;
+        uint64_t high;
+        int depth;
+        NimDwarfLocation callSite;
+    };
+
+    bool loadUnit(NimDwarfUnit &unit);
+    bool loadLineProgram(NimDwarfUnit &unit, uint64_t offset);
+    int fileId(const std::string &path);
+
+    NimDwarfSections m_sections;
+    std::vector<LineRange> m_lines;
+    std::vector<InlineRange> m_inlines;
+    std::vector<std::string> m_files;
+    std::map<std::string, int> m_fileIds;
+    std::string m_errorString;
+};
+
+} // namespace Nim
@@ -0,0 +1,147 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimelffile.h"
+
+#include <QCoreApplication>
+
+#include <cstring>
+#include <elf.h>
+
+namespace Nim {
+
+static QString tr(const char *text)
+{
+    return QCoreApplication::translate("Nim::NimElfFile", text);
+}
+
+bool NimElfFile::open(const QString &path)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+    m_size = m_file.size();
+    m_data = m_file.map(0, m_size);
+    if (!m_data || m_size < qint64(sizeof(Elf64_Ehdr))) {
+        m_errorString = tr("Cannot map the file.");
+        return false;
+    }
+
+    Elf64_Ehdr header;
+    std::memcpy(&header, m_data, sizeof(header));
+    if (std::memcmp(header.e_ident, ELFMAG, SELFMAG) != 0
+            || header.e_ident[EI_CLASS] != ELFCLASS64
+            || header.e_ident[EI_DATA] != ELFDATA2LSB) {
+        m_errorString = tr("Not a 64-bit little-endian ELF file.");
+        return false;
+    }
+    if (header.e_shoff + quint64(header.e_shnum) * sizeof(Elf64_Shdr) > quint64(m_size)
+            || header.e_shstrndx >= header.e_shnum) {
+        m_errorString = tr("Truncated section headers.");
+        return false;
+    }
+
+    for (int i = 0; i < header.e_shnum; ++i) {
+        Elf64_Shdr sectionHeader;
+        std::memcpy(&sectionHeader, m_data + header.e_shoff + i * sizeof(Elf64_Shdr), sizeof(sectionHeader));
+        Section section;
+        section.type = sectionHeader.sh_type;
+        section.flags = sectionHeader.sh_flags;
+        section.offset = sectionHeader.sh_offset;
+        section.size = section.type == SHT_NOBITS ? 0 : sectionHeader.sh_size;
+        section.link = sectionHeader.sh_link;
+        if (section.offset + section.size > quint64(m_size))
+            section.size = 0;
+        m_sections.append(section);
+    }
+
+    const Section &names = m_sections.at(header.e_shstrndx);
+    for (int i = 0; i < header.e_shnum; ++i) {
+        Elf64_Shdr sectionHeader;
+        std::memcpy(&sectionHeader, m_data + header.e_shoff + i * sizeof(Elf64_Shdr), sizeof(sectionHeader));
+        if (sectionHeader.sh_name >= names.size)
+            continue;
+        const char *name = reinterpret_cast<const char *>(m_data + names.offset + sectionHeader.sh_name);
+        m_sectionIndex.insert(QByteArray(name, int(qstrnlen(name, names.size - sectionHeader.sh_name))), i);
+    }
+    return true;
+}
+
+bool NimElfFile::hasSection(const QByteArray &name) const
+{
+    return m_sectionIndex.contains(name);
+}
+
+QByteArray NimElfFile::section(const QByteArray &name) const
+{
+    const int index = m_sectionIndex.value(name, -1);
+    if (index < 0)
+        return QByteArray();
+    const Section &section = m_sections.at(index);
+    // Compressed debug sections are not supported, they are not Cargo's default
+    if (section.flags & SHF_COMPRESSED)
+        return QByteArray();
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(m_data + section.offset),
+                                   int(section.size));
+}
+
+QVector<NimElfSymbol> NimElfFile::symbols(const QByteArray &table) const
+{
+    QVector<NimElfSymbol> result;
+    const int index = m_sectionIndex.value(table, -1);
+    if (index < 0)
+        return result;
+    const Section &symbols = m_sections.at(index);
+    if (symbols.link >= quint32(m_sections.size()))
+        return result;
+    const Section &strings = m_sections.at(symbols.link);
+
+    for (quint64 offset = 0; offset + sizeof(Elf64_Sym) <= symbols.size; offset += sizeof(Elf64_Sym)) {
+        Elf64_Sym symbol;
+        std::memcpy(&symbol, m_data + symbols.offset + offset, sizeof(symbol));
+        if (ELF64_ST_TYPE(symbol.st_info) != STT_FUNC || symbol.st_value == 0
+                || symbol.st_name >= strings.size) {
+            continue;
+        }
+        const char *name = reinterpret_cast<const char *>(m_data + strings.offset + symbol.st_name);
+        NimElfSymbol elfSymbol;
+        elfSymbol.name = QByteArray(name, int(qstrnlen(name, strings.size - symbol.st_name)));
+        elfSymbol.address = symbol.st_value;
+        elfSymbol.size = symbol.st_size;
+        result.append(elfSymbol);
+    }
+    return result;
+}
+
+QVector<NimElfSymbol> NimElfFile::functionSymbols() const
+{
+    const QVector<NimElfSymbol> result = symbols(".symtab");
+    return result.isEmpty() ? symbols(".dynsym") : result;
+}
+
+} // namespace Nim
@@ -0,0 +1,79 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QVector>
+
+namespace Nim {
+
+class NimElfSymbol
+{
+public:
+    QByteArray name;
+    quint64 address = 0;
+    quint64 size = 0;
+};
+
+// Read-only view of a 64-bit little-endian ELF file, mapped into memory
+class NimElfFile
+{
+public:
+    bool open(const QString &path);
+    QString errorString() const { return m_errorString; }
+
+    // Empty if there is no such section or it has no data in the file
+    QByteArray section(const QByteArray &name) const;
+    bool hasSection(const QByteArray &name) const;
+
+    // Functions of .symtab, or of .dynsym if the binary was stripped
+    QVector<NimElfSymbol> functionSymbols() const;
+
+private:
+    class Section
+    {
+    public:
+        quint32 type = 0;
+        quint64 flags = 0;
+        quint64 offset = 0;
+        quint64 size = 0;
+        quint32 link = 0;
+    };
+
+    QVector<NimElfSymbol> symbols(const QByteArray &table) const;
+
+    QFile m_file;
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    QVector<Section> m_sections;
+    QHash<QByteArray, int> m_sectionIndex;
+    QString m_errorString;
+};
+
+} // namespace Nim
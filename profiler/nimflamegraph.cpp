@@ -0,0 +1,100 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimflamegraph.h"
+
+#include <algorithm>
+
+namespace Nim {
+
+qint64 NimFlameGraphNode::selfSamples() const
+{
+    qint64 self = samples;
+    for (const NimFlameGraphNode &child : children)
+        self -= child.samples;
+    return self;
+}
+
+int NimFlameGraphNode::depth() const
+{
+    int depth = 0;
+    for (const NimFlameGraphNode &child : children)
+        depth = qMax(depth, child.depth());
+    return depth + 1;
+}
+
+static NimFlameGraphNode &child(NimFlameGraphNode &node, const QString &name)
+{
+    auto it = std::lower_bound(node.children.begin(), node.children.end(), name,
+                               [](const NimFlameGraphNode &n, const QString &name) {
+        return n.name < name;
+    });
+    if (it == node.children.end() || it->name != name) {
+        NimFlameGraphNode inserted;
+        inserted.name = name;
+        it = node.children.insert(it, inserted);
+    }
+    return *it;
+}
+
+// Walks the path of a base stack without creating frames missing from the recording
+static void addBaseShare(NimFlameGraphNode &root, const QStringList &frames, double share)
+{
+    NimFlameGraphNode *node = &root;
+    node->baseShare += share;
+    for (const QString &frame : frames) {
+        auto it = std::lower_bound(node->children.begin(), node->children.end(), frame,
+                                   [](const NimFlameGraphNode &n, const QString &name) {
+            return n.name < name;
+        });
+        if (it == node->children.end() || it->name != frame)
+            return;
+        node = &*it;
+        node->baseShare += share;
+    }
+}
+
+NimFlameGraphNode NimFlameGraph::build(const NimFoldedStacks &stacks, const NimFoldedStacks &base)
+{
+    NimFlameGraphNode root;
+    for (auto it = stacks.cbegin(); it != stacks.cend(); ++it) {
+        NimFlameGraphNode *node = &root;
+        node->samples += it.value();
+        for (const QString &frame : it.key().split(';')) {
+            node = &child(*node, frame);
+            node->samples += it.value();
+        }
+    }
+
+    qint64 baseTotal = 0;
+    for (const qint64 samples : base)
+        baseTotal += samples;
+    for (auto it = base.cbegin(); it != base.cend(); ++it)
+        addBaseShare(root, it.key().split(';'), double(it.value()) / baseTotal);
+    return root;
+}
+
+} // namespace Nim
@@ -0,0 +1,249 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimflamegraphwidget.h"
+
+#include <QHelpEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QToolTip>
+
+#include <functional>
+
+namespace Nim {
+
+const int FRAME_HEIGHT = 18;
+const int MIN_TEXT_WIDTH = 24;
+
+NimFlameGraphWidget::NimFlameGraphWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    setMouseTracking(true);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+}
+
+static double maxShareChange(const NimFlameGraphNode &node, qint64 total)
+{
+    double change = qAbs(double(node.samples) / total - node.baseShare);
+    for (const NimFlameGraphNode &child : node.children)
+        change = qMax(change, maxShareChange(child, total));
+    return change;
+}
+
+void NimFlameGraphWidget::setGraph(const NimFlameGraphNode &root, bool differential)
+{
+    m_root = root;
+    m_zoomed = &m_root;
+    m_differential = differential;
+    m_maxShareChange = differential && root.samples ? maxShareChange(root, root.samples) : 0;
+    setMinimumHeight(sizeHint().height());
+    updateGeometry();
+    setSearchText(m_searchText);
+}
+
+void NimFlameGraphWidget::setIcicle(bool icicle)
+{
+    m_icicle = icicle;
+    update();
+}
+
+void NimFlameGraphWidget::setUnit(Unit unit)
+{
+    m_unit = unit;
+}
+
+void NimFlameGraphWidget::setSearchText(const QString &text)
+{
+    m_searchText = text;
+    if (!text.isEmpty() && m_root.samples)
+        emit searchMatched(double(matchingSamples(m_root)) / m_root.samples);
+    update();
+}
+
+void NimFlameGraphWidget::resetZoom()
+{
+    m_zoomed = &m_root;
+    update();
+}
+
+QSize NimFlameGraphWidget::sizeHint() const
+{
+    return QSize(600, (m_root.depth() + 1) * FRAME_HEIGHT);
+}
+
+// Samples in matching frames, not counting matches below a match twice
+qint64 NimFlameGraphWidget::matchingSamples(const NimFlameGraphNode &node) const
+{
+    if (!node.name.isEmpty() && node.name.contains(m_searchText, Qt::CaseInsensitive))
+        return node.samples;
+    qint64 samples = 0;
+    for (const NimFlameGraphNode &child : node.children)
+        samples += matchingSamples(child);
+    return samples;
+}
+
+QColor NimFlameGraphWidget::color(const NimFlameGraphNode &node) const
+{
+    if (!m_searchText.isEmpty() && node.name.contains(m_searchText, Qt::CaseInsensitive))
+        return QColor(230, 0, 230);
+    if (m_differential) {
+        const double change = double(node.samples) / m_root.samples - node.baseShare;
+        const int intensity = m_maxShareChange > 0 ? qRound(200 * qAbs(change) / m_maxShareChange) : 0;
+        return change >= 0 ? QColor(255, 255 - intensity, 255 - intensity)
+                           : QColor(255 - intensity, 255 - intensity, 255);
+    }
+    // Warm colors, stable per function name
+    const uint hash = qHash(node.name);
+    return QColor(205 + int(hash % 50), 80 + int((hash >> 8) % 150), int((hash >> 16) % 55));
+}
+
+void NimFlameGraphWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+    m_boxes.clear();
+    if (!m_zoomed || m_zoomed->samples == 0)
+        return;
+
+    // The zoomed frame spans the full width, its callers are drawn above it
+    QList<const NimFlameGraphNode *> callers;
+    std::function<bool(const NimFlameGraphNode &)> findPath = [&](const NimFlameGraphNode &node) {
+        if (&node == m_zoomed)
+            return true;
+        for (const NimFlameGraphNode &child : node.children) {
+            if (findPath(child)) {
+                callers.prepend(&node);
+                return true;
+            }
+        }
+        return false;
+    };
+    findPath(m_root);
+
+    const double pixelsPerSample = double(width()) / m_zoomed->samples;
+    int depth = 0;
+    for (const NimFlameGraphNode *caller : qAsConst(callers)) {
+        const QRectF rect(0, m_icicle ? depth * FRAME_HEIGHT : height() - (depth + 1) * FRAME_HEIGHT,
+                          width(), FRAME_HEIGHT);
+        painter.fillRect(rect.adjusted(0, 0, -1, -1), color(*caller).lighter(130));
+        m_boxes.append({rect, caller});
+        ++depth;
+    }
+    paintNode(painter, *m_zoomed, 0, depth, pixelsPerSample);
+}
+
+void NimFlameGraphWidget::paintNode(QPainter &painter, const NimFlameGraphNode &node, double x,
+                                    int depth, double pixelsPerSample)
+{
+    const double width = node.samples * pixelsPerSample;
+    if (width < 1)
+        return;
+    const QRectF rect(x, m_icicle ? depth * FRAME_HEIGHT : height() - (depth + 1) * FRAME_HEIGHT,
+                      width, FRAME_HEIGHT);
+    painter.fillRect(rect.adjusted(0, 0, -1, -1), color(node));
+    if (width >= MIN_TEXT_WIDTH) {
+        const QString name = node.name.isEmpty() ? tr("all") : node.name;
+        painter.setPen(Qt::black);
+        painter.drawText(rect.adjusted(2, 0, -2, 0), Qt::AlignVCenter | Qt::AlignLeft,
+                         painter.fontMetrics().elidedText(name, Qt::ElideRight, int(width) - 4));
+    }
+    m_boxes.append({rect, &node});
+
+    double childX = x;
+    for (const NimFlameGraphNode &child : node.children) {
+        paintNode(painter, child, childX, depth + 1, pixelsPerSample);
+        childX += child.samples * pixelsPerSample;
+    }
+}
+
+const NimFlameGraphNode *NimFlameGraphWidget::nodeAt(const QPoint &pos) const
+{
+    for (const Box &box : m_boxes) {
+        if (box.rect.contains(pos))
+            return box.node;
+    }
+    return nullptr;
+}
+
+void NimFlameGraphWidget::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton)
+        return;
+    if (const NimFlameGraphNode *node = nodeAt(event->pos())) {
+        m_zoomed = node;
+        update();
+        if (!node->name.isEmpty())
+            emit frameActivated(node->name);
+    }
+}
+
+void NimFlameGraphWidget::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    Q_UNUSED(event)
+    resetZoom();
+}
+
+bool NimFlameGraphWidget::event(QEvent *event)
+{
+    if (event->type() != QEvent::ToolTip)
+        return QWidget::event(event);
+
+    auto helpEvent = static_cast<QHelpEvent *>(event);
+    const NimFlameGraphNode *node = nodeAt(helpEvent->pos());
+    if (!node || !m_root.samples) {
+        QToolTip::hideText();
+        return true;
+    }
+    const double share = double(node->samples) / m_root.samples;
+    const QString name = node->name.isEmpty() ? tr("all") : node->name;
+    QString text;
+    switch (m_unit) {
+    case WaitTime:
+        text = tr("%1\n%2 ms waited (%3%), %4 ms in the function itself")
+                .arg(name).arg(node->samples / 1000.0, 0, 'f', 1).arg(100 * share, 0, 'f', 2)
+                .arg(node->selfSamples() / 1000.0, 0, 'f', 1);
+        break;
+    case Allocations:
+        text = tr("%1\n%2 allocations (%3%), %4 in the function itself")
+                .arg(name).arg(node->samples).arg(100 * share, 0, 'f', 2).arg(node->selfSamples());
+        break;
+    default:
+        text = tr("%1\n%2 samples (%3%), %4 in the function itself")
+                .arg(name).arg(node->samples).arg(100 * share, 0, 'f', 2).arg(node->selfSamples());
+        break;
+    }
+    if (m_differential) {
+        text += '\n' + tr("%1% in the compared recording, %2%3 percentage points")
+                .arg(100 * node->baseShare, 0, 'f', 2)
+                .arg(share >= node->baseShare ? "+" : "")
+                .arg(100 * (share - node->baseShare), 0, 'f', 2);
+    }
+    QToolTip::showText(helpEvent->globalPos(), text, this);
+    return true;
+}
+
+} // namespace Nim
@@ -0,0 +1,91 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include "nimflamegraph.h"
+
+#include <QWidget>
+
+namespace Nim {
+
+// Paints a flame graph, or an icicle graph with the callers on top. Clicking
+// a frame zooms into it, clicking the root or double-clicking zooms out.
+// In a differential graph frames are red when they take a bigger share of
+// the samples than in the compared recording and blue when a smaller one.
+class NimFlameGraphWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit NimFlameGraphWidget(QWidget *parent = nullptr);
+
+    void setGraph(const NimFlameGraphNode &root, bool differential);
+    void setIcicle(bool icicle);
+    // What the counts of the folded stacks are
+    enum Unit { Samples, WaitTime, Allocations };
+    void setUnit(Unit unit);
+    void setSearchText(const QString &text);
+    void resetZoom();
+
+    QSize sizeHint() const override;
+
+signals:
+    // Share of the samples in frames matching the search text
+    void searchMatched(double share);
+    void frameActivated(const QString &name);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    bool event(QEvent *event) override;
+
+private:
+    class Box
+    {
+    public:
+        QRectF rect;
+        const NimFlameGraphNode *node;
+    };
+
+    void paintNode(QPainter &painter, const NimFlameGraphNode &node, double x, int depth,
+                   double pixelsPerSample);
+    QColor color(const NimFlameGraphNode &node) const;
+    const NimFlameGraphNode *nodeAt(const QPoint &pos) const;
+    qint64 matchingSamples(const NimFlameGraphNode &node) const;
+
+    NimFlameGraphNode m_root;
+    const NimFlameGraphNode *m_zoomed = nullptr;
+    bool m_differential = false;
+    bool m_icicle = false;
+    Unit m_unit = Samples;
+    QString m_searchText;
+    double m_maxShareChange = 0;
+    QVector<Box> m_boxes;
+};
+
+} // namespace Nim
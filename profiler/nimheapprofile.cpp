@@ -0,0 +1,425 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimheapprofile.h"
+#include "nimperfrecorder.h"
+#include "nimprofilerpane.h"
+
+#include "../nimconstants.h"
+
+#include <projectexplorer/runconfiguration.h>
+#include <utils/environment.h>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QLocale>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace ProjectExplorer;
+using namespace Utils;
+
+namespace Nim {
+
+static QString tr(const char *text)
+{
+    return QCoreApplication::translate("Nim::NimHeapProfile", text);
+}
+
+static FilePath derivedFile(const FilePath &recording, const QString &suffix)
+{
+    QString path = recording.toString();
+    path.chop(QString(".data").size());
+    return FilePath::fromString(path + suffix);
+}
+
+// NimHeapSummary
+
+QString NimHeapSummary::toString() const
+{
+    const QLocale locale = QLocale::system();
+    QStringList parts;
+    if (allocations >= 0) {
+        parts << (temporaryAllocations >= 0
+                  ? tr("%1 allocations (%2 temporary)").arg(locale.toString(allocations),
+                                                            locale.toString(temporaryAllocations))
+                  : tr("%1 allocations").arg(locale.toString(allocations)));
+    }
+    if (allocatedBytes >= 0)
+        parts << tr("%1 allocated in total").arg(locale.formattedDataSize(allocatedBytes));
+    if (peakBytes >= 0)
+        parts << tr("%1 at the peak").arg(locale.formattedDataSize(peakBytes));
+    if (leakedBytes >= 0)
+        parts << tr("%1 leaked").arg(locale.formattedDataSize(leakedBytes));
+    return parts.join(", ");
+}
+
+// NimHeapProfile
+
+FilePath NimHeapProfile::heaptrackExecutable()
+{
+    return Environment::systemEnvironment().searchInPath("heaptrack");
+}
+
+FilePath NimHeapProfile::traceFile(const FilePath &recording)
+{
+    for (const QString &suffix : {".zst", ".gz", ""}) {
+        const FilePath trace = recording.stringAppended(suffix);
+        if (trace.exists())
+            return trace;
+    }
+    return FilePath();
+}
+
+FilePath NimHeapProfile::costFile(const FilePath &recording, NimAllocationSite::Cost cost)
+{
+    switch (cost) {
+    case NimAllocationSite::TemporaryAllocations:
+        return derivedFile(recording, ".temporary");
+    case NimAllocationSite::PeakBytes:
+        return derivedFile(recording, ".peak");
+    case NimAllocationSite::LeakedBytes:
+        return derivedFile(recording, ".leaked");
+    default:
+        return NimPerfRecordings::foldedFile(recording);
+    }
+}
+
+FilePath NimHeapProfile::summaryFile(const FilePath &recording)
+{
+    return derivedFile(recording, ".summary");
+}
+
+// heaptrack_print ends with the totals, in units of 1000 bytes:
+//   calls to allocation functions: 1035 (20700/s)
+//   temporary memory allocations: 214 (4280/s)
+//   peak heap memory consumption: 85.34K
+//   total memory leaked: 70.72K
+NimHeapSummary NimHeapProfile::parseSummary(const QString &output)
+{
+    auto count = [&output](const QString &label) {
+        const QRegularExpressionMatch match
+                = QRegularExpression("^" + QRegularExpression::escape(label) + R"(:\s*(\d+))",
+                                     QRegularExpression::MultilineOption).match(output);
+        return match.hasMatch() ? match.captured(1).toLongLong() : -1;
+    };
+    auto bytes = [&output](const QString &label) -> qint64 {
+        const QRegularExpressionMatch match
+                = QRegularExpression("^" + QRegularExpression::escape(label) + R"(:\s*([\d.]+)\s*([KMGT]?))",
+                                     QRegularExpression::MultilineOption).match(output);
+        if (!match.hasMatch())
+            return -1;
+        const int exponent = match.captured(2).isEmpty() ? 0 : QString("KMGT").indexOf(match.captured(2)) + 1;
+        return qRound64(match.captured(1).toDouble() * std::pow(1000.0, exponent));
+    };
+
+    NimHeapSummary summary;
+    summary.allocations = count("calls to allocation functions");
+    summary.temporaryAllocations = count("temporary memory allocations");
+    summary.allocatedBytes = bytes("bytes allocated in total (ignoring deallocations)");
+    summary.peakBytes = bytes("peak heap memory consumption");
+    summary.leakedBytes = bytes("total memory leaked");
+    return summary;
+}
+
+NimHeapSummary NimHeapProfile::readSummary(const FilePath &recording)
+{
+    NimHeapSummary summary;
+    QFile file(summaryFile(recording).toString());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return summary;
+    while (!file.atEnd()) {
+        const QStringList fields = QString::fromUtf8(file.readLine()).trimmed().split('\t');
+        if (fields.size() != 2)
+            continue;
+        const qint64 value = fields.at(1).toLongLong();
+        if (fields.at(0) == "allocations")
+            summary.allocations = value;
+        else if (fields.at(0) == "temporary")
+            summary.temporaryAllocations = value;
+        else if (fields.at(0) == "allocated")
+            summary.allocatedBytes = value;
+        else if (fields.at(0) == "peak")
+            summary.peakBytes = value;
+        else if (fields.at(0) == "leaked")
+            summary.leakedBytes = value;
+    }
+    return summary;
+}
+
+bool NimHeapProfile::writeSummary(const FilePath &recording, const NimHeapSummary &summary)
+{
+    QFile file(summaryFile(recording).toString());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+    QByteArray contents;
+    contents += "allocations\t" + QByteArray::number(summary.allocations) + '\n';
+    contents += "temporary\t" + QByteArray::number(summary.temporaryAllocations) + '\n';
+    contents += "allocated\t" + QByteArray::number(summary.allocatedBytes) + '\n';
+    contents += "peak\t" + QByteArray::number(summary.peakBytes) + '\n';
+    contents += "leaked\t" + QByteArray::number(summary.leakedBytes) + '\n';
+    return file.write(contents) == contents.size();
+}
+
+QString NimHeapProfile::frameName(const QString &frame)
+{
+    static const QRegularExpression hash("::h[0-9a-f]{16}$");
+    QString name = frame.trimmed();
+    if (name.startsWith("_ZN") || name.startsWith("_R"))
+        name = NimStackFolder::symbolName(name);
+    name.remove(hash);
+    return name;
+}
+
+bool NimHeapProfile::isAllocatorFrame(const QString &name)
+{
+    static const QStringList prefixes = {
+        "malloc", "calloc", "realloc", "posix_memalign", "aligned_alloc", "operator new",
+        "__rust_", "__rdl_", "__rg_", "alloc::", "core::alloc::", "std::alloc::", "hashbrown::",
+        "std::collections::"
+    };
+    QString path = name;
+    if (path.startsWith('<'))
+        path.remove(0, 1);
+    for (const QString &prefix : prefixes) {
+        if (path.startsWith(prefix))
+            return true;
+    }
+    // Like <T as alloc::borrow::ToOwned>::to_owned
+    return name.contains(" as alloc::");
+}
+
+QVector<NimAllocationSite> NimHeapProfile::allocationSites(const QVector<NimFoldedStacks> &stacks)
+{
+    QHash<QString, NimAllocationSite> sites;
+    QHash<QString, QHash<QString, NimAllocationSite>> callers;
+    for (int cost = 0; cost < qMin(int(stacks.size()), int(NimAllocationSite::CostCount)); ++cost) {
+        for (auto it = stacks.at(cost).cbegin(); it != stacks.at(cost).cend(); ++it) {
+            const QStringList frames = it.key().split(';');
+            int index = frames.size() - 1;
+            while (index > 0 && isAllocatorFrame(frames.at(index)))
+                --index;
+            NimAllocationSite &site = sites[frames.at(index)];
+            site.function = frames.at(index);
+            site.costs[cost] += it.value();
+            const QString callerName = index > 0 ? frames.at(index - 1) : tr("(no caller)");
+            NimAllocationSite &caller = callers[site.function][callerName];
+            caller.function = callerName;
+            caller.costs[cost] += it.value();
+        }
+    }
+
+    auto moreAllocations = [](const NimAllocationSite &a, const NimAllocationSite &b) {
+        if (a.costs[NimAllocationSite::Allocations] != b.costs[NimAllocationSite::Allocations])
+            return a.costs[NimAllocationSite::Allocations] > b.costs[NimAllocationSite::Allocations];
+        return a.costs[NimAllocationSite::PeakBytes] > b.costs[NimAllocationSite::PeakBytes];
+    };
+    QVector<NimAllocationSite> result;
+    for (NimAllocationSite &site : sites) {
+        site.callers = callers.value(site.function).values().toVector();
+        std::sort(site.callers.begin(), site.callers.end(), moreAllocations);
+        result.append(site);
+    }
+    std::sort(result.begin(), result.end(), moreAllocations);
+    return result;
+}
+
+QVector<NimAllocationSite> NimHeapProfile::allocationSites(const FilePath &recording)
+{
+    QVector<NimFoldedStacks> stacks;
+    for (int cost = 0; cost < NimAllocationSite::CostCount; ++cost)
+        stacks.append(NimStackFolder::readFolded(costFile(recording, NimAllocationSite::Cost(cost))));
+    return allocationSites(stacks);
+}
+
+// NimHeapAnalyzer
+
+static QString heaptrackPrint(const FilePath &trace, const QStringList &arguments, QString *output)
+{
+    const FilePath executable = Environment::systemEnvironment().searchInPath("heaptrack_print");
+    if (executable.isEmpty())
+        return tr("heaptrack_print was not found in PATH.");
+    QProcess process;
+    process.start(executable.toString(), QStringList{"-f", trace.toString()} + arguments);
+    if (!process.waitForStarted())
+        return tr("Could not start heaptrack_print: %1").arg(process.errorString());
+    process.closeWriteChannel();
+    process.waitForFinished(-1);
+    if (output)
+        *output = QString::fromUtf8(process.readAllStandardOutput());
+    if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+        return tr("heaptrack_print failed for %1: %2")
+                .arg(trace.toUserOutput(), QString::fromLocal8Bit(process.readAllStandardError()).trimmed());
+    }
+    return QString();
+}
+
+NimHeapAnalyzer::NimHeapAnalyzer(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_watcher, &QFutureWatcher<QString>::finished, this, [this] {
+        const QString errorString = m_watcher.result();
+        if (errorString.isEmpty())
+            emit finished(NimPerfRecordings::foldedFile(m_recording));
+        else
+            emit failed(errorString);
+    });
+}
+
+NimHeapAnalyzer::~NimHeapAnalyzer()
+{
+    m_watcher.waitForFinished();
+}
+
+void NimHeapAnalyzer::analyze(const FilePath &recording)
+{
+    if (m_watcher.isRunning()) {
+        emit failed(tr("Another heap recording is being analyzed."));
+        return;
+    }
+    m_recording = recording;
+    m_watcher.setFuture(QtConcurrent::run([recording]() -> QString {
+        const FilePath trace = NimHeapProfile::traceFile(recording);
+        if (trace.isEmpty())
+            return tr("heaptrack did not write %1.").arg(recording.toUserOutput());
+
+        // heaptrack_print writes the stacks of one cost per run
+        const QStringList costTypes = {"allocations", "temporary", "peak", "leaked"};
+        for (int cost = 0; cost < NimAllocationSite::CostCount; ++cost) {
+            const FilePath folded = NimHeapProfile::costFile(recording, NimAllocationSite::Cost(cost));
+            const FilePath raw = folded.stringAppended(".raw");
+            QString output;
+            const QString errorString = heaptrackPrint(trace, {"-F", raw.toString(), "--flamegraph-cost-type",
+                                                               costTypes.at(cost)}, &output);
+            if (!errorString.isEmpty()) {
+                QFile::remove(raw.toString());
+                return errorString;
+            }
+            if (cost == NimAllocationSite::Allocations)
+                NimHeapProfile::writeSummary(recording, NimHeapProfile::parseSummary(output));
+
+            NimFoldedStacks stacks;
+            const NimFoldedStacks rawStacks = NimStackFolder::readFolded(raw);
+            for (auto it = rawStacks.cbegin(); it != rawStacks.cend(); ++it) {
+                QStringList frames = it.key().split(';');
+                for (QString &frame : frames)
+                    frame = NimHeapProfile::frameName(frame);
+                stacks[frames.join(';')] += it.value();
+            }
+            QFile::remove(raw.toString());
+            if (!NimStackFolder::writeFolded(folded, stacks))
+                return tr("Could not write %1.").arg(folded.toUserOutput());
+        }
+        return QString();
+    }));
+}
+
+// NimHeaptrackRunner
+
+NimHeaptrackRunner::NimHeaptrackRunner(RunControl *runControl)
+    : SimpleTargetRunner(runControl)
+{
+    setId("NimHeaptrackRunner");
+
+    setStarter([this, runControl] {
+        const FilePath heaptrack = NimHeapProfile::heaptrackExecutable();
+        if (heaptrack.isEmpty()) {
+            reportFailure(tr("heaptrack was not found in PATH."));
+            return;
+        }
+        m_recording = NimPerfRecordings::newRecording(
+                    NimPerfRecordings::directory(runControl->runConfiguration(), NimPerfRecordings::HeapRecording));
+
+        Runnable runnable = runControl->runnable();
+        CommandLine command(heaptrack, {"-o", m_recording.toString(), runnable.executable.toString()});
+        command.addArgs(runnable.commandLineArguments, CommandLine::Raw);
+        runnable.executable = heaptrack;
+        runnable.commandLineArguments = command.arguments();
+        appendMessage(tr("Recording the heap allocations to %1").arg(m_recording.toUserOutput()),
+                      NormalMessageFormat);
+        doStart(runnable, device());
+    });
+
+    connect(this, &RunWorker::stopped, this, [this, runControl] {
+        if (!NimHeapProfile::traceFile(m_recording).isEmpty() && NimProfilerPane::instance())
+            NimProfilerPane::instance()->addHeapRecording(runControl->displayName(), m_recording);
+    });
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QTest>
+
+namespace Nim {
+
+void RustPlugin::testHeapProfile()
+{
+    const NimHeapSummary summary = NimHeapProfile::parseSummary(
+                "total runtime: 0.05s.\n"
+                "calls to allocation functions: 1035 (20700/s)\n"
+                "temporary memory allocations: 214 (4280/s)\n"
+                "peak heap memory consumption: 85.34K\n"
+                "peak RSS (including heaptrack overhead): 5.52M\n"
+                "total memory leaked: 70B\n");
+    QCOMPARE(summary.allocations, qint64(1035));
+    QCOMPARE(summary.temporaryAllocations, qint64(214));
+    QCOMPARE(summary.peakBytes, qint64(85340));
+    QCOMPARE(summary.leakedBytes, qint64(70));
+    QCOMPARE(summary.allocatedBytes, qint64(-1));
+
+    QCOMPARE(NimHeapProfile::frameName("server::parse::h0123456789abcdef"), QString("server::parse"));
+    QVERIFY(NimHeapProfile::isAllocatorFrame("alloc::raw_vec::RawVec<T,A>::reserve"));
+    QVERIFY(NimHeapProfile::isAllocatorFrame("<alloc::string::String as core::clone::Clone>::clone"));
+    QVERIFY(!NimHeapProfile::isAllocatorFrame("server::parse"));
+
+    NimFoldedStacks allocations;
+    allocations["main;server::run;server::parse;alloc::vec::Vec<T>::push;malloc"] = 10;
+    allocations["main;server::run;server::parse;__rust_alloc"] = 5;
+    allocations["main;server::handle;server::parse;malloc"] = 3;
+    allocations["main;server::run;malloc"] = 4;
+    NimFoldedStacks peak;
+    peak["main;server::run;malloc"] = 4096;
+    const QVector<NimAllocationSite> sites = NimHeapProfile::allocationSites({allocations, {}, peak});
+    QCOMPARE(sites.size(), 2);
+    QCOMPARE(sites.at(0).function, QString("server::parse"));
+    QCOMPARE(sites.at(0).costs[NimAllocationSite::Allocations], qint64(18));
+    QCOMPARE(sites.at(0).callers.size(), 2);
+    QCOMPARE(sites.at(0).callers.at(0).function, QString("server::run"));
+    QCOMPARE(sites.at(0).callers.at(0).costs[NimAllocationSite::Allocations], qint64(15));
+    QCOMPARE(sites.at(1).costs[NimAllocationSite::PeakBytes], qint64(4096));
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
@@ -0,0 +1,127 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include "nimstackfolder.h"
+
+#include <projectexplorer/runcontrol.h>
+#include <utils/fileutils.h>
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QVector>
+
+namespace Nim {
+
+// The totals heaptrack_print reports, -1 where it did not
+class NimHeapSummary
+{
+public:
+    qint64 allocations = -1;
+    qint64 temporaryAllocations = -1;
+    qint64 allocatedBytes = -1;
+    qint64 peakBytes = -1;
+    qint64 leakedBytes = -1;
+
+    QString toString() const;
+};
+
+// Where the program asked for memory: the innermost function outside of the
+// allocator and the collections of alloc and hashbrown, which are rarely
+// where allocations can be avoided
+class NimAllocationSite
+{
+public:
+    enum Cost { Allocations, TemporaryAllocations, PeakBytes, LeakedBytes, CostCount };
+
+    QString function;
+    qint64 costs[CostCount] = {};
+    // The callers of the function, most allocations first
+    QVector<NimAllocationSite> callers;
+};
+
+// Heap recordings of heaptrack are kept like the perf recordings, see
+// NimPerfRecordings::HeapRecording. Next to a recording are the folded
+// stacks of every cost, <recording>.folded for the number of allocations,
+// and the totals.
+class NimHeapProfile
+{
+public:
+    static Utils::FilePath heaptrackExecutable();
+    // heaptrack compresses what it writes and names the file accordingly
+    static Utils::FilePath traceFile(const Utils::FilePath &recording);
+    static Utils::FilePath costFile(const Utils::FilePath &recording, NimAllocationSite::Cost cost);
+    static Utils::FilePath summaryFile(const Utils::FilePath &recording);
+
+    static NimHeapSummary parseSummary(const QString &output);
+    static NimHeapSummary readSummary(const Utils::FilePath &recording);
+    static bool writeSummary(const Utils::FilePath &recording, const NimHeapSummary &summary);
+
+    // heaptrack demangles legacy Rust symbols as C++, leaving the hash
+    static QString frameName(const QString &frame);
+    static bool isAllocatorFrame(const QString &name);
+
+    // Indexed by cost, the most allocations first
+    static QVector<NimAllocationSite> allocationSites(const QVector<NimFoldedStacks> &stacks);
+    static QVector<NimAllocationSite> allocationSites(const Utils::FilePath &recording);
+};
+
+// Turns heaptrack's recordings into folded stacks and totals with
+// heaptrack_print in a worker thread
+class NimHeapAnalyzer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NimHeapAnalyzer(QObject *parent = nullptr);
+    ~NimHeapAnalyzer() override;
+
+    void analyze(const Utils::FilePath &recording);
+
+signals:
+    void finished(const Utils::FilePath &foldedFile);
+    void failed(const QString &message);
+
+private:
+    Utils::FilePath m_recording;
+    QFutureWatcher<QString> m_watcher;
+};
+
+// Runs the executable of a run configuration under heaptrack and hands the
+// recording to the profiler pane afterwards
+class NimHeaptrackRunner : public ProjectExplorer::SimpleTargetRunner
+{
+    Q_OBJECT
+
+public:
+    explicit NimHeaptrackRunner(ProjectExplorer::RunControl *runControl);
+
+private:
+    Utils::FilePath m_recording;
+};
+
+} // namespace Nim
@@ -0,0 +1,98 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimhotlinemarks.h"
+
+#include <texteditor/textmark.h>
+
+#include <QCoreApplication>
+#include <QPainter>
+#include <QPixmap>
+
+using namespace Utils;
+
+namespace Nim {
+
+const char HOT_LINE_CATEGORY[] = "Rust.HotLine";
+const double MIN_SHARE = 0.005;
+const int MAX_MARKS = 500;
+
+static QIcon heatIcon(double heat)
+{
+    // From yellow for the coolest marked lines to red for the hottest one
+    const QColor color = QColor::fromHsvF((1.0 - heat) * 60.0 / 360.0, 0.9, 0.95);
+    QPixmap pixmap(16, 16);
+    pixmap.fill(Qt::transparent);
+    QPainter painter(&pixmap);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(color.darker(130));
+    painter.setBrush(color);
+    painter.drawRoundedRect(QRectF(2, 2, 12, 12), 3, 3);
+    return QIcon(pixmap);
+}
+
+NimHotLineMarks::NimHotLineMarks() = default;
+
+NimHotLineMarks::~NimHotLineMarks() = default;
+
+void NimHotLineMarks::setReport(const NimHotLineReport &report)
+{
+    clear();
+    if (report.totalSamples == 0 || report.lines.isEmpty())
+        return;
+
+    const double hottest = double(report.lines.first().samples);
+    for (const NimHotLine &line : report.lines) {
+        const double share = double(line.samples) / report.totalSamples;
+        if (share < MIN_SHARE || int(m_marks.size()) >= MAX_MARKS)
+            break;
+        auto mark = std::make_unique<TextEditor::TextMark>(FilePath::fromString(line.file), line.line,
+                                                           Core::Id(HOT_LINE_CATEGORY));
+        mark->setIcon(heatIcon(line.samples / hottest));
+        mark->setPriority(TextEditor::TextMark::LowPriority);
+        const double selfShare = double(line.selfSamples) / report.totalSamples;
+        if (line.selfSamples == line.samples) {
+            mark->setLineAnnotation(QCoreApplication::translate("Nim::NimHotLineMarks", "%1% of the samples")
+                                        .arg(100 * share, 0, 'f', 1));
+        } else {
+            mark->setLineAnnotation(QCoreApplication::translate("Nim::NimHotLineMarks",
+                                                                "%1% of the samples, %2% in this line, "
+                                                                "the rest in inlined code")
+                                        .arg(100 * share, 0, 'f', 1)
+                                        .arg(100 * selfShare, 0, 'f', 1));
+        }
+        mark->setToolTip(QCoreApplication::translate("Nim::NimHotLineMarks",
+                                                     "%n samples", nullptr, int(line.samples)));
+        m_marks.push_back(std::move(mark));
+    }
+}
+
+void NimHotLineMarks::clear()
+{
+    m_marks.clear();
+}
+
+} // namespace Nim
@@ -0,0 +1,619 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimhotlines.h"
+#include "nimdwarf.h"
+#include "nimelffile.h"
+#include "nimperfrecorder.h"
+#include "nimrustdemangler.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QHash>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+using namespace Utils;
+
+namespace Nim {
+
+namespace {
+
+class SampleKey
+{
+public:
+    QByteArray symbol;
+    quint64 offset;
+
+    bool operator==(const SampleKey &other) const
+    {
+        return offset == other.offset && symbol == other.symbol;
+    }
+};
+
+uint qHash(const SampleKey &key, uint seed = 0)
+{
+    return ::qHash(key.symbol, seed) ^ ::qHash(key.offset, seed);
+}
+
+using LineKey = QPair<QString, int>;
+
+} // namespace
+
+static FilePath scriptFile(const FilePath &recording)
+{
+    return recording.stringAppended(".lines");
+}
+
+static NimDwarfSection dwarfSection(const QByteArray &data)
+{
+    NimDwarfSection section;
+    section.data = data.constData();
+    section.size = size_t(data.size());
+    return section;
+}
+
+NimHotLineAnalyzer::NimHotLineAnalyzer(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<NimHotLineReport>();
+    connect(&m_watcher, &QFutureWatcher<NimHotLineReport>::finished, this, [this] {
+        QFile::remove(scriptFile(m_recording).toString());
+        emit finished(m_recording, m_watcher.result());
+    });
+}
+
+NimHotLineAnalyzer::~NimHotLineAnalyzer()
+{
+    if (m_process) {
+        m_process->disconnect(this);
+        m_process->kill();
+        m_process->waitForFinished(1000);
+        delete m_process;
+    }
+    m_watcher.waitForFinished();
+}
+
+void NimHotLineAnalyzer::analyze(const FilePath &recording)
+{
+    if (m_process || m_watcher.isRunning()) {
+        emit failed(tr("Another recording is being analyzed."));
+        return;
+    }
+    m_recording = recording;
+
+    // Mangled names, as the symbol tables of the binaries have them
+    m_process = new QProcess;
+    m_process->setStandardOutputFile(scriptFile(recording).toString());
+    connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &NimHotLineAnalyzer::onScriptFinished);
+    connect(m_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart)
+            onScriptFinished(-1, QProcess::CrashExit);
+    });
+    m_process->start(NimPerfRecordings::perfExecutable().toString(),
+                     {"script", "--no-demangle", "-F", "ip,sym,symoff,dso", "-i", recording.toString()});
+}
+
+void NimHotLineAnalyzer::onScriptFinished(int exitCode, QProcess::ExitStatus status)
+{
+    const QString errors = QString::fromLocal8Bit(m_process->readAllStandardError()).trimmed();
+    m_process->disconnect(this);
+    m_process->deleteLater();
+    m_process = nullptr;
+    if (status != QProcess::NormalExit || exitCode != 0) {
+        QFile::remove(scriptFile(m_recording).toString());
+        emit failed(tr("perf script failed for %1: %2").arg(m_recording.toUserOutput(), errors));
+        return;
+    }
+
+    const FilePath recording = m_recording;
+    m_watcher.setFuture(QtConcurrent::run([recording] {
+        QFile script(scriptFile(recording).toString());
+        if (!script.open(QIODevice::ReadOnly)) {
+            NimHotLineReport report;
+            report.errors.append(script.errorString());
+            return report;
+        }
+        return analyzeScript(&script);
+    }));
+}
+
+// One line per sample, recorded without call graphs:
+//       55d0c1a2b3c4 _ZN6server4main17h0123456789abcdefE+0x14 (/path/to/server)
+NimHotLineReport NimHotLineAnalyzer::analyzeScript(QIODevice *script)
+{
+    NimHotLineReport report;
+    QHash<QString, QHash<SampleKey, qint64>> samplesByBinary;
+    while (!script->atEnd()) {
+        const QByteArray line = script->readLine().trimmed();
+        if (line.isEmpty())
+            continue;
+        ++report.totalSamples;
+        const int symbolStart = line.indexOf(' ');
+        const int binaryStart = line.lastIndexOf(" (");
+        const int offsetStart = line.lastIndexOf("+0x", binaryStart);
+        if (symbolStart < 0 || binaryStart <= symbolStart || offsetStart <= symbolStart) {
+            ++report.unresolvedSamples;
+            continue;
+        }
+        SampleKey key;
+        key.symbol = line.mid(symbolStart + 1, offsetStart - symbolStart - 1);
+        key.offset = line.mid(offsetStart + 3, binaryStart - offsetStart - 3).toULongLong(nullptr, 16);
+        const QString binary = QString::fromUtf8(line.mid(binaryStart + 2, line.size() - binaryStart - 3));
+        ++samplesByBinary[binary][key];
+    }
+
+    QHash<LineKey, NimHotLine> lines;
+    QHash<QString, NimHotFunction> functions;
+    QHash<QString, QHash<LineKey, NimHotLine>> functionLines;
+
+    for (auto binary = samplesByBinary.cbegin(); binary != samplesByBinary.cend(); ++binary) {
+        qint64 binarySamples = 0;
+        for (const qint64 count : binary.value())
+            binarySamples += count;
+
+        NimElfFile elf;
+        if (!elf.open(binary.key())) {
+            report.unresolvedSamples += binarySamples;
+            continue;
+        }
+        if (!elf.hasSection(".debug_line")) {
+            // Usually a system library, the share tells whether that matters
+            report.unresolvedSamples += binarySamples;
+            report.errors.append(QCoreApplication::translate("Nim::NimHotLineAnalyzer",
+                                                             "%1 has no debug information (%2% of the samples).")
+                                     .arg(binary.key())
+                                     .arg(100.0 * binarySamples / report.totalSamples, 0, 'f', 1));
+            continue;
+        }
+
+        // The line tables are indexed by ELF addresses, which perf gives as
+        // symbol and offset independent of where the binary was loaded
+        QHash<QByteArray, quint64> symbolAddresses;
+        for (const NimElfSymbol &symbol : elf.functionSymbols())
+            symbolAddresses.insert(symbol.name, symbol.address);
+
+        const QByteArray info = elf.section(".debug_info");
+        const QByteArray abbrev = elf.section(".debug_abbrev");
+        const QByteArray line = elf.section(".debug_line");
+        const QByteArray str = elf.section(".debug_str");
+        const QByteArray lineStr = elf.section(".debug_line_str");
+        const QByteArray strOffsets = elf.section(".debug_str_offsets");
+        const QByteArray addr = elf.section(".debug_addr");
+        const QByteArray ranges = elf.section(".debug_ranges");
+        const QByteArray rnglists = elf.section(".debug_rnglists");
+        NimDwarfSections sections;
+        sections.info = dwarfSection(info);
+        sections.abbrev = dwarfSection(abbrev);
+        sections.line = dwarfSection(line);
+        sections.str = dwarfSection(str);
+        sections.lineStr = dwarfSection(lineStr);
+        sections.strOffsets = dwarfSection(strOffsets);
+        sections.addr = dwarfSection(addr);
+        sections.ranges = dwarfSection(ranges);
+        sections.rnglists = dwarfSection(rnglists);
+        NimDwarfLineInfo lineInfo;
+        if (!lineInfo.load(sections)) {
+            report.unresolvedSamples += binarySamples;
+            report.errors.append(QString("%1: %2").arg(binary.key(),
+                                                       QString::fromStdString(lineInfo.errorString())));
+            continue;
+        }
+
+        std::vector<uint64_t> addresses;
+        for (auto sample = binary.value().cbegin(); sample != binary.value().cend(); ++sample) {
+            const auto symbol = symbolAddresses.constFind(sample.key().symbol);
+            if (symbol != symbolAddresses.cend())
+                addresses.push_back(symbol.value() + sample.key().offset);
+        }
+        std::sort(addresses.begin(), addresses.end());
+        addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+        const std::vector<NimDwarfAddressInfo> resolved = lineInfo.resolve(addresses);
+
+        const std::vector<std::string> &files = lineInfo.files();
+        auto lineKey = [&files](const NimDwarfLocation &location) {
+            return LineKey(QString::fromStdString(files.at(size_t(location.file))), location.line);
+        };
+
+        for (auto sample = binary.value().cbegin(); sample != binary.value().cend(); ++sample) {
+            const qint64 count = sample.value();
+            const auto symbol = symbolAddresses.constFind(sample.key().symbol);
+            if (symbol == symbolAddresses.cend()) {
+                report.unresolvedSamples += count;
+                continue;
+            }
+            const uint64_t address = symbol.value() + sample.key().offset;
+            const auto it = std::lower_bound(addresses.begin(), addresses.end(), address);
+            const NimDwarfAddressInfo &addressInfo = resolved.at(size_t(it - addresses.begin()));
+
+            // Compiler generated code of inlined functions has no line, it
+            // belongs to the innermost call
+            NimDwarfLocation leaf = addressInfo.location;
+            std::vector<NimDwarfLocation> callSites = addressInfo.callSites;
+            while (!leaf.isValid() && !callSites.empty()) {
+                leaf = callSites.back();
+                callSites.pop_back();
+            }
+            if (!leaf.isValid()) {
+                report.unresolvedSamples += count;
+                continue;
+            }
+
+            // The leaf line gets the sample as its own, each line that inlines
+            // it once more as part of the call
+            QVector<LineKey> counted{lineKey(leaf)};
+            for (const NimDwarfLocation &callSite : callSites) {
+                if (callSite.isValid() && !counted.contains(lineKey(callSite)))
+                    counted.append(lineKey(callSite));
+            }
+            for (const LineKey &key : counted) {
+                NimHotLine &hotLine = lines[key];
+                hotLine.file = key.first;
+                hotLine.line = key.second;
+                hotLine.samples += count;
+            }
+            lines[counted.first()].selfSamples += count;
+
+            // The line of the function itself is the outermost call
+            const NimDwarfLocation own = callSites.empty() || !callSites.front().isValid()
+                    ? leaf : callSites.front();
+            const QString name = NimRustDemangler::demangle(sample.key().symbol);
+            NimHotFunction &function = functions[name];
+            function.name = name;
+            function.samples += count;
+            NimHotLine &functionLine = functionLines[name][lineKey(own)];
+            functionLine.file = lineKey(own).first;
+            functionLine.line = own.line;
+            functionLine.samples += count;
+            if (callSites.empty())
+                functionLine.selfSamples += count;
+        }
+    }
+
+    auto bySamples = [](const auto &a, const auto &b) { return a.samples > b.samples; };
+    for (auto function = functions.begin(); function != functions.end(); ++function) {
+        function.value().lines = functionLines.value(function.key()).values().toVector();
+        std::sort(function.value().lines.begin(), function.value().lines.end(), bySamples);
+        report.functions.append(function.value());
+    }
+    std::sort(report.functions.begin(), report.functions.end(), bySamples);
+    report.lines = lines.values().toVector();
+    std::sort(report.lines.begin(), report.lines.end(), bySamples);
+    return report;
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QBuffer>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <cstring>
+#include <elf.h>
+
+namespace Nim {
+
+namespace {
+
+// Little-endian DWARF encodings for the hand-assembled sections
+class DwarfBuffer
+{
+public:
+    DwarfBuffer &fixed(quint64 value, int bytes)
+    {
+        for (int i = 0; i < bytes; ++i)
+            data.append(char(value >> (8 * i)));
+        return *this;
+    }
+
+    DwarfBuffer &uleb(quint64 value)
+    {
+        do {
+            const char byte = char(value & 0x7f);
+            value >>= 7;
+            data.append(value ? char(byte | 0x80) : byte);
+        } while (value);
+        return *this;
+    }
+
+    DwarfBuffer &sleb(qint64 value)
+    {
+        for (;;) {
+            const char byte = char(value & 0x7f);
+            value >>= 7;
+            if ((value == 0 && !(byte & 0x40)) || (value == -1 && (byte & 0x40))) {
+                data.append(byte);
+                return *this;
+            }
+            data.append(char(byte | 0x80));
+        }
+    }
+
+    DwarfBuffer &string(const QByteArray &value)
+    {
+        data.append(value).append('\0');
+        return *this;
+    }
+
+    // With the 32-bit unit length in front
+    QByteArray unit() const
+    {
+        DwarfBuffer result;
+        result.fixed(quint64(data.size()), 4);
+        return result.data + data;
+    }
+
+    QByteArray data;
+};
+
+} // namespace
+
+// app::main at 0x1000-0x1040 in src/main.rs inlines square() from src/math.rs
+// at line 11, which inlines add() at line 4:
+//   0x1000 main.rs:10
+//   0x1010 math.rs:3  (square)
+//   0x1020 math.rs:8  (add)
+//   0x1028 no line    (add, compiler generated)
+//   0x1030 main.rs:12
+static QByteArray testLineProgram()
+{
+    DwarfBuffer header;
+    // Minimum instruction length, maximum operations, default is_stmt, line
+    // base, line range and opcode base with the standard opcode lengths
+    header.fixed(1, 1).fixed(1, 1).fixed(1, 1).fixed(quint8(-5), 1).fixed(14, 1).fixed(13, 1);
+    for (const int length : {0, 1, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1})
+        header.fixed(quint64(length), 1);
+    header.fixed(0, 1); // no include directories
+    header.string("src/main.rs").uleb(0).uleb(0).uleb(0);
+    header.string("src/math.rs").uleb(0).uleb(0).uleb(0);
+    header.fixed(0, 1);
+
+    DwarfBuffer program;
+    program.fixed(0, 1).uleb(9).fixed(2, 1).fixed(0x1000, 8); // DW_LNE_set_address
+    quint64 address = 0x1000;
+    int file = 1;
+    int line = 1;
+    const auto row = [&](quint64 rowAddress, int rowFile, int rowLine) {
+        program.fixed(2, 1).uleb(rowAddress - address); // DW_LNS_advance_pc
+        if (rowFile != file)
+            program.fixed(4, 1).uleb(quint64(rowFile)); // DW_LNS_set_file
+        program.fixed(3, 1).sleb(rowLine - line); // DW_LNS_advance_line
+        program.fixed(1, 1); // DW_LNS_copy
+        address = rowAddress;
+        file = rowFile;
+        line = rowLine;
+    };
+    row(0x1000, 1, 10);
+    row(0x1010, 2, 3);
+    row(0x1020, 2, 8);
+    row(0x1028, 2, 0);
+    row(0x1030, 1, 12);
+    program.fixed(2, 1).uleb(0x1040 - address);
+    program.fixed(0, 1).uleb(1).fixed(1, 1); // DW_LNE_end_sequence
+
+    DwarfBuffer unit;
+    unit.fixed(4, 2).fixed(quint64(header.data.size()), 4);
+    unit.data += header.data + program.data;
+    return unit.unit();
+}
+
+static QByteArray testAbbreviations()
+{
+    DwarfBuffer abbrev;
+    // DW_TAG_compile_unit: name, comp_dir, stmt_list, low_pc, high_pc
+    abbrev.uleb(1).uleb(0x11).fixed(1, 1);
+    abbrev.uleb(0x03).uleb(0x08).uleb(0x1b).uleb(0x08).uleb(0x10).uleb(0x17);
+    abbrev.uleb(0x11).uleb(0x01).uleb(0x12).uleb(0x07).uleb(0).uleb(0);
+    // DW_TAG_subprogram: low_pc, high_pc
+    abbrev.uleb(2).uleb(0x2e).fixed(1, 1);
+    abbrev.uleb(0x11).uleb(0x01).uleb(0x12).uleb(0x07).uleb(0).uleb(0);
+    // DW_TAG_inlined_subroutine: low_pc, high_pc, call_file, call_line
+    abbrev.uleb(3).uleb(0x1d).fixed(1, 1);
+    abbrev.uleb(0x11).uleb(0x01).uleb(0x12).uleb(0x07);
+    abbrev.uleb(0x58).uleb(0x0b).uleb(0x59).uleb(0x0b).uleb(0).uleb(0);
+    abbrev.uleb(0);
+    return abbrev.data;
+}
+
+static QByteArray testDebugInfo()
+{
+    DwarfBuffer info;
+    info.fixed(4, 2).fixed(0, 4).fixed(8, 1); // version, abbreviations, address size
+    info.uleb(1).string("src/main.rs").string("/work").fixed(0, 4).fixed(0x1000, 8).fixed(0x40, 8);
+    info.uleb(2).fixed(0x1000, 8).fixed(0x40, 8);
+    info.uleb(3).fixed(0x1010, 8).fixed(0x20, 8).fixed(1, 1).fixed(11, 1); // square()
+    info.uleb(3).fixed(0x1020, 8).fixed(0x10, 8).fixed(2, 1).fixed(4, 1);  // add()
+    info.uleb(0).uleb(0).uleb(0).uleb(0);
+    return info.unit();
+}
+
+// A relocatable-looking ELF file with just the symbol table and the debug sections
+static bool writeTestElf(const QString &path, const QByteArray &symbol, quint64 address, quint64 size,
+                         const QList<QPair<QByteArray, QByteArray>> &debugSections)
+{
+    Elf64_Sym symbols[2];
+    std::memset(symbols, 0, sizeof(symbols));
+    symbols[1].st_name = 1;
+    symbols[1].st_info = ELF64_ST_INFO(STB_GLOBAL, STT_FUNC);
+    symbols[1].st_shndx = SHN_ABS;
+    symbols[1].st_value = address;
+    symbols[1].st_size = size;
+    QList<QPair<QByteArray, QByteArray>> sections{
+        {".symtab", QByteArray(reinterpret_cast<const char *>(symbols), sizeof(symbols))},
+        {".strtab", QByteArray(1, '\0') + symbol + '\0'}};
+    sections += debugSections;
+
+    QByteArray data(sizeof(Elf64_Ehdr), '\0');
+    QByteArray names(1, '\0');
+    QVector<Elf64_Shdr> headers(1);
+    std::memset(headers.data(), 0, sizeof(Elf64_Shdr));
+    for (const QPair<QByteArray, QByteArray> &section : sections) {
+        Elf64_Shdr header;
+        std::memset(&header, 0, sizeof(header));
+        header.sh_name = quint32(names.size());
+        names += section.first + '\0';
+        header.sh_type = section.first == ".symtab" ? SHT_SYMTAB
+                       : section.first == ".strtab" ? SHT_STRTAB : SHT_PROGBITS;
+        if (section.first == ".symtab") {
+            header.sh_link = 2;
+            header.sh_info = 1;
+            header.sh_entsize = sizeof(Elf64_Sym);
+        }
+        header.sh_offset = quint64(data.size());
+        header.sh_size = quint64(section.second.size());
+        header.sh_addralign = 1;
+        data += section.second;
+        headers.append(header);
+    }
+    Elf64_Shdr namesHeader;
+    std::memset(&namesHeader, 0, sizeof(namesHeader));
+    namesHeader.sh_name = quint32(names.size());
+    names += QByteArray(".shstrtab") + '\0';
+    namesHeader.sh_type = SHT_STRTAB;
+    namesHeader.sh_offset = quint64(data.size());
+    namesHeader.sh_size = quint64(names.size());
+    namesHeader.sh_addralign = 1;
+    data += names;
+    headers.append(namesHeader);
+    while (data.size() % 8)
+        data += '\0';
+
+    Elf64_Ehdr header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.e_ident, ELFMAG, SELFMAG);
+    header.e_ident[EI_CLASS] = ELFCLASS64;
+    header.e_ident[EI_DATA] = ELFDATA2LSB;
+    header.e_ident[EI_VERSION] = EV_CURRENT;
+    header.e_type = ET_EXEC;
+    header.e_machine = EM_X86_64;
+    header.e_version = EV_CURRENT;
+    header.e_ehsize = sizeof(Elf64_Ehdr);
+    header.e_shentsize = sizeof(Elf64_Shdr);
+    header.e_shoff = quint64(data.size());
+    header.e_shnum = quint16(headers.size());
+    header.e_shstrndx = quint16(headers.size() - 1);
+    data.replace(0, sizeof(header), QByteArray(reinterpret_cast<const char *>(&header), sizeof(header)));
+    data += QByteArray(reinterpret_cast<const char *>(headers.constData()),
+                       int(headers.size() * sizeof(Elf64_Shdr)));
+
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+void RustPlugin::testHotLines()
+{
+    const QByteArray info = testDebugInfo();
+    const QByteArray abbrev = testAbbreviations();
+    const QByteArray line = testLineProgram();
+    NimDwarfSections sections;
+    sections.info = dwarfSection(info);
+    sections.abbrev = dwarfSection(abbrev);
+    sections.line = dwarfSection(line);
+    NimDwarfLineInfo lineInfo;
+    QVERIFY2(lineInfo.load(sections), lineInfo.errorString().c_str());
+    QStringList files;
+    for (const std::string &file : lineInfo.files())
+        files << QString::fromStdString(file);
+    QCOMPARE(files, QStringList({"/work/src/main.rs", "/work/src/math.rs"}));
+
+    // Outermost call first, the instruction's own line last
+    const auto location = [&files](const NimDwarfLocation &at) {
+        return at.isValid() ? QString("%1:%2").arg(QFileInfo(files.at(at.file)).fileName()).arg(at.line)
+                            : QString("?");
+    };
+    QStringList resolved;
+    for (const NimDwarfAddressInfo &address : lineInfo.resolve({0x1004, 0x1014, 0x1024, 0x102c, 0x1034, 0x2000})) {
+        QStringList calls;
+        for (const NimDwarfLocation &callSite : address.callSites)
+            calls << location(callSite);
+        resolved << (calls << location(address.location)).join(" > ");
+    }
+    QCOMPARE(resolved, QStringList({"main.rs:10", "main.rs:11 > math.rs:3",
+                                    "main.rs:11 > math.rs:4 > math.rs:8",
+                                    "main.rs:11 > math.rs:4 > ?", "main.rs:12", "?"}));
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    const QString binary = directory.filePath("app");
+    QVERIFY(writeTestElf(binary, "_ZN3app4main17h0123456789abcdefE", 0x1000, 0x40,
+                         {{".debug_info", info}, {".debug_abbrev", abbrev}, {".debug_line", line}}));
+
+    // perf script -F ip,sym,symoff,dso
+    QByteArray script;
+    const auto samples = [&script, &binary](int offset, int count) {
+        for (int i = 0; i < count; ++i) {
+            script += "    55d0c1a2b" + QByteArray::number(0x1000 + offset, 16)
+                    + " _ZN3app4main17h0123456789abcdefE+0x" + QByteArray::number(offset, 16)
+                    + " (" + binary.toUtf8() + ")\n";
+        }
+    };
+    samples(0x04, 3);
+    samples(0x14, 2);
+    samples(0x24, 4);
+    samples(0x2c, 1);
+    samples(0x34, 2);
+    script += "    7f3a5c0a1234 malloc+0x24 (/nonexistent/libc.so.6)\n";
+    script += "    ffffffffffffffff [unknown] ([unknown])\n";
+    QBuffer buffer(&script);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    const NimHotLineReport report = NimHotLineAnalyzer::analyzeScript(&buffer);
+
+    QCOMPARE(report.totalSamples, qint64(14));
+    QCOMPARE(report.unresolvedSamples, qint64(2));
+    QVERIFY(report.errors.isEmpty());
+
+    // "<line> <samples> <self samples>", the call of add() gets the compiler
+    // generated code of add()
+    const auto lines = [](const QVector<NimHotLine> &hotLines) {
+        QStringList result;
+        for (const NimHotLine &hotLine : hotLines) {
+            result << QString("%1:%2 %3 %4").arg(QFileInfo(hotLine.file).fileName()).arg(hotLine.line)
+                      .arg(hotLine.samples).arg(hotLine.selfSamples);
+        }
+        result.sort();
+        return result;
+    };
+    QCOMPARE(lines(report.lines), QStringList({"main.rs:10 3 3", "main.rs:11 7 0", "main.rs:12 2 2",
+                                               "math.rs:3 2 2", "math.rs:4 5 1", "math.rs:8 4 4"}));
+    QCOMPARE(report.lines.first().line, 11);
+
+    QCOMPARE(report.functions.size(), 1);
+    QCOMPARE(report.functions.first().name, QString("app::main"));
+    QCOMPARE(report.functions.first().samples, qint64(12));
+    QCOMPARE(lines(report.functions.first().lines),
+             QStringList({"main.rs:10 3 3", "main.rs:11 7 0", "main.rs:12 2 2"}));
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
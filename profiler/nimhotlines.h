@@ -0,0 +1,102 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include <utils/fileutils.h>
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+class QIODevice;
+QT_END_NAMESPACE
+
+namespace Nim {
+
+class NimHotLine
+{
+public:
+    QString file;
+    int line = 0;
+    qint64 selfSamples = 0;  // in the instructions of the line itself
+    qint64 samples = 0;      // including the code inlined into the line
+};
+
+class NimHotFunction
+{
+public:
+    QString name;
+    qint64 samples = 0;
+    // Lines of the function itself, code inlined into it counts for the call,
+    // most samples first
+    QVector<NimHotLine> lines;
+};
+
+class NimHotLineReport
+{
+public:
+    qint64 totalSamples = 0;
+    qint64 unresolvedSamples = 0;
+    QVector<NimHotFunction> functions;  // most samples first
+    QVector<NimHotLine> lines;          // most samples first
+    QStringList errors;
+};
+
+// Maps the samples of a perf recording to source lines with the DWARF
+// debug information of the sampled binaries. perf script lists the symbol
+// and offset of each sample, the line tables are read from the binaries
+// in a worker thread.
+class NimHotLineAnalyzer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NimHotLineAnalyzer(QObject *parent = nullptr);
+    ~NimHotLineAnalyzer() override;
+
+    void analyze(const Utils::FilePath &recording);
+
+    static NimHotLineReport analyzeScript(QIODevice *script);
+
+signals:
+    void finished(const Utils::FilePath &recording, const Nim::NimHotLineReport &report);
+    void failed(const QString &message);
+
+private:
+    void onScriptFinished(int exitCode, QProcess::ExitStatus status);
+
+    Utils::FilePath m_recording;
+    QProcess *m_process = nullptr;
+    QFutureWatcher<NimHotLineReport> m_watcher;
+};
+
+} // namespace Nim
+
+Q_DECLARE_METATYPE(Nim::NimHotLineReport)
@@ -0,0 +1,278 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimoffcpu.h"
+#include "nimperfrecorder.h"
+
+#include <QFile>
+#include <QHash>
+#include <QRegularExpression>
+
+#include <algorithm>
+
+using namespace Utils;
+
+namespace Nim {
+
+const char KERNEL_BINARY[] = "[kernel.kallsyms]";
+
+namespace {
+
+class SwitchOut
+{
+public:
+    double time = 0;
+    QString stack;
+    QString callSite;
+    QString blockedIn;
+};
+
+} // namespace
+
+QStringList NimOffCpuProfile::scriptArguments()
+{
+    return {"--no-inline", "--no-demangle", "--show-switch-events", "-F", "comm,tid,time,event,ip,sym,dso"};
+}
+
+// Events start with a header line, samples are followed by one indented
+// line per frame, inner frame first, and an empty line:
+//   server  4711 12345.678901: sched:sched_switch:
+//       ffffffff8a0c4d21 __schedule+0x2d1 ([kernel.kallsyms])
+//       7f0e6d2a3b4c __futex_abstimed_wait_common+0xcc (/usr/lib/libc.so.6)
+//       55d0c1a2b3d5 server::main+0x20 (/path/to/server)
+//
+//   server  4711 12345.678950: PERF_RECORD_SWITCH OUT
+//   server  4711 12345.702340: PERF_RECORD_SWITCH IN
+NimOffCpuProfile NimOffCpuProfile::fromScript(QIODevice *script)
+{
+    static const QRegularExpression header("^(.*\\S)\\s+(\\d+)\\s+(\\d+\\.\\d+):\\s+(.*)$");
+
+    NimOffCpuProfile result;
+    QHash<QString, NimBlockingCall> calls;
+    QHash<qint64, SwitchOut> switchedOut;
+
+    qint64 sampleThread = -1;
+    double sampleTime = 0;
+    QString process;
+    QStringList frames;
+    QStringList binaries;
+    auto finishSample = [&] {
+        if (sampleThread < 0)
+            return;
+        SwitchOut out;
+        out.time = sampleTime;
+        QStringList stack{process};
+        for (auto it = frames.crbegin(); it != frames.crend(); ++it)
+            stack.append(*it);
+        out.stack = stack.join(';');
+        // The program is the binary of the outermost frame
+        const QString program = binaries.isEmpty() ? QString() : binaries.last();
+        for (int i = 0; i < frames.size(); ++i) {
+            if (out.blockedIn.isEmpty() && binaries.at(i) != KERNEL_BINARY)
+                out.blockedIn = frames.at(i);
+            if (binaries.at(i) == program) {
+                out.callSite = frames.at(i);
+                break;
+            }
+        }
+        switchedOut.insert(sampleThread, out);
+        sampleThread = -1;
+        frames.clear();
+        binaries.clear();
+    };
+
+    while (!script->atEnd()) {
+        const QString rawLine = QString::fromUtf8(script->readLine());
+        const QString line = rawLine.trimmed();
+        if (line.isEmpty()) {
+            finishSample();
+            continue;
+        }
+        if (rawLine.at(0).isSpace() && sampleThread >= 0) {
+            QString binary;
+            frames.append(NimStackFolder::frameSymbol(line, &binary));
+            binaries.append(binary);
+            continue;
+        }
+
+        finishSample();
+        const QRegularExpressionMatch match = header.match(line);
+        if (!match.hasMatch())
+            continue;
+        const qint64 thread = match.captured(2).toLongLong();
+        const double time = match.captured(3).toDouble();
+        const QString event = match.captured(4);
+        if (event.startsWith("PERF_RECORD_SWITCH")) {
+            const auto out = switchedOut.find(thread);
+            if (out == switchedOut.end())
+                continue;
+            // Being preempted is not waiting for anything
+            if (event.contains("OUT") && event.contains("preempt")) {
+                switchedOut.erase(out);
+            } else if (event.contains(" IN")) {
+                const qint64 wait = qRound64((time - out->time) * 1e6);
+                if (wait > 0) {
+                    result.stacks[out->stack] += wait;
+                    const QString key = out->callSite + '\n' + out->blockedIn;
+                    NimBlockingCall &call = calls[key];
+                    call.callSite = out->callSite.isEmpty() ? QString("[unknown]") : out->callSite;
+                    call.blockedIn = out->blockedIn;
+                    ++call.switches;
+                    call.waitMicroseconds += wait;
+                }
+                switchedOut.erase(out);
+            }
+        } else if (event.contains("sched_switch")) {
+            sampleThread = thread;
+            sampleTime = time;
+            process = match.captured(1).trimmed();
+            process.replace(';', ':');
+        }
+    }
+    finishSample();
+
+    result.blockingCalls = calls.values().toVector();
+    std::sort(result.blockingCalls.begin(), result.blockingCalls.end(),
+              [](const NimBlockingCall &a, const NimBlockingCall &b) {
+        return a.waitMicroseconds > b.waitMicroseconds;
+    });
+    return result;
+}
+
+FilePath NimOffCpuProfile::blockingCallsFile(const FilePath &recording)
+{
+    QString path = recording.toString();
+    path.chop(QString(".data").size());
+    return FilePath::fromString(path + ".blocking");
+}
+
+// One call per line: call site, blocking frame, switches and microseconds, tab separated
+QVector<NimBlockingCall> NimOffCpuProfile::readBlockingCalls(const FilePath &path)
+{
+    QVector<NimBlockingCall> result;
+    QFile file(path.toString());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return result;
+    while (!file.atEnd()) {
+        const QStringList fields = QString::fromUtf8(file.readLine()).chopped(1).split('\t');
+        if (fields.size() != 4)
+            continue;
+        NimBlockingCall call;
+        call.callSite = fields.at(0);
+        call.blockedIn = fields.at(1);
+        call.switches = fields.at(2).toLongLong();
+        call.waitMicroseconds = fields.at(3).toLongLong();
+        result.append(call);
+    }
+    return result;
+}
+
+bool NimOffCpuProfile::writeBlockingCalls(const FilePath &path, const QVector<NimBlockingCall> &calls)
+{
+    QFile file(path.toString());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+    for (const NimBlockingCall &call : calls) {
+        file.write(QStringList{call.callSite, call.blockedIn, QString::number(call.switches),
+                               QString::number(call.waitMicroseconds)}.join('\t').toUtf8() + '\n');
+    }
+    return true;
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QBuffer>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Nim {
+
+void RustPlugin::testOffCpuProfile()
+{
+    const QString server = " (/work/target/release/server)";
+    const QString main = "\t    55d0c1a2b3d5 _ZN6server4main17h0123456789abcdefE+0x20" + server;
+    const QString schedule = "\t    ffffffff8a0c4d21 __schedule+0x2d1 ([kernel.kallsyms])";
+    const QString futexWait = "\t    7f0e6d2a3b4c __futex_abstimed_wait_common+0xcc (/usr/lib/libc.so.6)";
+    // perf script with scriptArguments(): two futex waits and a read, a
+    // preempted thread and a thread switched in without a sample
+    const QStringList lines{
+        "server  4711 100.000000: sched:sched_switch:",
+        schedule, futexWait, "\t    55d0c1a2b3c4 _RNvCs1234_6server4wait+0x14" + server, main, "",
+        "server  4711 100.000010: PERF_RECORD_SWITCH OUT",
+        "server  4712 100.001000: sched:sched_switch:",
+        schedule, "\t    7f0e6d2a1000 read+0x10 (/usr/lib/libc.so.6)",
+        "\t    55d0c1a2b400 _RNvCs1234_6server4load+0x8" + server, main, "",
+        "server  4712 100.001010: PERF_RECORD_SWITCH OUT",
+        "server  4712 100.001500: PERF_RECORD_SWITCH IN",
+        "server  4711 100.002010: PERF_RECORD_SWITCH IN",
+        "server  4713 100.004000: sched:sched_switch:",
+        schedule, "\t    55d0c1a2b500 _RNvCs1234_6server7compute+0x8" + server, "",
+        "server  4713 100.004001: PERF_RECORD_SWITCH OUT preempt",
+        "server  4714 100.005000: PERF_RECORD_SWITCH IN",
+        "server  4713 100.009000: PERF_RECORD_SWITCH IN",
+        "server  4711 100.010000: sched:sched_switch:",
+        schedule, futexWait, "\t    55d0c1a2b3d0 _RNvCs1234_6server4wait+0x20" + server, main, "",
+        "server  4711 100.013000: PERF_RECORD_SWITCH IN"};
+
+    QByteArray script = lines.join('\n').toUtf8();
+    QBuffer buffer(&script);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    const NimOffCpuProfile profile = NimOffCpuProfile::fromScript(&buffer);
+
+    NimFoldedStacks stacks;
+    stacks["server;server::main;server::wait;__futex_abstimed_wait_common;__schedule"] = 5010;
+    stacks["server;server::main;server::load;read;__schedule"] = 500;
+    QCOMPARE(profile.stacks, stacks);
+
+    QCOMPARE(profile.blockingCalls.size(), 2);
+    QCOMPARE(profile.blockingCalls.at(0).callSite, QString("server::wait"));
+    QCOMPARE(profile.blockingCalls.at(0).blockedIn, QString("__futex_abstimed_wait_common"));
+    QCOMPARE(profile.blockingCalls.at(0).switches, qint64(2));
+    QCOMPARE(profile.blockingCalls.at(0).waitMicroseconds, qint64(5010));
+    QCOMPARE(profile.blockingCalls.at(1).callSite, QString("server::load"));
+    QCOMPARE(profile.blockingCalls.at(1).blockedIn, QString("read"));
+    QCOMPARE(profile.blockingCalls.at(1).switches, qint64(1));
+    QCOMPARE(profile.blockingCalls.at(1).waitMicroseconds, qint64(500));
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    const FilePath recording = FilePath::fromString(directory.filePath("offcpu.data"));
+    const FilePath file = NimOffCpuProfile::blockingCallsFile(recording);
+    QCOMPARE(file.fileName(), QString("offcpu.blocking"));
+    QVERIFY(NimOffCpuProfile::writeBlockingCalls(file, profile.blockingCalls));
+    const QVector<NimBlockingCall> calls = NimOffCpuProfile::readBlockingCalls(file);
+    QCOMPARE(calls.size(), 2);
+    QCOMPARE(calls.at(1).callSite, QString("server::load"));
+    QCOMPARE(calls.at(1).waitMicroseconds, qint64(500));
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
@@ -0,0 +1,62 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include "nimstackfolder.h"
+
+#include <QVector>
+
+namespace Nim {
+
+class NimBlockingCall
+{
+public:
+    QString callSite;   // innermost frame of the program itself
+    QString blockedIn;  // innermost frame outside the kernel, like a futex wait
+    qint64 switches = 0;
+    qint64 waitMicroseconds = 0;
+};
+
+// Time threads spent off the CPU because they blocked, by stack. Built from
+// a recording of the sched:sched_switch events of the process, which have the
+// stack a thread switched away with, and the switch records which tell when
+// it ran again and whether it was preempted rather than blocked.
+class NimOffCpuProfile
+{
+public:
+    NimFoldedStacks stacks;                  // wait time in microseconds
+    QVector<NimBlockingCall> blockingCalls;  // most wait time first
+
+    static QStringList scriptArguments();
+    static NimOffCpuProfile fromScript(QIODevice *script);
+
+    static Utils::FilePath blockingCallsFile(const Utils::FilePath &recording);
+    static QVector<NimBlockingCall> readBlockingCalls(const Utils::FilePath &path);
+    static bool writeBlockingCalls(const Utils::FilePath &path, const QVector<NimBlockingCall> &calls);
+};
+
+} // namespace Nim
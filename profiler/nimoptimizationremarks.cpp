@@ -0,0 +1,296 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+
+#include "nimoptimizationremarks.h"
+#include "nimrustdemangler.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QSet>
+#include <QtConcurrent>
+
+using namespace Utils;
+
+namespace Nim {
+
+static QString demangleSymbols(const QString &message)
+{
+    static const QRegularExpression symbol("(?<![\\w$])(_ZN[\\w$.]+|_R[A-Z][\\w.]*)");
+    QString result;
+    int last = 0;
+    QRegularExpressionMatchIterator it = symbol.globalMatch(message);
+    while (it.hasNext()) {
+        const QRegularExpressionMatch match = it.next();
+        result += message.midRef(last, match.capturedStart(1) - last);
+        result += NimRustDemangler::demangle(match.captured(1).toUtf8());
+        last = match.capturedEnd(1);
+    }
+    return result + message.midRef(last);
+}
+
+// Inlining remarks name the caller, some others the function they are in
+static QString remarkFunction(const QString &message)
+{
+    static const QRegularExpression function("(?:inlined into '?([\\w$.]+)|in function[: ]+'?([\\w$.]+)"
+                                             "|Function: ([\\w$.]+))");
+    const QRegularExpressionMatch match = function.match(message);
+    if (!match.hasMatch())
+        return QString();
+    for (int i = 1; i <= 3; ++i) {
+        if (!match.captured(i).isEmpty())
+            return NimRustDemangler::demangle(match.captured(i).toUtf8());
+    }
+    return QString();
+}
+
+QVector<NimOptimizationRemark> NimOptimizationRemarks::parse(const QByteArray &log, const QString &crate,
+                                                             const FilePath &workspaceDirectory)
+{
+    static const QRegularExpression remark("^(.+):(\\d+):(\\d+) (\\S+) \\((success|missed|analysis|failure)\\): ",
+                                           QRegularExpression::DotMatchesEverythingOption);
+    const QDir workspace(workspaceDirectory.toString());
+    QVector<NimOptimizationRemark> result;
+    QSet<QString> seen;
+    QHash<QString, QStringList> sources;
+    for (const QByteArray &line : log.split('\n')) {
+        QString text;
+        if (line.startsWith('{'))
+            text = QJsonDocument::fromJson(line).object().value("message").toString();
+        else if (line.startsWith("note: "))
+            text = QString::fromUtf8(line.mid(6));
+        const QRegularExpressionMatch match = remark.match(text);
+        if (!match.hasMatch() || match.captured(1) == "<unknown file>" || match.captured(2) == "0")
+            continue;
+        // Loops and inlined functions repeat the same remark
+        if (seen.contains(text))
+            continue;
+        seen.insert(text);
+
+        NimOptimizationRemark remark;
+        remark.crate = crate;
+        remark.file = QDir::cleanPath(workspace.absoluteFilePath(match.captured(1)));
+        remark.line = match.captured(2).toInt();
+        remark.column = match.captured(3).toInt();
+        remark.pass = match.captured(4);
+        const QString kind = match.captured(5);
+        remark.kind = kind == "success" ? NimOptimizationRemark::Passed
+                    : kind == "analysis" ? NimOptimizationRemark::Analysis
+                                         : NimOptimizationRemark::Missed;
+        const QString message = text.mid(match.capturedEnd()).trimmed();
+        remark.message = demangleSymbols(message);
+        remark.function = remarkFunction(message);
+        if (remark.function.isEmpty()) {
+            auto source = sources.find(remark.file);
+            if (source == sources.end()) {
+                QFile file(remark.file);
+                source = sources.insert(remark.file, file.open(QIODevice::ReadOnly | QIODevice::Text)
+                                                         ? QString::fromUtf8(file.readAll()).split('\n')
+                                                         : QStringList());
+            }
+            remark.function = enclosingFunction(source.value(), remark.line);
+        }
+        result.append(remark);
+    }
+    return result;
+}
+
+QVector<NimOptimizationRemark> NimOptimizationRemarks::read(const FilePath &directory,
+                                                            const FilePath &workspaceDirectory)
+{
+    QVector<NimOptimizationRemark> result;
+    const QFileInfoList files = QDir(directory.toString()).entryInfoList({"*.remarks"}, QDir::Files, QDir::Name);
+    for (const QFileInfo &info : files) {
+        QFile file(info.absoluteFilePath());
+        if (file.open(QIODevice::ReadOnly))
+            result += parse(file.readAll(), info.completeBaseName(), workspaceDirectory);
+    }
+    return result;
+}
+
+QString NimOptimizationRemarks::enclosingFunction(const QStringList &sourceLines, int line)
+{
+    static const QRegularExpression function("\\bfn\\s+([A-Za-z_][A-Za-z0-9_]*)");
+    for (int i = qMin(line, sourceLines.size()) - 1; i >= 0; --i) {
+        const QRegularExpressionMatch match = function.match(sourceLines.at(i));
+        if (match.hasMatch())
+            return match.captured(1);
+    }
+    return QString();
+}
+
+QString NimOptimizationRemarks::kindName(NimOptimizationRemark::Kind kind)
+{
+    switch (kind) {
+    case NimOptimizationRemark::Passed:
+        return QCoreApplication::translate("Nim::NimOptimizationRemarks", "Passed");
+    case NimOptimizationRemark::Missed:
+        return QCoreApplication::translate("Nim::NimOptimizationRemarks", "Missed");
+    case NimOptimizationRemark::Analysis:
+        break;
+    }
+    return QCoreApplication::translate("Nim::NimOptimizationRemarks", "Analysis");
+}
+
+// NimOptimizationRemarksReader
+
+NimOptimizationRemarksReader::NimOptimizationRemarksReader(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<QVector<NimOptimizationRemark>>();
+    connect(&m_watcher, &QFutureWatcher<QVector<NimOptimizationRemark>>::finished, this, [this] {
+        emit finished(m_watcher.result());
+    });
+}
+
+NimOptimizationRemarksReader::~NimOptimizationRemarksReader()
+{
+    m_watcher.waitForFinished();
+}
+
+bool NimOptimizationRemarksReader::isRunning() const
+{
+    return m_watcher.isRunning();
+}
+
+void NimOptimizationRemarksReader::read(const FilePath &directory, const FilePath &workspaceDirectory)
+{
+    if (isRunning()) {
+        emit failed(tr("The optimization remarks are still being read."));
+        return;
+    }
+    m_watcher.setFuture(QtConcurrent::run(&NimOptimizationRemarks::read, directory, workspaceDirectory));
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Nim {
+
+void RustPlugin::testOptimizationRemarks()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    const auto write = [&directory](const QString &name, const QByteArray &contents) {
+        const QString path = directory.filePath(name);
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly) && file.write(contents) == contents.size();
+    };
+    QVERIFY(write("workspace/src/main.rs",
+                  "fn compute(values: &[u64]) -> u64 {\n"
+                  "    let mut sum = 0;\n"
+                  "    for v in values {\n"
+                  "        sum += v * v;\n"
+                  "    }\n"
+                  "    sum\n"
+                  "}\n"
+                  "fn main() {\n"
+                  "    println!(\"{}\", compute(&[1, 2, 3]));\n"
+                  "}\n"));
+    QVERIFY(write("workspace/util/src/lib.rs",
+                  "pub fn parse(text: &str) -> i64 {\n"
+                  "    let value = text.trim();\n"
+                  "    log(value);\n"
+                  "    value.parse().unwrap_or(0)\n"
+                  "}\n"));
+
+    // rustc -C remark=all with the human readable error format, the inlining
+    // remark repeats for every instance of the call
+    const QByteArray inlined = "note: src/main.rs:9:20 inline (success): '_ZN3app7compute17h0123456789abcdefE' "
+                               "inlined into '_ZN3app4main17hfedcba9876543210E' with (cost=35, threshold=375) "
+                               "at callsite _ZN3app4main17hfedcba9876543210E:9:20;\n\n";
+    QVERIFY(write("remarks/app.remarks",
+                  inlined + inlined
+                  + "note: src/main.rs:3:5 loop-vectorize (missed): loop not vectorized\n\n"
+                    "note: src/main.rs:4:13 loop-vectorize (analysis): loop not vectorized: value that "
+                    "could not be identified as reduction is used outside the loop\n\n"
+                    "note: <unknown file>:0:0 asm-printer (analysis): 42 instructions in function\n\n"
+                    "warning: unused variable: `sum`\n"));
+    // ... and with --error-format=json, next to the artifact notifications
+    QVERIFY(write("remarks/util.remarks",
+                  "{\"$message_type\":\"diagnostic\",\"message\":\"util/src/lib.rs:3:5 inline (missed): "
+                  "'_ZN4util3log17h0011223344556677E' will not be inlined into "
+                  "'_ZN4util5parse17h8899aabbccddeeffE' because its definition is unavailable\","
+                  "\"code\":null,\"level\":\"note\",\"spans\":[],\"children\":[],\"rendered\":null}\n"
+                  "{\"$message_type\":\"diagnostic\",\"message\":\"util/src/lib.rs:4:11 gvn (missed): "
+                  "load of type i64 not eliminated because it is clobbered by call\","
+                  "\"code\":null,\"level\":\"note\",\"spans\":[],\"children\":[],\"rendered\":null}\n"
+                  "{\"$message_type\":\"artifact\",\"artifact\":\"/work/target/release/deps/libutil.rlib\","
+                  "\"emit\":\"link\"}\n"));
+    QVERIFY(write("remarks/notes.txt", inlined));
+
+    const FilePath workspace = FilePath::fromString(directory.filePath("workspace"));
+    const QVector<NimOptimizationRemark> remarks = NimOptimizationRemarks::read(
+                FilePath::fromString(directory.filePath("remarks")), workspace);
+    QCOMPARE(remarks.size(), 5);
+
+    const NimOptimizationRemark &inlining = remarks.at(0);
+    QCOMPARE(inlining.crate, QString("app"));
+    QCOMPARE(inlining.file, workspace.pathAppended("src/main.rs").toString());
+    QCOMPARE(inlining.line, 9);
+    QCOMPARE(inlining.column, 20);
+    QCOMPARE(inlining.pass, QString("inline"));
+    QCOMPARE(inlining.kind, NimOptimizationRemark::Passed);
+    QCOMPARE(inlining.function, QString("app::main"));
+    QCOMPARE(inlining.message, QString("'app::compute' inlined into 'app::main' with (cost=35, threshold=375) "
+                                       "at callsite app::main:9:20;"));
+
+    // Remarks that do not name their function get the enclosing one
+    QCOMPARE(remarks.at(1).pass, QString("loop-vectorize"));
+    QCOMPARE(remarks.at(1).kind, NimOptimizationRemark::Missed);
+    QCOMPARE(remarks.at(1).line, 3);
+    QCOMPARE(remarks.at(1).function, QString("compute"));
+    QCOMPARE(remarks.at(1).message, QString("loop not vectorized"));
+    QCOMPARE(remarks.at(2).kind, NimOptimizationRemark::Analysis);
+    QCOMPARE(remarks.at(2).function, QString("compute"));
+
+    QCOMPARE(remarks.at(3).crate, QString("util"));
+    QCOMPARE(remarks.at(3).file, workspace.pathAppended("util/src/lib.rs").toString());
+    QCOMPARE(remarks.at(3).kind, NimOptimizationRemark::Missed);
+    QCOMPARE(remarks.at(3).function, QString("util::parse"));
+    QCOMPARE(remarks.at(3).message, QString("'util::log' will not be inlined into 'util::parse' "
+                                            "because its definition is unavailable"));
+    QCOMPARE(remarks.at(4).pass, QString("gvn"));
+    QCOMPARE(remarks.at(4).line, 4);
+    QCOMPARE(remarks.at(4).column, 11);
+    QCOMPARE(remarks.at(4).function, QString("parse"));
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
@@ -0,0 +1,94 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+
+#pragma once
+
+#include <utils/fileutils.h>
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QVector>
+
+namespace Nim {
+
+class NimOptimizationRemark
+{
+public:
+    enum Kind { Passed, Missed, Analysis };
+
+    QString crate;
+    QString file;
+    int line = 0;
+    int column = 0;
+    QString pass;
+    Kind kind = Analysis;
+    QString function;  // the function the remark is about, demangled
+    QString message;   // with demangled symbols
+};
+
+// Parses the optimization remarks the rustc wrapper collects for the crates
+// selected in the build step, one of rustc's notes per line:
+//   src/main.rs:5:9 inline (missed): '_ZN1p3foo17h...E' not inlined into '_ZN1p4main17h...E' ...
+// Remarks without a location, mostly from the code generator, are dropped.
+class NimOptimizationRemarks
+{
+public:
+    // Relative file names are resolved against the workspace directory
+    static QVector<NimOptimizationRemark> parse(const QByteArray &log, const QString &crate,
+                                                const Utils::FilePath &workspaceDirectory);
+    static QVector<NimOptimizationRemark> read(const Utils::FilePath &directory,
+                                               const Utils::FilePath &workspaceDirectory);
+
+    // The name of the last function declared before the line, for remarks
+    // that do not name theirs
+    static QString enclosingFunction(const QStringList &sourceLines, int line);
+
+    static QString kindName(NimOptimizationRemark::Kind kind);
+};
+
+class NimOptimizationRemarksReader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NimOptimizationRemarksReader(QObject *parent = nullptr);
+    ~NimOptimizationRemarksReader() override;
+
+    bool isRunning() const;
+    void read(const Utils::FilePath &directory, const Utils::FilePath &workspaceDirectory);
+
+signals:
+    void finished(const QVector<Nim::NimOptimizationRemark> &remarks);
+    void failed(const QString &message);
+
+private:
+    QFutureWatcher<QVector<NimOptimizationRemark>> m_watcher;
+};
+
+} // namespace Nim
+
+Q_DECLARE_METATYPE(QVector<Nim::NimOptimizationRemark>)
@@ -0,0 +1,176 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimperfrecorder.h"
+#include "nimprofilerpane.h"
+
+#include "../nimconstants.h"
+#include "../project/nimdatadirectory.h"
+
+#include <projectexplorer/runconfiguration.h>
+#include <projectexplorer/target.h>
+#include <utils/environment.h>
+
+#include <QDateTime>
+#include <QDir>
+
+using namespace ProjectExplorer;
+using namespace Utils;
+
+namespace Nim {
+
+const int MAX_RECORDINGS = 10;
+const char SAMPLING_FREQUENCY[] = "999";
+
+// NimPerfRecordings
+
+FilePath NimPerfRecordings::perfExecutable()
+{
+    return Environment::systemEnvironment().searchInPath("perf");
+}
+
+FilePath NimPerfRecordings::directory(RunConfiguration *runConfiguration, Kind kind)
+{
+    const FilePath directory = NimDataDirectory::forRunConfiguration(runConfiguration, "perf");
+    switch (kind) {
+    case LineRecording:
+        return directory.pathAppended("lines");
+    case OffCpuRecording:
+        return directory.pathAppended("offcpu");
+    case HeapRecording:
+        return directory.pathAppended("heap");
+    default:
+        return directory;
+    }
+}
+
+NimPerfRecordings::Kind NimPerfRecordings::kind(const FilePath &directory)
+{
+    const QString name = directory.fileName();
+    if (name == "lines")
+        return LineRecording;
+    if (name == "offcpu")
+        return OffCpuRecording;
+    if (name == "heap")
+        return HeapRecording;
+    return CpuRecording;
+}
+
+FilePath NimPerfRecordings::newRecording(const FilePath &directory)
+{
+    QDir dir(directory.toString());
+    dir.mkpath(".");
+    // heaptrack compresses its recordings
+    const QFileInfoList recordings = dir.entryInfoList({"*.data", "*.data.gz", "*.data.zst"}, QDir::Files,
+                                                       QDir::Name | QDir::Reversed);
+    // Along with what was derived from them, like the folded stacks
+    for (const QFileInfo &old : recordings.mid(MAX_RECORDINGS - 1)) {
+        for (const QString &file : dir.entryList({old.baseName() + ".*"}, QDir::Files))
+            QFile::remove(dir.absoluteFilePath(file));
+    }
+    return directory.pathAppended(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".data");
+}
+
+FilePaths NimPerfRecordings::folded(const FilePath &directory)
+{
+    FilePaths result;
+    const QDir dir(directory.toString());
+    for (const QFileInfo &file : dir.entryInfoList({"*.folded"}, QDir::Files, QDir::Name | QDir::Reversed))
+        result.append(FilePath::fromFileInfo(file));
+    return result;
+}
+
+FilePath NimPerfRecordings::foldedFile(const FilePath &recording)
+{
+    QString path = recording.toString();
+    path.chop(QString(".data").size());
+    return FilePath::fromString(path + ".folded");
+}
+
+// NimPerfRecordRunner
+
+NimPerfRecordRunner::NimPerfRecordRunner(RunControl *runControl)
+    : SimpleTargetRunner(runControl)
+{
+    setId("NimPerfRecordRunner");
+    if (runControl->runMode() == Constants::C_NIMPERF_HOTLINES_RUN_MODE)
+        m_kind = NimPerfRecordings::LineRecording;
+    else if (runControl->runMode() == Constants::C_NIMPERF_OFFCPU_RUN_MODE)
+        m_kind = NimPerfRecordings::OffCpuRecording;
+
+    setStarter([this, runControl] {
+        const FilePath perf = NimPerfRecordings::perfExecutable();
+        if (perf.isEmpty()) {
+            reportFailure(tr("perf was not found in PATH."));
+            return;
+        }
+        m_recording = NimPerfRecordings::newRecording(
+                    NimPerfRecordings::directory(runControl->runConfiguration(), m_kind));
+
+        Runnable runnable = runControl->runnable();
+        CommandLine command(perf, QStringList{"record"});
+        switch (m_kind) {
+        case NimPerfRecordings::CpuRecording:
+            command.addArgs({"-g", "--call-graph", "dwarf", "-F", SAMPLING_FREQUENCY});
+            break;
+        case NimPerfRecordings::LineRecording:
+            // Source lines only need the sampled instructions, which keeps
+            // the recording small
+            command.addArgs({"-F", SAMPLING_FREQUENCY});
+            break;
+        case NimPerfRecordings::OffCpuRecording:
+            // The stack of every switch away from the process, and the
+            // switch records telling when it was back and whether it was
+            // preempted rather than blocked
+            command.addArgs({"-e", "sched:sched_switch", "--switch-events", "-g", "--call-graph", "dwarf"});
+            break;
+        }
+        command.addArgs({"-o", m_recording.toString(), "--", runnable.executable.toString()});
+        command.addArgs(runnable.commandLineArguments, CommandLine::Raw);
+        runnable.executable = perf;
+        runnable.commandLineArguments = command.arguments();
+        appendMessage(tr("Recording to %1").arg(m_recording.toUserOutput()), NormalMessageFormat);
+        doStart(runnable, device());
+    });
+
+    connect(this, &RunWorker::stopped, this, [this, runControl] {
+        if (!m_recording.exists() || !NimProfilerPane::instance())
+            return;
+        switch (m_kind) {
+        case NimPerfRecordings::CpuRecording:
+            NimProfilerPane::instance()->addRecording(runControl->displayName(), m_recording);
+            break;
+        case NimPerfRecordings::LineRecording:
+            NimProfilerPane::instance()->addLineRecording(runControl->displayName(), m_recording);
+            break;
+        case NimPerfRecordings::OffCpuRecording:
+            NimProfilerPane::instance()->addOffCpuRecording(runControl->displayName(), m_recording);
+            break;
+        }
+    });
+}
+
+} // namespace Nim
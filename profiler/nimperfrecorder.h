@@ -0,0 +1,69 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include <projectexplorer/runcontrol.h>
+#include <utils/fileutils.h>
+
+namespace Nim {
+
+// Recordings are kept per run configuration in <data directory>/perf/<name>,
+// the ones other than CPU time in a subdirectory per kind. Heap recordings
+// come from heaptrack, see NimHeapProfile.
+class NimPerfRecordings
+{
+public:
+    enum Kind { CpuRecording, LineRecording, OffCpuRecording, HeapRecording };
+
+    static Utils::FilePath perfExecutable();
+    static Utils::FilePath directory(ProjectExplorer::RunConfiguration *runConfiguration,
+                                     Kind kind = CpuRecording);
+    static Kind kind(const Utils::FilePath &directory);
+    // A new, timestamped recording, dropping the oldest ones
+    static Utils::FilePath newRecording(const Utils::FilePath &directory);
+    // The recordings with folded stacks, newest first
+    static Utils::FilePaths folded(const Utils::FilePath &directory);
+    static Utils::FilePath foldedFile(const Utils::FilePath &recording);
+};
+
+// Runs the executable of a run configuration under perf record, sampling
+// with DWARF call graphs for flame graphs or without them for source line
+// annotations, or recording the stacks of the context switches for off-CPU
+// time, and hands the recording to the profiler pane afterwards.
+class NimPerfRecordRunner : public ProjectExplorer::SimpleTargetRunner
+{
+    Q_OBJECT
+
+public:
+    explicit NimPerfRecordRunner(ProjectExplorer::RunControl *runControl);
+
+private:
+    Utils::FilePath m_recording;
+    NimPerfRecordings::Kind m_kind = NimPerfRecordings::CpuRecording;
+};
+
+} // namespace Nim
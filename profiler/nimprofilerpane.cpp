@@ -0,0 +1,667 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimprofilerpane.h"
+#include "nimbenchmarkwidget.h"
+#include "nimcodegenwidget.h"
+#include "nimflamegraphwidget.h"
+#include "nimoffcpu.h"
+#include "nimperfrecorder.h"
+#include "nimremarkswidget.h"
+
+#include <coreplugin/editormanager/editormanager.h>
+#include <coreplugin/messagemanager.h>
+#include <projectexplorer/project.h>
+#include <projectexplorer/runconfiguration.h>
+#include <projectexplorer/session.h>
+#include <projectexplorer/target.h>
+
+#include <QComboBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QLocale>
+#include <QScrollArea>
+#include <QTabWidget>
+#include <QToolButton>
+#include <QTreeWidget>
+
+#include <algorithm>
+
+using namespace ProjectExplorer;
+using namespace Utils;
+
+namespace Nim {
+
+static NimProfilerPane *m_instance = nullptr;
+
+enum HotFunctionColumn { NameColumn, SamplesColumn, ShareColumn, LocationColumn };
+const int FileRole = Qt::UserRole;
+const int LineRole = Qt::UserRole + 1;
+const int MAX_FUNCTION_LINES = 10;
+
+enum BlockingCallColumn { CallSiteColumn, WaitColumn, WaitShareColumn, SwitchesColumn };
+
+enum AllocationColumn {
+    SiteColumn, AllocationsColumn, TemporaryColumn, PeakColumn, LeakedColumn, AllocationChangeColumn
+};
+const int MAX_ALLOCATION_SITES = 100;
+const int MAX_SITE_CALLERS = 10;
+
+// The recording folded stacks were derived from
+static FilePath recordingFile(const FilePath &folded)
+{
+    QString path = folded.toString();
+    path.chop(QString(".folded").size());
+    return FilePath::fromString(path + ".data");
+}
+
+static QString changeText(double change)
+{
+    return QString("%1%2%").arg(change >= 0 ? "+" : "").arg(100 * change, 0, 'f', 1);
+}
+
+enum BinarySizeColumn { SizeNameColumn, SizeColumn, SizeShareColumn, CopiesColumn, SizeChangeColumn };
+const int MAX_CRATE_FUNCTIONS = 100;
+
+NimProfilerPane::NimProfilerPane()
+    : m_tabWidget(new QTabWidget)
+    , m_scrollArea(new QScrollArea)
+    , m_hotFunctions(new QTreeWidget)
+    , m_blockingCalls(new QTreeWidget)
+    , m_allocations(new QTreeWidget)
+    , m_binarySize(new QTreeWidget)
+    , m_codegen(new NimCodegenWidget)
+    , m_remarks(new NimRemarksWidget)
+    , m_benchmarks(new NimBenchmarkWidget)
+    , m_flameGraph(new NimFlameGraphWidget)
+    , m_recordingComboBox(new QComboBox)
+    , m_baseComboBox(new QComboBox)
+    , m_icicleButton(new QToolButton)
+    , m_resetZoomButton(new QToolButton)
+    , m_searchLineEdit(new QLineEdit)
+    , m_searchLabel(new QLabel)
+{
+    m_instance = this;
+
+    m_scrollArea->setWidgetResizable(true);
+    m_scrollArea->setWidget(m_flameGraph);
+    m_hotFunctions->setHeaderLabels({tr("Function"), tr("Samples"), tr("Share"), tr("Location")});
+    m_hotFunctions->setRootIsDecorated(true);
+    m_hotFunctions->setUniformRowHeights(true);
+    m_hotFunctions->header()->setSectionResizeMode(NameColumn, QHeaderView::Stretch);
+    m_hotFunctions->header()->setStretchLastSection(false);
+    m_blockingCalls->setHeaderLabels({tr("Call Site"), tr("Wait Time"), tr("Share"), tr("Switches")});
+    m_blockingCalls->header()->setSectionResizeMode(CallSiteColumn, QHeaderView::Stretch);
+    m_blockingCalls->header()->setStretchLastSection(false);
+    m_allocations->setHeaderLabels({tr("Allocation Site / Caller"), tr("Allocations"), tr("Temporary"),
+                                    tr("Peak"), tr("Leaked"), tr("Change")});
+    m_allocations->setUniformRowHeights(true);
+    m_allocations->header()->setSectionResizeMode(SiteColumn, QHeaderView::Stretch);
+    m_allocations->header()->setStretchLastSection(false);
+    m_binarySize->setHeaderLabels({tr("Crate / Function"), tr("Size"), tr("Share"), tr("Copies"), tr("Change")});
+    m_binarySize->setUniformRowHeights(true);
+    m_binarySize->header()->setSectionResizeMode(SizeNameColumn, QHeaderView::Stretch);
+    m_binarySize->header()->setStretchLastSection(false);
+    m_tabWidget->setDocumentMode(true);
+    m_tabWidget->setTabPosition(QTabWidget::South);
+    m_tabWidget->addTab(m_scrollArea, tr("Flame Graph"));
+    m_tabWidget->addTab(m_hotFunctions, tr("Hot Functions"));
+    m_tabWidget->addTab(m_blockingCalls, tr("Blocking Calls"));
+    m_tabWidget->addTab(m_allocations, tr("Heap Allocations"));
+    m_tabWidget->addTab(m_binarySize, tr("Binary Size"));
+    m_tabWidget->addTab(m_codegen, tr("Generated Code"));
+    m_tabWidget->addTab(m_remarks, tr("Optimization Remarks"));
+    m_tabWidget->addTab(m_benchmarks, tr("Benchmarks"));
+    m_recordingComboBox->setToolTip(tr("Recording"));
+    m_recordingComboBox->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+    m_baseComboBox->setToolTip(tr("Compare with an earlier recording"));
+    m_baseComboBox->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+    m_icicleButton->setText(tr("Icicle"));
+    m_icicleButton->setToolTip(tr("Show the callers on top"));
+    m_icicleButton->setCheckable(true);
+    m_resetZoomButton->setText(tr("Reset Zoom"));
+    m_searchLineEdit->setPlaceholderText(tr("Search"));
+    m_searchLineEdit->setClearButtonEnabled(true);
+
+    connect(m_recordingComboBox, QOverload<int>::of(&QComboBox::activated),
+            this, &NimProfilerPane::updateGraph);
+    connect(m_baseComboBox, QOverload<int>::of(&QComboBox::activated),
+            this, &NimProfilerPane::updateGraph);
+    connect(m_icicleButton, &QToolButton::toggled, m_flameGraph, &NimFlameGraphWidget::setIcicle);
+    connect(m_resetZoomButton, &QToolButton::clicked, m_flameGraph, &NimFlameGraphWidget::resetZoom);
+    connect(m_searchLineEdit, &QLineEdit::textChanged, this, [this](const QString &text) {
+        m_flameGraph->setSearchText(text);
+        if (text.isEmpty())
+            m_searchLabel->clear();
+    });
+    connect(m_flameGraph, &NimFlameGraphWidget::searchMatched, this, [this](double share) {
+        m_searchLabel->setText(tr("%1% matched").arg(100 * share, 0, 'f', 1));
+    });
+
+    connect(&m_folder, &NimStackFolder::folded, this, [this](const FilePath &folded) {
+        m_directory = folded.parentDir();
+        updateRecordings(folded);
+        m_tabWidget->setCurrentWidget(NimPerfRecordings::kind(m_directory) == NimPerfRecordings::OffCpuRecording
+                                      ? static_cast<QWidget *>(m_blockingCalls) : m_scrollArea);
+        popup(IOutputPane::NoModeSwitch);
+    });
+    connect(&m_folder, &NimStackFolder::failed, this, [](const QString &message) {
+        Core::MessageManager::write(message);
+    });
+
+    connect(&m_heapAnalyzer, &NimHeapAnalyzer::finished, this, [this](const FilePath &folded) {
+        m_directory = folded.parentDir();
+        updateRecordings(folded);
+        m_tabWidget->setCurrentWidget(m_allocations);
+        popup(IOutputPane::NoModeSwitch);
+
+        const FilePaths recordings = NimPerfRecordings::folded(m_directory);
+        const int index = recordings.indexOf(folded);
+        const NimHeapSummary summary = NimHeapProfile::readSummary(recordingFile(folded));
+        QString message = tr("Heap profile %1: %2").arg(folded.toFileInfo().completeBaseName(),
+                                                        summary.toString());
+        if (index >= 0 && index + 1 < recordings.size()) {
+            const NimHeapSummary previous = NimHeapProfile::readSummary(recordingFile(recordings.at(index + 1)));
+            if (summary.allocations >= 0 && previous.allocations > 0 && summary.peakBytes >= 0
+                    && previous.peakBytes > 0) {
+                message += '\n' + tr("%1 allocations and %2 peak heap since %3")
+                        .arg(changeText(double(summary.allocations) / previous.allocations - 1),
+                             changeText(double(summary.peakBytes) / previous.peakBytes - 1),
+                             recordings.at(index + 1).toFileInfo().completeBaseName());
+            }
+        }
+        Core::MessageManager::write(message);
+    });
+    connect(&m_heapAnalyzer, &NimHeapAnalyzer::failed, this, [](const QString &message) {
+        Core::MessageManager::write(message);
+    });
+
+    connect(m_hotFunctions, &QTreeWidget::itemActivated, this, &NimProfilerPane::openHotLine);
+    connect(&m_hotLineAnalyzer, &NimHotLineAnalyzer::finished,
+            this, [this](const FilePath &, const NimHotLineReport &report) {
+        showHotLines(report);
+        m_tabWidget->setCurrentWidget(m_hotFunctions);
+        popup(IOutputPane::NoModeSwitch);
+    });
+    connect(&m_hotLineAnalyzer, &NimHotLineAnalyzer::failed, this, [](const QString &message) {
+        Core::MessageManager::write(message);
+    });
+
+    connect(&m_binarySizeAnalyzer, &NimBinarySizeAnalyzer::finished, this, [this](const NimBinarySize &size) {
+        showBinarySize(size);
+        m_tabWidget->setCurrentWidget(m_binarySize);
+        popup(IOutputPane::NoModeSwitch);
+    });
+    connect(&m_binarySizeAnalyzer, &NimBinarySizeAnalyzer::failed, this, [](const QString &message) {
+        Core::MessageManager::write(message);
+    });
+
+    connect(&m_codegenInspector, &NimCodegenInspector::finished, this, [this](const NimCodegenView &view) {
+        m_codegen->setView(view);
+        m_tabWidget->setCurrentWidget(m_codegen);
+        popup(IOutputPane::NoModeSwitch);
+    });
+    connect(&m_codegenInspector, &NimCodegenInspector::failed, this, [](const QString &message) {
+        Core::MessageManager::write(message);
+    });
+
+    connect(&m_remarksReader, &NimOptimizationRemarksReader::finished,
+            this, [this](const QVector<NimOptimizationRemark> &remarks) {
+        if (remarks.isEmpty()) {
+            Core::MessageManager::write(tr("No optimization remarks were recorded. Build the project "
+                                           "after listing crates under \"Optimization remarks for\" "
+                                           "in the build step."));
+        }
+        m_remarks->setRemarks(remarks);
+        m_remarkMarks.setRemarks(remarks);
+        m_tabWidget->setCurrentWidget(m_remarks);
+        popup(IOutputPane::NoModeSwitch);
+    });
+    connect(&m_remarksReader, &NimOptimizationRemarksReader::failed, this, [](const QString &message) {
+        Core::MessageManager::write(message);
+    });
+}
+
+NimProfilerPane::~NimProfilerPane()
+{
+    m_instance = nullptr;
+    delete m_tabWidget;
+    qDeleteAll(toolBarWidgets());
+}
+
+NimProfilerPane *NimProfilerPane::instance()
+{
+    return m_instance;
+}
+
+void NimProfilerPane::addRecording(const QString &title, const FilePath &recording)
+{
+    Core::MessageManager::write(tr("Folding the stacks of %1 (%2)...")
+                                    .arg(title, recording.toUserOutput()));
+    m_folder.fold(recording);
+}
+
+void NimProfilerPane::addLineRecording(const QString &title, const FilePath &recording)
+{
+    Core::MessageManager::write(tr("Mapping the samples of %1 to source lines (%2)...")
+                                    .arg(title, recording.toUserOutput()));
+    m_hotLineAnalyzer.analyze(recording);
+}
+
+void NimProfilerPane::addOffCpuRecording(const QString &title, const FilePath &recording)
+{
+    Core::MessageManager::write(tr("Collecting the off-CPU time of %1 (%2)...")
+                                    .arg(title, recording.toUserOutput()));
+    m_folder.fold(recording);
+}
+
+void NimProfilerPane::addHeapRecording(const QString &title, const FilePath &recording)
+{
+    Core::MessageManager::write(tr("Collecting the heap allocations of %1 (%2)...")
+                                    .arg(title, recording.toUserOutput()));
+    m_heapAnalyzer.analyze(recording);
+}
+
+void NimProfilerPane::analyzeBinarySize(const FilePath &binary, const FilePath &reportFile,
+                                        const FilePath &baseBinary)
+{
+    Core::MessageManager::write(baseBinary.isEmpty()
+                                    ? tr("Analyzing the code size of %1...").arg(binary.toUserOutput())
+                                    : tr("Comparing the code size of %1 with %2...")
+                                          .arg(binary.toUserOutput(), baseBinary.toUserOutput()));
+    m_binarySizeAnalyzer.analyze(binary, reportFile, baseBinary);
+}
+
+void NimProfilerPane::inspectGeneratedCode(NimBuildConfiguration *buildConfiguration, const FilePath &file,
+                                           int line, const QString &name)
+{
+    m_codegenInspector.inspect(buildConfiguration, file, line, name);
+}
+
+void NimProfilerPane::addBenchmarkRun(const QString &title, const FilePath &history)
+{
+    const QVector<NimBenchmarkRun> runs = NimBenchmarks::readHistory(history);
+    if (runs.isEmpty())
+        return;
+    m_benchmarks->setHistory(runs);
+    m_tabWidget->setCurrentWidget(m_benchmarks);
+    popup(IOutputPane::NoModeSwitch);
+
+    const int baseline = NimBenchmarks::defaultBaseline(runs);
+    if (baseline < 0) {
+        Core::MessageManager::write(tr("Recorded the first results of %1 in %2.")
+                                        .arg(title, history.toUserOutput()));
+        return;
+    }
+    QStringList regressions;
+    for (const NimBenchmarkComparison &comparison : NimBenchmarks::compare(runs.last(), runs.at(baseline))) {
+        if (comparison.verdict == NimBenchmarkComparison::Regressed) {
+            regressions.append(tr("%1: %2 instead of %3 (+%4%)")
+                                   .arg(comparison.result.name,
+                                        NimBenchmarks::formatDuration(comparison.result.estimate),
+                                        NimBenchmarks::formatDuration(comparison.baseline.estimate))
+                                   .arg(100 * comparison.change, 0, 'f', 1));
+        }
+    }
+    if (regressions.isEmpty()) {
+        Core::MessageManager::write(tr("No benchmark of %1 regressed since %2.")
+                                        .arg(title, runs.at(baseline).displayName()));
+    } else {
+        Core::MessageManager::write(tr("%n benchmarks of %1 regressed since %2:", nullptr, regressions.size())
+                                        .arg(title, runs.at(baseline).displayName())
+                                    + "\n" + regressions.join('\n'));
+    }
+}
+
+void NimProfilerPane::showOptimizationRemarks(const FilePath &directory, const FilePath &workspaceDirectory)
+{
+    m_remarksReader.read(directory, workspaceDirectory);
+}
+
+void NimProfilerPane::updateBlockingCalls(const FilePath &folded)
+{
+    m_blockingCalls->clear();
+    if (NimPerfRecordings::kind(folded.parentDir()) != NimPerfRecordings::OffCpuRecording)
+        return;
+    QString recording = folded.toString();
+    recording.chop(QString(".folded").size());
+    const QVector<NimBlockingCall> calls
+            = NimOffCpuProfile::readBlockingCalls(NimOffCpuProfile::blockingCallsFile(
+                                                      FilePath::fromString(recording + ".data")));
+    qint64 total = 0;
+    for (const NimBlockingCall &call : calls)
+        total += call.waitMicroseconds;
+    if (total == 0)
+        return;
+
+    // Call sites on top, with what they blocked in below. The calls come
+    // with the longest wait first.
+    QStringList callSiteOrder;
+    QHash<QString, NimBlockingCall> callSites;
+    for (const NimBlockingCall &call : calls) {
+        NimBlockingCall &callSite = callSites[call.callSite];
+        if (callSite.callSite.isEmpty()) {
+            callSite.callSite = call.callSite;
+            callSiteOrder.append(call.callSite);
+        }
+        callSite.switches += call.switches;
+        callSite.waitMicroseconds += call.waitMicroseconds;
+    }
+    std::stable_sort(callSiteOrder.begin(), callSiteOrder.end(), [&callSites](const QString &a, const QString &b) {
+        return callSites.value(a).waitMicroseconds > callSites.value(b).waitMicroseconds;
+    });
+
+    auto setWait = [total](QTreeWidgetItem *item, const NimBlockingCall &call) {
+        item->setText(WaitColumn, tr("%1 ms").arg(call.waitMicroseconds / 1000.0, 0, 'f', 1));
+        item->setText(WaitShareColumn, QString("%1%").arg(100.0 * call.waitMicroseconds / total, 0, 'f', 1));
+        item->setText(SwitchesColumn, QString::number(call.switches));
+    };
+    for (const QString &name : callSiteOrder) {
+        auto callSite = new QTreeWidgetItem(m_blockingCalls);
+        callSite->setText(CallSiteColumn, name);
+        callSite->setToolTip(CallSiteColumn, name);
+        setWait(callSite, callSites.value(name));
+        for (const NimBlockingCall &call : calls) {
+            if (call.callSite != name)
+                continue;
+            auto blockedIn = new QTreeWidgetItem(callSite);
+            blockedIn->setText(CallSiteColumn, tr("in %1").arg(call.blockedIn));
+            blockedIn->setToolTip(CallSiteColumn, call.blockedIn);
+            setWait(blockedIn, call);
+        }
+    }
+}
+
+void NimProfilerPane::updateAllocations(const FilePath &folded, const FilePath &baseFolded)
+{
+    m_allocations->clear();
+    m_allocations->setColumnHidden(AllocationChangeColumn, baseFolded.isEmpty());
+    if (NimPerfRecordings::kind(folded.parentDir()) != NimPerfRecordings::HeapRecording)
+        return;
+    const QVector<NimAllocationSite> sites = NimHeapProfile::allocationSites(recordingFile(folded));
+    QHash<QString, NimAllocationSite> baseSites;
+    if (!baseFolded.isEmpty()) {
+        for (const NimAllocationSite &site : NimHeapProfile::allocationSites(recordingFile(baseFolded)))
+            baseSites.insert(site.function, site);
+    }
+
+    const QLocale locale = QLocale::system();
+    auto setCosts = [&](QTreeWidgetItem *item, const NimAllocationSite &site) {
+        item->setText(SiteColumn, site.function);
+        item->setToolTip(SiteColumn, site.function);
+        item->setText(AllocationsColumn, locale.toString(site.costs[NimAllocationSite::Allocations]));
+        item->setText(TemporaryColumn, locale.toString(site.costs[NimAllocationSite::TemporaryAllocations]));
+        item->setText(PeakColumn, locale.formattedDataSize(site.costs[NimAllocationSite::PeakBytes]));
+        item->setText(LeakedColumn, locale.formattedDataSize(site.costs[NimAllocationSite::LeakedBytes]));
+        for (int column = AllocationsColumn; column <= AllocationChangeColumn; ++column)
+            item->setTextAlignment(column, Qt::AlignRight);
+    };
+    for (const NimAllocationSite &site : sites.mid(0, MAX_ALLOCATION_SITES)) {
+        auto siteItem = new QTreeWidgetItem(m_allocations);
+        setCosts(siteItem, site);
+        if (!baseFolded.isEmpty()) {
+            const qint64 before = baseSites.value(site.function).costs[NimAllocationSite::Allocations];
+            siteItem->setText(AllocationChangeColumn,
+                              before > 0 ? changeText(double(site.costs[NimAllocationSite::Allocations])
+                                                      / before - 1)
+                                         : tr("new"));
+        }
+        for (const NimAllocationSite &caller : site.callers.mid(0, MAX_SITE_CALLERS))
+            setCosts(new QTreeWidgetItem(siteItem), caller);
+    }
+}
+
+void NimProfilerPane::showBinarySize(const NimBinarySize &size)
+{
+    m_binarySize->clear();
+    const bool compared = !size.baseName.isEmpty();
+    m_binarySize->setColumnHidden(SizeChangeColumn, !compared);
+
+    const QLocale locale = QLocale::system();
+    auto formatSize = [&locale](qint64 bytes) { return locale.formattedDataSize(bytes); };
+    auto formatChange = [&formatSize](qint64 bytes) {
+        return bytes > 0 ? '+' + formatSize(bytes) : bytes < 0 ? '-' + formatSize(-bytes) : QString();
+    };
+    const qint64 total = size.attributedSize();
+    auto setSize = [&](QTreeWidgetItem *item, const NimSizeEntry &entry) {
+        item->setText(SizeNameColumn, entry.name);
+        item->setToolTip(SizeNameColumn, entry.name);
+        item->setText(SizeColumn, formatSize(entry.size));
+        item->setText(SizeShareColumn, QString("%1%").arg(total ? 100.0 * entry.size / total : 0, 0, 'f', 1));
+        item->setText(CopiesColumn, QString::number(entry.copies));
+        if (compared) {
+            item->setText(SizeChangeColumn, formatChange(entry.size - entry.baseSize));
+            item->setToolTip(SizeChangeColumn, tr("%1 in %n copies before", nullptr, entry.baseCopies)
+                                                   .arg(formatSize(entry.baseSize)));
+        }
+        for (int column = SizeColumn; column <= SizeChangeColumn; ++column)
+            item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+    };
+    for (const NimSizeEntry &crate : size.crates) {
+        auto crateItem = new QTreeWidgetItem(m_binarySize);
+        setSize(crateItem, crate);
+        for (const NimSizeEntry &function : crate.functions.mid(0, MAX_CRATE_FUNCTIONS))
+            setSize(new QTreeWidgetItem(crateItem), function);
+        if (crate.functions.size() > MAX_CRATE_FUNCTIONS) {
+            auto more = new QTreeWidgetItem(crateItem);
+            more->setText(SizeNameColumn, tr("%n more functions", nullptr,
+                                             crate.functions.size() - MAX_CRATE_FUNCTIONS));
+        }
+    }
+
+    Core::MessageManager::write(tr("Functions account for %1 of the %2 of code in %3.")
+                                    .arg(formatSize(total), formatSize(size.textSize),
+                                         size.binary.toUserOutput()));
+    if (compared) {
+        Core::MessageManager::write(tr("The code changed by %1 since %2.")
+                                        .arg(size.textSize == size.baseTextSize
+                                                 ? tr("0 bytes") : formatChange(size.textSize - size.baseTextSize),
+                                             size.baseName));
+    }
+}
+
+void NimProfilerPane::showHotLines(const NimHotLineReport &report)
+{
+    m_hotFunctions->clear();
+    m_hotLineMarks.setReport(report);
+    for (const QString &error : report.errors)
+        Core::MessageManager::write(error);
+    if (report.totalSamples == 0) {
+        Core::MessageManager::write(tr("The recording has no samples."));
+        return;
+    }
+    if (report.lines.isEmpty()) {
+        Core::MessageManager::write(tr("No samples could be mapped to source lines. Profile a Debug build, "
+                                       "or a Release build with \"Release with debug information\" "
+                                       "enabled in the build settings."));
+        return;
+    }
+
+    auto share = [&report](qint64 samples) {
+        return QString("%1%").arg(100.0 * samples / report.totalSamples, 0, 'f', 1);
+    };
+    auto setLocation = [](QTreeWidgetItem *item, const NimHotLine &line) {
+        item->setText(LocationColumn, QString("%1:%2").arg(FilePath::fromString(line.file).fileName())
+                                                      .arg(line.line));
+        item->setToolTip(LocationColumn, QString("%1:%2").arg(line.file).arg(line.line));
+        item->setData(NameColumn, FileRole, line.file);
+        item->setData(NameColumn, LineRole, line.line);
+    };
+    for (const NimHotFunction &function : report.functions) {
+        auto item = new QTreeWidgetItem(m_hotFunctions);
+        item->setText(NameColumn, function.name);
+        item->setToolTip(NameColumn, function.name);
+        item->setText(SamplesColumn, QString::number(function.samples));
+        item->setText(ShareColumn, share(function.samples));
+        if (!function.lines.isEmpty())
+            setLocation(item, function.lines.first());
+        for (const NimHotLine &line : function.lines.mid(0, MAX_FUNCTION_LINES)) {
+            auto child = new QTreeWidgetItem(item);
+            child->setText(NameColumn, line.selfSamples == line.samples ? tr("Line %1").arg(line.line)
+                                                                        : tr("Line %1, with inlined code")
+                                                                              .arg(line.line));
+            child->setText(SamplesColumn, QString::number(line.samples));
+            child->setText(ShareColumn, share(line.samples));
+            setLocation(child, line);
+        }
+    }
+    if (report.unresolvedSamples > 0) {
+        Core::MessageManager::write(tr("%1 of the samples could not be mapped to source lines.")
+                                        .arg(share(report.unresolvedSamples)));
+    }
+}
+
+void NimProfilerPane::openHotLine(QTreeWidgetItem *item)
+{
+    const QString file = item->data(NameColumn, FileRole).toString();
+    if (!file.isEmpty())
+        Core::EditorManager::openEditorAt(file, item->data(NameColumn, LineRole).toInt());
+}
+
+void NimProfilerPane::updateRecordings(const FilePath &select)
+{
+    m_recordingComboBox->clear();
+    m_baseComboBox->clear();
+    m_baseComboBox->addItem(tr("No comparison"));
+    for (const FilePath &folded : NimPerfRecordings::folded(m_directory)) {
+        const QString name = folded.toFileInfo().completeBaseName();
+        m_recordingComboBox->addItem(name, folded.toString());
+        m_baseComboBox->addItem(tr("Compared with %1").arg(name), folded.toString());
+    }
+    const int index = m_recordingComboBox->findData(select.toString());
+    m_recordingComboBox->setCurrentIndex(qMax(0, index));
+    updateGraph();
+}
+
+void NimProfilerPane::updateGraph()
+{
+    const FilePath recording = FilePath::fromString(m_recordingComboBox->currentData().toString());
+    const FilePath base = FilePath::fromString(m_baseComboBox->currentData().toString());
+    const bool differential = !base.isEmpty() && base != recording;
+    switch (NimPerfRecordings::kind(m_directory)) {
+    case NimPerfRecordings::OffCpuRecording:
+        m_flameGraph->setUnit(NimFlameGraphWidget::WaitTime);
+        break;
+    case NimPerfRecordings::HeapRecording:
+        m_flameGraph->setUnit(NimFlameGraphWidget::Allocations);
+        break;
+    default:
+        m_flameGraph->setUnit(NimFlameGraphWidget::Samples);
+        break;
+    }
+    m_flameGraph->setGraph(NimFlameGraph::build(NimStackFolder::readFolded(recording),
+                                                differential ? NimStackFolder::readFolded(base)
+                                                             : NimFoldedStacks()),
+                           differential);
+    updateBlockingCalls(recording);
+    updateAllocations(recording, differential ? base : FilePath());
+}
+
+QWidget *NimProfilerPane::outputWidget(QWidget *parent)
+{
+    m_tabWidget->setParent(parent);
+    return m_tabWidget;
+}
+
+QList<QWidget *> NimProfilerPane::toolBarWidgets() const
+{
+    return {m_recordingComboBox, m_baseComboBox, m_icicleButton, m_resetZoomButton,
+            m_searchLineEdit, m_searchLabel};
+}
+
+QString NimProfilerPane::displayName() const
+{
+    return tr("Rust Profile");
+}
+
+int NimProfilerPane::priorityInStatusBar() const
+{
+    return 5;
+}
+
+void NimProfilerPane::clearContents()
+{
+    m_flameGraph->setGraph(NimFlameGraphNode(), false);
+    m_hotFunctions->clear();
+    m_blockingCalls->clear();
+    m_allocations->clear();
+    m_binarySize->clear();
+    m_codegen->clear();
+    m_remarks->clear();
+    m_benchmarks->clear();
+    m_hotLineMarks.clear();
+    m_remarkMarks.clear();
+}
+
+void NimProfilerPane::visibilityChanged(bool visible)
+{
+    if (!visible || !m_directory.isEmpty())
+        return;
+    Project *project = SessionManager::startupProject();
+    if (!project || !project->activeTarget() || !project->activeTarget()->activeRunConfiguration())
+        return;
+    m_directory = NimPerfRecordings::directory(project->activeTarget()->activeRunConfiguration());
+    updateRecordings(FilePath());
+}
+
+void NimProfilerPane::setFocus()
+{
+    m_flameGraph->setFocus();
+}
+
+bool NimProfilerPane::hasFocus() const
+{
+    return m_flameGraph->hasFocus();
+}
+
+bool NimProfilerPane::canFocus() const
+{
+    return true;
+}
+
+bool NimProfilerPane::canNavigate() const
+{
+    return false;
+}
+
+bool NimProfilerPane::canNext() const
+{
+    return false;
+}
+
+bool NimProfilerPane::canPrevious() const
+{
+    return false;
+}
+
+void NimProfilerPane::goToNext()
+{}
+
+void NimProfilerPane::goToPrev()
+{}
+
+} // namespace Nim
@@ -0,0 +1,140 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include "nimbenchmarks.h"
+#include "nimbinarysize.h"
+#include "nimcodegen.h"
+#include "nimheapprofile.h"
+#include "nimhotlinemarks.h"
+#include "nimhotlines.h"
+#include "nimoptimizationremarks.h"
+#include "nimremarkmarks.h"
+#include "nimstackfolder.h"
+
+#include <coreplugin/ioutputpane.h>
+
+QT_BEGIN_NAMESPACE
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QScrollArea;
+class QTabWidget;
+class QToolButton;
+class QTreeWidget;
+class QTreeWidgetItem;
+QT_END_NAMESPACE
+
+namespace Nim {
+
+class NimBenchmarkWidget;
+class NimBuildConfiguration;
+class NimCodegenWidget;
+class NimFlameGraphWidget;
+class NimRemarksWidget;
+
+// Shows the perf recordings of a run configuration as flame graphs, on
+// their own or compared with an earlier recording, the functions and source
+// lines with the most samples of a line level recording, the calls that
+// waited longest in an off-CPU recording, the code size of a binary, the
+// code generated for a function, the optimization remarks of crates,
+// benchmark results compared with a baseline and the sites allocating most
+// in a heaptrack recording
+class NimProfilerPane : public Core::IOutputPane
+{
+    Q_OBJECT
+
+public:
+    NimProfilerPane();
+    ~NimProfilerPane() override;
+
+    static NimProfilerPane *instance();
+
+    void addRecording(const QString &title, const Utils::FilePath &recording);
+    void addLineRecording(const QString &title, const Utils::FilePath &recording);
+    void addOffCpuRecording(const QString &title, const Utils::FilePath &recording);
+    void addHeapRecording(const QString &title, const Utils::FilePath &recording);
+    void analyzeBinarySize(const Utils::FilePath &binary, const Utils::FilePath &reportFile,
+                           const Utils::FilePath &baseBinary = Utils::FilePath());
+    void inspectGeneratedCode(NimBuildConfiguration *buildConfiguration, const Utils::FilePath &file,
+                              int line, const QString &name);
+    void addBenchmarkRun(const QString &title, const Utils::FilePath &history);
+    void showOptimizationRemarks(const Utils::FilePath &directory,
+                                 const Utils::FilePath &workspaceDirectory);
+
+    QWidget *outputWidget(QWidget *parent) override;
+    QList<QWidget *> toolBarWidgets() const override;
+    QString displayName() const override;
+    int priorityInStatusBar() const override;
+    void clearContents() override;
+    void visibilityChanged(bool visible) override;
+    void setFocus() override;
+    bool hasFocus() const override;
+    bool canFocus() const override;
+    bool canNavigate() const override;
+    bool canNext() const override;
+    bool canPrevious() const override;
+    void goToNext() override;
+    void goToPrev() override;
+
+private:
+    void updateRecordings(const Utils::FilePath &select);
+    void updateGraph();
+    void showHotLines(const NimHotLineReport &report);
+    void openHotLine(QTreeWidgetItem *item);
+    void updateBlockingCalls(const Utils::FilePath &folded);
+    void updateAllocations(const Utils::FilePath &folded, const Utils::FilePath &baseFolded);
+    void showBinarySize(const NimBinarySize &size);
+
+    NimStackFolder m_folder;
+    NimHotLineAnalyzer m_hotLineAnalyzer;
+    NimHeapAnalyzer m_heapAnalyzer;
+    NimHotLineMarks m_hotLineMarks;
+    NimBinarySizeAnalyzer m_binarySizeAnalyzer;
+    NimCodegenInspector m_codegenInspector;
+    NimOptimizationRemarksReader m_remarksReader;
+    NimRemarkMarks m_remarkMarks;
+    Utils::FilePath m_directory;
+    QTabWidget *m_tabWidget;
+    QScrollArea *m_scrollArea;
+    QTreeWidget *m_hotFunctions;
+    QTreeWidget *m_blockingCalls;
+    QTreeWidget *m_allocations;
+    QTreeWidget *m_binarySize;
+    NimCodegenWidget *m_codegen;
+    NimRemarksWidget *m_remarks;
+    NimBenchmarkWidget *m_benchmarks;
+    NimFlameGraphWidget *m_flameGraph;
+    QComboBox *m_recordingComboBox;
+    QComboBox *m_baseComboBox;
+    QToolButton *m_icicleButton;
+    QToolButton *m_resetZoomButton;
+    QLineEdit *m_searchLineEdit;
+    QLabel *m_searchLabel;
+};
+
+} // namespace Nim
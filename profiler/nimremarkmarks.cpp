@@ -0,0 +1,118 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+
+#include "nimremarkmarks.h"
+
+#include <texteditor/textmark.h>
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QHash>
+#include <QMap>
+#include <QPainter>
+#include <QPixmap>
+
+#include <algorithm>
+
+using namespace Utils;
+
+namespace Nim {
+
+const char REMARK_CATEGORY[] = "Rust.OptimizationRemark";
+const int MAX_MARKS = 500;
+const int MAX_TOOLTIP_REMARKS = 10;
+
+static QIcon remarkIcon(bool missed)
+{
+    const QColor color = missed ? QColor(230, 126, 34) : QColor(46, 160, 67);
+    QPixmap pixmap(16, 16);
+    pixmap.fill(Qt::transparent);
+    QPainter painter(&pixmap);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(color.darker(130));
+    painter.setBrush(color);
+    painter.drawEllipse(QRectF(3, 3, 10, 10));
+    return QIcon(pixmap);
+}
+
+NimRemarkMarks::NimRemarkMarks() = default;
+
+NimRemarkMarks::~NimRemarkMarks() = default;
+
+void NimRemarkMarks::setRemarks(const QVector<NimOptimizationRemark> &remarks)
+{
+    clear();
+
+    // Analysis remarks are too many to mark, they stay in the table
+    QMap<QPair<QString, int>, QVector<NimOptimizationRemark>> lines;
+    for (const NimOptimizationRemark &remark : remarks) {
+        if (remark.kind != NimOptimizationRemark::Analysis)
+            lines[{remark.file, remark.line}].append(remark);
+    }
+
+    QHash<QString, bool> fileExists;
+    for (auto it = lines.cbegin(); it != lines.cend() && int(m_marks.size()) < MAX_MARKS; ++it) {
+        const QString &file = it.key().first;
+        auto exists = fileExists.find(file);
+        if (exists == fileExists.end())
+            exists = fileExists.insert(file, QFileInfo::exists(file));
+        if (!exists.value())
+            continue;
+
+        const QVector<NimOptimizationRemark> &lineRemarks = it.value();
+        const auto missed = std::find_if(lineRemarks.cbegin(), lineRemarks.cend(),
+                                         [](const NimOptimizationRemark &remark) {
+            return remark.kind == NimOptimizationRemark::Missed;
+        });
+        const NimOptimizationRemark &shown = missed != lineRemarks.cend() ? *missed : lineRemarks.first();
+
+        auto mark = std::make_unique<TextEditor::TextMark>(FilePath::fromString(file), it.key().second,
+                                                           Core::Id(REMARK_CATEGORY));
+        mark->setIcon(remarkIcon(missed != lineRemarks.cend()));
+        mark->setPriority(TextEditor::TextMark::LowPriority);
+        mark->setLineAnnotation(QString("%1: %2").arg(shown.pass, shown.message));
+        QStringList toolTip;
+        for (const NimOptimizationRemark &remark : lineRemarks.mid(0, MAX_TOOLTIP_REMARKS)) {
+            toolTip.append(QString("%1 (%2): %3").arg(remark.pass,
+                                                      NimOptimizationRemarks::kindName(remark.kind),
+                                                      remark.message));
+        }
+        if (lineRemarks.size() > MAX_TOOLTIP_REMARKS) {
+            toolTip.append(QCoreApplication::translate("Nim::NimRemarkMarks", "%n more remarks", nullptr,
+                                                       lineRemarks.size() - MAX_TOOLTIP_REMARKS));
+        }
+        mark->setToolTip(toolTip.join('\n'));
+        m_marks.push_back(std::move(mark));
+    }
+}
+
+void NimRemarkMarks::clear()
+{
+    m_marks.clear();
+}
+
+} // namespace Nim
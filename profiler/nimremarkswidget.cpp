@@ -0,0 +1,164 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+
+#include "nimremarkswidget.h"
+
+#include <coreplugin/editormanager/editormanager.h>
+#include <utils/fileutils.h>
+
+#include <QComboBox>
+#include <QHash>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QTreeWidget>
+
+#include <algorithm>
+#include <tuple>
+
+using namespace Utils;
+
+namespace Nim {
+
+enum RemarkColumn { RemarkNameColumn, KindColumn, PassColumn, LocationColumn };
+const int FileRole = Qt::UserRole;
+const int LineRole = Qt::UserRole + 1;
+const int AllKinds = -1;
+
+NimRemarksWidget::NimRemarksWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_filterLineEdit(new QLineEdit)
+    , m_kindComboBox(new QComboBox)
+    , m_countLabel(new QLabel)
+    , m_tree(new QTreeWidget)
+{
+    m_filterLineEdit->setPlaceholderText(tr("Filter"));
+    m_filterLineEdit->setClearButtonEnabled(true);
+    m_kindComboBox->addItem(tr("Missed"), NimOptimizationRemark::Missed);
+    m_kindComboBox->addItem(tr("Passed"), NimOptimizationRemark::Passed);
+    m_kindComboBox->addItem(tr("Analysis"), NimOptimizationRemark::Analysis);
+    m_kindComboBox->addItem(tr("All"), AllKinds);
+    m_tree->setHeaderLabels({tr("Function / Remark"), tr("Kind"), tr("Pass"), tr("Location")});
+    m_tree->setUniformRowHeights(true);
+    m_tree->header()->setSectionResizeMode(RemarkNameColumn, QHeaderView::Stretch);
+    m_tree->header()->setStretchLastSection(false);
+
+    auto toolBar = new QHBoxLayout;
+    toolBar->addWidget(m_filterLineEdit, 1);
+    toolBar->addWidget(m_kindComboBox);
+    toolBar->addWidget(m_countLabel, 1);
+    auto layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(toolBar);
+    layout->addWidget(m_tree);
+
+    connect(m_filterLineEdit, &QLineEdit::textChanged, this, &NimRemarksWidget::updateTree);
+    connect(m_kindComboBox, QOverload<int>::of(&QComboBox::activated), this, &NimRemarksWidget::updateTree);
+    connect(m_tree, &QTreeWidget::itemActivated, this, &NimRemarksWidget::openRemark);
+}
+
+void NimRemarksWidget::setRemarks(const QVector<NimOptimizationRemark> &remarks)
+{
+    m_remarks = remarks;
+    updateTree();
+}
+
+void NimRemarksWidget::clear()
+{
+    m_remarks.clear();
+    updateTree();
+}
+
+void NimRemarksWidget::updateTree()
+{
+    m_tree->clear();
+    const int kind = m_kindComboBox->currentData().toInt();
+    const QString filter = m_filterLineEdit->text();
+
+    // Functions with the most remarks first, their remarks in source order
+    QStringList functionOrder;
+    QHash<QString, QVector<const NimOptimizationRemark *>> functions;
+    int shown = 0;
+    for (const NimOptimizationRemark &remark : m_remarks) {
+        if (kind != AllKinds && remark.kind != kind)
+            continue;
+        if (!filter.isEmpty() && !remark.function.contains(filter, Qt::CaseInsensitive)
+                && !remark.pass.contains(filter, Qt::CaseInsensitive)
+                && !remark.message.contains(filter, Qt::CaseInsensitive)) {
+            continue;
+        }
+        const QString function = remark.function.isEmpty() ? tr("<unknown function>") : remark.function;
+        QVector<const NimOptimizationRemark *> &functionRemarks = functions[function];
+        if (functionRemarks.isEmpty())
+            functionOrder.append(function);
+        functionRemarks.append(&remark);
+        ++shown;
+    }
+    std::stable_sort(functionOrder.begin(), functionOrder.end(), [&functions](const QString &a, const QString &b) {
+        return functions.value(a).size() > functions.value(b).size();
+    });
+
+    auto setLocation = [](QTreeWidgetItem *item, const NimOptimizationRemark &remark) {
+        item->setText(LocationColumn, QString("%1:%2").arg(FilePath::fromString(remark.file).fileName())
+                                                      .arg(remark.line));
+        item->setToolTip(LocationColumn, QString("%1:%2:%3").arg(remark.file).arg(remark.line)
+                                                            .arg(remark.column));
+        item->setData(RemarkNameColumn, FileRole, remark.file);
+        item->setData(RemarkNameColumn, LineRole, remark.line);
+    };
+    for (const QString &function : functionOrder) {
+        QVector<const NimOptimizationRemark *> functionRemarks = functions.value(function);
+        std::stable_sort(functionRemarks.begin(), functionRemarks.end(),
+                         [](const NimOptimizationRemark *a, const NimOptimizationRemark *b) {
+            return std::tie(a->file, a->line, a->column) < std::tie(b->file, b->line, b->column);
+        });
+        auto functionItem = new QTreeWidgetItem(m_tree);
+        functionItem->setText(RemarkNameColumn, tr("%1 (%n remarks)", nullptr, functionRemarks.size())
+                                                    .arg(function));
+        functionItem->setToolTip(RemarkNameColumn, function);
+        setLocation(functionItem, *functionRemarks.first());
+        for (const NimOptimizationRemark *remark : functionRemarks) {
+            auto item = new QTreeWidgetItem(functionItem);
+            item->setText(RemarkNameColumn, remark->message);
+            item->setToolTip(RemarkNameColumn, remark->message);
+            item->setText(KindColumn, NimOptimizationRemarks::kindName(remark->kind));
+            item->setText(PassColumn, remark->pass);
+            setLocation(item, *remark);
+        }
+    }
+    m_countLabel->setText(tr("%1 of %n remarks", nullptr, m_remarks.size()).arg(shown));
+}
+
+void NimRemarksWidget::openRemark(QTreeWidgetItem *item)
+{
+    const QString file = item->data(RemarkNameColumn, FileRole).toString();
+    if (!file.isEmpty())
+        Core::EditorManager::openEditorAt(file, item->data(RemarkNameColumn, LineRole).toInt());
+}
+
+} // namespace Nim
@@ -0,0 +1,425 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+
+#include "nimrepeatedruns.h"
+#include "nimbenchmarks.h"
+
+#include "../project/nimdatadirectory.h"
+#include "../project/nimrunconfiguration.h"
+
+#include <projectexplorer/runconfiguration.h>
+#include <projectexplorer/target.h>
+#include <utils/qtcprocess.h>
+
+#include <QDir>
+#include <QFile>
+#include <QLocale>
+#include <QMap>
+#include <QProcess>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace ProjectExplorer;
+using namespace Utils;
+
+namespace Nim {
+
+const double OUTLIER_SCORE = 3.5;
+
+static double elapsedSeconds(const timespec &start)
+{
+    timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return double(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+static double toSeconds(const timeval &time)
+{
+    return time.tv_sec + time.tv_usec / 1e6;
+}
+
+// The process of a measured run, with everything allocated before it starts
+class NimSpawnedProcess
+{
+    Q_DISABLE_COPY(NimSpawnedProcess)
+
+public:
+    explicit NimSpawnedProcess(const Runnable &runnable)
+    {
+        m_executable = runnable.executable.toString().toLocal8Bit();
+        m_arguments.push_back(m_executable);
+        for (const QString &argument : QtcProcess::splitArgs(runnable.commandLineArguments))
+            m_arguments.push_back(argument.toLocal8Bit());
+        for (const QString &variable : runnable.environment.toStringList())
+            m_environment.push_back(variable.toLocal8Bit());
+        m_workingDirectory = runnable.workingDirectory.toLocal8Bit();
+        for (QByteArray &argument : m_arguments)
+            m_argv.push_back(argument.data());
+        m_argv.push_back(nullptr);
+        for (QByteArray &variable : m_environment)
+            m_envp.push_back(variable.data());
+        m_envp.push_back(nullptr);
+    }
+
+    // Starts the process with its standard streams on /dev/null, -1 on failure
+    pid_t spawn() const
+    {
+        pid_t pid = -1;
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+        if (!m_workingDirectory.isEmpty())
+            posix_spawn_file_actions_addchdir_np(&actions, m_workingDirectory.constData());
+        const int error = posix_spawn(&pid, m_executable.constData(), &actions, nullptr, m_argv.data(), m_envp.data());
+        posix_spawn_file_actions_destroy(&actions);
+        return error == 0 ? pid : -1;
+#else
+        // Without posix_spawn_file_actions_addchdir_np
+        pid = fork();
+        if (pid != 0)
+            return pid;
+        const int null = open("/dev/null", O_RDWR);
+        dup2(null, STDIN_FILENO);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        if (!m_workingDirectory.isEmpty() && chdir(m_workingDirectory.constData()) != 0)
+            _exit(127);
+        execve(m_executable.constData(), m_argv.data(), m_envp.data());
+        _exit(127);
+#endif
+    }
+
+private:
+    QByteArray m_executable;
+    std::vector<QByteArray> m_arguments;
+    std::vector<QByteArray> m_environment;
+    QByteArray m_workingDirectory;
+    std::vector<char *> m_argv;
+    std::vector<char *> m_envp;
+};
+
+static bool measure(const NimSpawnedProcess &process, std::atomic<qint64> &runningPid,
+                    NimRunMeasurement *measurement)
+{
+    timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    const pid_t pid = process.spawn();
+    if (pid < 0)
+        return false;
+    runningPid = pid;
+    int status = 0;
+    rusage usage;
+    pid_t waited;
+    do {
+        waited = wait4(pid, &status, 0, &usage);
+    } while (waited < 0 && errno == EINTR);
+    measurement->wallSeconds = elapsedSeconds(start);
+    runningPid = 0;
+    if (waited != pid)
+        return false;
+
+    measurement->userSeconds = toSeconds(usage.ru_utime);
+    measurement->systemSeconds = toSeconds(usage.ru_stime);
+    measurement->maxRssKiB = usage.ru_maxrss;
+    measurement->voluntarySwitches = usage.ru_nvcsw;
+    measurement->involuntarySwitches = usage.ru_nivcsw;
+    measurement->exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    return true;
+}
+
+static bool dropCaches()
+{
+    if (QProcess::execute("sync", {}) != 0)
+        return false;
+    QProcess tee;
+    tee.start("sudo", {"-n", "/usr/bin/tee", "/proc/sys/vm/drop_caches"});
+    if (!tee.waitForStarted())
+        return false;
+    tee.write("3\n");
+    tee.closeWriteChannel();
+    return tee.waitForFinished() && tee.exitStatus() == QProcess::NormalExit && tee.exitCode() == 0;
+}
+
+// NimRunStatistics
+
+NimRunStatistics NimRunStatistics::of(const QVector<double> &values)
+{
+    NimRunStatistics statistics;
+    statistics.count = values.size();
+    if (values.isEmpty())
+        return statistics;
+
+    auto median = [](QVector<double> sorted) {
+        std::sort(sorted.begin(), sorted.end());
+        const int middle = sorted.size() / 2;
+        return sorted.size() % 2 ? sorted.at(middle) : (sorted.at(middle - 1) + sorted.at(middle)) / 2;
+    };
+    statistics.mean = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+    statistics.median = median(values);
+    statistics.minimum = *std::min_element(values.begin(), values.end());
+    statistics.maximum = *std::max_element(values.begin(), values.end());
+    if (values.size() < 2)
+        return statistics;
+    double squares = 0;
+    for (double value : values)
+        squares += (value - statistics.mean) * (value - statistics.mean);
+    statistics.standardDeviation = std::sqrt(squares / (values.size() - 1));
+
+    QVector<double> deviations;
+    for (double value : values)
+        deviations.append(std::abs(value - statistics.median));
+    const double mad = median(deviations);
+    if (mad > 0) {
+        for (int i = 0; i < values.size(); ++i) {
+            if (0.6745 * std::abs(values.at(i) - statistics.median) / mad > OUTLIER_SCORE)
+                statistics.outliers.append(i);
+        }
+    }
+    return statistics;
+}
+
+// NimRepeatedRunner
+
+NimRepeatedRunner::NimRepeatedRunner(RunControl *runControl)
+    : RunWorker(runControl)
+{
+    setId("NimRepeatedRunner");
+    connect(&m_watcher, &QFutureWatcher<NimRepeatedRunResult>::finished, this, &NimRepeatedRunner::report);
+}
+
+NimRepeatedRunner::~NimRepeatedRunner()
+{
+    m_canceled = true;
+    m_watcher.waitForFinished();
+}
+
+FilePath NimRepeatedRunner::sessionFile(RunConfiguration *runConfiguration)
+{
+    return NimDataDirectory::forRunConfiguration(runConfiguration, "runs", ".last");
+}
+
+void NimRepeatedRunner::start()
+{
+    RunConfiguration *runConfiguration = runControl()->runConfiguration();
+    auto runsAspect = runConfiguration ? runConfiguration->aspect<NimRepeatedRunsAspect>() : nullptr;
+    auto warmupAspect = runConfiguration ? runConfiguration->aspect<NimWarmupRunsAspect>() : nullptr;
+    auto dropCachesAspect = runConfiguration ? runConfiguration->aspect<NimDropCachesAspect>() : nullptr;
+    if (!runsAspect || !warmupAspect || !dropCachesAspect) {
+        reportFailure(tr("The run configuration does not support repeated runs."));
+        return;
+    }
+    const int runs = int(runsAspect->value());
+    const int warmups = int(warmupAspect->value());
+    const bool cold = dropCachesAspect->value();
+    const Runnable runnable = runControl()->runnable();
+
+    appendMessage(tr("Running %1 %n time(s) after %2 warmup run(s)%3...", nullptr, runs)
+                      .arg(runnable.executable.toUserOutput()).arg(warmups)
+                      .arg(cold ? tr(", with a cold page cache") : QString()), NormalMessageFormat);
+    m_canceled = false;
+    m_watcher.setFuture(QtConcurrent::run([this, runnable, runs, warmups, cold] {
+        NimRepeatedRunResult result;
+        const NimSpawnedProcess process(runnable);
+        auto message = [this](const QString &text) {
+            QMetaObject::invokeMethod(this, [this, text] { appendMessage(text, NormalMessageFormat); },
+                                      Qt::QueuedConnection);
+        };
+        for (int i = 0; i < warmups + runs && !m_canceled; ++i) {
+            const bool warmup = i < warmups;
+            if (cold && !warmup && !dropCaches()) {
+                result.errorString = tr("Could not drop the page cache. It needs a sudo rule like "
+                                        "\"%1 ALL=(root) NOPASSWD: /usr/bin/tee /proc/sys/vm/drop_caches\".")
+                        .arg(qEnvironmentVariable("USER", "<user>"));
+                return result;
+            }
+            NimRunMeasurement measurement;
+            if (!measure(process, m_pid, &measurement)) {
+                result.errorString = tr("Could not start %1.").arg(runnable.executable.toUserOutput());
+                return result;
+            }
+            if (m_canceled)
+                break;
+            if (warmup)
+                continue;
+            result.runs.append(measurement);
+            message(tr("Run %1 of %2: %3 wall, %4 user, %5 system, exit code %6")
+                        .arg(result.runs.size()).arg(runs)
+                        .arg(NimBenchmarks::formatDuration(measurement.wallSeconds * 1e9),
+                             NimBenchmarks::formatDuration(measurement.userSeconds * 1e9),
+                             NimBenchmarks::formatDuration(measurement.systemSeconds * 1e9))
+                        .arg(measurement.exitCode));
+        }
+        return result;
+    }));
+    reportStarted();
+}
+
+void NimRepeatedRunner::stop()
+{
+    m_canceled = true;
+    if (const qint64 pid = m_pid)
+        kill(pid_t(pid), SIGKILL);
+    if (!m_watcher.isRunning())
+        reportStopped();
+}
+
+static QMap<QString, double> readSession(const FilePath &path)
+{
+    QMap<QString, double> means;
+    QFile file(path.toString());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return means;
+    while (!file.atEnd()) {
+        const QStringList fields = QString::fromUtf8(file.readLine()).trimmed().split('\t');
+        if (fields.size() == 2)
+            means.insert(fields.at(0), fields.at(1).toDouble());
+    }
+    return means;
+}
+
+static void writeSession(const FilePath &path, const QMap<QString, double> &means)
+{
+    QDir().mkpath(path.parentDir().toString());
+    QFile file(path.toString());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return;
+    for (auto it = means.cbegin(); it != means.cend(); ++it)
+        file.write(it.key().toUtf8() + '\t' + QByteArray::number(it.value(), 'g', 10) + '\n');
+}
+
+void NimRepeatedRunner::report()
+{
+    const NimRepeatedRunResult result = m_watcher.result();
+    if (!result.errorString.isEmpty())
+        appendMessage(result.errorString, ErrorMessageFormat);
+    if (result.runs.isEmpty()) {
+        reportStopped();
+        return;
+    }
+
+    const FilePath session = sessionFile(runControl()->runConfiguration());
+    const QMap<QString, double> previous = readSession(session);
+    QMap<QString, double> means;
+    QStringList lines;
+    auto addMetric = [&](const QString &key, const QString &title, double (*value)(const NimRunMeasurement &),
+                         const std::function<QString(double)> &format) {
+        QVector<double> values;
+        for (const NimRunMeasurement &run : result.runs)
+            values.append(value(run));
+        const NimRunStatistics statistics = NimRunStatistics::of(values);
+        means.insert(key, statistics.mean);
+        QString line = tr("%1 %2 ± %3, median %4, range %5 to %6")
+                .arg(title, -18)
+                .arg(format(statistics.mean), format(statistics.standardDeviation),
+                     format(statistics.median), format(statistics.minimum), format(statistics.maximum));
+        const double before = previous.value(key, -1);
+        if (before > 0) {
+            line += tr(", %1%2% since the previous session")
+                    .arg(statistics.mean >= before ? "+" : "")
+                    .arg(100 * (statistics.mean - before) / before, 0, 'f', 1);
+        }
+        lines << line;
+        if (!statistics.outliers.isEmpty()) {
+            QStringList runs;
+            for (int index : statistics.outliers)
+                runs << QString::number(index + 1);
+            lines << tr("    outliers in run(s) %1, consider more warmup runs or a quieter system")
+                         .arg(runs.join(", "));
+        }
+    };
+    auto duration = [](double seconds) { return NimBenchmarks::formatDuration(seconds * 1e9); };
+    auto memory = [](double kib) { return QLocale::system().formattedDataSize(qint64(kib * 1024)); };
+    auto count = [](double switches) { return QString::number(switches, 'f', 1); };
+    addMetric("wall", tr("Wall time:"), [](const NimRunMeasurement &run) { return run.wallSeconds; }, duration);
+    addMetric("user", tr("User time:"), [](const NimRunMeasurement &run) { return run.userSeconds; }, duration);
+    addMetric("system", tr("System time:"), [](const NimRunMeasurement &run) { return run.systemSeconds; },
+              duration);
+    addMetric("maxrss", tr("Peak memory:"), [](const NimRunMeasurement &run) { return double(run.maxRssKiB); },
+              memory);
+    addMetric("voluntary", tr("Voluntary switches:"),
+              [](const NimRunMeasurement &run) { return double(run.voluntarySwitches); }, count);
+    addMetric("involuntary", tr("Involuntary switches:"),
+              [](const NimRunMeasurement &run) { return double(run.involuntarySwitches); }, count);
+
+    const int failed = int(std::count_if(result.runs.begin(), result.runs.end(),
+                                         [](const NimRunMeasurement &run) { return run.exitCode != 0; }));
+    if (failed > 0)
+        lines << tr("%n run(s) exited with an error.", nullptr, failed);
+    appendMessage(tr("%n run(s) measured:", nullptr, result.runs.size()) + '\n' + lines.join('\n'),
+                  NormalMessageFormat);
+    // Only complete sessions count as the previous one
+    if (result.errorString.isEmpty() && !m_canceled)
+        writeSession(session, means);
+    reportStopped();
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QTest>
+
+namespace Nim {
+
+void RustPlugin::testRunStatistics()
+{
+    const NimRunStatistics statistics = NimRunStatistics::of({1.0, 1.1, 0.9, 1.0, 1.05, 0.95, 3.0});
+    QCOMPARE(statistics.count, 7);
+    QCOMPARE(statistics.median, 1.0);
+    QCOMPARE(statistics.minimum, 0.9);
+    QCOMPARE(statistics.maximum, 3.0);
+    QCOMPARE(statistics.mean, 9.0 / 7);
+    QCOMPARE(statistics.outliers, QVector<int>{6});
+
+    const NimRunStatistics even = NimRunStatistics::of({4, 1, 3, 2});
+    QCOMPARE(even.median, 2.5);
+    QVERIFY(even.outliers.isEmpty());
+    QCOMPARE(NimRunStatistics::of({}).count, 0);
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
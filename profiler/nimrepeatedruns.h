@@ -0,0 +1,102 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+
+#pragma once
+
+#include <projectexplorer/runcontrol.h>
+#include <utils/fileutils.h>
+
+#include <QFutureWatcher>
+#include <QVector>
+
+#include <atomic>
+
+namespace Nim {
+
+// One run of an executable, from wait4()'s resource usage
+class NimRunMeasurement
+{
+public:
+    double wallSeconds = 0;
+    double userSeconds = 0;
+    double systemSeconds = 0;
+    qint64 maxRssKiB = 0;
+    qint64 voluntarySwitches = 0;
+    qint64 involuntarySwitches = 0;
+    int exitCode = 0;
+};
+
+class NimRunStatistics
+{
+public:
+    int count = 0;
+    double mean = 0;
+    double median = 0;
+    double standardDeviation = 0;
+    double minimum = 0;
+    double maximum = 0;
+    // Runs with a modified z-score above 3.5, from the median absolute deviation
+    QVector<int> outliers;
+
+    static NimRunStatistics of(const QVector<double> &values);
+};
+
+class NimRepeatedRunResult
+{
+public:
+    QVector<NimRunMeasurement> runs;
+    QString errorString;
+};
+
+// Runs the executable of a run configuration a number of times after some
+// warmup runs, with its output discarded, and reports the statistics of the
+// wall-clock, user and system time, peak memory and context switches, with
+// the change since the previous session of the run configuration. Dropping
+// the page cache before every measured run needs a sudo rule like
+//   <user> ALL=(root) NOPASSWD: /usr/bin/tee /proc/sys/vm/drop_caches
+class NimRepeatedRunner : public ProjectExplorer::RunWorker
+{
+    Q_OBJECT
+
+public:
+    explicit NimRepeatedRunner(ProjectExplorer::RunControl *runControl);
+    ~NimRepeatedRunner() override;
+
+    // The means of the previous session, in <data directory>/runs/<name>.last
+    static Utils::FilePath sessionFile(ProjectExplorer::RunConfiguration *runConfiguration);
+
+private:
+    void start() override;
+    void stop() override;
+    void report();
+
+    QFutureWatcher<NimRepeatedRunResult> m_watcher;
+    std::atomic<bool> m_canceled{false};
+    std::atomic<qint64> m_pid{0};
+};
+
+} // namespace Nim
@@ -0,0 +1,1462 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimrustdemangler.h"
+
+#include <QVarLengthArray>
+#include <QtConcurrent>
+
+#include <cstdint>
+#include <cstring>
+
+namespace Nim {
+
+namespace {
+
+const int MAX_DEPTH = 500;
+const int MAX_PUNYCODE_LENGTH = 128;
+const int CHUNK_SIZE = 4096;
+const int MAX_OUTPUT_SIZE = 1000000;
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+bool isLower(char c) { return c >= 'a' && c <= 'z'; }
+bool isUpper(char c) { return c >= 'A' && c <= 'Z'; }
+bool isHexDigit(char c) { return isDigit(c) || (c >= 'a' && c <= 'f'); }
+
+// The buffers are large enough for a u64, one UTF-8 encoded character and
+// the longest escape, \u{10ffff}
+int formatNumber(uint64_t value, char *buffer)
+{
+    char digits[20];
+    int count = 0;
+    do {
+        digits[count++] = char('0' + value % 10);
+        value /= 10;
+    } while (value);
+    for (int i = 0; i < count; ++i)
+        buffer[i] = digits[count - 1 - i];
+    return count;
+}
+
+int encodeUtf8(uint32_t c, char *buffer)
+{
+    if (c < 0x80) {
+        buffer[0] = char(c);
+        return 1;
+    }
+    if (c < 0x800) {
+        buffer[0] = char(0xc0 | (c >> 6));
+        buffer[1] = char(0x80 | (c & 0x3f));
+        return 2;
+    }
+    if (c < 0x10000) {
+        buffer[0] = char(0xe0 | (c >> 12));
+        buffer[1] = char(0x80 | ((c >> 6) & 0x3f));
+        buffer[2] = char(0x80 | (c & 0x3f));
+        return 3;
+    }
+    buffer[0] = char(0xf0 | (c >> 18));
+    buffer[1] = char(0x80 | ((c >> 12) & 0x3f));
+    buffer[2] = char(0x80 | ((c >> 6) & 0x3f));
+    buffer[3] = char(0x80 | (c & 0x3f));
+    return 4;
+}
+
+bool isValidChar(uint64_t c)
+{
+    return c <= 0x10ffff && (c < 0xd800 || c > 0xdfff);
+}
+
+bool isControl(uint32_t c)
+{
+    return c < 0x20 || (c >= 0x7f && c < 0xa0);
+}
+
+// Like Rust's escape_debug, in a char or in a string literal
+int escapeChar(uint32_t c, char quote, char *buffer)
+{
+    auto escaped = [buffer](char c) {
+        buffer[0] = '\\';
+        buffer[1] = c;
+        return 2;
+    };
+    switch (c) {
+    case '\t': return escaped('t');
+    case '\r': return escaped('r');
+    case '\n': return escaped('n');
+    case '\\': return escaped('\\');
+    case 0: return escaped('0');
+    default: break;
+    }
+    if (c == uint32_t(quote))
+        return escaped(quote);
+    if (isControl(c)) {
+        static const char hex[] = "0123456789abcdef";
+        int size = 0;
+        for (const char *prefix = "\\u{"; *prefix; ++prefix)
+            buffer[size++] = *prefix;
+        if (c >= 0x10)
+            buffer[size++] = hex[c >> 4];
+        buffer[size++] = hex[c & 0xf];
+        buffer[size++] = '}';
+        return size;
+    }
+    return encodeUtf8(c, buffer);
+}
+
+// What may follow a symbol, like LLVM's ".llvm.1234" or ".cold", is not part
+// of the name
+bool isVendorSuffix(const char *suffix, int size)
+{
+    if (size == 0)
+        return true;
+    if (suffix[0] != '.')
+        return false;
+    for (int i = 0; i < size; ++i) {
+        if (suffix[i] <= ' ' || suffix[i] > '~')
+            return false;
+    }
+    return true;
+}
+
+// RFC 3492, with the digits Rust uses: a-z are 0-25 and 0-9 are 26-35
+bool decodePunycode(const char *ascii, int asciiSize, const char *punycode, int punycodeSize,
+                    uint32_t *result, int *resultSize)
+{
+    if (asciiSize > MAX_PUNYCODE_LENGTH)
+        return false;
+    int size = 0;
+    for (int i = 0; i < asciiSize; ++i)
+        result[size++] = uchar(ascii[i]);
+
+    uint64_t n = 0x80;
+    uint64_t i = 0;
+    uint64_t bias = 72;
+    int position = 0;
+    while (position < punycodeSize) {
+        const uint64_t oldI = i;
+        uint64_t weight = 1;
+        for (uint64_t k = 36; ; k += 36) {
+            if (position >= punycodeSize)
+                return false;
+            const char c = punycode[position++];
+            uint64_t digit;
+            if (isLower(c))
+                digit = uint64_t(c - 'a');
+            else if (isDigit(c))
+                digit = uint64_t(26 + c - '0');
+            else
+                return false;
+            if (digit > (UINT32_MAX - i) / weight)
+                return false;
+            i += digit * weight;
+            const uint64_t t = k <= bias ? 1 : (k >= bias + 26 ? 26 : k - bias);
+            if (digit < t)
+                break;
+            weight *= 36 - t;
+            if (weight > UINT32_MAX)
+                return false;
+        }
+
+        ++size;
+        uint64_t delta = i - oldI;
+        delta /= oldI == 0 ? 700 : 2;
+        delta += delta / uint64_t(size);
+        uint64_t k = 0;
+        while (delta > 35 * 26 / 2) {
+            delta /= 35;
+            k += 36;
+        }
+        bias = k + 36 * delta / (delta + 38);
+
+        n += i / uint64_t(size);
+        i %= uint64_t(size);
+        if (size > MAX_PUNYCODE_LENGTH || !isValidChar(n))
+            return false;
+        std::memmove(result + i + 1, result + i, sizeof(uint32_t) * (uint64_t(size - 1) - i));
+        result[i] = uint32_t(n);
+        ++i;
+    }
+    *resultSize = size;
+    return true;
+}
+
+// Legacy symbols are Itanium C++ style nested names, _ZN 3foo 3bar 17h0123456789abcdef E,
+// with the special characters of the identifiers escaped like $LT$ for <
+bool isLegacyHash(const char *identifier, int size)
+{
+    if (size < 1 || identifier[0] != 'h')
+        return false;
+    for (int i = 1; i < size; ++i) {
+        if (!isHexDigit(identifier[i]) && !(identifier[i] >= 'A' && identifier[i] <= 'F'))
+            return false;
+    }
+    return true;
+}
+
+// Returns the escaped character, or 0 if this is not an escape after all,
+// in which case the rest of the identifier is not unescaped
+uint32_t legacyEscape(const char *escape, int size)
+{
+    static const struct { const char *escape; char character; } escapes[] = {
+        {"SP", '@'}, {"BP", '*'}, {"RF", '&'}, {"LT", '<'}, {"GT", '>'}, {"LP", '('}, {"RP", ')'},
+        {"C", ','},
+    };
+    for (const auto &e : escapes) {
+        if (int(std::strlen(e.escape)) == size && std::memcmp(escape, e.escape, size_t(size)) == 0)
+            return uint32_t(e.character);
+    }
+    // $u7e$ for ~
+    if (size < 2 || escape[0] != 'u')
+        return 0;
+    uint32_t code = 0;
+    for (int i = 1; i < size; ++i) {
+        if (!isHexDigit(escape[i]))
+            return 0;
+        code = code * 16 + uint32_t(isDigit(escape[i]) ? escape[i] - '0' : escape[i] - 'a' + 10);
+        if (code > 0x10ffff)
+            return 0;
+    }
+    return isValidChar(code) && !isControl(code) ? code : 0;
+}
+
+void appendLegacyIdentifier(QByteArray &output, const char *identifier, int size)
+{
+    int i = 0;
+    if (size >= 2 && identifier[0] == '_' && identifier[1] == '$')
+        i = 1;
+    while (i < size) {
+        const char c = identifier[i];
+        if (c == '.') {
+            const bool separator = i + 1 < size && identifier[i + 1] == '.';
+            output.append(separator ? "::" : ".");
+            i += separator ? 2 : 1;
+        } else if (c == '$') {
+            const char *escape = identifier + i + 1;
+            const char *end = static_cast<const char *>(std::memchr(escape, '$', size_t(size - i - 1)));
+            const uint32_t character = end ? legacyEscape(escape, int(end - escape)) : 0;
+            if (character == 0)
+                break;
+            char buffer[4];
+            output.append(buffer, encodeUtf8(character, buffer));
+            i = int(end - identifier) + 1;
+        } else {
+            int next = i + 1;
+            while (next < size && identifier[next] != '$' && identifier[next] != '.')
+                ++next;
+            output.append(identifier + i, next - i);
+            i = next;
+        }
+    }
+    output.append(identifier + i, size - i);
+}
+
+bool demangleLegacy(const char *symbol, int size, QByteArray &output)
+{
+    // _ZN, with one more underscore on macOS
+    int start;
+    if (size >= 3 && std::memcmp(symbol, "_ZN", 3) == 0)
+        start = 3;
+    else if (size >= 2 && std::memcmp(symbol, "ZN", 2) == 0)
+        start = 2;
+    else if (size >= 4 && std::memcmp(symbol, "__ZN", 4) == 0)
+        start = 4;
+    else
+        return false;
+    for (int i = start; i < size; ++i) {
+        if (symbol[i] & 0x80)
+            return false;
+    }
+
+    // Count the identifiers first, the last one is left out if it is the hash
+    int count = 0;
+    int i = start;
+    while (i < size && symbol[i] != 'E') {
+        if (!isDigit(symbol[i]))
+            return false;
+        int length = 0;
+        while (i < size && isDigit(symbol[i])) {
+            length = length * 10 + (symbol[i] - '0');
+            if (length > size)
+                return false;
+            ++i;
+        }
+        if (length >= size - i)
+            return false;
+        i += length;
+        ++count;
+    }
+    if (i >= size || !isVendorSuffix(symbol + i + 1, size - i - 1))
+        return false;
+
+    i = start;
+    for (int element = 0; element < count; ++element) {
+        int length = 0;
+        while (isDigit(symbol[i]))
+            length = length * 10 + (symbol[i++] - '0');
+        const char *identifier = symbol + i;
+        i += length;
+        if (element + 1 == count && isLegacyHash(identifier, length))
+            break;
+        if (element > 0)
+            output.append("::");
+        appendLegacyIdentifier(output, identifier, length);
+    }
+    return true;
+}
+
+// The v0 scheme: https://doc.rust-lang.org/rustc/symbol-mangling/v0.html
+// Parsing and printing are one pass, like in rustc-demangle, whose error
+// handling is followed too: the symbol is validated first without printing
+// or following back references, and what goes wrong behind a back reference
+// while printing is printed as "{invalid syntax}", with "?" for the parts the
+// parser did not get to.
+class V0Printer
+{
+public:
+    V0Printer(const char *symbol, int size, QByteArray *output)
+        : m_symbol(symbol), m_size(size), m_output(output), m_outputStart(output ? output->size() : 0)
+    {}
+
+    // Without output, the instantiating crate may follow the path
+    bool printSymbol()
+    {
+        printPath(m_output != nullptr);
+        if (!m_output && m_error == NoError && m_parser.position < m_size
+                && isUpper(m_symbol[m_parser.position])) {
+            printPath(false);
+        }
+        if (m_tooLong)
+            m_output->append("{size limit reached}");
+        return m_output || (m_error == NoError && m_parser.position == m_size);
+    }
+
+private:
+    enum Error { NoError, Invalid, RecursedTooDeep };
+
+    struct Parser
+    {
+        int position = 0;
+        int depth = 0;
+    };
+
+    class Identifier
+    {
+    public:
+        const char *ascii = nullptr;
+        int asciiSize = 0;
+        const char *punycode = nullptr;
+        int punycodeSize = 0;
+
+        bool isEmpty() const { return asciiSize == 0 && punycodeSize == 0; }
+    };
+
+    // The parser steps, they leave the printer alone
+
+    bool eat(char c)
+    {
+        if (m_error == NoError && m_parser.position < m_size && m_symbol[m_parser.position] == c) {
+            ++m_parser.position;
+            return true;
+        }
+        return false;
+    }
+
+    Error next(char *c)
+    {
+        if (m_parser.position >= m_size)
+            return Invalid;
+        *c = m_symbol[m_parser.position++];
+        return NoError;
+    }
+
+    Error pushDepth()
+    {
+        return ++m_parser.depth > MAX_DEPTH ? RecursedTooDeep : NoError;
+    }
+
+    // "_" is 0, otherwise the base 62 digits before "_" plus one
+    Error integer62(uint64_t *value)
+    {
+        *value = 0;
+        if (eat('_'))
+            return NoError;
+        while (!eat('_')) {
+            char c;
+            if (next(&c) != NoError)
+                return Invalid;
+            uint64_t digit;
+            if (isDigit(c))
+                digit = uint64_t(c - '0');
+            else if (isLower(c))
+                digit = uint64_t(10 + c - 'a');
+            else if (isUpper(c))
+                digit = uint64_t(36 + c - 'A');
+            else
+                return Invalid;
+            if (*value > (UINT64_MAX - digit) / 62)
+                return Invalid;
+            *value = *value * 62 + digit;
+        }
+        if (*value == UINT64_MAX)
+            return Invalid;
+        ++*value;
+        return NoError;
+    }
+
+    Error optionalInteger62(char tag, uint64_t *value)
+    {
+        *value = 0;
+        if (!eat(tag))
+            return NoError;
+        if (integer62(value) != NoError || *value == UINT64_MAX)
+            return Invalid;
+        ++*value;
+        return NoError;
+    }
+
+    Error disambiguator(uint64_t *value) { return optionalInteger62('s', value); }
+
+    // Uppercase namespaces are special, like closures, lowercase ones are not printed
+    Error nameSpace(char *ns)
+    {
+        if (next(ns) != NoError || !(isLower(*ns) || isUpper(*ns)))
+            return Invalid;
+        return NoError;
+    }
+
+    // The hexadecimal digits before "_"
+    Error hexNibbles(const char **nibbles, int *size)
+    {
+        const int start = m_parser.position;
+        for (;;) {
+            char c;
+            if (next(&c) != NoError)
+                return Invalid;
+            if (c == '_')
+                break;
+            if (!isHexDigit(c))
+                return Invalid;
+        }
+        *nibbles = m_symbol + start;
+        *size = m_parser.position - start - 1;
+        return NoError;
+    }
+
+    Error identifier(Identifier *result)
+    {
+        const bool isPunycode = eat('u');
+        if (m_parser.position >= m_size || !isDigit(m_symbol[m_parser.position]))
+            return Invalid;
+        uint64_t length = uint64_t(m_symbol[m_parser.position++] - '0');
+        if (length != 0) {
+            while (m_parser.position < m_size && isDigit(m_symbol[m_parser.position])) {
+                length = length * 10 + uint64_t(m_symbol[m_parser.position++] - '0');
+                if (length > uint64_t(m_size))
+                    return Invalid;
+            }
+        }
+        eat('_');
+        if (length > uint64_t(m_size - m_parser.position))
+            return Invalid;
+        const char *bytes = m_symbol + m_parser.position;
+        m_parser.position += int(length);
+
+        *result = Identifier();
+        if (!isPunycode) {
+            result->ascii = bytes;
+            result->asciiSize = int(length);
+            return NoError;
+        }
+        // The ASCII characters come before the last "_"
+        int separator = int(length) - 1;
+        while (separator >= 0 && bytes[separator] != '_')
+            --separator;
+        if (separator >= 0) {
+            result->ascii = bytes;
+            result->asciiSize = separator;
+        }
+        result->punycode = bytes + separator + 1;
+        result->punycodeSize = int(length) - separator - 1;
+        return result->punycodeSize ? NoError : Invalid;
+    }
+
+    // A parser for what an earlier part of the symbol, which is where it
+    // points to, is followed by
+    Error backref(Parser *target)
+    {
+        const int tagPosition = m_parser.position - 1;
+        uint64_t position;
+        if (integer62(&position) != NoError || position >= uint64_t(tagPosition))
+            return Invalid;
+        target->position = int(position);
+        target->depth = m_parser.depth + 1;
+        return target->depth > MAX_DEPTH ? RecursedTooDeep : NoError;
+    }
+
+    // Runs a step of the parser. Once the parser failed, the caller prints
+    // "?" in place of what it was going to print, and returns.
+    template<typename Step>
+    bool parse(Step step)
+    {
+        if (m_tooLong)
+            m_error = Invalid;
+        if (m_error != NoError) {
+            print("?");
+            return false;
+        }
+        m_error = step();
+        if (m_error == NoError)
+            return true;
+        printError();
+        return false;
+    }
+
+    void invalid()
+    {
+        m_error = Invalid;
+        printError();
+    }
+
+    void printError()
+    {
+        print(m_error == RecursedTooDeep ? "{recursion limit reached}" : "{invalid syntax}");
+    }
+
+    void popDepth()
+    {
+        if (m_error == NoError)
+            --m_parser.depth;
+    }
+
+    // Back references can make the output grow exponentially with the
+    // length of the symbol. What does not fit into the size limit ends the
+    // printing, and is written like rustc-demangle does, which is in pieces
+    // like the characters of an escape.
+    void write(const char *text, int size)
+    {
+        if (!m_output || m_tooLong)
+            return;
+        if (m_output->size() - m_outputStart + size > MAX_OUTPUT_SIZE) {
+            m_tooLong = true;
+            return;
+        }
+        m_output->append(text, size);
+    }
+
+    void print(const char *text) { write(text, int(std::strlen(text))); }
+    void print(char c) { write(&c, 1); }
+
+    void printNumber(uint64_t value)
+    {
+        char buffer[20];
+        write(buffer, formatNumber(value, buffer));
+    }
+
+    void printEscaped(uint32_t c, char quote)
+    {
+        char buffer[10];
+        const int size = escapeChar(c, quote, buffer);
+        if (buffer[0] != '\\') {
+            write(buffer, size);
+            return;
+        }
+        for (int i = 0; i < size; ++i)
+            write(buffer + i, 1);
+    }
+
+    void printIdentifier(const Identifier &identifier)
+    {
+        if (!m_output)
+            return;
+        if (identifier.punycodeSize == 0) {
+            write(identifier.ascii, identifier.asciiSize);
+            return;
+        }
+        uint32_t decoded[MAX_PUNYCODE_LENGTH];
+        int decodedSize = 0;
+        if (decodePunycode(identifier.ascii, identifier.asciiSize, identifier.punycode,
+                           identifier.punycodeSize, decoded, &decodedSize)) {
+            char buffer[4];
+            for (int i = 0; i < decodedSize; ++i)
+                write(buffer, encodeUtf8(decoded[i], buffer));
+            return;
+        }
+        print("punycode{");
+        if (identifier.asciiSize) {
+            write(identifier.ascii, identifier.asciiSize);
+            print('-');
+        }
+        write(identifier.punycode, identifier.punycodeSize);
+        print('}');
+    }
+
+    template<typename Print>
+    void skippingPrinting(Print print)
+    {
+        QByteArray *output = m_output;
+        m_output = nullptr;
+        print();
+        m_output = output;
+    }
+
+    // Back references are only followed when printing, an error behind
+    // one does not stop printing what follows it
+    template<typename Print>
+    void printBackref(Print print)
+    {
+        Parser target;
+        if (!parse([this, &target] { return backref(&target); }) || !m_output)
+            return;
+        const Parser original = m_parser;
+        m_parser = target;
+        print();
+        m_parser = original;
+        m_error = NoError;
+    }
+
+    // Bound lifetimes are only tracked when printing
+    void printLifetime(uint64_t lifetime)
+    {
+        if (!m_output)
+            return;
+        print('\'');
+        if (lifetime == 0) {
+            print('_');
+            return;
+        }
+        if (lifetime > m_boundLifetimes) {
+            invalid();
+            return;
+        }
+        const uint64_t depth = m_boundLifetimes - lifetime;
+        if (depth < 26) {
+            print(char('a' + depth));
+        } else {
+            print('_');
+            printNumber(depth);
+        }
+    }
+
+    // for<'a, 'b> before function pointers and trait objects
+    template<typename Print>
+    void inBinder(Print print)
+    {
+        uint64_t bound;
+        if (!parse([this, &bound] { return optionalInteger62('G', &bound); }))
+            return;
+        if (!m_output) {
+            print();
+            return;
+        }
+        if (bound > 0) {
+            this->print("for<");
+            for (uint64_t i = 0; i < bound && !m_tooLong; ++i) {
+                if (i > 0)
+                    this->print(", ");
+                ++m_boundLifetimes;
+                printLifetime(1);
+            }
+            this->print("> ");
+        }
+        print();
+        m_boundLifetimes -= bound;
+    }
+
+    template<typename Print>
+    int printList(Print print, const char *separator)
+    {
+        int count = 0;
+        while (m_error == NoError && !eat('E')) {
+            if (count > 0)
+                this->print(separator);
+            print();
+            ++count;
+        }
+        return count;
+    }
+
+    void printPath(bool inValue)
+    {
+        char tag;
+        if (!parse([this, &tag] { return next(&tag); }) || !parse([this] { return pushDepth(); }))
+            return;
+        switch (tag) {
+        case 'C': {
+            uint64_t disambiguator;
+            Identifier name;
+            if (!parse([this, &disambiguator] { return this->disambiguator(&disambiguator); })
+                    || !parse([this, &name] { return identifier(&name); })) {
+                return;
+            }
+            printIdentifier(name);
+            break;
+        }
+        case 'N': {
+            char ns;
+            if (!parse([this, &ns] { return nameSpace(&ns); }))
+                return;
+            printPath(inValue);
+            // The "?" for what is missing goes after "::"
+            if (m_error != NoError)
+                print("::");
+            uint64_t disambiguator;
+            Identifier name;
+            if (!parse([this, &disambiguator] { return this->disambiguator(&disambiguator); })
+                    || !parse([this, &name] { return identifier(&name); })) {
+                return;
+            }
+            if (isUpper(ns)) {
+                // Closures and shims are {closure#0} and {shim:vtable#0}
+                print("::{");
+                if (ns == 'C')
+                    print("closure");
+                else if (ns == 'S')
+                    print("shim");
+                else
+                    print(ns);
+                if (!name.isEmpty()) {
+                    print(':');
+                    printIdentifier(name);
+                }
+                print('#');
+                printNumber(disambiguator);
+                print('}');
+            } else if (!name.isEmpty()) {
+                print("::");
+                printIdentifier(name);
+            }
+            break;
+        }
+        case 'M':
+        case 'X':
+        case 'Y':
+            if (tag != 'Y') {
+                // The path of the impl block is not printed
+                uint64_t disambiguator;
+                if (!parse([this, &disambiguator] { return this->disambiguator(&disambiguator); }))
+                    return;
+                skippingPrinting([this] { printPath(false); });
+            }
+            print('<');
+            printType();
+            if (tag != 'M') {
+                print(" as ");
+                printPath(false);
+            }
+            print('>');
+            break;
+        case 'I':
+            printPath(inValue);
+            if (inValue)
+                print("::");
+            print('<');
+            printList([this] { printGenericArgument(); }, ", ");
+            print('>');
+            break;
+        case 'B':
+            printBackref([this, inValue] { printPath(inValue); });
+            break;
+        default:
+            invalid();
+            return;
+        }
+        popDepth();
+    }
+
+    void printGenericArgument()
+    {
+        if (eat('L')) {
+            uint64_t lifetime;
+            if (parse([this, &lifetime] { return integer62(&lifetime); }))
+                printLifetime(lifetime);
+        } else if (eat('K')) {
+            printConst(false);
+        } else {
+            printType();
+        }
+    }
+
+    static const char *basicType(char tag)
+    {
+        switch (tag) {
+        case 'a': return "i8";
+        case 'b': return "bool";
+        case 'c': return "char";
+        case 'd': return "f64";
+        case 'e': return "str";
+        case 'f': return "f32";
+        case 'h': return "u8";
+        case 'i': return "isize";
+        case 'j': return "usize";
+        case 'l': return "i32";
+        case 'm': return "u32";
+        case 'n': return "i128";
+        case 'o': return "u128";
+        case 'p': return "_";
+        case 's': return "i16";
+        case 't': return "u16";
+        case 'u': return "()";
+        case 'v': return "...";
+        case 'x': return "i64";
+        case 'y': return "u64";
+        case 'z': return "!";
+        default: return nullptr;
+        }
+    }
+
+    void printType()
+    {
+        char tag;
+        if (!parse([this, &tag] { return next(&tag); }))
+            return;
+        if (const char *basic = basicType(tag)) {
+            print(basic);
+            return;
+        }
+        if (!parse([this] { return pushDepth(); }))
+            return;
+        switch (tag) {
+        case 'R':
+        case 'Q':
+            print('&');
+            if (eat('L')) {
+                uint64_t lifetime;
+                if (!parse([this, &lifetime] { return integer62(&lifetime); }))
+                    return;
+                if (lifetime != 0) {
+                    printLifetime(lifetime);
+                    print(' ');
+                }
+            }
+            if (tag == 'Q')
+                print("mut ");
+            printType();
+            break;
+        case 'P':
+            print("*const ");
+            printType();
+            break;
+        case 'O':
+            print("*mut ");
+            printType();
+            break;
+        case 'A':
+        case 'S':
+            print('[');
+            printType();
+            if (tag == 'A') {
+                print("; ");
+                printConst(true);
+            }
+            print(']');
+            break;
+        case 'T': {
+            print('(');
+            const int count = printList([this] { printType(); }, ", ");
+            if (count == 1)
+                print(',');
+            print(')');
+            break;
+        }
+        case 'F':
+            inBinder([this] { printFunctionSignature(); });
+            break;
+        case 'D': {
+            print("dyn ");
+            inBinder([this] { printList([this] { printDynTrait(); }, " + "); });
+            if (!eat('L')) {
+                invalid();
+                return;
+            }
+            uint64_t lifetime;
+            if (!parse([this, &lifetime] { return integer62(&lifetime); }))
+                return;
+            if (lifetime != 0) {
+                print(" + ");
+                printLifetime(lifetime);
+            }
+            break;
+        }
+        case 'B':
+            printBackref([this] { printType(); });
+            break;
+        default:
+            // A named type
+            if (m_error == NoError)
+                --m_parser.position;
+            printPath(false);
+            break;
+        }
+        popDepth();
+    }
+
+    void printFunctionSignature()
+    {
+        const bool isUnsafe = eat('U');
+        Identifier abi;
+        bool hasAbi = false;
+        if (eat('K')) {
+            hasAbi = true;
+            if (eat('C')) {
+                abi.ascii = "C";
+                abi.asciiSize = 1;
+            } else {
+                if (!parse([this, &abi] { return identifier(&abi); }))
+                    return;
+                if (abi.asciiSize == 0 || abi.punycodeSize) {
+                    invalid();
+                    return;
+                }
+            }
+        }
+        if (isUnsafe)
+            print("unsafe ");
+        if (hasAbi) {
+            print("extern \"");
+            // Dashes are mangled as underscores, "C-unwind" is "C_unwind"
+            for (int i = 0; i < abi.asciiSize; ++i)
+                print(abi.ascii[i] == '_' ? '-' : abi.ascii[i]);
+            print("\" ");
+        }
+        print("fn(");
+        printList([this] { printType(); }, ", ");
+        print(')');
+        if (!eat('u')) {
+            print(" -> ");
+            printType();
+        }
+    }
+
+    // Returns whether generic arguments were opened with "<" and are left
+    // open for the associated type bindings
+    bool printPathMaybeOpenGenerics()
+    {
+        if (eat('B')) {
+            bool open = false;
+            printBackref([this, &open] { open = printPathMaybeOpenGenerics(); });
+            return open;
+        }
+        if (eat('I')) {
+            printPath(false);
+            print('<');
+            printList([this] { printGenericArgument(); }, ", ");
+            return true;
+        }
+        printPath(false);
+        return false;
+    }
+
+    void printDynTrait()
+    {
+        bool open = printPathMaybeOpenGenerics();
+        while (eat('p')) {
+            print(open ? ", " : "<");
+            open = true;
+            Identifier name;
+            if (!parse([this, &name] { return identifier(&name); }))
+                return;
+            printIdentifier(name);
+            print(" = ");
+            printType();
+        }
+        if (open)
+            print('>');
+    }
+
+    static bool nibblesValue(const char *nibbles, int size, uint64_t *value)
+    {
+        // Leading zeros are not allowed
+        while (size > 0 && nibbles[0] == '0') {
+            ++nibbles;
+            --size;
+        }
+        if (size > 16)
+            return false;
+        *value = 0;
+        for (int i = 0; i < size; ++i)
+            *value = *value * 16 + uint64_t(isDigit(nibbles[i]) ? nibbles[i] - '0' : nibbles[i] - 'a' + 10);
+        return true;
+    }
+
+    void printConstUnsigned()
+    {
+        const char *nibbles;
+        int size;
+        if (!parse([this, &nibbles, &size] { return hexNibbles(&nibbles, &size); }))
+            return;
+        uint64_t value;
+        if (nibblesValue(nibbles, size, &value)) {
+            printNumber(value);
+        } else {
+            print("0x");
+            for (int i = 0; i < size; ++i)
+                print(nibbles[i]);
+        }
+    }
+
+    // UTF-8, two nibbles per byte
+    static bool decodeString(const char *nibbles, int size, QVarLengthArray<uint32_t, 64> *chars)
+    {
+        if (size % 2)
+            return false;
+        auto byteAt = [nibbles](int i) {
+            auto value = [](char c) { return isDigit(c) ? c - '0' : c - 'a' + 10; };
+            return uchar(value(nibbles[2 * i]) << 4 | value(nibbles[2 * i + 1]));
+        };
+        const int bytes = size / 2;
+        for (int i = 0; i < bytes; ) {
+            const uchar lead = byteAt(i);
+            const int length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xe ? 3 : (lead >> 3) == 0x1e ? 4 : 0;
+            if (length == 0 || i + length > bytes)
+                return false;
+            uint32_t c = length == 1 ? lead : lead & (0x7f >> length);
+            for (int j = 1; j < length; ++j) {
+                const uchar continuation = byteAt(i + j);
+                if ((continuation & 0xc0) != 0x80)
+                    return false;
+                c = c << 6 | (continuation & 0x3f);
+            }
+            if (!isValidChar(c))
+                return false;
+            chars->append(c);
+            i += length;
+        }
+        return true;
+    }
+
+    void printConstStringLiteral()
+    {
+        const char *nibbles;
+        int size;
+        if (!parse([this, &nibbles, &size] { return hexNibbles(&nibbles, &size); }))
+            return;
+        QVarLengthArray<uint32_t, 64> chars;
+        if (!decodeString(nibbles, size, &chars)) {
+            invalid();
+            return;
+        }
+        print('"');
+        for (uint32_t c : chars)
+            printEscaped(c, '"');
+        print('"');
+    }
+
+    void printConst(bool inValue)
+    {
+        char tag;
+        if (!parse([this, &tag] { return next(&tag); }) || !parse([this] { return pushDepth(); }))
+            return;
+        bool openedBrace = false;
+        // Values outside of expressions are in braces, like in Foo<{ Bar { x: 1 } }>
+        auto openBrace = [this, inValue, &openedBrace] {
+            if (!inValue) {
+                openedBrace = true;
+                print('{');
+            }
+        };
+
+        switch (tag) {
+        case 'p':
+            print('_');
+            break;
+        case 'h': case 't': case 'm': case 'y': case 'o': case 'j':
+            printConstUnsigned();
+            break;
+        case 'a': case 's': case 'l': case 'x': case 'n': case 'i':
+            if (eat('n'))
+                print('-');
+            printConstUnsigned();
+            break;
+        case 'b':
+        case 'c': {
+            const char *nibbles;
+            int size;
+            if (!parse([this, &nibbles, &size] { return hexNibbles(&nibbles, &size); }))
+                return;
+            uint64_t value;
+            if (!nibblesValue(nibbles, size, &value) || (tag == 'b' ? value > 1 : !isValidChar(value))) {
+                invalid();
+                return;
+            }
+            if (tag == 'b') {
+                print(value ? "true" : "false");
+            } else {
+                print('\'');
+                printEscaped(uint32_t(value), '\'');
+                print('\'');
+            }
+            break;
+        }
+        case 'e':
+            // The value of a str, which is *"..." like a dereferenced literal
+            openBrace();
+            print('*');
+            printConstStringLiteral();
+            break;
+        case 'R':
+        case 'Q':
+            if (tag == 'R' && eat('e')) {
+                printConstStringLiteral();
+                break;
+            }
+            openBrace();
+            print('&');
+            if (tag == 'Q')
+                print("mut ");
+            printConst(true);
+            break;
+        case 'A':
+            openBrace();
+            print('[');
+            printList([this] { printConst(true); }, ", ");
+            print(']');
+            break;
+        case 'T': {
+            openBrace();
+            print('(');
+            const int count = printList([this] { printConst(true); }, ", ");
+            if (count == 1)
+                print(',');
+            print(')');
+            break;
+        }
+        case 'V': {
+            openBrace();
+            printPath(true);
+            char kind;
+            if (!parse([this, &kind] { return next(&kind); }))
+                return;
+            switch (kind) {
+            case 'U':
+                break;
+            case 'T':
+                print('(');
+                printList([this] { printConst(true); }, ", ");
+                print(')');
+                break;
+            case 'S':
+                print(" { ");
+                printList([this] {
+                    uint64_t disambiguator;
+                    Identifier name;
+                    if (!parse([this, &disambiguator] { return this->disambiguator(&disambiguator); })
+                            || !parse([this, &name] { return identifier(&name); })) {
+                        return;
+                    }
+                    printIdentifier(name);
+                    print(": ");
+                    printConst(true);
+                }, ", ");
+                print(" }");
+                break;
+            default:
+                invalid();
+                return;
+            }
+            break;
+        }
+        case 'B':
+            printBackref([this, inValue] { printConst(inValue); });
+            break;
+        default:
+            invalid();
+            return;
+        }
+        if (openedBrace)
+            print('}');
+        popDepth();
+    }
+
+    const char *m_symbol;
+    int m_size;
+    Parser m_parser;
+    Error m_error = NoError;
+    QByteArray *m_output;
+    int m_outputStart;
+    uint64_t m_boundLifetimes = 0;
+    bool m_tooLong = false;
+};
+
+bool demangleV0(const char *symbol, int size, QByteArray &output)
+{
+    // _R, with one more underscore on macOS, or just R on Windows
+    int start;
+    if (size > 2 && std::memcmp(symbol, "_R", 2) == 0)
+        start = 2;
+    else if (size > 3 && std::memcmp(symbol, "__R", 3) == 0)
+        start = 3;
+    else if (size > 1 && symbol[0] == 'R')
+        start = 1;
+    else
+        return false;
+
+    // The mangling version, only 0 which is left out, is followed by the path.
+    // A vendor specific suffix like ".llvm.1234" may follow.
+    if (!isUpper(symbol[start]))
+        return false;
+    int end = size;
+    for (int i = start; i < size; ++i) {
+        if (symbol[i] & 0x80)
+            return false;
+        if (symbol[i] == '.' && end == size)
+            end = i;
+    }
+    if (!isVendorSuffix(symbol + end, size - end)
+            || !V0Printer(symbol + start, end - start, nullptr).printSymbol()) {
+        return false;
+    }
+    const int originalSize = output.size();
+    if (V0Printer(symbol + start, end - start, &output).printSymbol())
+        return true;
+    output.resize(originalSize);
+    return false;
+}
+
+} // namespace
+
+bool NimRustDemangler::demangle(const char *symbol, int size, QByteArray &output)
+{
+    return demangleV0(symbol, size, output) || demangleLegacy(symbol, size, output);
+}
+
+QString NimRustDemangler::demangle(const QByteArray &symbol)
+{
+    QByteArray output;
+    output.reserve(symbol.size());
+    if (demangle(symbol.constData(), symbol.size(), output))
+        return QString::fromUtf8(output);
+    return QString::fromUtf8(symbol);
+}
+
+QStringList NimRustDemangler::demangleAll(const QVector<QByteArray> &symbols)
+{
+    QVector<QPair<int, int>> chunks;
+    for (int start = 0; start < symbols.size(); start += CHUNK_SIZE)
+        chunks.append({start, qMin(CHUNK_SIZE, symbols.size() - start)});
+
+    const QList<QStringList> demangled = QtConcurrent::blockingMapped<QList<QStringList>>(
+                chunks, [&symbols](const QPair<int, int> &chunk) {
+        QStringList result;
+        result.reserve(chunk.second);
+        // One buffer for all the symbols of the chunk
+        QByteArray output;
+        output.reserve(256);
+        for (int i = chunk.first; i < chunk.first + chunk.second; ++i) {
+            const QByteArray &symbol = symbols.at(i);
+            output.resize(0);
+            result.append(demangle(symbol.constData(), symbol.size(), output) ? QString::fromUtf8(output)
+                                                                             : QString::fromUtf8(symbol));
+        }
+        return result;
+    });
+
+    QStringList result;
+    result.reserve(symbols.size());
+    for (const QStringList &chunk : demangled)
+        result.append(chunk);
+    return result;
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "nimelffile.h"
+#include "../nimplugin.h"
+
+#include <QDir>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTest>
+
+namespace Nim {
+
+// The expected names are what rustfilt, that is rustc-demangle, prints
+void RustPlugin::testRustDemangler_data()
+{
+    QTest::addColumn<QByteArray>("symbol");
+    QTest::addColumn<QString>("name");
+
+    // v0
+    QTest::newRow("crate root") << QByteArray("_RNvCs1234_7mycrate3foo") << "mycrate::foo";
+    QTest::newRow("closure") << QByteArray("_RNCNvCsJRV5THAuFe_1v4mains0_0B3_") << "v::main::{closure#2}";
+    QTest::newRow("generic function")
+            << QByteArray("_RINvCsJRV5THAuFe_1v5applyNCNvB2_4main0EB2_") << "v::apply::<v::main::{closure#0}>";
+    QTest::newRow("inherent impl")
+            << QByteArray("_RINvMs_NtNtCs5GmCzIpY9Qj_4core3fmt2rtNtB7_9Arguments6new_v1Kj2_Kj1_ECsJRV5THAuFe_1v")
+            << "<core::fmt::Arguments>::new_v1::<2, 1>";
+    QTest::newRow("trait impl shim")
+            << QByteArray("_RNSNvYNCNvCsJRV5THAuFe_1v4mains_0INtNtNtCs5GmCzIpY9Qj_4core3ops8function6FnOnceTRhEE9call_once6vtableB8_")
+            << "<v::main::{closure#1} as core::ops::function::FnOnce<(&u8,)>>::call_once::{shim:vtable#0}";
+    QTest::newRow("punycode")
+            << QByteArray("_RNvNtCsJRV5THAuFe_1vu13ncd_dma1a7bzbu7fnc_hoa") << QString::fromUtf8("v::ünïcödé::fünc");
+    QTest::newRow("char constant")
+            << QByteArray("_RINvCsJRV5THAuFe_1v3arrKb1_Kc3bb_EB2_") << QString::fromUtf8("v::arr::<true, 'λ'>");
+    QTest::newRow("str constant") << QByteArray("_RIC0Ke616263_E") << "::<{*\"abc\"}>";
+    QTest::newRow("struct constant")
+            << QByteArray("_RIC0KVNvC0_3FooS1xj1_1yb0_EE") << "::<{::Foo { x: 1, y: false }}>";
+    QTest::newRow("function pointer")
+            << QByteArray("_RIC0FG0_KCRL0_hEuE") << "::<for<'a, 'b> extern \"C\" fn(&'b u8)>";
+    QTest::newRow("unsafe abi") << QByteArray("_RIC0FUK8C_unwinduEuE") << "::<unsafe extern \"C-unwind\" fn(())>";
+    QTest::newRow("dyn trait")
+            << QByteArray("_RIC0DNtC0_5Traitp4ItemjEL_E") << "::<dyn ::Trait<Item = usize>>";
+    QTest::newRow("llvm suffix")
+            << QByteArray("_RNvNtCs1234_7mycrate3foo3bar.llvm.123456") << "mycrate::foo::bar";
+    QTest::newRow("cold suffix") << QByteArray("_RNvCsJRV5THAuFe_1v4main.cold") << "v::main";
+    QTest::newRow("invalid backref") << QByteArray("_RNvNtB0_3foo3bar") << "{invalid syntax}::foo::bar";
+
+    // Legacy
+    QTest::newRow("legacy")
+            << QByteArray("_ZN4core3fmt9Arguments6new_v117h0123456789abcdefE") << "core::fmt::Arguments::new_v1";
+    QTest::newRow("legacy escapes")
+            << QByteArray("_ZN55_$LT$std..path..PathBuf$u20$as$u20$core..fmt..Debug$GT$3fmt17h0123456789abcdefE")
+            << "<std::path::PathBuf as core::fmt::Debug>::fmt";
+    QTest::newRow("legacy unicode escape")
+            << QByteArray("_ZN3foo11bar$u7e$baz17h0123456789abcdefE") << "foo::bar~baz";
+    QTest::newRow("legacy control escape")
+            << QByteArray("_ZN3foo10bar$u0$baz17h0123456789abcdefE") << "foo::bar$u0$baz";
+    QTest::newRow("legacy without hash") << QByteArray("_ZN3foo3barE") << "foo::bar";
+    QTest::newRow("legacy llvm suffix")
+            << QByteArray("_ZN3std2io5stdio6_print17h0123456789abcdefE.llvm.4545") << "std::io::stdio::_print";
+
+    // Not Rust
+    QTest::newRow("c") << QByteArray("main") << "main";
+    QTest::newRow("c++") << QByteArray("_ZN3foo3barEv") << "_ZN3foo3barEv";
+    QTest::newRow("truncated") << QByteArray("_RNvC3foo") << "_RNvC3foo";
+    QTest::newRow("trailing garbage") << QByteArray("_RNvCs_3foo3barX") << "_RNvCs_3foo3barX";
+}
+
+void RustPlugin::testRustDemangler()
+{
+    QFETCH(QByteArray, symbol);
+    QFETCH(QString, name);
+
+    QCOMPARE(NimRustDemangler::demangle(symbol), name);
+}
+
+// Mutations of valid symbols must neither crash nor touch the output of
+// what is not demangled. Their names were compared with rustc-demangle's
+// while writing the demangler, this keeps them from regressing.
+void RustPlugin::testRustDemanglerFuzz()
+{
+    const QList<QByteArray> seeds = {
+        "_RINvMs_NtNtCs5GmCzIpY9Qj_4core3fmt2rtNtB7_9Arguments6new_v1Kj2_Kj1_ECsJRV5THAuFe_1v",
+        "_RNSNvYNCNvCsJRV5THAuFe_1v4mains_0INtNtNtCs5GmCzIpY9Qj_4core3ops8function6FnOnceTRhEE9call_once6vtableB8_",
+        "_RNvNtCsJRV5THAuFe_1vu13ncd_dma1a7bzbu7fnc_hoa",
+        "_RIC0KVNvC0_3FooS1xj1_1yb0_EE",
+        "_RIC0FG0_KCRL0_hEuE",
+        "_RIC0DNtC0_5Traitp4ItemjEL_E",
+        "_ZN55_$LT$std..path..PathBuf$u20$as$u20$core..fmt..Debug$GT$3fmt17h0123456789abcdefE",
+    };
+    const QByteArray alphabet("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_$.");
+    quint32 random = 1;
+    auto next = [&random](int bound) {
+        random = random * 1103515245 + 12345;
+        return int((random >> 8) % quint32(bound));
+    };
+
+    QByteArray output;
+    QList<QByteArray> compared;
+    QList<QByteArray> demangled;
+    for (int i = 0; i < 100000; ++i) {
+        QByteArray symbol = seeds.at(next(seeds.size()));
+        for (int mutations = 1 + next(4); mutations > 0; --mutations) {
+            const int position = next(symbol.size() + 1);
+            switch (next(4)) {
+            case 0:
+                if (position < symbol.size())
+                    symbol[position] = alphabet.at(next(alphabet.size()));
+                break;
+            case 1:
+                symbol.insert(position, alphabet.at(next(alphabet.size())));
+                break;
+            case 2:
+                symbol.remove(position, 1);
+                break;
+            default:
+                // Copies make for back references which point to something
+                symbol.insert(position, symbol.mid(next(symbol.size()), 1 + next(16)));
+                break;
+            }
+        }
+        output = "prefix";
+        const bool isRust = NimRustDemangler::demangle(symbol.constData(), symbol.size(), output);
+        if (!isRust)
+            QCOMPARE(output, QByteArray("prefix"));
+        QVERIFY(output.startsWith("prefix"));
+        // rustfilt only picks up symbols starting like this, and keeps the
+        // suffixes after a dot which are dropped here
+        if ((symbol.startsWith("_R") || symbol.startsWith("_ZN")) && !symbol.contains('.')) {
+            compared.append(symbol);
+            demangled.append(isRust ? output.mid(6) : symbol);
+        }
+    }
+
+    const QString rustfilt = QStandardPaths::findExecutable("rustfilt");
+    if (rustfilt.isEmpty())
+        QSKIP("rustfilt was not found, the output was not compared.");
+    QProcess process;
+    process.start(rustfilt, QStringList());
+    QVERIFY(process.waitForStarted());
+    process.write(compared.join('\n') + '\n');
+    process.closeWriteChannel();
+    QVERIFY(process.waitForFinished(60000));
+    const QList<QByteArray> expected = process.readAllStandardOutput().split('\n');
+    for (int i = 0; i < compared.size(); ++i) {
+        QVERIFY2(demangled.at(i) == expected.value(i),
+                 (compared.at(i) + ": " + demangled.at(i) + " instead of " + expected.value(i)).constData());
+    }
+}
+
+// Demangles the symbol table of the compiler, which has 150000 Rust symbols
+void RustPlugin::testRustDemanglerBenchmark()
+{
+    QProcess rustc;
+    rustc.start("rustc", {"--print", "sysroot"});
+    if (!rustc.waitForFinished() || rustc.exitCode() != 0)
+        QSKIP("rustc was not found.");
+    const QDir lib(QString::fromLocal8Bit(rustc.readAllStandardOutput()).trimmed() + "/lib");
+    const QStringList drivers = lib.entryList({"librustc_driver-*.so"}, QDir::Files);
+    NimElfFile elf;
+    if (drivers.isEmpty() || !elf.open(lib.absoluteFilePath(drivers.first())))
+        QSKIP("The compiler's library was not found.");
+
+    QVector<QByteArray> symbols;
+    for (const NimElfSymbol &symbol : elf.functionSymbols())
+        symbols.append(symbol.name);
+    QVERIFY(!symbols.isEmpty());
+
+    QStringList names;
+    QBENCHMARK {
+        names = NimRustDemangler::demangleAll(symbols);
+    }
+    QCOMPARE(names.size(), symbols.size());
+}
+
+} // namespace Nim
+
+#endif
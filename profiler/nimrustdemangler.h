@@ -0,0 +1,53 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace Nim {
+
+// Demangles Rust symbol names of both the legacy and the v0 mangling scheme
+// without the hashes, crate disambiguators and suffixes like ".cold" that
+// make them unique, which is what profiles group by. Otherwise the output
+// matches rustc-demangle's alternate format, as printed by rustfilt.
+class NimRustDemangler
+{
+public:
+    // Appends the demangled name to output, which is left as it was if the
+    // symbol is not a Rust symbol. Reusing output saves the allocations.
+    static bool demangle(const char *symbol, int size, QByteArray &output);
+    // Returns the symbol unchanged if it is not a Rust symbol
+    static QString demangle(const QByteArray &symbol);
+    // Demangles a symbol table in parallel, keeping the names which are not
+    // Rust symbols
+    static QStringList demangleAll(const QVector<QByteArray> &symbols);
+};
+
+} // namespace Nim
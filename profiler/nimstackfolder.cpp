@@ -0,0 +1,314 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimstackfolder.h"
+#include "nimoffcpu.h"
+#include "nimperfrecorder.h"
+#include "nimrustdemangler.h"
+
+#include <utils/qtcassert.h>
+
+#include <QFile>
+#include <QStringList>
+#include <QtConcurrent>
+
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#endif
+
+#include <cstdlib>
+
+using namespace Utils;
+
+namespace Nim {
+
+static FilePath scriptFile(const FilePath &recording)
+{
+    return recording.stringAppended(".script");
+}
+
+static bool isOffCpu(const FilePath &recording)
+{
+    return NimPerfRecordings::kind(recording.parentDir()) == NimPerfRecordings::OffCpuRecording;
+}
+
+NimStackFolder::NimStackFolder(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_watcher, &QFutureWatcher<bool>::finished, this, [this] {
+        QFile::remove(scriptFile(m_current).toString());
+        if (m_watcher.result())
+            emit folded(NimPerfRecordings::foldedFile(m_current));
+        else
+            emit failed(tr("Could not fold the stacks of %1.").arg(m_current.toUserOutput()));
+        m_current.clear();
+        startNext();
+    });
+}
+
+NimStackFolder::~NimStackFolder()
+{
+    if (m_process) {
+        m_process->disconnect(this);
+        m_process->kill();
+        m_process->waitForFinished(1000);
+        delete m_process;
+    }
+    m_watcher.waitForFinished();
+}
+
+void NimStackFolder::fold(const FilePath &recording)
+{
+    m_queue.append(recording);
+    if (m_current.isEmpty())
+        startNext();
+}
+
+void NimStackFolder::startNext()
+{
+    if (m_queue.isEmpty())
+        return;
+    m_current = m_queue.takeFirst();
+
+    // The output of perf script gets big, it goes to a file rather than into memory
+    m_process = new QProcess;
+    m_process->setStandardOutputFile(scriptFile(m_current).toString());
+    connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &NimStackFolder::onScriptFinished);
+    connect(m_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart)
+            onScriptFinished(-1, QProcess::CrashExit);
+    });
+    const QStringList arguments = isOffCpu(m_current) ? NimOffCpuProfile::scriptArguments()
+                                                      : QStringList{"--no-inline", "--no-demangle", "-F", "comm,ip,sym,dso"};
+    m_process->start(NimPerfRecordings::perfExecutable().toString(),
+                     QStringList{"script"} + arguments + QStringList{"-i", m_current.toString()});
+}
+
+void NimStackFolder::onScriptFinished(int exitCode, QProcess::ExitStatus status)
+{
+    const QString errors = QString::fromLocal8Bit(m_process->readAllStandardError()).trimmed();
+    m_process->disconnect(this);
+    m_process->deleteLater();
+    m_process = nullptr;
+    if (status != QProcess::NormalExit || exitCode != 0) {
+        QFile::remove(scriptFile(m_current).toString());
+        emit failed(tr("perf script failed for %1: %2").arg(m_current.toUserOutput(), errors));
+        m_current.clear();
+        startNext();
+        return;
+    }
+
+    const FilePath recording = m_current;
+    m_watcher.setFuture(QtConcurrent::run([recording] {
+        QFile script(scriptFile(recording).toString());
+        if (!script.open(QIODevice::ReadOnly))
+            return false;
+        if (isOffCpu(recording)) {
+            const NimOffCpuProfile profile = NimOffCpuProfile::fromScript(&script);
+            return writeFolded(NimPerfRecordings::foldedFile(recording), profile.stacks)
+                    && NimOffCpuProfile::writeBlockingCalls(NimOffCpuProfile::blockingCallsFile(recording),
+                                                            profile.blockingCalls);
+        }
+        return writeFolded(NimPerfRecordings::foldedFile(recording), foldScript(&script));
+    }));
+}
+
+// A sample is a header line followed by one indented line per frame, inner
+// frame first, and an empty line:
+//   server 
+//       55d0c1a2b3c4 _RINvNtCs1234_4core3ptr13drop_in_placeNtCs5678_6server6ServerEB8_+0x14 (/path/to/server)
+//       55d0c1a2b3d5 _RNvCs5678_6server4main+0x20 (/path/to/server)
+NimFoldedStacks NimStackFolder::foldScript(QIODevice *script)
+{
+    NimFoldedStacks result;
+    QString process;
+    QStringList frames;
+    auto finishSample = [&] {
+        if (process.isEmpty())
+            return;
+        QStringList stack{process};
+        for (auto it = frames.crbegin(); it != frames.crend(); ++it)
+            stack.append(*it);
+        ++result[stack.join(';')];
+        process.clear();
+        frames.clear();
+    };
+
+    while (!script->atEnd()) {
+        const QString rawLine = QString::fromUtf8(script->readLine());
+        const QString line = rawLine.trimmed();
+        if (line.isEmpty()) {
+            finishSample();
+            continue;
+        }
+        if (!rawLine.at(0).isSpace()) {
+            finishSample();
+            process = line.section(' ', 0, 0);
+            process.replace(';', ':');
+            continue;
+        }
+        if (process.isEmpty())
+            continue;
+
+        frames.append(frameSymbol(line));
+    }
+    finishSample();
+    return result;
+}
+
+// Address, symbol with offset and the binary in parentheses
+QString NimStackFolder::frameSymbol(const QString &frame, QString *binary)
+{
+    QString symbol = frame.section(' ', 1);
+    const int binaryStart = symbol.lastIndexOf(" (");
+    const QString frameBinary = binaryStart < 0 ? QString() : symbol.mid(binaryStart + 2).chopped(1);
+    symbol = binaryStart < 0 ? symbol : symbol.left(binaryStart);
+    const int offset = symbol.lastIndexOf("+0x");
+    if (offset > 0)
+        symbol.truncate(offset);
+    if (symbol.isEmpty() || symbol == "[unknown]") {
+        const QString fileName = FilePath::fromString(frameBinary).fileName();
+        symbol = fileName.isEmpty() || fileName == "[unknown]" ? QString("[unknown]") : '[' + fileName + ']';
+    }
+    if (binary)
+        *binary = frameBinary;
+    return symbolName(symbol);
+}
+
+// perf script runs with --no-demangle, perf's own demangling of Rust
+// symbols depends on how it was built and keeps the hashes of legacy ones
+QString NimStackFolder::symbolName(const QString &symbol)
+{
+    const QByteArray mangled = symbol.toUtf8();
+    QString name = NimRustDemangler::demangle(mangled);
+#if defined(__GNUC__)
+    if (name == symbol && mangled.startsWith("_Z")) {
+        int status = 0;
+        if (char *demangled = abi::__cxa_demangle(mangled.constData(), nullptr, nullptr, &status)) {
+            name = QString::fromUtf8(demangled);
+            std::free(demangled);
+        }
+    }
+#endif
+    name.replace(';', ':');
+    return name;
+}
+
+NimFoldedStacks NimStackFolder::readFolded(const FilePath &path)
+{
+    NimFoldedStacks result;
+    QFile file(path.toString());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return result;
+    while (!file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        const int space = line.lastIndexOf(' ');
+        if (space > 0)
+            result[line.left(space)] += line.mid(space + 1).toLongLong();
+    }
+    return result;
+}
+
+bool NimStackFolder::writeFolded(const FilePath &path, const NimFoldedStacks &stacks)
+{
+    QFile file(path.toString());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+    for (auto it = stacks.cbegin(); it != stacks.cend(); ++it)
+        file.write(it.key().toUtf8() + ' ' + QByteArray::number(it.value()) + '\n');
+    return true;
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QBuffer>
+#include <QTest>
+
+namespace Nim {
+
+void RustPlugin::testStackFolder_data()
+{
+    QTest::addColumn<QStringList>("script");
+    QTest::addColumn<QStringList>("folded");
+
+    const QString server = " (/work/target/release/server)";
+    QTest::newRow("v0 and legacy symbols")
+            << QStringList({"server ",
+                            "\t    55d0c1a2b3c4 _RNvCs1234_6server6handle+0x14" + server,
+                            "\t    55d0c1a2b3d5 _ZN6server4main17h0123456789abcdefE+0x20" + server,
+                            "",
+                            "server ",
+                            "\t    55d0c1a2b3f0 _RNvCs1234_6server6handle+0x30" + server,
+                            "\t    55d0c1a2b3d5 _ZN6server4main17h0123456789abcdefE+0x20" + server,
+                            ""})
+            << QStringList({"server;server::main;server::handle 2"});
+
+    QTest::newRow("unknown frames")
+            << QStringList({"worker ",
+                            "\t    7f3a5c0a1234 [unknown] (/usr/lib/libc.so.6)",
+                            "\t    55d0c1a2b3d5 _ZN6server4main17h0123456789abcdefE+0x20" + server,
+                            "\t    ffffffffffffffff [unknown] ([unknown])",
+                            ""})
+            << QStringList({"worker;[unknown];server::main;[libc.so.6] 1"});
+
+    QTest::newRow("C++ frames, semicolons and no trailing empty line")
+            << QStringList({"a;b ",
+                            "\t    7f3a5c0a1234 _ZN3foo3barEv+0x10 (/usr/lib/libfoo.so)",
+                            "",
+                            "server ",
+                            "\t    55d0c1a2b3c4 _RNvCs1234_6server6handle+0x14" + server})
+            << QStringList({"a:b;foo::bar() 1", "server;server::handle 1"});
+
+    QTest::newRow("frames without a sample header")
+            << QStringList({"\t    55d0c1a2b3c4 _RNvCs1234_6server6handle+0x14" + server, ""})
+            << QStringList();
+}
+
+void RustPlugin::testStackFolder()
+{
+    QFETCH(QStringList, script);
+    QFETCH(QStringList, folded);
+
+    QByteArray data = script.join('\n').toUtf8();
+    QBuffer buffer(&data);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    const NimFoldedStacks stacks = NimStackFolder::foldScript(&buffer);
+    QStringList lines;
+    for (auto it = stacks.cbegin(); it != stacks.cend(); ++it)
+        lines << it.key() + ' ' + QString::number(it.value());
+    lines.sort();
+    QCOMPARE(lines, folded);
+
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
@@ -0,0 +1,80 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include <utils/fileutils.h>
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+#include <QProcess>
+
+QT_BEGIN_NAMESPACE
+class QIODevice;
+QT_END_NAMESPACE
+
+namespace Nim {
+
+using NimFoldedStacks = QHash<QString, qint64>;
+
+// Turns perf recordings into folded stacks, "process;outer;...;inner count"
+// per line, as used by flame graphs. Recordings are folded one after another
+// with perf script, the folding itself runs in a worker thread. The count of
+// off-CPU recordings is the time waited in microseconds, see NimOffCpuProfile.
+class NimStackFolder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NimStackFolder(QObject *parent = nullptr);
+    ~NimStackFolder() override;
+
+    void fold(const Utils::FilePath &recording);
+
+    static NimFoldedStacks foldScript(QIODevice *script);
+    // The symbol of a frame line of perf script
+    static QString frameSymbol(const QString &frame, QString *binary = nullptr);
+    static QString symbolName(const QString &symbol);
+
+    static NimFoldedStacks readFolded(const Utils::FilePath &path);
+    static bool writeFolded(const Utils::FilePath &path, const NimFoldedStacks &stacks);
+
+signals:
+    void folded(const Utils::FilePath &foldedFile);
+    void failed(const QString &message);
+
+private:
+    void startNext();
+    void onScriptFinished(int exitCode, QProcess::ExitStatus status);
+
+    Utils::FilePaths m_queue;
+    Utils::FilePath m_current;
+    QProcess *m_process = nullptr;
+    QFutureWatcher<bool> m_watcher;
+};
+
+} // namespace Nim
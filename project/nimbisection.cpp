@@ -0,0 +1,578 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+
+#include "nimbisection.h"
+
+#include "nimbuildconfiguration.h"
+#include "nimcargomessages.h"
+#include "nimcompilerbuildstep.h"
+#include "nimdatadirectory.h"
+#include "nimgit.h"
+#include "nimrunconfiguration.h"
+
+#include "../nimconstants.h"
+#include "../profiler/nimbenchmarks.h"
+
+#include <coreplugin/icore.h>
+#include <coreplugin/messagemanager.h>
+#include <projectexplorer/kitinformation.h>
+#include <projectexplorer/project.h>
+#include <projectexplorer/runconfigurationaspects.h>
+#include <projectexplorer/target.h>
+#include <projectexplorer/toolchain.h>
+#include <utils/qtcassert.h>
+
+#include <QComboBox>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QDir>
+#include <QDoubleSpinBox>
+#include <QFormLayout>
+#include <QLineEdit>
+#include <QRegularExpression>
+#include <QSpinBox>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using namespace ProjectExplorer;
+using namespace Utils;
+
+namespace Nim {
+
+// Two-sided 95% quantiles of Student's t distribution by degrees of freedom
+static double tQuantile(int degreesOfFreedom)
+{
+    static const double quantiles[] = {12.71, 4.30, 3.18, 2.78, 2.57, 2.45, 2.36, 2.31, 2.26, 2.23};
+    if (degreesOfFreedom < 1)
+        return 0;
+    if (degreesOfFreedom <= 10)
+        return quantiles[degreesOfFreedom - 1];
+    return degreesOfFreedom <= 30 ? 2.1 : 1.96;
+}
+
+// NimBisectionCommit
+
+double NimBisectionCommit::mean(const QString &benchmark) const
+{
+    const QVector<double> values = samples.value(benchmark);
+    if (values.isEmpty())
+        return 0;
+    return std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+}
+
+double NimBisectionCommit::confidence(const QString &benchmark) const
+{
+    const QVector<double> values = samples.value(benchmark);
+    if (values.size() < 2)
+        return 0;
+    const double average = mean(benchmark);
+    double squares = 0;
+    for (double value : values)
+        squares += (value - average) * (value - average);
+    const double deviation = std::sqrt(squares / (values.size() - 1));
+    return tQuantile(values.size() - 1) * deviation / std::sqrt(double(values.size()));
+}
+
+// The bisection parameters
+
+class NimBisectionParameters
+{
+public:
+    NimBenchRunConfiguration *benchmark = nullptr;
+    QString benchmarkName;  // empty for all
+    QString good;
+    QString bad;
+    int runs = 0;
+    double threshold = 0;
+};
+
+static QString lastMeasuredCommit(NimBenchRunConfiguration *benchmark)
+{
+    const QVector<NimBenchmarkRun> history = NimBenchmarks::readHistory(NimBenchmarks::historyFile(benchmark));
+    const int baseline = NimBenchmarks::defaultBaseline(history);
+    if (baseline < 0)
+        return QString();
+    QString commit = history.at(baseline).commit;
+    commit.remove(QRegularExpression("-dirty$"));
+    return commit == "-" ? QString() : commit;
+}
+
+// The benchmarks of the last run of a bench target
+static QStringList benchmarkNames(NimBenchRunConfiguration *benchmark)
+{
+    const QVector<NimBenchmarkRun> history = NimBenchmarks::readHistory(NimBenchmarks::historyFile(benchmark));
+    QStringList names;
+    if (!history.isEmpty()) {
+        for (const NimBenchmarkResult &result : history.last().results)
+            names.append(result.name);
+    }
+    return names;
+}
+
+static bool askParameters(const QList<NimBenchRunConfiguration *> &benchmarks,
+                          NimBisectionParameters &parameters)
+{
+    QDialog dialog(Core::ICore::dialogParent());
+    dialog.setWindowTitle(NimPerformanceBisection::tr("Bisect Performance Regression"));
+    auto benchmarkComboBox = new QComboBox;
+    for (NimBenchRunConfiguration *benchmark : benchmarks)
+        benchmarkComboBox->addItem(benchmark->displayName());
+    benchmarkComboBox->setCurrentIndex(qMax(0, benchmarks.indexOf(parameters.benchmark)));
+    auto nameComboBox = new QComboBox;
+    nameComboBox->setToolTip(NimPerformanceBisection::tr("The benchmark to judge the commits by, or all of "
+                                                         "them, judged by the one with the largest slowdown"));
+    auto goodLineEdit = new QLineEdit;
+    goodLineEdit->setPlaceholderText(NimPerformanceBisection::tr("Commit, branch or tag"));
+    auto badLineEdit = new QLineEdit(parameters.bad);
+    auto runsSpinBox = new QSpinBox;
+    runsSpinBox->setRange(2, 50);
+    runsSpinBox->setValue(parameters.runs);
+    auto thresholdSpinBox = new QDoubleSpinBox;
+    thresholdSpinBox->setRange(0.5, 100);
+    thresholdSpinBox->setSuffix(" %");
+    thresholdSpinBox->setValue(100 * parameters.threshold);
+    thresholdSpinBox->setToolTip(NimPerformanceBisection::tr("How much slower than the good commit a commit "
+                                                             "has to be to count as bad"));
+    auto buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+
+    // The baseline the benchmark results are compared with is a likely good commit
+    auto updateBenchmark = [&] {
+        const int index = benchmarkComboBox->currentIndex();
+        if (index < 0)
+            return;
+        goodLineEdit->setText(lastMeasuredCommit(benchmarks.at(index)));
+        nameComboBox->clear();
+        nameComboBox->addItem(NimPerformanceBisection::tr("All"));
+        nameComboBox->addItems(benchmarkNames(benchmarks.at(index)));
+    };
+    updateBenchmark();
+    QObject::connect(benchmarkComboBox, QOverload<int>::of(&QComboBox::activated), &dialog, updateBenchmark);
+    QObject::connect(buttons, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    QObject::connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    auto layout = new QFormLayout(&dialog);
+    layout->addRow(NimPerformanceBisection::tr("Bench target:"), benchmarkComboBox);
+    layout->addRow(NimPerformanceBisection::tr("Benchmark:"), nameComboBox);
+    layout->addRow(NimPerformanceBisection::tr("Good commit:"), goodLineEdit);
+    layout->addRow(NimPerformanceBisection::tr("Bad commit:"), badLineEdit);
+    layout->addRow(NimPerformanceBisection::tr("Runs per commit:"), runsSpinBox);
+    layout->addRow(NimPerformanceBisection::tr("Slowdown threshold:"), thresholdSpinBox);
+    layout->addRow(buttons);
+
+    if (dialog.exec() != QDialog::Accepted || benchmarkComboBox->currentIndex() < 0)
+        return false;
+    parameters.benchmark = benchmarks.at(benchmarkComboBox->currentIndex());
+    parameters.benchmarkName = nameComboBox->currentIndex() > 0 ? nameComboBox->currentText() : QString();
+    parameters.good = goodLineEdit->text().trimmed();
+    parameters.bad = badLineEdit->text().trimmed();
+    parameters.runs = runsSpinBox->value();
+    parameters.threshold = thresholdSpinBox->value() / 100;
+    return true;
+}
+
+// NimPerformanceBisection
+
+NimPerformanceBisection::NimPerformanceBisection(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_sequence, &NimCommandSequence::message, this, [](const QString &message) {
+        Core::MessageManager::write(message);
+    });
+}
+
+bool NimPerformanceBisection::isRunning() const
+{
+    return m_sequence.isRunning();
+}
+
+void NimPerformanceBisection::run(NimBuildConfiguration *buildConfiguration)
+{
+    if (isRunning() || !buildConfiguration)
+        return;
+    ToolChain *toolChain = ToolChainKitAspect::toolChain(buildConfiguration->target()->kit(),
+                                                         Constants::C_NIMLANGUAGE_ID);
+    NimCompilerBuildStep *buildStep = buildConfiguration->nimCompilerBuildStep();
+    if (!toolChain || !buildStep) {
+        Core::MessageManager::write(tr("Bisecting needs a Rust tool chain and a build step."));
+        return;
+    }
+    QList<NimBenchRunConfiguration *> benchmarks;
+    for (RunConfiguration *runConfiguration : buildConfiguration->target()->runConfigurations()) {
+        if (auto benchmark = qobject_cast<NimBenchRunConfiguration *>(runConfiguration))
+            benchmarks.append(benchmark);
+    }
+    if (benchmarks.isEmpty()) {
+        Core::MessageManager::write(tr("Bisecting needs a bench target and its run configuration."));
+        return;
+    }
+    const FilePath projectDirectory = buildConfiguration->project()->projectDirectory();
+    const FilePath topLevel = FilePath::fromString(
+                NimGit::output(projectDirectory, {"rev-parse", "--show-toplevel"}));
+    if (topLevel.isEmpty()) {
+        Core::MessageManager::write(tr("Bisecting needs a git repository."));
+        return;
+    }
+
+    NimBisectionParameters parameters;
+    parameters.benchmark = qobject_cast<NimBenchRunConfiguration *>(
+                buildConfiguration->target()->activeRunConfiguration());
+    parameters.bad = "HEAD";
+    parameters.runs = m_runs;
+    parameters.threshold = m_threshold;
+    if (!askParameters(benchmarks, parameters))
+        return;
+    m_runs = parameters.runs;
+    m_threshold = parameters.threshold;
+
+    const QString good = NimGit::output(topLevel, {"rev-parse", "--verify", parameters.good + "^{commit}"});
+    const QString bad = NimGit::output(topLevel, {"rev-parse", "--verify", parameters.bad + "^{commit}"});
+    if (good.isEmpty() || bad.isEmpty()) {
+        Core::MessageManager::write(tr("\"%1\" is not a commit.").arg(good.isEmpty() ? parameters.good
+                                                                                     : parameters.bad));
+        return;
+    }
+    if (NimGit::output(topLevel, {"merge-base", good, bad}) != good) {
+        Core::MessageManager::write(tr("The good commit must be an ancestor of the bad commit."));
+        return;
+    }
+    // Oldest first, starting with the good commit
+    QStringList lines = NimGit::output(topLevel, {"log", "--first-parent", "--format=%H%x09%s",
+                                                  good + ".." + bad})
+            .split('\n', QString::SkipEmptyParts);
+    lines.append(NimGit::output(topLevel, {"log", "-1", "--format=%H%x09%s", good}));
+    std::reverse(lines.begin(), lines.end());
+    m_commits.clear();
+    for (const QString &line : qAsConst(lines)) {
+        NimBisectionCommit commit;
+        commit.hash = line.section('\t', 0, 0);
+        commit.subject = line.section('\t', 1);
+        m_commits.append(commit);
+    }
+    if (m_commits.size() < 2) {
+        Core::MessageManager::write(tr("There are no commits between the good and the bad commit."));
+        return;
+    }
+
+    m_buildConfiguration = buildConfiguration;
+    const BuildTargetInfo targetInfo = parameters.benchmark->buildTargetInfo();
+    m_bench = targetInfo.additionalData.toString();
+    m_benchArguments = parameters.benchmark->aspect<ArgumentsAspect>()->arguments(
+                parameters.benchmark->macroExpander());
+    m_benchmarkName = parameters.benchmarkName;
+    const Runnable runnable = parameters.benchmark->runnable();
+    m_runEnvironment = runnable.environment;
+    m_environment = buildStep->cargoEnvironment();
+    m_wallTime = false;
+
+    const FilePath bisectDirectory = NimDataDirectory::besideBuildDirectory(buildConfiguration, "bisect");
+    m_worktree = bisectDirectory.pathAppended("worktree");
+    const FilePath manifest = m_worktree.pathAppended(
+                QDir(topLevel.toString()).relativeFilePath(targetInfo.projectFilePath.toString()));
+    m_packageDirectory = manifest.parentDir();
+
+    // The build step's options, but for the bench target in the worktree
+    m_build = CommandLine(toolChain->compilerCommand(), {"bench", "--no-run"});
+    bool subcommandSkipped = false;
+    for (const QString &option : buildStep->userCompilerOptions()) {
+        if (option.isEmpty() || option == "--release")
+            continue;
+        if (!subcommandSkipped && !option.startsWith('-')) {
+            subcommandSkipped = true;
+            continue;
+        }
+        m_build.addArg(option);
+    }
+    m_build.addArgs({"--bench", m_bench,
+                     "--target-dir=" + bisectDirectory.pathAppended("target").toString(),
+                     "--manifest-path=" + manifest.toString(),
+                     "--message-format=json-render-diagnostics"});
+    m_build.addArgs(buildStep->cargoConfigArguments());
+
+    m_sequence.setWorkingDirectory(topLevel);
+    m_sequence.setEnvironment(m_environment);
+    m_sequence.addCommand(CommandLine(FilePath::fromString("git"), {"worktree", "prune"}), {}, true);
+    if (!m_worktree.pathAppended(".git").exists()) {
+        m_sequence.addCommand(CommandLine(FilePath::fromString("git"),
+                                          {"worktree", "add", "--detach", "--force", m_worktree.toString(), good}));
+    }
+    Core::MessageManager::write(tr("Bisecting %1 over %n commit(s), %2 runs each, a commit is bad when it is "
+                                   "more than %3% slower than %4...", nullptr, m_commits.size() - 1)
+                                    .arg(m_benchmarkName.isEmpty() ? parameters.benchmark->displayName()
+                                                                   : m_benchmarkName)
+                                    .arg(m_runs)
+                                    .arg(100 * m_threshold).arg(good.left(10)));
+    addMeasurement(0);
+    m_sequence.start();
+}
+
+void NimPerformanceBisection::addMeasurement(int index)
+{
+    const NimBisectionCommit commit = m_commits.at(index);
+    m_sequence.addAction([this, commit] {
+        Core::MessageManager::write(tr("Building %1 %2...").arg(commit.hash.left(10), commit.subject));
+        m_sequence.setWorkingDirectory(m_worktree);
+        m_sequence.setEnvironment(m_environment);
+        m_executable.clear();
+    });
+    m_sequence.addCommand(CommandLine(FilePath::fromString("git"),
+                                      {"checkout", "--quiet", "--force", "--detach", commit.hash}));
+    m_sequence.addCommand(m_build, [this](const NimCommandResult &result) {
+        if (!result.success())
+            return;
+        for (const NimCargoExecutable &executable : NimCargoMessages::executables(result.standardOutput)) {
+            if (executable.test && executable.name == m_bench)
+                m_executable = executable.path;
+        }
+    }, true);
+    m_sequence.addAction([this, index] { addRuns(index); });
+}
+
+void NimPerformanceBisection::addRuns(int index)
+{
+    if (m_executable.isEmpty()) {
+        Core::MessageManager::write(tr("The benchmark did not build at %1, skipping it.")
+                                        .arg(m_commits.at(index).hash.left(10)));
+        evaluate(index);
+        return;
+    }
+    // Like cargo bench, which runs benchmarks in their package directory
+    m_sequence.setWorkingDirectory(m_packageDirectory);
+    m_sequence.setEnvironment(m_runEnvironment);
+    CommandLine command(m_executable, {"--bench"});
+    command.addArgs(m_benchArguments, CommandLine::Raw);
+    for (int run = 0; run < m_runs; ++run) {
+        m_sequence.addCommand(command, [this, index](const NimCommandResult &result) {
+            if (!result.success())
+                return;
+            const QVector<NimBenchmarkResult> results
+                    = NimBenchmarks::parseOutput(QString::fromUtf8(result.standardOutput));
+            NimBisectionCommit &commit = m_commits[index];
+            for (const NimBenchmarkResult &benchmark : results) {
+                if (m_benchmarkName.isEmpty() || benchmark.name == m_benchmarkName)
+                    commit.samples[benchmark.name].append(benchmark.estimate);
+            }
+            // The time of the run for benchmarks that report nothing the parser knows
+            if (results.isEmpty()) {
+                m_wallTime = true;
+                commit.samples[QString()].append(result.seconds * 1e9);
+            }
+        }, true);
+    }
+    m_sequence.addAction([this, index] { evaluate(index); });
+}
+
+void NimPerformanceBisection::evaluate(int index)
+{
+    NimBisectionCommit &commit = m_commits[index];
+    const bool isGood = index == 0;
+    const bool isBad = index == m_commits.size() - 1;
+    if (commit.samples.isEmpty()) {
+        commit.verdict = NimBisectionCommit::Skipped;
+    } else if (isGood) {
+        commit.verdict = NimBisectionCommit::Good;
+        Core::MessageManager::write(tr("%1: %n benchmark(s) measured", nullptr, commit.samples.size())
+                                        .arg(commit.hash.left(10)));
+    } else {
+        classify(commit, m_commits.first(), m_threshold);
+        if (commit.verdict == NimBisectionCommit::Skipped) {
+            Core::MessageManager::write(tr("%1 has none of the benchmarks of the good commit, skipping it.")
+                                            .arg(commit.hash.left(10)));
+        }
+    }
+    if (commit.verdict == NimBisectionCommit::Skipped && (isGood || isBad)) {
+        Core::MessageManager::write(tr("The benchmark could not be run at the %1 commit.")
+                                        .arg(isGood ? tr("good") : tr("bad")));
+        return;
+    }
+    if (!isGood && commit.verdict != NimBisectionCommit::Skipped) {
+        const QString &name = commit.slowest;
+        const double goodMean = m_commits.first().mean(name);
+        Core::MessageManager::write(tr("%1: %2 %3 ± %4, %5% compared with the good commit: %6")
+                                        .arg(commit.hash.left(10), name.isEmpty() ? tr("Run time") : name,
+                                             NimBenchmarks::formatDuration(commit.mean(name)),
+                                             NimBenchmarks::formatDuration(commit.confidence(name)))
+                                        .arg(100 * (commit.mean(name) - goodMean) / goodMean, 0, 'f', 1)
+                                        .arg(commit.verdict == NimBisectionCommit::Bad
+                                                 ? (commit.uncertain ? tr("bad, but close") : tr("bad"))
+                                                 : (commit.uncertain ? tr("good, but close") : tr("good"))));
+    }
+    if (isBad && commit.verdict != NimBisectionCommit::Bad) {
+        Core::MessageManager::write(tr("The bad commit is not more than %1% slower than the good one.")
+                                        .arg(100 * m_threshold));
+        return;
+    }
+
+    const int next = nextCommit(m_commits);
+    if (next < 0)
+        report();
+    else
+        addMeasurement(next);
+}
+
+int NimPerformanceBisection::nextCommit(const QVector<NimBisectionCommit> &commits)
+{
+    if (commits.isEmpty())
+        return -1;
+    if (commits.first().verdict == NimBisectionCommit::Unmeasured)
+        return 0;
+    if (commits.last().verdict == NimBisectionCommit::Unmeasured)
+        return commits.size() - 1;
+    int bad = commits.size() - 1;
+    for (int i = 0; i < commits.size(); ++i) {
+        if (commits.at(i).verdict == NimBisectionCommit::Bad) {
+            bad = i;
+            break;
+        }
+    }
+    int good = 0;
+    for (int i = 0; i < bad; ++i) {
+        if (commits.at(i).verdict == NimBisectionCommit::Good)
+            good = i;
+    }
+    // The unmeasured commit closest to the middle
+    const double middle = (good + bad) / 2.0;
+    int next = -1;
+    for (int i = good + 1; i < bad; ++i) {
+        if (commits.at(i).verdict == NimBisectionCommit::Unmeasured
+                && (next < 0 || std::abs(i - middle) < std::abs(next - middle))) {
+            next = i;
+        }
+    }
+    return next;
+}
+
+void NimPerformanceBisection::classify(NimBisectionCommit &commit, const NimBisectionCommit &good,
+                                       double threshold)
+{
+    // Ratios, because the slowdown of a fast benchmark vanishes in the sum of all of them
+    bool found = false;
+    double largestRatio = 0;
+    for (auto it = commit.samples.cbegin(); it != commit.samples.cend(); ++it) {
+        const double goodMean = good.mean(it.key());
+        if (goodMean <= 0 || it.value().isEmpty())
+            continue;
+        const double ratio = commit.mean(it.key()) / goodMean;
+        if (!found || ratio > largestRatio) {
+            found = true;
+            largestRatio = ratio;
+            commit.slowest = it.key();
+        }
+    }
+    if (!found) {
+        commit.verdict = NimBisectionCommit::Skipped;
+        return;
+    }
+    const double limit = good.mean(commit.slowest) * (1 + threshold);
+    const double mean = commit.mean(commit.slowest);
+    commit.verdict = mean > limit ? NimBisectionCommit::Bad : NimBisectionCommit::Good;
+    commit.uncertain = std::abs(mean - limit) < commit.confidence(commit.slowest);
+}
+
+void NimPerformanceBisection::report()
+{
+    int bad = m_commits.size() - 1;
+    for (int i = 0; i < m_commits.size(); ++i) {
+        if (m_commits.at(i).verdict == NimBisectionCommit::Bad) {
+            bad = i;
+            break;
+        }
+    }
+    int good = 0;
+    for (int i = 0; i < bad; ++i) {
+        if (m_commits.at(i).verdict == NimBisectionCommit::Good)
+            good = i;
+    }
+
+    QStringList lines;
+    const NimBisectionCommit &first = m_commits.at(bad);
+    if (bad - good == 1) {
+        lines << tr("The first bad commit is %1 %2.").arg(first.hash, first.subject);
+    } else {
+        lines << tr("The regression is in one of these commits, the others did not build:");
+        for (int i = good + 1; i <= bad; ++i)
+            lines << QString("  %1 %2").arg(m_commits.at(i).hash, m_commits.at(i).subject);
+    }
+    if (first.uncertain || m_commits.at(good).uncertain)
+        lines << tr("The commits next to it were close to the threshold, more runs per commit would tell "
+                    "them apart with more confidence.");
+    if (m_wallTime)
+        lines << tr("Some runs reported no benchmark results, their duration was measured instead.");
+    lines << tr("The worktree in %1 is kept for the next bisection, remove it with \"git worktree remove\".")
+                 .arg(m_worktree.toUserOutput());
+    Core::MessageManager::write(lines.join('\n'));
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QTest>
+
+namespace Nim {
+
+void RustPlugin::testPerformanceBisection()
+{
+    NimBisectionCommit good;
+    good.samples["slow"] = {1e9, 1e9, 1e9};
+    good.samples["fast"] = {100, 100, 100};
+
+    // 20% slower in the fast benchmark, which is nothing in the sum
+    NimBisectionCommit commit;
+    commit.samples["slow"] = {1e9, 1e9, 1e9};
+    commit.samples["fast"] = {120, 120, 120};
+    NimPerformanceBisection::classify(commit, good, 0.05);
+    QCOMPARE(commit.verdict, NimBisectionCommit::Bad);
+    QCOMPARE(commit.slowest, QString("fast"));
+    QVERIFY(!commit.uncertain);
+
+    commit.samples["fast"] = {102, 98, 101};
+    NimPerformanceBisection::classify(commit, good, 0.05);
+    QCOMPARE(commit.verdict, NimBisectionCommit::Good);
+
+    NimBisectionCommit renamed;
+    renamed.samples["other"] = {100};
+    NimPerformanceBisection::classify(renamed, good, 0.05);
+    QCOMPARE(renamed.verdict, NimBisectionCommit::Skipped);
+
+    QVector<NimBisectionCommit> commits(5);
+    QCOMPARE(NimPerformanceBisection::nextCommit(commits), 0);
+    commits[0].verdict = NimBisectionCommit::Good;
+    QCOMPARE(NimPerformanceBisection::nextCommit(commits), 4);
+    commits[4].verdict = NimBisectionCommit::Bad;
+    QCOMPARE(NimPerformanceBisection::nextCommit(commits), 2);
+    commits[2].verdict = NimBisectionCommit::Skipped;
+    const int next = NimPerformanceBisection::nextCommit(commits);
+    QVERIFY(next == 1 || next == 3);
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
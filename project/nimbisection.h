@@ -0,0 +1,111 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+
+#pragma once
+
+#include "nimcommandsequence.h"
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+
+namespace Nim {
+
+class NimBuildConfiguration;
+
+class NimBisectionCommit
+{
+public:
+    enum Verdict { Unmeasured, Good, Bad, Skipped };
+
+    QString hash;
+    QString subject;
+    // Nanoseconds per run by benchmark name, the duration of the runs under
+    // an empty name when the output has no results the parser knows
+    QHash<QString, QVector<double>> samples;
+    Verdict verdict = Unmeasured;
+    QString slowest;          // the benchmark with the largest slowdown
+    bool uncertain = false;   // the confidence interval spans the threshold
+
+    double mean(const QString &benchmark) const;
+    // Half the width of the 95% confidence interval of the mean
+    double confidence(const QString &benchmark) const;
+};
+
+// Finds the commit that made a benchmark slower. The commits between a good
+// and a bad one, along the first-parent history, are checked out in turn in
+// a git worktree in <build directory>-bisect/worktree and their bench target
+// is built with the build step's options and environment. The benchmarks run
+// a number of times per commit, a commit is bad when one of them, or the one
+// that was picked, is slower than at the good commit by more than the
+// threshold.
+//
+// All steps build into <build directory>-bisect/target, so that only what
+// changed between two commits is compiled again, and the worktree and target
+// directory are kept for the next bisection.
+class NimPerformanceBisection : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NimPerformanceBisection(QObject *parent = nullptr);
+
+    bool isRunning() const;
+    void run(NimBuildConfiguration *buildConfiguration);
+
+    // The commit to measure next or -1 when done, skipping commits that
+    // did not build. Index 0 is the good and the last one the bad commit.
+    static int nextCommit(const QVector<NimBisectionCommit> &commits);
+    // Compares every benchmark with its mean at the good commit and judges
+    // the commit by the one with the largest slowdown
+    static void classify(NimBisectionCommit &commit, const NimBisectionCommit &good, double threshold);
+
+private:
+    void addMeasurement(int index);
+    void addRuns(int index);
+    void evaluate(int index);
+    void report();
+
+    QPointer<NimBuildConfiguration> m_buildConfiguration;
+    NimCommandSequence m_sequence;
+    QVector<NimBisectionCommit> m_commits;
+    Utils::CommandLine m_build;
+    Utils::Environment m_environment;
+    Utils::Environment m_runEnvironment;
+    Utils::FilePath m_worktree;
+    Utils::FilePath m_packageDirectory;  // in the worktree
+    QString m_bench;
+    QString m_benchArguments;
+    QString m_benchmarkName;  // empty for all benchmarks
+    Utils::FilePath m_executable;
+    int m_runs = 5;
+    double m_threshold = 0.05;
+    bool m_wallTime = false;
+};
+
+} // namespace Nim
@@ -0,0 +1,462 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimbranchsnapshots.h"
+
+#include "nimbuildconfiguration.h"
+#include "nimgit.h"
+#include "nimramtargetdirectory.h"
+#include "nimutils.h"
+
+#include <coreplugin/messagemanager.h>
+#include <projectexplorer/buildmanager.h>
+#include <projectexplorer/project.h>
+#include <utils/qtcassert.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QHash>
+#include <QSaveFile>
+#include <QUrl>
+#include <QtConcurrent>
+
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+using namespace ProjectExplorer;
+using namespace Utils;
+
+namespace Nim {
+
+const char MANIFEST_FILE[] = ".rust-creator/sources.manifest";
+const char PARTIAL_SUFFIX[] = ".partial";
+const int MAX_SNAPSHOTS = 4;
+const int DEBOUNCE_MS = 1000;
+
+static QString snapshotName(const QString &ref)
+{
+    return QString::fromLatin1(QUrl::toPercentEncoding(ref));
+}
+
+// Tracked files whose working tree content matches the index, with their blob ids
+static QHash<QByteArray, QByteArray> cleanTrackedFiles(const FilePath &projectDirectory)
+{
+    QHash<QByteArray, QByteArray> result;
+    // "<mode> <blob> <stage>\t<path>"
+    const QByteArray files = NimGit::run(projectDirectory, {"ls-files", "-s", "-z"});
+    for (const QByteArray &entry : files.split('\0')) {
+        const int tab = entry.indexOf('\t');
+        const QList<QByteArray> fields = entry.left(tab).split(' ');
+        if (tab < 0 || fields.size() != 3)
+            continue;
+        result.insert(entry.mid(tab + 1), fields.at(1));
+    }
+    const QByteArray modified = NimGit::run(projectDirectory, {"diff", "--name-only", "--relative", "-z"});
+    for (const QByteArray &path : modified.split('\0'))
+        result.remove(path);
+    return result;
+}
+
+#ifdef Q_OS_UNIX
+static bool modificationTime(const QByteArray &path, struct timespec *time)
+{
+    struct stat st;
+    if (::stat(path.constData(), &st) != 0)
+        return false;
+    *time = st.st_mtim;
+    return true;
+}
+#endif
+
+// One "<blob> <seconds> <nanoseconds> <path>\0" record per clean tracked file
+static void writeManifest(const FilePath &projectDirectory, const FilePath &buildDirectory)
+{
+#ifdef Q_OS_UNIX
+    const QHash<QByteArray, QByteArray> files = cleanTrackedFiles(projectDirectory);
+    const QString root = projectDirectory.toString() + '/';
+    QByteArray manifest;
+    for (auto it = files.cbegin(); it != files.cend(); ++it) {
+        struct timespec time;
+        if (!modificationTime(QFile::encodeName(root) + it.key(), &time))
+            continue;
+        manifest += it.value() + ' ' + QByteArray::number(qint64(time.tv_sec)) + ' '
+                + QByteArray::number(qint64(time.tv_nsec)) + ' ' + it.key() + '\0';
+    }
+
+    const FilePath manifestFile = buildDirectory.pathAppended(MANIFEST_FILE);
+    QDir().mkpath(manifestFile.parentDir().toString());
+    QSaveFile file(manifestFile.toString());
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(manifest);
+        file.commit();
+    }
+#else
+    Q_UNUSED(projectDirectory)
+    Q_UNUSED(buildDirectory)
+#endif
+}
+
+static int restoreTimestamps(const FilePath &projectDirectory, const FilePath &buildDirectory)
+{
+    int restored = 0;
+#ifdef Q_OS_UNIX
+    QFile file(buildDirectory.pathAppended(MANIFEST_FILE).toString());
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+    const QHash<QByteArray, QByteArray> files = cleanTrackedFiles(projectDirectory);
+    const QByteArray root = QFile::encodeName(projectDirectory.toString() + '/');
+
+    for (const QByteArray &record : file.readAll().split('\0')) {
+        const QList<QByteArray> fields = record.split(' ');
+        if (fields.size() < 4)
+            continue;
+        // Paths may contain spaces
+        const QByteArray path = record.mid(fields.at(0).size() + fields.at(1).size()
+                                           + fields.at(2).size() + 3);
+        if (files.value(path) != fields.at(0))
+            continue;
+
+        const QByteArray absolutePath = root + path;
+        struct timespec times[2];
+        times[0].tv_sec = 0;
+        times[0].tv_nsec = UTIME_OMIT;
+        times[1].tv_sec = time_t(fields.at(1).toLongLong());
+        times[1].tv_nsec = long(fields.at(2).toLongLong());
+        struct timespec current;
+        if (!modificationTime(absolutePath, &current)
+                || (current.tv_sec == times[1].tv_sec && current.tv_nsec == times[1].tv_nsec)) {
+            continue;
+        }
+        if (::utimensat(AT_FDCWD, absolutePath.constData(), times, 0) == 0)
+            ++restored;
+    }
+#else
+    Q_UNUSED(projectDirectory)
+    Q_UNUSED(buildDirectory)
+#endif
+    return restored;
+}
+
+static void evictSnapshots(const FilePath &snapshotsDirectory)
+{
+    QFileInfoList snapshots = QDir(snapshotsDirectory.toString())
+            .entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::Hidden);
+    const auto lastBuilt = [](const QFileInfo &snapshot) {
+        return QFileInfo(snapshot.filePath() + '/' + MANIFEST_FILE).lastModified();
+    };
+    std::sort(snapshots.begin(), snapshots.end(), [&](const QFileInfo &a, const QFileInfo &b) {
+        return lastBuilt(a) > lastBuilt(b);
+    });
+    for (const QFileInfo &snapshot : snapshots.mid(MAX_SNAPSHOTS))
+        QDir(snapshot.filePath()).removeRecursively();
+}
+
+// The snapshots are taken of the build directory on disk. A target directory
+// in RAM is persisted to it first and replaced by the restored snapshot.
+static NimSnapshotSwitch switchSnapshots(const FilePath &projectDirectory,
+                                         const FilePath &buildDirectory,
+                                         const FilePath &ramDirectory,
+                                         const FilePath &snapshotsDirectory,
+                                         const QString &from, const QString &to)
+{
+    NimSnapshotSwitch result;
+    result.from = from;
+    result.to = to;
+    QDir().mkpath(snapshotsDirectory.toString());
+
+    if (!ramDirectory.isEmpty()
+            && !NimFileCloner::syncTree(ramDirectory, buildDirectory, {".fingerprint"}).ok) {
+        result.error = QCoreApplication::translate("Nim::NimBranchSnapshots",
+                                                   "Could not copy %1 to %2, the snapshots are "
+                                                   "left as they are.")
+                .arg(ramDirectory.toUserOutput(), buildDirectory.toUserOutput());
+        return result;
+    }
+    // The sync deletes nothing, the manifest of an earlier build may remain
+    if (!ramDirectory.isEmpty() && !ramDirectory.pathAppended(MANIFEST_FILE).exists())
+        QFile::remove(buildDirectory.pathAppended(MANIFEST_FILE).toString());
+
+    // Only a build directory that was built successfully on the branch being
+    // left is worth keeping
+    if (!from.isEmpty() && buildDirectory.pathAppended(MANIFEST_FILE).exists()) {
+        const QString snapshot = snapshotsDirectory.pathAppended(snapshotName(from)).toString();
+        const QString partial = snapshot + PARTIAL_SUFFIX;
+        QDir(partial).removeRecursively();
+
+        const qint64 freeBefore = NimFileCloner::freeBytes(snapshotsDirectory);
+        result.saveStatistics = NimFileCloner::cloneTree(buildDirectory, FilePath::fromString(partial));
+        if (result.saveStatistics.ok) {
+            QDir(snapshot).removeRecursively();
+            result.saved = QDir().rename(partial, snapshot);
+            result.diskOverhead = qMax(Q_INT64_C(0),
+                                       freeBefore - NimFileCloner::freeBytes(snapshotsDirectory));
+        } else {
+            QDir(partial).removeRecursively();
+            result.error = QCoreApplication::translate("Nim::NimBranchSnapshots",
+                                                       "Could not copy %1.")
+                    .arg(buildDirectory.toUserOutput());
+        }
+    }
+
+    // The incoming snapshot is moved rather than copied, it gets cloned again
+    // when the branch is left
+    const QString incoming = snapshotsDirectory.pathAppended(snapshotName(to)).toString();
+    if (QFileInfo::exists(incoming)) {
+        QDir(buildDirectory.toString()).removeRecursively();
+        result.restored = QDir().rename(incoming, buildDirectory.toString());
+        if (result.restored)
+            result.restoredTimestamps = restoreTimestamps(projectDirectory, buildDirectory);
+        else
+            result.error = QCoreApplication::translate("Nim::NimBranchSnapshots",
+                                                       "Could not move %1 to %2.")
+                    .arg(QDir::toNativeSeparators(incoming), buildDirectory.toUserOutput());
+    }
+    if (result.restored && !ramDirectory.isEmpty()) {
+        QDir(ramDirectory.toString()).removeRecursively();
+        if (!NimRamTargetDirectory::copy(buildDirectory, ramDirectory).ok) {
+            result.error = QCoreApplication::translate("Nim::NimBranchSnapshots",
+                                                       "Could not copy %1 to %2.")
+                    .arg(buildDirectory.toUserOutput(), ramDirectory.toUserOutput());
+        }
+    }
+
+    evictSnapshots(snapshotsDirectory);
+    return result;
+}
+
+NimBranchSnapshots::NimBranchSnapshots(NimBuildConfiguration *buildConfiguration)
+    : QObject(buildConfiguration)
+    , m_buildConfiguration(buildConfiguration)
+{
+    m_debounceTimer.setSingleShot(true);
+    m_debounceTimer.setInterval(DEBOUNCE_MS);
+    connect(&m_debounceTimer, &QTimer::timeout, this, &NimBranchSnapshots::startSwitch);
+    connect(&m_headWatcher, &QFileSystemWatcher::fileChanged,
+            this, &NimBranchSnapshots::onHeadChanged);
+    connect(&m_switchWatcher, &QFutureWatcherBase::finished,
+            this, &NimBranchSnapshots::onSwitchFinished);
+    connect(&m_manifestWatcher, &QFutureWatcherBase::finished,
+            this, &NimBranchSnapshots::onManifestWritten);
+    connect(BuildManager::instance(), &BuildManager::buildQueueFinished, this, [this] {
+        if (m_switchPending)
+            startSwitch();
+    });
+    connect(buildConfiguration, &NimBuildConfiguration::targetDirectoryIdle, this, [this] {
+        if (m_switchPending)
+            startSwitch();
+    });
+}
+
+bool NimBranchSnapshots::isEnabled() const
+{
+    return m_enabled;
+}
+
+void NimBranchSnapshots::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled)
+        return;
+    m_enabled = enabled;
+    updateWatcher();
+}
+
+bool NimBranchSnapshots::isBusy() const
+{
+    return m_switchWatcher.isRunning() || m_manifestWatcher.isRunning();
+}
+
+double NimBranchSnapshots::switchRebuildSeconds() const
+{
+    return m_switchRebuildSeconds;
+}
+
+void NimBranchSnapshots::setSwitchRebuildSeconds(double seconds)
+{
+    m_switchRebuildSeconds = seconds;
+}
+
+FilePath NimBranchSnapshots::snapshotsDirectory() const
+{
+    // Beside the build directory on disk, also while the target directory is in RAM
+    const FilePath buildDirectory = m_buildConfiguration->buildDirectory();
+    return buildDirectory.parentDir().pathAppended(buildDirectory.fileName() + ".snapshots");
+}
+
+void NimBranchSnapshots::buildStarted()
+{
+    // A failed or interrupted build leaves no manifest, so no timestamps
+    // are restored for it later
+    if (m_enabled)
+        QFile::remove(m_buildConfiguration->effectiveTargetDirectory().pathAppended(MANIFEST_FILE).toString());
+}
+
+QString NimBranchSnapshots::buildFinished(bool success, double seconds)
+{
+    if (!m_enabled || !success)
+        return QString();
+
+    QString report;
+    if (m_lastSwitch == LastSwitch::NotRestored) {
+        m_switchRebuildSeconds = seconds;
+        report = tr("First build after switching to \"%1\" took %2 s.")
+                .arg(m_currentRef).arg(seconds, 0, 'f', 1);
+    } else if (m_lastSwitch == LastSwitch::Restored && m_switchRebuildSeconds > 0) {
+        report = tr("First build after restoring the snapshot of \"%1\" took %2 s instead of "
+                    "about %3 s without a snapshot (%4 s saved).")
+                .arg(m_currentRef).arg(seconds, 0, 'f', 1).arg(m_switchRebuildSeconds, 0, 'f', 1)
+                .arg(qMax(0.0, m_switchRebuildSeconds - seconds), 0, 'f', 1);
+    }
+    m_lastSwitch = LastSwitch::None;
+
+    // The working tree changed during the build, the manifest would not
+    // describe what was compiled. The switch follows once the queue is done.
+    if (m_switchPending)
+        return report;
+
+    m_manifestWatcher.setFuture(QtConcurrent::run(writeManifest,
+                                                  m_buildConfiguration->project()->projectDirectory(),
+                                                  m_buildConfiguration->effectiveTargetDirectory()));
+    return report;
+}
+
+void NimBranchSnapshots::updateWatcher()
+{
+    if (!m_headWatcher.files().isEmpty())
+        m_headWatcher.removePaths(m_headWatcher.files());
+    m_gitDirectory.clear();
+    m_currentRef.clear();
+    if (!m_enabled)
+        return;
+
+    const QByteArray gitDirectory = NimGit::run(m_buildConfiguration->project()->projectDirectory(),
+                                                {"rev-parse", "--absolute-git-dir"}).trimmed();
+    if (gitDirectory.isEmpty()) {
+        Core::MessageManager::write(tr("Build directory snapshots need a git repository."));
+        return;
+    }
+    m_gitDirectory = FilePath::fromString(QFile::decodeName(gitDirectory));
+    m_currentRef = readHead();
+    m_headWatcher.addPath(m_gitDirectory.pathAppended("HEAD").toString());
+}
+
+void NimBranchSnapshots::onHeadChanged()
+{
+    // Git replaces HEAD by renaming a lock file, which drops the watch
+    const QString head = m_gitDirectory.pathAppended("HEAD").toString();
+    if (!m_headWatcher.files().contains(head))
+        m_headWatcher.addPath(head);
+    m_debounceTimer.start();
+}
+
+QString NimBranchSnapshots::readHead() const
+{
+    QFile file(m_gitDirectory.pathAppended("HEAD").toString());
+    if (!file.open(QIODevice::ReadOnly))
+        return QString();
+    const QString head = QString::fromUtf8(file.readAll()).trimmed();
+    if (head.startsWith("ref: refs/heads/"))
+        return head.mid(16);
+    if (head.startsWith("ref: "))
+        return head.mid(5);
+    return head.left(12); // detached HEAD
+}
+
+void NimBranchSnapshots::startSwitch()
+{
+    if (!m_enabled)
+        return;
+    const QString ref = readHead();
+    if (ref.isEmpty() || ref == m_currentRef)
+        return;
+    // Also waits for the RAM target directory, whose sync the switch does itself
+    if (m_buildConfiguration->isTargetDirectoryBusy()
+            || BuildManager::isBuilding(m_buildConfiguration->project())) {
+        m_switchPending = true;
+        return;
+    }
+    m_switchPending = false;
+
+    const QString from = m_currentRef;
+    m_currentRef = ref;
+    Core::MessageManager::write(tr("Branch changed from \"%1\" to \"%2\", updating build "
+                                   "directory snapshots...").arg(from, ref));
+    const FilePath projectDirectory = m_buildConfiguration->project()->projectDirectory();
+    const FilePath buildDirectory = m_buildConfiguration->buildDirectory();
+    const NimRamTargetDirectory *ram = m_buildConfiguration->ramTargetDirectory();
+    const FilePath ramDirectory = ram->isActive() ? ram->directory() : FilePath();
+    const FilePath snapshots = snapshotsDirectory();
+    m_switchWatcher.setFuture(QtConcurrent::run([=] {
+        return switchSnapshots(projectDirectory, buildDirectory, ramDirectory, snapshots, from, ref);
+    }));
+}
+
+void NimBranchSnapshots::onSwitchFinished()
+{
+    const NimSnapshotSwitch result = m_switchWatcher.result();
+    QStringList lines;
+    if (result.saved) {
+        const NimCloneStatistics &save = result.saveStatistics;
+        lines << tr("Saved snapshot of \"%1\": %2 files, %3 MiB (%4 reflinked, %5 copied), "
+                    "%6 MiB of additional disk space.")
+                 .arg(result.from).arg(save.files).arg(NimUtils::toMiB(save.bytes))
+                 .arg(save.reflinkedFiles).arg(save.copiedFiles).arg(NimUtils::toMiB(result.diskOverhead));
+    }
+    if (result.restored) {
+        QString line = tr("Restored snapshot of \"%1\" and the timestamps of %2 unchanged sources.")
+                .arg(result.to).arg(result.restoredTimestamps);
+        if (m_switchRebuildSeconds > 0)
+            line += ' ' + tr("A rebuild after a branch switch took %1 s.")
+                    .arg(m_switchRebuildSeconds, 0, 'f', 1);
+        lines << line;
+        m_lastSwitch = LastSwitch::Restored;
+    } else {
+        lines << tr("No snapshot of \"%1\" yet, the next build starts from the current "
+                    "build directory.").arg(result.to);
+        m_lastSwitch = LastSwitch::NotRestored;
+    }
+    if (!result.error.isEmpty())
+        lines << result.error;
+    Core::MessageManager::write(lines.join('\n'));
+
+    if (m_switchPending)
+        startSwitch();
+    if (!isBusy())
+        emit idle();
+}
+
+void NimBranchSnapshots::onManifestWritten()
+{
+    if (m_switchPending)
+        startSwitch();
+    if (!isBusy())
+        emit idle();
+}
+
+} // namespace Nim
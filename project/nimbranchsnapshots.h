@@ -0,0 +1,110 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include "nimfilecloner.h"
+
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QTimer>
+
+namespace Nim {
+
+class NimBuildConfiguration;
+
+class NimSnapshotSwitch
+{
+public:
+    QString from;
+    QString to;
+    bool saved = false;
+    bool restored = false;
+    NimCloneStatistics saveStatistics;
+    qint64 diskOverhead = 0;     // free space consumed by the new snapshot
+    qint64 snapshotsBytes = 0;   // apparent size of all kept snapshots
+    int restoredTimestamps = 0;
+    QString error;
+};
+
+// Keeps a copy of the build directory per git branch. When HEAD moves, the
+// build directory is cloned into a snapshot for the branch being left, and
+// the snapshot of the branch being entered, if any, takes its place. Git
+// rewrites every file that differs between the branches, so the modification
+// times of unchanged content are restored from the manifest recorded after
+// the last successful build; otherwise Cargo would rebuild those crates.
+class NimBranchSnapshots : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NimBranchSnapshots(NimBuildConfiguration *buildConfiguration);
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    bool isBusy() const;
+
+    // Duration of the first build after a branch switch without a snapshot,
+    // i.e. what a snapshot saves
+    double switchRebuildSeconds() const;
+    void setSwitchRebuildSeconds(double seconds);
+
+    void buildStarted();
+    // Returns a report line for the build output, if any
+    QString buildFinished(bool success, double seconds);
+
+    Utils::FilePath snapshotsDirectory() const;
+
+signals:
+    void idle();
+
+private:
+    void updateWatcher();
+    void onHeadChanged();
+    void onSwitchFinished();
+    void onManifestWritten();
+    void startSwitch();
+    QString readHead() const;
+
+    NimBuildConfiguration *m_buildConfiguration;
+    bool m_enabled = false;
+    Utils::FilePath m_gitDirectory;
+    QString m_currentRef;
+    bool m_switchPending = false;
+
+    enum class LastSwitch { None, Restored, NotRestored };
+    LastSwitch m_lastSwitch = LastSwitch::None;
+    double m_switchRebuildSeconds = 0;
+
+    QFileSystemWatcher m_headWatcher;
+    QTimer m_debounceTimer;
+    QFutureWatcher<NimSnapshotSwitch> m_switchWatcher;
+    QFutureWatcher<void> m_manifestWatcher;
+};
+
+} // namespace Nim
@@ -27,6 +27,7 @@
 
 #include "nimbuildconfigurationwidget.h"
 #include "nimcompilerbuildstep.h"
+#include "nimprofilevariants.h"
 #include "nimproject.h"
 
 #include "../nimconstants.h"
@@ -49,6 +50,8 @@ using namespace Utils;
 
 namespace Nim {
 
+const int MAX_LINK_TIME_HISTORY = 1000;
+
 static FilePath defaultBuildDirectory(const Kit *k,
                                       const FilePath &projectFilePath,
                                       const QString &bc,
@@ -69,6 +72,9 @@ static FilePath defaultBuildDirectory(const Kit *k,
 
 NimBuildConfiguration::NimBuildConfiguration(Target *target, Core::Id id)
     : BuildConfiguration(target, id)
+    , m_profileVariants(NimProfileVariant::defaultVariants())
+    , m_branchSnapshots(new NimBranchSnapshots(this))
+    , m_ramTargetDirectory(new NimRamTargetDirectory(this))
 {
     setConfigWidgetDisplayName(tr("General"));
     setConfigWidgetHasFrame(true);
@@ -117,6 +123,20 @@ NimBuildConfiguration::NimBuildConfiguration(Target *target, Core::Id id)
             this, &NimBuildConfiguration::processParametersChanged);
     connect(this, &NimBuildConfiguration::nimBuildTypeChanged,
             this, &NimBuildConfiguration::processParametersChanged);
+    connect(this, &NimBuildConfiguration::resourceLimitsChanged,
+            this, &NimBuildConfiguration::processParametersChanged);
+    connect(this, &NimBuildConfiguration::sharedArtifactCacheChanged,
+            this, &NimBuildConfiguration::processParametersChanged);
+    connect(this, &NimBuildConfiguration::ramTargetDirectoryChanged,
+            this, &NimBuildConfiguration::processParametersChanged);
+    connect(this, &NimBuildConfiguration::linkerChanged,
+            this, &NimBuildConfiguration::processParametersChanged);
+    connect(this, &NimBuildConfiguration::releaseDebugInfoChanged,
+            this, &NimBuildConfiguration::processParametersChanged);
+    connect(m_branchSnapshots, &NimBranchSnapshots::idle,
+            this, &NimBuildConfiguration::targetDirectoryIdle);
+    connect(m_ramTargetDirectory, &NimRamTargetDirectory::idle,
+            this, &NimBuildConfiguration::targetDirectoryIdle);
 }
 
 
@@ -131,10 +151,35 @@ bool NimBuildConfiguration::fromMap(const QVariantMap &map)
     m_buildType = static_cast<NimBuildType>(map[Constants::C_NIMCOMPILERBUILDSTEP_BUILDTYPE].toInt());
     m_targetNimFile = FilePath::fromString(map[Constants::C_NIMCOMPILERBUILDSTEP_TARGETNIMFILE].toString());
 
+    m_crateMemoryPeaks.clear();
+    const QVariantMap peaks = map[Constants::C_NIMBUILDCONFIGURATION_CRATEMEMORYPEAKS].toMap();
+    for (auto it = peaks.cbegin(); it != peaks.cend(); ++it)
+        m_crateMemoryPeaks.insert(it.key(), it.value().toLongLong());
+    m_resourceLimits.fromMap(map[Constants::C_NIMBUILDCONFIGURATION_RESOURCELIMITS].toMap());
+    m_sharedArtifactCache = map[Constants::C_NIMBUILDCONFIGURATION_SHAREDARTIFACTCACHE].toBool();
+    m_profileVariants = map.value(Constants::C_NIMBUILDCONFIGURATION_PROFILEVARIANTS,
+                                  NimProfileVariant::defaultVariants()).toString();
+    m_profileVariantWorkload = map[Constants::C_NIMBUILDCONFIGURATION_PROFILEVARIANTWORKLOAD].toInt();
+    m_releaseDebugInfo = map[Constants::C_NIMBUILDCONFIGURATION_RELEASEDEBUGINFO].toBool();
+    m_linker = static_cast<NimLinker>(map[Constants::C_NIMBUILDCONFIGURATION_LINKER].toInt());
+    m_measureLinkTime = map[Constants::C_NIMBUILDCONFIGURATION_MEASURELINKTIME].toBool();
+    m_linkTimeHistory.clear();
+    for (const QVariant &link : map[Constants::C_NIMBUILDCONFIGURATION_LINKTIMES].toList())
+        m_linkTimeHistory.append(NimLinkTime::fromMap(link.toMap()));
+    m_branchSnapshots->setSwitchRebuildSeconds(map[Constants::C_NIMBUILDCONFIGURATION_SWITCHREBUILDSECONDS].toDouble());
+
     if (!ProjectExplorer::ProjectConfiguration::fromMap(map))
         return false;
 
-    return ProjectExplorer::BuildConfiguration::fromMap(map);
+    if (!ProjectExplorer::BuildConfiguration::fromMap(map))
+        return false;
+
+    // Needs the build directory
+    m_ramTargetDirectory->setSizeLimitMiB(map.value(Constants::C_NIMBUILDCONFIGURATION_RAMTARGETDIRECTORYLIMIT,
+                                                    m_ramTargetDirectory->sizeLimitMiB()).toInt());
+    m_ramTargetDirectory->setEnabled(map[Constants::C_NIMBUILDCONFIGURATION_RAMTARGETDIRECTORY].toBool());
+    m_branchSnapshots->setEnabled(map[Constants::C_NIMBUILDCONFIGURATION_BRANCHSNAPSHOTS].toBool());
+    return true;
 }
 
 QVariantMap NimBuildConfiguration::toMap() const
@@ -142,6 +187,26 @@ QVariantMap NimBuildConfiguration::toMap() const
     QVariantMap result = BuildConfiguration::toMap();
     result[Constants::C_NIMCOMPILERBUILDSTEP_BUILDTYPE] = m_buildType;
     result[Constants::C_NIMCOMPILERBUILDSTEP_TARGETNIMFILE] = m_targetNimFile.toString();
+
+    QVariantMap peaks;
+    for (auto it = m_crateMemoryPeaks.cbegin(); it != m_crateMemoryPeaks.cend(); ++it)
+        peaks.insert(it.key(), it.value());
+    result[Constants::C_NIMBUILDCONFIGURATION_CRATEMEMORYPEAKS] = peaks;
+    result[Constants::C_NIMBUILDCONFIGURATION_RESOURCELIMITS] = m_resourceLimits.toMap();
+    result[Constants::C_NIMBUILDCONFIGURATION_SHAREDARTIFACTCACHE] = m_sharedArtifactCache;
+    result[Constants::C_NIMBUILDCONFIGURATION_BRANCHSNAPSHOTS] = m_branchSnapshots->isEnabled();
+    result[Constants::C_NIMBUILDCONFIGURATION_SWITCHREBUILDSECONDS] = m_branchSnapshots->switchRebuildSeconds();
+    result[Constants::C_NIMBUILDCONFIGURATION_RAMTARGETDIRECTORY] = m_ramTargetDirectory->isEnabled();
+    result[Constants::C_NIMBUILDCONFIGURATION_RAMTARGETDIRECTORYLIMIT] = m_ramTargetDirectory->sizeLimitMiB();
+    result[Constants::C_NIMBUILDCONFIGURATION_PROFILEVARIANTS] = m_profileVariants;
+    result[Constants::C_NIMBUILDCONFIGURATION_PROFILEVARIANTWORKLOAD] = m_profileVariantWorkload;
+    result[Constants::C_NIMBUILDCONFIGURATION_RELEASEDEBUGINFO] = m_releaseDebugInfo;
+    result[Constants::C_NIMBUILDCONFIGURATION_LINKER] = m_linker;
+    result[Constants::C_NIMBUILDCONFIGURATION_MEASURELINKTIME] = m_measureLinkTime;
+    QVariantList linkTimes;
+    for (const NimLinkTime &link : m_linkTimeHistory)
+        linkTimes.append(link.toMap());
+    result[Constants::C_NIMBUILDCONFIGURATION_LINKTIMES] = linkTimes;
     return result;
 }
 
@@ -181,7 +246,221 @@ FilePath NimBuildConfiguration::outFilePath() const
     const NimCompilerBuildStep *step = nimCompilerBuildStep();
     QTC_ASSERT(step, return FilePath());
     const QString targetName = Utils::HostOsInfo::withExecutableSuffix(m_targetNimFile.toFileInfo().baseName());
-    return buildDirectory().pathAppended(targetName);
+    return effectiveTargetDirectory().pathAppended(targetName);
+}
+
+QMap<QString, qint64> NimBuildConfiguration::crateMemoryPeaks() const
+{
+    return m_crateMemoryPeaks;
+}
+
+void NimBuildConfiguration::mergeCrateMemoryPeaks(const QMap<QString, qint64> &peaks)
+{
+    for (auto it = peaks.cbegin(); it != peaks.cend(); ++it)
+        m_crateMemoryPeaks[it.key()] = qMax(m_crateMemoryPeaks.value(it.key()), it.value());
+}
+
+NimResourceLimits NimBuildConfiguration::resourceLimits() const
+{
+    return m_resourceLimits;
+}
+
+void NimBuildConfiguration::setResourceLimits(const NimResourceLimits &limits)
+{
+    if (m_resourceLimits == limits)
+        return;
+    m_resourceLimits = limits;
+    emit resourceLimitsChanged();
+}
+
+bool NimBuildConfiguration::sharedArtifactCache() const
+{
+    return m_sharedArtifactCache;
+}
+
+void NimBuildConfiguration::setSharedArtifactCache(bool enabled)
+{
+    if (m_sharedArtifactCache == enabled)
+        return;
+    m_sharedArtifactCache = enabled;
+    emit sharedArtifactCacheChanged(enabled);
+}
+
+bool NimBuildConfiguration::branchSnapshotsEnabled() const
+{
+    return m_branchSnapshots->isEnabled();
+}
+
+void NimBuildConfiguration::setBranchSnapshotsEnabled(bool enabled)
+{
+    if (m_branchSnapshots->isEnabled() == enabled)
+        return;
+    m_branchSnapshots->setEnabled(enabled);
+    emit branchSnapshotsEnabledChanged(enabled);
+}
+
+NimBranchSnapshots *NimBuildConfiguration::branchSnapshots()
+{
+    return m_branchSnapshots;
+}
+
+bool NimBuildConfiguration::ramTargetDirectoryEnabled() const
+{
+    return m_ramTargetDirectory->isEnabled();
+}
+
+void NimBuildConfiguration::setRamTargetDirectoryEnabled(bool enabled)
+{
+    if (m_ramTargetDirectory->isEnabled() == enabled)
+        return;
+    m_ramTargetDirectory->setEnabled(enabled);
+    emit ramTargetDirectoryChanged();
+}
+
+int NimBuildConfiguration::ramTargetDirectoryLimitMiB() const
+{
+    return m_ramTargetDirectory->sizeLimitMiB();
+}
+
+void NimBuildConfiguration::setRamTargetDirectoryLimitMiB(int limitMiB)
+{
+    if (m_ramTargetDirectory->sizeLimitMiB() == limitMiB)
+        return;
+    m_ramTargetDirectory->setSizeLimitMiB(limitMiB);
+    emit ramTargetDirectoryChanged();
+}
+
+NimRamTargetDirectory *NimBuildConfiguration::ramTargetDirectory()
+{
+    return m_ramTargetDirectory;
+}
+
+QString NimBuildConfiguration::profileVariants() const
+{
+    return m_profileVariants;
+}
+
+void NimBuildConfiguration::setProfileVariants(const QString &profileVariants)
+{
+    if (m_profileVariants == profileVariants)
+        return;
+    m_profileVariants = profileVariants;
+    emit profileVariantsChanged();
+}
+
+int NimBuildConfiguration::profileVariantWorkload() const
+{
+    return m_profileVariantWorkload;
+}
+
+void NimBuildConfiguration::setProfileVariantWorkload(int workload)
+{
+    if (m_profileVariantWorkload == workload)
+        return;
+    m_profileVariantWorkload = workload;
+    emit profileVariantsChanged();
+}
+
+bool NimBuildConfiguration::releaseDebugInfo() const
+{
+    return m_releaseDebugInfo;
+}
+
+void NimBuildConfiguration::setReleaseDebugInfo(bool enabled)
+{
+    if (m_releaseDebugInfo == enabled)
+        return;
+    m_releaseDebugInfo = enabled;
+    emit releaseDebugInfoChanged(enabled);
+}
+
+NimBuildConfiguration::NimLinker NimBuildConfiguration::linker() const
+{
+    return m_linker;
+}
+
+void NimBuildConfiguration::setLinker(NimLinker linker)
+{
+    if (m_linker == linker)
+        return;
+    m_linker = linker;
+    emit linkerChanged();
+}
+
+QString NimBuildConfiguration::linkerName() const
+{
+    switch (m_linker) {
+    case LldLinker:
+        return QString("lld");
+    case MoldLinker:
+        return QString("mold");
+    default:
+        return QString("ld");
+    }
+}
+
+QString NimBuildConfiguration::linkerExecutable() const
+{
+    switch (m_linker) {
+    case LldLinker:
+        return QString("ld.lld");
+    case MoldLinker:
+        return QString("mold");
+    default:
+        return QString();
+    }
+}
+
+QString NimBuildConfiguration::linkerRustFlags() const
+{
+    // Selected through the C compiler driver rustc links with
+    return m_linker == DefaultLinker ? QString() : "-C link-arg=-fuse-ld=" + linkerName();
+}
+
+bool NimBuildConfiguration::measureLinkTime() const
+{
+    return m_measureLinkTime;
+}
+
+void NimBuildConfiguration::setMeasureLinkTime(bool measure)
+{
+    if (m_measureLinkTime == measure)
+        return;
+    m_measureLinkTime = measure;
+    emit linkerChanged();
+}
+
+QList<NimLinkTime> NimBuildConfiguration::linkTimeHistory() const
+{
+    return m_linkTimeHistory;
+}
+
+void NimBuildConfiguration::addLinkTimes(const QList<NimLinkTime> &links)
+{
+    m_linkTimeHistory.append(links);
+    if (m_linkTimeHistory.size() > MAX_LINK_TIME_HISTORY)
+        m_linkTimeHistory.erase(m_linkTimeHistory.begin(), m_linkTimeHistory.end() - MAX_LINK_TIME_HISTORY);
+}
+
+FilePath NimBuildConfiguration::effectiveTargetDirectory() const
+{
+    if (m_ramTargetDirectory->isActive())
+        return m_ramTargetDirectory->directory();
+    return buildDirectory();
+}
+
+bool NimBuildConfiguration::isTargetDirectoryBusy() const
+{
+    return m_targetDirectoryPruning || m_branchSnapshots->isBusy() || m_ramTargetDirectory->isBusy();
+}
+
+void NimBuildConfiguration::setTargetDirectoryPruning(bool pruning)
+{
+    if (m_targetDirectoryPruning == pruning)
+        return;
+    m_targetDirectoryPruning = pruning;
+    if (!isTargetDirectoryBusy())
+        emit targetDirectoryIdle();
 }
 
 void NimBuildConfiguration::updateTargetNimFile()
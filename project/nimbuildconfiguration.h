@@ -25,6 +25,11 @@
 
 #pragma once
 
+#include "nimbranchsnapshots.h"
+#include "nimcgroupscope.h"
+#include "nimlinktimes.h"
+#include "nimramtargetdirectory.h"
+
 #include <projectexplorer/buildconfiguration.h>
 #include <projectexplorer/target.h>
 
@@ -47,6 +52,7 @@ class NimBuildConfiguration : public ProjectExplorer::BuildConfiguration
 
 public:
     enum NimBuildType { Default = 0, Debug, Release};
+    enum NimLinker { DefaultLinker = 0, LldLinker, MoldLinker };
 
     NimBuildType nimBuildType() const;
     void setNimBuildType(NimBuildType buildType);
@@ -56,19 +62,87 @@ public:
 
     Utils::FilePath outFilePath() const;
 
+    const NimCompilerBuildStep *nimCompilerBuildStep() const;
+    NimCompilerBuildStep *nimCompilerBuildStep();
+
+    QMap<QString, qint64> crateMemoryPeaks() const;
+    void mergeCrateMemoryPeaks(const QMap<QString, qint64> &peaks);
+
+    NimResourceLimits resourceLimits() const;
+    void setResourceLimits(const NimResourceLimits &limits);
+
+    bool sharedArtifactCache() const;
+    void setSharedArtifactCache(bool enabled);
+
+    bool branchSnapshotsEnabled() const;
+    void setBranchSnapshotsEnabled(bool enabled);
+    NimBranchSnapshots *branchSnapshots();
+
+    bool ramTargetDirectoryEnabled() const;
+    void setRamTargetDirectoryEnabled(bool enabled);
+    int ramTargetDirectoryLimitMiB() const;
+    void setRamTargetDirectoryLimitMiB(int limitMiB);
+    NimRamTargetDirectory *ramTargetDirectory();
+
+    // One variant per line, see NimProfileVariant
+    QString profileVariants() const;
+    void setProfileVariants(const QString &profileVariants);
+    int profileVariantWorkload() const;
+    void setProfileVariantWorkload(int workload);
+
+    // Line tables for profilers in Release builds, which Cargo builds without debug information
+    bool releaseDebugInfo() const;
+    void setReleaseDebugInfo(bool enabled);
+
+    NimLinker linker() const;
+    void setLinker(NimLinker linker);
+    QString linkerName() const;
+    // The executable the linker option needs, empty for the default linker
+    QString linkerExecutable() const;
+    QString linkerRustFlags() const;
+
+    bool measureLinkTime() const;
+    void setMeasureLinkTime(bool measure);
+    QList<NimLinkTime> linkTimeHistory() const;
+    void addLinkTimes(const QList<NimLinkTime> &links);
+
+    // Where Cargo puts its output, the build directory unless it lives in RAM
+    Utils::FilePath effectiveTargetDirectory() const;
+    // Whether the target directory is being copied or pruned, builds wait for targetDirectoryIdle()
+    bool isTargetDirectoryBusy() const;
+    void setTargetDirectoryPruning(bool pruning);
+
 signals:
     void nimBuildTypeChanged(NimBuildType options);
     void targetNimFileChanged(const Utils::FilePath &targetNimFile);
+    void resourceLimitsChanged();
+    void sharedArtifactCacheChanged(bool enabled);
+    void branchSnapshotsEnabledChanged(bool enabled);
+    void ramTargetDirectoryChanged();
+    void profileVariantsChanged();
+    void linkerChanged();
+    void releaseDebugInfoChanged(bool enabled);
+    void targetDirectoryIdle();
     void processParametersChanged();
 
 private:
     void updateTargetNimFile();
-    const NimCompilerBuildStep *nimCompilerBuildStep() const;
-    NimCompilerBuildStep *nimCompilerBuildStep();
     NimCompilerBuildStep *nimCompilerCleanStep();
 
     NimBuildType m_buildType;
     Utils::FilePath m_targetNimFile;
+    QMap<QString, qint64> m_crateMemoryPeaks;
+    NimResourceLimits m_resourceLimits;
+    bool m_sharedArtifactCache = false;
+    QString m_profileVariants;
+    int m_profileVariantWorkload = 0;
+    bool m_releaseDebugInfo = false;
+    NimLinker m_linker = DefaultLinker;
+    bool m_measureLinkTime = false;
+    QList<NimLinkTime> m_linkTimeHistory;
+    NimBranchSnapshots *m_branchSnapshots;
+    NimRamTargetDirectory *m_ramTargetDirectory;
+    bool m_targetDirectoryPruning = false;
 };
 
 
@@ -58,12 +58,51 @@ NimBuildConfigurationWidget::NimBuildConfigurationWidget(NimBuildConfiguration *
     // Connect build step signals
     connect(m_buildConfiguration, &NimBuildConfiguration::processParametersChanged,
             this, &NimBuildConfigurationWidget::updateUi);
+    connect(m_buildConfiguration, &NimBuildConfiguration::profileVariantsChanged,
+            this, &NimBuildConfigurationWidget::updateProfileVariants);
 
     // Connect UI signals
     connect(m_ui->targetComboBox, QOverload<int>::of(&QComboBox::activated),
             this, &NimBuildConfigurationWidget::onTargetChanged);
     connect(m_ui->defaultArgumentsComboBox, QOverload<int>::of(&QComboBox::activated),
             this, &NimBuildConfigurationWidget::onDefaultArgumentsComboBoxIndexChanged);
+    connect(m_ui->sharedArtifactCacheCheckBox, &QCheckBox::clicked,
+            m_buildConfiguration, &NimBuildConfiguration::setSharedArtifactCache);
+    connect(m_ui->branchSnapshotsCheckBox, &QCheckBox::clicked,
+            m_buildConfiguration, &NimBuildConfiguration::setBranchSnapshotsEnabled);
+    connect(m_ui->ramTargetDirectoryCheckBox, &QCheckBox::clicked,
+            m_buildConfiguration, &NimBuildConfiguration::setRamTargetDirectoryEnabled);
+    connect(m_ui->ramLimitSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            m_buildConfiguration, &NimBuildConfiguration::setRamTargetDirectoryLimitMiB);
+    connect(m_ui->profileVariantsTextEdit, &QPlainTextEdit::textChanged, this, [this] {
+        m_buildConfiguration->setProfileVariants(m_ui->profileVariantsTextEdit->toPlainText());
+    });
+    connect(m_ui->profileVariantWorkloadComboBox, QOverload<int>::of(&QComboBox::activated),
+            m_buildConfiguration, &NimBuildConfiguration::setProfileVariantWorkload);
+    connect(m_ui->releaseDebugInfoCheckBox, &QCheckBox::clicked,
+            m_buildConfiguration, &NimBuildConfiguration::setReleaseDebugInfo);
+    connect(m_ui->linkerComboBox, QOverload<int>::of(&QComboBox::activated), this, [this](int index) {
+        m_buildConfiguration->setLinker(static_cast<NimBuildConfiguration::NimLinker>(index));
+    });
+    connect(m_ui->measureLinkTimeCheckBox, &QCheckBox::clicked,
+            m_buildConfiguration, &NimBuildConfiguration::setMeasureLinkTime);
+    connect(m_ui->isolationCheckBox, &QCheckBox::clicked,
+            this, &NimBuildConfigurationWidget::onResourceLimitsEdited);
+    connect(m_ui->cpuWeightSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &NimBuildConfigurationWidget::onResourceLimitsEdited);
+    connect(m_ui->ioWeightSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, &NimBuildConfigurationWidget::onResourceLimitsEdited);
+    connect(m_ui->memoryHighLineEdit, &QLineEdit::textEdited,
+            this, &NimBuildConfigurationWidget::onResourceLimitsEdited);
+
+    if (!NimCgroupScope::isAvailable()) {
+        m_ui->isolationCheckBox->setEnabled(false);
+        m_ui->isolationCheckBox->setToolTip(tr("Requires cgroup v2 and systemd-run."));
+    }
+    if (!NimRamTargetDirectory::isAvailable()) {
+        m_ui->ramTargetDirectoryCheckBox->setEnabled(false);
+        m_ui->ramTargetDirectoryCheckBox->setToolTip(tr("Requires /dev/shm or $XDG_RUNTIME_DIR on tmpfs."));
+    }
 
     updateUi();
 }
@@ -84,10 +123,27 @@ void NimBuildConfigurationWidget::onDefaultArgumentsComboBoxIndexChanged(int ind
     m_buildConfiguration->setNimBuildType(options);
 }
 
+void NimBuildConfigurationWidget::onResourceLimitsEdited()
+{
+    NimResourceLimits limits;
+    limits.enabled = m_ui->isolationCheckBox->isChecked();
+    limits.cpuWeight = m_ui->cpuWeightSpinBox->value();
+    limits.ioWeight = m_ui->ioWeightSpinBox->value();
+    limits.memoryHigh = m_ui->memoryHighLineEdit->text().trimmed();
+    m_buildConfiguration->setResourceLimits(limits);
+}
+
 void NimBuildConfigurationWidget::updateUi()
 {
     updateTargetComboBox();
     updateDefaultArgumentsComboBox();
+    updateResourceLimits();
+    updateSharedArtifactCacheCheckBox();
+    updateBranchSnapshotsCheckBox();
+    updateRamTargetDirectory();
+    updateProfileVariants();
+    updateLinker();
+    updateReleaseDebugInfoCheckBox();
 }
 
 void NimBuildConfigurationWidget::updateTargetComboBox()
@@ -116,5 +172,66 @@ void NimBuildConfigurationWidget::updateDefaultArgumentsComboBox()
     m_ui->defaultArgumentsComboBox->setCurrentIndex(index);
 }
 
+void NimBuildConfigurationWidget::updateSharedArtifactCacheCheckBox()
+{
+    QTC_ASSERT(m_buildConfiguration, return);
+    m_ui->sharedArtifactCacheCheckBox->setChecked(m_buildConfiguration->sharedArtifactCache());
+}
+
+void NimBuildConfigurationWidget::updateBranchSnapshotsCheckBox()
+{
+    QTC_ASSERT(m_buildConfiguration, return);
+    m_ui->branchSnapshotsCheckBox->setChecked(m_buildConfiguration->branchSnapshotsEnabled());
+}
+
+void NimBuildConfigurationWidget::updateRamTargetDirectory()
+{
+    QTC_ASSERT(m_buildConfiguration, return);
+    const QSignalBlocker blocker(m_ui->ramLimitSpinBox);
+    m_ui->ramTargetDirectoryCheckBox->setChecked(m_buildConfiguration->ramTargetDirectoryEnabled());
+    m_ui->ramLimitSpinBox->setValue(m_buildConfiguration->ramTargetDirectoryLimitMiB());
+    m_ui->ramLimitSpinBox->setEnabled(m_buildConfiguration->ramTargetDirectoryEnabled());
+}
+
+void NimBuildConfigurationWidget::updateProfileVariants()
+{
+    QTC_ASSERT(m_buildConfiguration, return);
+    if (m_ui->profileVariantsTextEdit->toPlainText() != m_buildConfiguration->profileVariants())
+        m_ui->profileVariantsTextEdit->setPlainText(m_buildConfiguration->profileVariants());
+    m_ui->profileVariantWorkloadComboBox->setCurrentIndex(m_buildConfiguration->profileVariantWorkload());
+}
+
+void NimBuildConfigurationWidget::updateLinker()
+{
+    QTC_ASSERT(m_buildConfiguration, return);
+    m_ui->linkerComboBox->setCurrentIndex(m_buildConfiguration->linker());
+    m_ui->measureLinkTimeCheckBox->setChecked(m_buildConfiguration->measureLinkTime());
+}
+
+void NimBuildConfigurationWidget::updateReleaseDebugInfoCheckBox()
+{
+    QTC_ASSERT(m_buildConfiguration, return);
+    m_ui->releaseDebugInfoCheckBox->setChecked(m_buildConfiguration->releaseDebugInfo());
+    m_ui->releaseDebugInfoCheckBox->setEnabled(m_buildConfiguration->nimBuildType()
+                                               == NimBuildConfiguration::Release);
+}
+
+void NimBuildConfigurationWidget::updateResourceLimits()
+{
+    QTC_ASSERT(m_buildConfiguration, return);
+
+    const NimResourceLimits limits = m_buildConfiguration->resourceLimits();
+    const QSignalBlocker cpuBlocker(m_ui->cpuWeightSpinBox);
+    const QSignalBlocker ioBlocker(m_ui->ioWeightSpinBox);
+    m_ui->isolationCheckBox->setChecked(limits.enabled);
+    m_ui->cpuWeightSpinBox->setValue(limits.cpuWeight);
+    m_ui->ioWeightSpinBox->setValue(limits.ioWeight);
+    if (m_ui->memoryHighLineEdit->text().trimmed() != limits.memoryHigh)
+        m_ui->memoryHighLineEdit->setText(limits.memoryHigh);
+    m_ui->cpuWeightSpinBox->setEnabled(limits.enabled);
+    m_ui->ioWeightSpinBox->setEnabled(limits.enabled);
+    m_ui->memoryHighLineEdit->setEnabled(limits.enabled);
+}
+
 }
 
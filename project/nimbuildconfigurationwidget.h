@@ -48,9 +48,17 @@ private:
     void updateUi();
     void updateTargetComboBox();
     void updateDefaultArgumentsComboBox();
+    void updateResourceLimits();
+    void updateSharedArtifactCacheCheckBox();
+    void updateBranchSnapshotsCheckBox();
+    void updateRamTargetDirectory();
+    void updateProfileVariants();
+    void updateLinker();
+    void updateReleaseDebugInfoCheckBox();
 
     void onTargetChanged(int index);
     void onDefaultArgumentsComboBoxIndexChanged(int index);
+    void onResourceLimitsEdited();
 
     NimBuildConfiguration *m_buildConfiguration;
     QScopedPointer<Ui::NimBuildConfigurationWidget> m_ui;
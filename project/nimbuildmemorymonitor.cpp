@@ -0,0 +1,283 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "nimbuildmemorymonitor.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+
+#include <algorithm>
+#include <functional>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+namespace Nim {
+
+const int SAMPLE_INTERVAL_MS = 500;
+
+struct ProcessInfo
+{
+    qint64 parentPid = 0;
+    qint64 startTime = 0;
+    qint64 residentMemory = 0;
+    QByteArray name;
+};
+
+static qint64 pageSize()
+{
+#ifdef Q_OS_UNIX
+    static const qint64 size = sysconf(_SC_PAGESIZE);
+    return size;
+#else
+    return 4096;
+#endif
+}
+
+static bool readProcessInfo(qint64 pid, ProcessInfo *info)
+{
+    QFile file(QString("/proc/%1/stat").arg(pid));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    const QByteArray stat = file.readAll();
+
+    // The command name is enclosed in parentheses and may itself contain spaces
+    const int nameBegin = stat.indexOf('(');
+    const int nameEnd = stat.lastIndexOf(')');
+    if (nameBegin < 0 || nameEnd < nameBegin)
+        return false;
+
+    // Fields after the command name: state(3) ppid(4) ... starttime(22) vsize(23) rss(24)
+    const QList<QByteArray> fields = stat.mid(nameEnd + 2).split(' ');
+    if (fields.size() < 22)
+        return false;
+
+    info->name = stat.mid(nameBegin + 1, nameEnd - nameBegin - 1);
+    info->parentPid = fields.at(1).toLongLong();
+    info->startTime = fields.at(19).toLongLong();
+    info->residentMemory = fields.at(21).toLongLong() * pageSize();
+    return true;
+}
+
+static QString crateNameOf(qint64 pid)
+{
+    QFile file(QString("/proc/%1/cmdline").arg(pid));
+    if (!file.open(QIODevice::ReadOnly))
+        return QString();
+    const QList<QByteArray> args = file.readAll().split('\0');
+    const int index = args.indexOf("--crate-name");
+    if (index < 0 || index + 1 >= args.size())
+        return QString();
+    return QString::fromLocal8Bit(args.at(index + 1));
+}
+
+NimBuildMemoryMonitor::NimBuildMemoryMonitor(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setInterval(SAMPLE_INTERVAL_MS);
+    connect(&m_timer, &QTimer::timeout, this, &NimBuildMemoryMonitor::sample);
+}
+
+void NimBuildMemoryMonitor::start(const QString &program)
+{
+    // The kernel truncates command names to 15 characters
+    m_program = QFileInfo(program).fileName().toLocal8Bit().left(15);
+    m_rootPid = 0;
+    m_peakTotalMemory = 0;
+    m_minAvailableMemory = availableMemory();
+    m_crateMemoryPeaks.clear();
+    m_timer.start();
+}
+
+void NimBuildMemoryMonitor::stop()
+{
+    m_timer.stop();
+}
+
+qint64 NimBuildMemoryMonitor::peakTotalMemory() const
+{
+    return m_peakTotalMemory;
+}
+
+qint64 NimBuildMemoryMonitor::minAvailableMemory() const
+{
+    return m_minAvailableMemory;
+}
+
+QMap<QString, qint64> NimBuildMemoryMonitor::crateMemoryPeaks() const
+{
+    return m_crateMemoryPeaks;
+}
+
+qint64 NimBuildMemoryMonitor::availableMemory()
+{
+    QFile file("/proc/meminfo");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return 0;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        if (line.startsWith("MemAvailable:"))
+            return line.mid(13).trimmed().split(' ').first().toLongLong() * 1024;
+    }
+    return 0;
+}
+
+int NimBuildMemoryMonitor::recommendedJobs(const QMap<QString, qint64> &crateMemoryPeaks,
+                                           qint64 availableMemory,
+                                           int maxJobs,
+                                           QString *limitingCrate)
+{
+    if (crateMemoryPeaks.isEmpty() || availableMemory <= 0)
+        return maxJobs;
+
+    // Assume the worst case: the heaviest crates end up being compiled or
+    // linked at the same time. Keep some headroom for the IDE itself.
+    QList<QPair<qint64, QString>> peaks;
+    for (auto it = crateMemoryPeaks.cbegin(); it != crateMemoryPeaks.cend(); ++it)
+        peaks.append({it.value(), it.key()});
+    std::sort(peaks.begin(), peaks.end(), std::greater<QPair<qint64, QString>>());
+
+    const qint64 budget = availableMemory * 9 / 10;
+    qint64 used = 0;
+    int jobs = 0;
+    for (const QPair<qint64, QString> &peak : qAsConst(peaks)) {
+        if (jobs >= maxJobs)
+            break;
+        if (used + peak.first > budget) {
+            if (limitingCrate)
+                *limitingCrate = peak.second;
+            break;
+        }
+        used += peak.first;
+        ++jobs;
+    }
+    if (jobs == peaks.size() && jobs < maxJobs)
+        return maxJobs;
+    return qBound(1, jobs, maxJobs);
+}
+
+void NimBuildMemoryMonitor::sample()
+{
+    const qint64 available = availableMemory();
+    if (available > 0)
+        m_minAvailableMemory = m_minAvailableMemory > 0 ? qMin(m_minAvailableMemory, available)
+                                                        : available;
+
+    QHash<qint64, ProcessInfo> processes;
+    QMultiHash<qint64, qint64> children;
+    const QStringList entries = QDir("/proc").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &entry : entries) {
+        bool ok = false;
+        const qint64 pid = entry.toLongLong(&ok);
+        ProcessInfo info;
+        if (!ok || !readProcessInfo(pid, &info))
+            continue;
+        processes.insert(pid, info);
+        children.insert(info.parentPid, pid);
+    }
+
+    // The IDE also runs language servers, tests and benchmarks, only the
+    // build's process tree counts. A command executing cargo, like
+    // systemd-run, keeps its pid.
+    if (!processes.contains(m_rootPid)) {
+        m_rootPid = 0;
+        qint64 newest = -1;
+        for (qint64 child : children.values(QCoreApplication::applicationPid())) {
+            const ProcessInfo &info = processes[child];
+            if ((info.name == m_program || info.name == "cargo") && info.startTime > newest) {
+                m_rootPid = child;
+                newest = info.startTime;
+            }
+        }
+        if (!m_rootPid)
+            return;
+    }
+
+    // Everything spawned by a rustc process (linkers, LTO workers) is
+    // charged to that rustc's crate
+    QMap<QString, qint64> crateMemory;
+    qint64 totalMemory = 0;
+    QList<QPair<qint64, QString>> queue = {{m_rootPid, QString()}};
+    while (!queue.isEmpty()) {
+        const QPair<qint64, QString> current = queue.takeFirst();
+        const ProcessInfo info = processes.value(current.first);
+        QString crate = current.second;
+        if (crate.isEmpty() && info.name == "rustc")
+            crate = crateNameOf(current.first);
+
+        totalMemory += info.residentMemory;
+        if (!crate.isEmpty())
+            crateMemory[crate] += info.residentMemory;
+
+        for (qint64 child : children.values(current.first))
+            queue.append({child, crate});
+    }
+
+    m_peakTotalMemory = qMax(m_peakTotalMemory, totalMemory);
+    for (auto it = crateMemory.cbegin(); it != crateMemory.cend(); ++it)
+        m_crateMemoryPeaks[it.key()] = qMax(m_crateMemoryPeaks.value(it.key()), it.value());
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QTest>
+
+namespace Nim {
+
+void RustPlugin::testRecommendedJobs()
+{
+    const qint64 gib = Q_INT64_C(1) << 30;
+    const QMap<QString, qint64> peaks = {{"a", 4 * gib}, {"b", 3 * gib}, {"c", gib}};
+    QString limitingCrate;
+
+    // Nothing recorded yet
+    QCOMPARE(NimBuildMemoryMonitor::recommendedJobs({}, 8 * gib, 8), 8);
+    QCOMPARE(NimBuildMemoryMonitor::recommendedJobs(peaks, 0, 8), 8);
+
+    // All crates fit at once
+    QCOMPARE(NimBuildMemoryMonitor::recommendedJobs(peaks, 10 * gib, 8, &limitingCrate), 8);
+    QVERIFY(limitingCrate.isEmpty());
+    QCOMPARE(NimBuildMemoryMonitor::recommendedJobs(peaks, 10 * gib, 2), 2);
+
+    // The two heaviest fit into 90% of 8 GiB, the third does not
+    QCOMPARE(NimBuildMemoryMonitor::recommendedJobs(peaks, 8 * gib, 8, &limitingCrate), 2);
+    QCOMPARE(limitingCrate, QString("c"));
+
+    // At least one job, even if the heaviest crate does not fit
+    QCOMPARE(NimBuildMemoryMonitor::recommendedJobs(peaks, 3 * gib, 8, &limitingCrate), 1);
+    QCOMPARE(limitingCrate, QString("a"));
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
@@ -0,0 +1,70 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QMap>
+#include <QObject>
+#include <QTimer>
+
+namespace Nim {
+
+// Samples /proc while a build runs and keeps track of the peak resident
+// memory of every rustc process of the build (including the linker it
+// spawns), keyed by the crate it compiles.
+class NimBuildMemoryMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NimBuildMemoryMonitor(QObject *parent = nullptr);
+
+    // Samples the processes below the IDE's newest child running program,
+    // which is the build's cargo or the command executing it
+    void start(const QString &program);
+    void stop();
+
+    qint64 peakTotalMemory() const;
+    qint64 minAvailableMemory() const;
+    QMap<QString, qint64> crateMemoryPeaks() const;
+
+    static qint64 availableMemory();
+    static int recommendedJobs(const QMap<QString, qint64> &crateMemoryPeaks,
+                               qint64 availableMemory,
+                               int maxJobs,
+                               QString *limitingCrate = nullptr);
+
+private:
+    void sample();
+
+    QTimer m_timer;
+    QByteArray m_program;
+    qint64 m_rootPid = 0;
+    qint64 m_peakTotalMemory = 0;
+    qint64 m_minAvailableMemory = 0;
+    QMap<QString, qint64> m_crateMemoryPeaks;
+};
+
+} // namespace Nim
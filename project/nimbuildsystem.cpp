@@ -25,6 +25,7 @@
 
 #include "nimbuildsystem.h"
 
+#include "nimbuildconfiguration.h"
 #include "nimproject.h"
 #include "nimprojectnode.h"
 
@@ -54,6 +55,7 @@ const char EXCLUDED_FILES_KEY[] = "ExcludedFiles";
 
 NimProjectScanner::NimProjectScanner(Project *project)
     : m_project(project)
+    , m_scannerScope(NimCgroupScope::uniqueUnitName("metadata", this))
 {
     connect(&m_directoryWatcher, &FileSystemWatcher::directoryChanged,
             this, &NimProjectScanner::directoryChanged);
@@ -75,6 +77,29 @@ NimProjectScanner::NimProjectScanner(Project *project)
         projectNode->setDisplayName(m_project->displayName());
         projectNode->setIcon(QIcon(":/rust/images/ferris.png"));
 
+        // Without dependencies, metadata only lists the workspace members
+        QStringList members;
+        QStringList targets;
+        m_benchTargets.clear();
+        for (const QJsonValue &package : doc["packages"].toArray()) {
+            members << package["name"].toString();
+            for (const QJsonValue &target : package["targets"].toArray()) {
+                targets << target["name"].toString();
+                if (!target["kind"].toArray().contains("bench"))
+                    continue;
+                BuildTargetInfo benchTarget;
+                benchTarget.buildKey = package["name"].toString() + '/' + target["name"].toString();
+                benchTarget.displayName = target["name"].toString();
+                benchTarget.displayNameUniquifier = QString(" (%1)").arg(package["name"].toString());
+                benchTarget.projectFilePath = FilePath::fromString(package["manifest_path"].toString());
+                benchTarget.workingDirectory = benchTarget.projectFilePath.parentDir();
+                benchTarget.additionalData = target["name"].toString();
+                m_benchTargets << benchTarget;
+            }
+        }
+        static_cast<NimProject *>(m_project)->setWorkspaceMembers(members);
+        static_cast<NimProject *>(m_project)->setWorkspaceTargets(targets);
+
         // Collect scanned nodes
         for (const QJsonValue &package : doc["packages"].toArray()) {
             auto subProjectNode = std::make_unique<ProjectNode>(FilePath::fromString(package["manifest_path"].toString()));
@@ -138,14 +163,18 @@ void NimProjectScanner::startScan()
     auto tc = ToolChainKitAspect::toolChain(kit, Constants::C_NIMLANGUAGE_ID);
     QTC_ASSERT(tc, return);
 
-    const auto args = QStringList()
-        << "metadata"
-        << "--no-deps"
-        << "--offline"
-        << "--manifest-path=" + m_project->projectFilePath().toString()
-        << "--format-version=1";
-
-    m_scanner.start(tc->compilerCommand().toString(), args);
+    CommandLine command(tc->compilerCommand(), {"metadata",
+                                                "--no-deps",
+                                                "--offline",
+                                                "--manifest-path=" + m_project->projectFilePath().toString(),
+                                                "--format-version=1"});
+
+    // Metadata is refreshed in the background and must not slow down builds
+    auto bc = qobject_cast<NimBuildConfiguration *>(m_project->activeTarget()->activeBuildConfiguration());
+    const NimResourceLimits limits = bc ? bc->resourceLimits().background() : NimResourceLimits();
+    if (limits.enabled && NimCgroupScope::isAvailable())
+        command = m_scannerScope.wrap(command, limits);
+    m_scanner.start(command.executable().toString(), command.splitArguments());
 }
 
 void NimProjectScanner::watchProjectFilePath()
@@ -163,6 +192,11 @@ QStringList NimProjectScanner::excludedFiles() const
     return static_cast<NimProject *>(m_project)->excludedFiles();
 }
 
+QList<BuildTargetInfo> NimProjectScanner::benchTargets() const
+{
+    return m_benchTargets;
+}
+
 bool NimProjectScanner::addFiles(const QStringList &filePaths)
 {
     setExcludedFiles(Utils::filtered(excludedFiles(), [&](const QString & f) {
@@ -199,6 +233,7 @@ NimBuildSystem::NimBuildSystem(Target *target)
 {
     connect(&m_projectScanner, &NimProjectScanner::finished, this, [this] {
         m_guard.markAsSuccess();
+        setApplicationTargets(m_projectScanner.benchTargets());
         m_guard = {}; // Trigger destructor of previous object, emitting parsingFinished()
 
         emitBuildSystemUpdated();
@@ -25,7 +25,10 @@
 
 #pragma once
 
+#include "nimcgroupscope.h"
+
 #include <projectexplorer/buildsystem.h>
+#include <projectexplorer/buildtargetinfo.h>
 
 #include <utils/filesystemwatcher.h>
 
@@ -46,6 +49,9 @@ public:
     void setExcludedFiles(const QStringList &list);
     QStringList excludedFiles() const;
 
+    // The bench targets of the workspace members, run by bench run configurations
+    QList<ProjectExplorer::BuildTargetInfo> benchTargets() const;
+
     bool addFiles(const QStringList &filePaths);
     ProjectExplorer::RemovedFilesFromProject removeFiles(const QStringList &filePaths);
     bool renameFile(const QString &from, const QString &to);
@@ -62,7 +68,9 @@ private:
 
     ProjectExplorer::Project *m_project = nullptr;
     QProcess m_scanner;
+    NimCgroupScope m_scannerScope;
     Utils::FileSystemWatcher m_directoryWatcher;
+    QList<ProjectExplorer::BuildTargetInfo> m_benchTargets;
 };
 
 class NimBuildSystem : public ProjectExplorer::BuildSystem
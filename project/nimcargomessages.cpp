@@ -0,0 +1,73 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimcargomessages.h"
+
+#include <utils/algorithm.h>
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+using namespace Utils;
+
+namespace Nim {
+
+QList<NimCargoExecutable> NimCargoMessages::executables(const QByteArray &messages)
+{
+    QList<NimCargoExecutable> result;
+    for (const QByteArray &line : messages.split('\n')) {
+        if (!line.startsWith('{'))
+            continue;
+        const QJsonObject message = QJsonDocument::fromJson(line).object();
+        if (message["reason"].toString() != "compiler-artifact" || !message["executable"].isString())
+            continue;
+        NimCargoExecutable executable;
+        executable.name = message["target"]["name"].toString();
+        for (const QJsonValue &kind : message["target"]["kind"].toArray())
+            executable.kinds << kind.toString();
+        executable.test = message["profile"]["test"].toBool();
+        executable.path = FilePath::fromString(message["executable"].toString());
+        executable.manifestPath = FilePath::fromString(message["manifest_path"].toString());
+        result.append(executable);
+    }
+    return result;
+}
+
+NimCargoExecutable NimCargoMessages::binary(const QList<NimCargoExecutable> &executables,
+                                            const QString &fileName)
+{
+    const QList<NimCargoExecutable> binaries = Utils::filtered(executables, [](const NimCargoExecutable &e) {
+        return !e.test && e.kinds.contains("bin");
+    });
+    for (const NimCargoExecutable &executable : binaries) {
+        if (executable.path.fileName() == fileName)
+            return executable;
+    }
+    return binaries.size() == 1 ? binaries.first() : NimCargoExecutable();
+}
+
+} // namespace Nim
@@ -0,0 +1,208 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "nimcgroupscope.h"
+
+#include <utils/environment.h>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+using namespace Utils;
+
+namespace Nim {
+
+const char ENABLED_KEY[] = "Enabled";
+const char CPU_WEIGHT_KEY[] = "CpuWeight";
+const char IO_WEIGHT_KEY[] = "IoWeight";
+const char MEMORY_HIGH_KEY[] = "MemoryHigh";
+
+// Dashes in slice names denote nesting, hence no dash here
+const char SLICE_NAME[] = "rustcreator.slice";
+const int BACKGROUND_WEIGHT_DIVISOR = 5;
+const int ACCOUNTING_INTERVAL_MS = 500;
+
+NimResourceLimits NimResourceLimits::background() const
+{
+    NimResourceLimits result = *this;
+    result.cpuWeight = qMax(1, cpuWeight / BACKGROUND_WEIGHT_DIVISOR);
+    result.ioWeight = qMax(1, ioWeight / BACKGROUND_WEIGHT_DIVISOR);
+    return result;
+}
+
+QVariantMap NimResourceLimits::toMap() const
+{
+    QVariantMap result;
+    result[ENABLED_KEY] = enabled;
+    result[CPU_WEIGHT_KEY] = cpuWeight;
+    result[IO_WEIGHT_KEY] = ioWeight;
+    result[MEMORY_HIGH_KEY] = memoryHigh;
+    return result;
+}
+
+void NimResourceLimits::fromMap(const QVariantMap &map)
+{
+    enabled = map.value(ENABLED_KEY, false).toBool();
+    cpuWeight = map.value(CPU_WEIGHT_KEY, 100).toInt();
+    ioWeight = map.value(IO_WEIGHT_KEY, 100).toInt();
+    memoryHigh = map.value(MEMORY_HIGH_KEY).toString();
+}
+
+bool NimResourceLimits::operator==(const NimResourceLimits &other) const
+{
+    return enabled == other.enabled
+            && cpuWeight == other.cpuWeight
+            && ioWeight == other.ioWeight
+            && memoryHigh == other.memoryHigh;
+}
+
+static FilePath systemdRun()
+{
+    return Environment::systemEnvironment().searchInPath("systemd-run");
+}
+
+static QByteArray readCgroupFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    return file.readAll();
+}
+
+NimCgroupScope::NimCgroupScope(const QString &unitName, QObject *parent)
+    : QObject(parent)
+    , m_unitName(unitName)
+{
+    m_timer.setInterval(ACCOUNTING_INTERVAL_MS);
+    connect(&m_timer, &QTimer::timeout, this, &NimCgroupScope::sample);
+}
+
+bool NimCgroupScope::isAvailable()
+{
+    return QFileInfo::exists("/sys/fs/cgroup/cgroup.controllers") && !systemdRun().isEmpty();
+}
+
+QString NimCgroupScope::uniqueUnitName(const QString &purpose, const void *owner)
+{
+    return QString("rustcreator-%1-%2-%3").arg(purpose)
+            .arg(QCoreApplication::applicationPid())
+            .arg(quintptr(owner), 0, 16);
+}
+
+QString NimCgroupScope::unitName() const
+{
+    return m_unitName;
+}
+
+QStringList NimCgroupScope::wrapArguments(const QString &program, const QStringList &arguments,
+                                          const NimResourceLimits &limits) const
+{
+    QStringList result = {"--user", "--scope", "--quiet", "--collect",
+                          QString("--slice=") + SLICE_NAME,
+                          "--unit=" + m_unitName,
+                          "-p", QString("CPUWeight=%1").arg(limits.cpuWeight),
+                          "-p", QString("IOWeight=%1").arg(limits.ioWeight)};
+    if (!limits.memoryHigh.isEmpty())
+        result << "-p" << "MemoryHigh=" + limits.memoryHigh;
+    result << "--" << program << arguments;
+    return result;
+}
+
+CommandLine NimCgroupScope::wrap(const CommandLine &command, const NimResourceLimits &limits) const
+{
+    CommandLine result{systemdRun(), wrapArguments(command.executable().toString(), {}, limits)};
+    result.addArgs(command.arguments(), CommandLine::Raw);
+    return result;
+}
+
+void NimCgroupScope::startAccounting()
+{
+    m_accounting = NimResourceAccounting();
+    m_timer.start();
+}
+
+void NimCgroupScope::stopAccounting()
+{
+    sample();
+    m_timer.stop();
+}
+
+NimResourceAccounting NimCgroupScope::accounting() const
+{
+    return m_accounting;
+}
+
+QString NimCgroupScope::cgroupPath() const
+{
+#ifdef Q_OS_UNIX
+    const uint uid = getuid();
+#else
+    const uint uid = 0;
+#endif
+    return QString("/sys/fs/cgroup/user.slice/user-%1.slice/user@%1.service/%2/%3.scope")
+            .arg(uid).arg(SLICE_NAME).arg(m_unitName);
+}
+
+void NimCgroupScope::sample()
+{
+    const QString path = cgroupPath();
+
+    // Keep the previous values once the scope is gone
+    const QByteArray cpuStat = readCgroupFile(path + "/cpu.stat");
+    for (const QByteArray &line : cpuStat.split('\n')) {
+        if (line.startsWith("usage_usec "))
+            m_accounting.cpuSeconds = line.mid(11).toLongLong() / 1e6;
+    }
+
+    // memory.peak only exists since Linux 5.19
+    QByteArray memory = readCgroupFile(path + "/memory.peak");
+    if (memory.isEmpty())
+        memory = readCgroupFile(path + "/memory.current");
+    if (!memory.isEmpty())
+        m_accounting.peakMemory = qMax(m_accounting.peakMemory, memory.trimmed().toLongLong());
+
+    const QByteArray ioStat = readCgroupFile(path + "/io.stat");
+    if (!ioStat.isEmpty()) {
+        qint64 bytesRead = 0;
+        qint64 bytesWritten = 0;
+        for (const QByteArray &line : ioStat.split('\n')) {
+            for (const QByteArray &field : line.split(' ')) {
+                if (field.startsWith("rbytes="))
+                    bytesRead += field.mid(7).toLongLong();
+                else if (field.startsWith("wbytes="))
+                    bytesWritten += field.mid(7).toLongLong();
+            }
+        }
+        m_accounting.bytesRead = bytesRead;
+        m_accounting.bytesWritten = bytesWritten;
+    }
+}
+
+} // namespace Nim
@@ -0,0 +1,97 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <utils/fileutils.h>
+
+#include <QObject>
+#include <QTimer>
+#include <QVariantMap>
+
+namespace Nim {
+
+class NimResourceLimits
+{
+public:
+    bool enabled = false;
+    int cpuWeight = 100;
+    int ioWeight = 100;
+    QString memoryHigh; // systemd syntax, e.g. "8G" or "75%"; empty means no limit
+
+    // Limits for background analyses, which must not compete with builds
+    NimResourceLimits background() const;
+
+    QVariantMap toMap() const;
+    void fromMap(const QVariantMap &map);
+
+    bool operator==(const NimResourceLimits &other) const;
+    bool operator!=(const NimResourceLimits &other) const { return !(*this == other); }
+};
+
+class NimResourceAccounting
+{
+public:
+    double cpuSeconds = 0;
+    qint64 peakMemory = 0;
+    qint64 bytesRead = 0;
+    qint64 bytesWritten = 0;
+};
+
+// Runs a command inside a transient systemd scope below the user's service
+// manager and reads the cgroup v2 accounting of that scope while it exists.
+class NimCgroupScope : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NimCgroupScope(const QString &unitName, QObject *parent = nullptr);
+
+    static bool isAvailable();
+    static QString uniqueUnitName(const QString &purpose, const void *owner);
+
+    QString unitName() const;
+
+    // Runs the command through systemd-run as found in the PATH, callers check isAvailable()
+    Utils::CommandLine wrap(const Utils::CommandLine &command, const NimResourceLimits &limits) const;
+
+    // The scope is removed as soon as its last process exits, so accounting
+    // is sampled periodically while the command runs.
+    void startAccounting();
+    void stopAccounting();
+    NimResourceAccounting accounting() const;
+
+private:
+    QStringList wrapArguments(const QString &program, const QStringList &arguments,
+                              const NimResourceLimits &limits) const;
+    void sample();
+    QString cgroupPath() const;
+
+    QString m_unitName;
+    QTimer m_timer;
+    NimResourceAccounting m_accounting;
+};
+
+} // namespace Nim
@@ -0,0 +1,166 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimcommandsequence.h"
+
+#include <utils/qtcassert.h>
+
+#include <QTimer>
+
+using namespace Utils;
+
+namespace Nim {
+
+const int MAX_ERROR_LINES = 10;
+
+NimCommandSequence::NimCommandSequence(QObject *parent)
+    : QObject(parent)
+{}
+
+NimCommandSequence::~NimCommandSequence()
+{
+    cancel();
+}
+
+void NimCommandSequence::setWorkingDirectory(const FilePath &workingDirectory)
+{
+    m_workingDirectory = workingDirectory;
+}
+
+void NimCommandSequence::setEnvironment(const Environment &environment)
+{
+    m_environment = environment;
+}
+
+void NimCommandSequence::addCommand(const CommandLine &command, const Handler &handler, bool optional)
+{
+    Step step;
+    step.command = command;
+    step.handler = handler;
+    step.optional = optional;
+    m_steps.append(step);
+}
+
+void NimCommandSequence::addAction(const Action &action)
+{
+    Step step;
+    step.action = action;
+    m_steps.append(step);
+}
+
+bool NimCommandSequence::isRunning() const
+{
+    return m_running;
+}
+
+void NimCommandSequence::start()
+{
+    QTC_ASSERT(!isRunning(), return);
+    m_running = true;
+    runNext();
+}
+
+void NimCommandSequence::cancel()
+{
+    m_steps.clear();
+    m_running = false;
+    if (!m_process)
+        return;
+    m_process->disconnect(this);
+    m_process->kill();
+    m_process->waitForFinished(1000);
+    delete m_process;
+    m_process = nullptr;
+}
+
+void NimCommandSequence::runNext()
+{
+    // Actions may add further steps
+    while (!m_steps.isEmpty() && m_steps.first().action) {
+        const Step step = m_steps.takeFirst();
+        step.action();
+    }
+    if (m_steps.isEmpty()) {
+        finish(true);
+        return;
+    }
+
+    m_current = m_steps.takeFirst();
+    m_process = new QProcess;
+    m_process->setWorkingDirectory(m_workingDirectory.toString());
+    m_process->setProcessEnvironment(m_environment.toProcessEnvironment());
+    connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &NimCommandSequence::onProcessFinished);
+    connect(m_process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart)
+            onProcessFinished(-1, QProcess::CrashExit);
+    });
+    m_timer.start();
+    m_process->start(m_current.command.executable().toString(),
+                     m_current.command.splitArguments());
+}
+
+void NimCommandSequence::onProcessFinished(int exitCode, QProcess::ExitStatus status)
+{
+    NimCommandResult result;
+    result.seconds = m_timer.elapsed() / 1000.0;
+    result.exitCode = exitCode;
+    result.crashed = status != QProcess::NormalExit;
+    result.standardOutput = m_process->readAllStandardOutput();
+    result.standardError = m_process->readAllStandardError();
+    m_process->disconnect(this);
+    m_process->deleteLater();
+    m_process = nullptr;
+
+    if (m_current.handler)
+        m_current.handler(result);
+
+    if (!result.success() && !m_current.optional) {
+        const QList<QByteArray> lines = result.standardError.trimmed().split('\n');
+        QStringList tail;
+        for (const QByteArray &line : lines.mid(qMax(0, lines.size() - MAX_ERROR_LINES)))
+            tail << QString::fromLocal8Bit(line);
+        emit message(tr("\"%1\" failed:").arg(m_current.command.toUserOutput())
+                     + '\n' + tail.join('\n'));
+        m_steps.clear();
+        finish(false);
+        return;
+    }
+
+    // Handlers may start other work on the same event, run the next step later
+    QTimer::singleShot(0, this, [this] {
+        if (m_running)
+            runNext();
+    });
+}
+
+void NimCommandSequence::finish(bool success)
+{
+    m_running = false;
+    emit finished(success);
+}
+
+} // namespace Nim
@@ -0,0 +1,104 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include <utils/environment.h>
+#include <utils/fileutils.h>
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QProcess>
+
+#include <functional>
+
+namespace Nim {
+
+class NimCommandResult
+{
+public:
+    int exitCode = -1;
+    bool crashed = false;
+    double seconds = 0;
+    QByteArray standardOutput;
+    QByteArray standardError;
+
+    bool success() const { return !crashed && exitCode == 0; }
+};
+
+// Runs commands and callbacks one after another outside of the build
+// manager, e.g. for benchmarks that build and run the project several times.
+// A failing command stops the sequence unless it was added as optional.
+class NimCommandSequence : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Handler = std::function<void(const NimCommandResult &result)>;
+    using Action = std::function<void()>;
+
+    explicit NimCommandSequence(QObject *parent = nullptr);
+    ~NimCommandSequence() override;
+
+    void setWorkingDirectory(const Utils::FilePath &workingDirectory);
+    void setEnvironment(const Utils::Environment &environment);
+
+    void addCommand(const Utils::CommandLine &command, const Handler &handler = {},
+                    bool optional = false);
+    void addAction(const Action &action);
+
+    bool isRunning() const;
+    void start();
+    void cancel();
+
+signals:
+    void message(const QString &message);
+    void finished(bool success);
+
+private:
+    class Step
+    {
+    public:
+        Utils::CommandLine command;
+        Handler handler;
+        Action action;
+        bool optional = false;
+    };
+
+    void runNext();
+    void onProcessFinished(int exitCode, QProcess::ExitStatus status);
+    void finish(bool success);
+
+    Utils::FilePath m_workingDirectory;
+    Utils::Environment m_environment = Utils::Environment::systemEnvironment();
+    QList<Step> m_steps;
+    Step m_current;
+    QProcess *m_process = nullptr;
+    bool m_running = false;
+    QElapsedTimer m_timer;
+};
+
+} // namespace Nim
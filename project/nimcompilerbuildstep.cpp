@@ -28,23 +28,154 @@
 #include "nimbuildsystem.h"
 #include "nimcompilerbuildstepconfigwidget.h"
 #include "nimconstants.h"
+#include "nimproject.h"
+#include "nimrustcwrapper.h"
 #include "nimtoolchain.h"
+#include "nimutils.h"
 
 #include <projectexplorer/buildconfiguration.h>
 #include <projectexplorer/ioutputparser.h>
 #include <projectexplorer/kitinformation.h>
 #include <projectexplorer/processparameters.h>
 #include <projectexplorer/projectexplorerconstants.h>
+#include <utils/algorithm.h>
+#include <utils/hostosinfo.h>
 #include <utils/qtcassert.h>
 
 #include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QProcess>
 #include <QRegularExpression>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <functional>
 
 using namespace ProjectExplorer;
 using namespace Utils;
 
 namespace Nim {
 
+const int RUSTC_TIMEOUT_MS = 10000;
+const int ARTIFACT_CACHE_MAX_MIB = 10 * 1024;
+
+// The target passed to cargo with --target, empty for the host
+static QString explicitTarget(const QStringList &options)
+{
+    for (int i = 0; i < options.size(); ++i) {
+        if (options.at(i).startsWith("--target="))
+            return options.at(i).mid(9);
+        if (options.at(i) == "--target" && i + 1 < options.size())
+            return options.at(i + 1);
+    }
+    return QString();
+}
+
+static QString readHostTriple(const FilePath &rustc, const Environment &env)
+{
+    QProcess process;
+    process.setProcessEnvironment(env.toProcessEnvironment());
+    process.start(rustc.toString(), {"-vV"});
+    if (!process.waitForFinished(RUSTC_TIMEOUT_MS) || process.exitStatus() != QProcess::NormalExit
+            || process.exitCode() != 0) {
+        return QString();
+    }
+    for (const QString &line : QString::fromUtf8(process.readAllStandardOutput()).split('\n')) {
+        if (line.startsWith("host: "))
+            return line.mid(6).trimmed();
+    }
+    return QString();
+}
+
+// rustc's host triple, asked once per rustc in the background. An empty
+// result is kept as well: that rustc cannot tell.
+static QFuture<QString> hostTriple(const FilePath &cargo, const Environment &env)
+{
+    static QHash<QString, QFuture<QString>> hostTriples;
+    FilePath rustc = cargo.parentDir().pathAppended(HostOsInfo::withExecutableSuffix("rustc"));
+    if (!rustc.exists())
+        rustc = env.searchInPath("rustc");
+    if (!hostTriples.contains(rustc.toString()))
+        hostTriples.insert(rustc.toString(), QtConcurrent::run(readHostTriple, rustc, env));
+    return hostTriples.value(rustc.toString());
+}
+
+// The strings of a TOML value: a string, or an array of strings
+static QStringList tomlStrings(const QString &value)
+{
+    static const QRegularExpression string(R"("((?:[^"\\]|\\.)*)"|'([^']*)')");
+    QStringList result;
+    QRegularExpressionMatchIterator it = string.globalMatch(value);
+    while (it.hasNext()) {
+        const QRegularExpressionMatch match = it.next();
+        result << (match.capturedStart(1) >= 0 ? match.captured(1).replace("\\\"", "\"")
+                                                   .replace("\\\\", "\\")
+                                               : match.captured(2));
+    }
+    return result;
+}
+
+// The values of a key in the cargo configuration files of a project, nearest
+// first: from the project directory up to the root, then in CARGO_HOME. The
+// TOML is only understood as far as tables, dotted keys and string values go.
+static QList<QStringList> cargoConfigValues(const FilePath &projectDirectory, const Environment &env,
+                                            const QString &key)
+{
+    QStringList files;
+    for (QDir directory(projectDirectory.toString()); ; ) {
+        const QString config = directory.filePath(".cargo/config");
+        files << (QFileInfo::exists(config + ".toml") ? config + ".toml" : config);
+        if (!directory.cdUp())
+            break;
+    }
+    const QString cargoHome = env.value("CARGO_HOME").isEmpty() ? QDir::homePath() + "/.cargo"
+                                                                : env.value("CARGO_HOME");
+    const QString homeConfig = QFileInfo::exists(cargoHome + "/config.toml") ? cargoHome + "/config.toml"
+                                                                              : cargoHome + "/config";
+    if (!files.contains(homeConfig))
+        files << homeConfig;
+
+    const auto unquoted = [](QString text) {
+        return text.remove('"').remove('\'').remove(' ');
+    };
+    QList<QStringList> result;
+    for (const QString &fileName : qAsConst(files)) {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+            continue;
+        QString table;
+        while (!file.atEnd()) {
+            const QString line = QString::fromUtf8(file.readLine()).trimmed();
+            if (line.startsWith('[') && !line.startsWith("[[")) {
+                table = unquoted(line.mid(1, line.indexOf(']') - 1));
+                continue;
+            }
+            const int equals = line.indexOf('=');
+            if (equals < 0 || line.startsWith('#'))
+                continue;
+            const QString name = unquoted(line.left(equals));
+            if ((table.isEmpty() ? name : table + '.' + name) != key)
+                continue;
+            QString value = line.mid(equals + 1).trimmed();
+            // Arrays can span several lines
+            while (value.startsWith('[') && !value.contains(']') && !file.atEnd())
+                value += QString::fromUtf8(file.readLine()).trimmed();
+            result << tomlStrings(value);
+        }
+    }
+    return result;
+}
+
+static QString tomlArray(const QStringList &strings)
+{
+    const QStringList quoted = Utils::transform(strings, [](QString string) {
+        return '"' + string.replace('\\', "\\\\").replace('"', "\\\"") + '"';
+    });
+    return '[' + quoted.join(", ") + ']';
+}
+
 class LineStateMachine
 {
 public:
@@ -151,6 +282,7 @@ private:
 
 NimCompilerBuildStep::NimCompilerBuildStep(BuildStepList *parentList, Core::Id id)
     : AbstractProcessStep(parentList, id)
+    , m_cgroupScope(NimCgroupScope::uniqueUnitName("build", this))
 {
     setDefaultDisplayName(tr(Constants::C_NIMCOMPILERBUILDSTEP_DISPLAY));
     setDisplayName(tr(Constants::C_NIMCOMPILERBUILDSTEP_DISPLAY));
@@ -162,18 +294,283 @@ NimCompilerBuildStep::NimCompilerBuildStep(BuildStepList *parentList, Core::Id i
             this, &NimCompilerBuildStep::updateProcessParameters);
     connect(bc, &NimBuildConfiguration::processParametersChanged,
             this, &NimCompilerBuildStep::updateProcessParameters);
+    connect(target(), &Target::buildSystemUpdated,
+            this, &NimCompilerBuildStep::updateProcessParameters);
+    connect(&m_hostTripleWatcher, &QFutureWatcher<QString>::finished,
+            this, &NimCompilerBuildStep::updateProcessParameters);
     updateProcessParameters();
 }
 
+NimCompilerBuildStep::~NimCompilerBuildStep()
+{
+    m_usageWatcher.waitForFinished();
+}
+
 bool NimCompilerBuildStep::init()
 {
     setOutputParser(new NimParser());
     if (IOutputParser *parser = target()->kit()->createOutputParser())
         appendOutputParser(parser);
     outputParser()->setWorkingDirectory(processParameters()->effectiveWorkingDirectory());
+    applyAdaptiveJobs();
+
+    if (m_selectiveClean && id() == Constants::C_NIMCOMPILERCLEANSTEP_ID
+            && static_cast<NimProject *>(project())->workspaceMembers().isEmpty()) {
+        emit addOutput(tr("The workspace members are not known yet, "
+                          "wait until the project has been parsed."),
+                       OutputFormat::ErrorMessage);
+        return false;
+    }
+
     return AbstractProcessStep::init();
 }
 
+void NimCompilerBuildStep::doRun()
+{
+    auto bc = qobject_cast<NimBuildConfiguration *>(buildConfiguration());
+    QTC_ASSERT(bc, return);
+    // What the sync has not persisted yet stays dirty for the next one
+    bc->ramTargetDirectory()->cancelSync();
+    if (bc->isTargetDirectoryBusy()) {
+        emit addOutput(tr("Waiting for the target directory to be copied..."),
+                       OutputFormat::NormalMessage);
+        m_targetDirectoryConnection = connect(bc, &NimBuildConfiguration::targetDirectoryIdle,
+                                              this, [this, bc] {
+            if (bc->isTargetDirectoryBusy())
+                return;
+            disconnect(m_targetDirectoryConnection);
+            m_targetDirectoryConnection = QMetaObject::Connection();
+            doRun();
+        });
+        return;
+    }
+    bc->ramTargetDirectory()->buildStarted();
+    if (id() == Constants::C_NIMCOMPILERBUILDSTEP_ID)
+        bc->branchSnapshots()->buildStarted();
+
+    if (!m_jobsReport.isEmpty())
+        emit addOutput(m_jobsReport, OutputFormat::NormalMessage);
+    if (!m_linkerReport.isEmpty())
+        emit addOutput(m_linkerReport, OutputFormat::ErrorMessage);
+    // Only a selective clean keeps enough of the target directory to be worth
+    // telling what it freed
+    if (m_selectiveClean && id() == Constants::C_NIMCOMPILERCLEANSTEP_ID) {
+        measureTargetDirectory([this](const NimTargetDirectoryUsage &usage) {
+            m_usageBeforeClean = usage;
+            startProcess();
+        });
+        return;
+    }
+    startProcess();
+}
+
+void NimCompilerBuildStep::startProcess()
+{
+    m_fingerprintParser.clear();
+    if (m_artifactCache) {
+        QFile::remove(artifactCacheLog().toString());
+        QDir().mkpath(artifactCacheLog().parentDir().toString());
+    }
+    if (m_linkTimesLogged) {
+        QFile::remove(linkTimesLog().toString());
+        QDir().mkpath(linkTimesLog().parentDir().toString());
+    }
+    if (m_remarksLogged)
+        recompileRemarkCrates();
+    // Appended to across builds, the latest entry of each unit wins. Only
+    // these are kept before each build, so the log does not grow with every
+    // rebuild.
+    if (m_unitTimingsLogged) {
+        QDir().mkpath(unitTimingsLog().parentDir().toString());
+        const QList<NimUnitTiming> timings = NimUnitTiming::fromLog(unitTimingsLog());
+        if (!timings.isEmpty())
+            NimUnitTiming::writeLog(unitTimingsLog(), timings);
+        m_unitTimingsBefore = timings.size();
+    }
+    AbstractProcessStep::doRun();
+}
+
+void NimCompilerBuildStep::doCancel()
+{
+    // Still waiting for the target directory, there is no process to stop
+    if (m_targetDirectoryConnection) {
+        disconnect(m_targetDirectoryConnection);
+        m_targetDirectoryConnection = QMetaObject::Connection();
+        emit finished(false);
+        return;
+    }
+    if (m_usageConnection) {
+        disconnect(m_usageConnection);
+        m_usageConnection = QMetaObject::Connection();
+        emit finished(false);
+        return;
+    }
+    AbstractProcessStep::doCancel();
+}
+
+void NimCompilerBuildStep::finish(bool success)
+{
+    if (!m_selectiveClean || id() != Constants::C_NIMCOMPILERCLEANSTEP_ID) {
+        AbstractProcessStep::finish(success);
+        return;
+    }
+    measureTargetDirectory([this, success](const NimTargetDirectoryUsage &usage) {
+        emit addOutput(tr("Freed %1 MiB, kept %2 compiled units.")
+                           .arg(NimUtils::toMiB(qMax(Q_INT64_C(0), m_usageBeforeClean.bytes - usage.bytes)))
+                           .arg(usage.compiledUnits),
+                       OutputFormat::NormalMessage);
+        AbstractProcessStep::finish(success);
+    });
+}
+
+// Walking a large target directory takes seconds
+void NimCompilerBuildStep::measureTargetDirectory(
+        const std::function<void(const NimTargetDirectoryUsage &)> &handler)
+{
+    auto bc = qobject_cast<NimBuildConfiguration *>(buildConfiguration());
+    QTC_ASSERT(bc, return);
+    m_usageConnection = connect(&m_usageWatcher, &QFutureWatcher<NimTargetDirectoryUsage>::finished,
+                                this, [this, handler] {
+        disconnect(m_usageConnection);
+        m_usageConnection = QMetaObject::Connection();
+        handler(m_usageWatcher.result());
+    });
+    m_usageWatcher.setFuture(QtConcurrent::run(&NimTargetDirectory::usage, bc->effectiveTargetDirectory()));
+}
+
+void NimCompilerBuildStep::processStarted()
+{
+    m_buildTimer.start();
+    if (m_adaptiveJobs && id() == Constants::C_NIMCOMPILERBUILDSTEP_ID)
+        m_memoryMonitor.start(processParameters()->effectiveCommand().toString());
+    if (m_isolated)
+        m_cgroupScope.startAccounting();
+    AbstractProcessStep::processStarted();
+}
+
+void NimCompilerBuildStep::processFinished(int exitCode, QProcess::ExitStatus status)
+{
+    AbstractProcessStep::processFinished(exitCode, status);
+
+    auto bc = qobject_cast<NimBuildConfiguration *>(buildConfiguration());
+    QTC_ASSERT(bc, return);
+    if (id() == Constants::C_NIMCOMPILERBUILDSTEP_ID) {
+        const bool success = status == QProcess::NormalExit && exitCode == 0;
+        const QString report = bc->branchSnapshots()->buildFinished(success,
+                                                                    m_buildTimer.elapsed() / 1000.0);
+        if (!report.isEmpty())
+            emit addOutput(report, OutputFormat::NormalMessage);
+        bc->ramTargetDirectory()->buildFinished();
+    }
+
+    if (m_isolated) {
+        m_cgroupScope.stopAccounting();
+        const NimResourceAccounting usage = m_cgroupScope.accounting();
+        emit addOutput(tr("Resource usage: %1 s CPU time, %2 MiB peak memory, "
+                          "%3 MiB read, %4 MiB written.")
+                           .arg(usage.cpuSeconds, 0, 'f', 1)
+                           .arg(NimUtils::toMiB(usage.peakMemory))
+                           .arg(NimUtils::toMiB(usage.bytesRead))
+                           .arg(NimUtils::toMiB(usage.bytesWritten)),
+                       OutputFormat::NormalMessage);
+    }
+
+    if (m_artifactCache) {
+        const NimArtifactCacheStatistics cache = NimArtifactCacheStatistics::fromLog(artifactCacheLog());
+        const int lookups = cache.hits + cache.misses;
+        emit addOutput(tr("Dependency artifact cache: %1 hits, %2 misses (%3% hit rate).")
+                           .arg(cache.hits).arg(cache.misses)
+                           .arg(lookups ? 100 * cache.hits / lookups : 0),
+                       OutputFormat::NormalMessage);
+    }
+
+    if (m_fingerprintLogging)
+        reportRebuildCauses();
+
+    if (m_linkTimesLogged)
+        reportLinkTimes();
+
+    if (m_unitTimingsLogged) {
+        const QList<NimUnitTiming> timings = NimUnitTiming::fromLog(unitTimingsLog());
+        double cpuSeconds = 0;
+        for (const NimUnitTiming &timing : timings)
+            cpuSeconds += timing.cpuSeconds;
+        emit addOutput(tr("Compile times of %1 units recorded (%2 new), %3 s of CPU time in total. "
+                          "See Tools > Rust > Dependency Compile Cost.")
+                           .arg(timings.size()).arg(timings.size() - m_unitTimingsBefore)
+                           .arg(cpuSeconds, 0, 'f', 1),
+                       OutputFormat::NormalMessage);
+    }
+
+    if (m_remarksLogged) {
+        const QStringList files = QDir(remarksDirectory().toString()).entryList({"*.remarks"}, QDir::Files);
+        emit addOutput(tr("Optimization remarks of %n crate(s) recorded. "
+                          "See Tools > Rust > Show Optimization Remarks.", nullptr, files.size()),
+                       OutputFormat::NormalMessage);
+    }
+
+    if (!m_adaptiveJobs || id() != Constants::C_NIMCOMPILERBUILDSTEP_ID)
+        return;
+
+    m_memoryMonitor.stop();
+    bc->mergeCrateMemoryPeaks(m_memoryMonitor.crateMemoryPeaks());
+
+    emit addOutput(tr("Peak build memory: %1 MiB, lowest available memory: %2 MiB.")
+                       .arg(NimUtils::toMiB(m_memoryMonitor.peakTotalMemory()))
+                       .arg(NimUtils::toMiB(m_memoryMonitor.minAvailableMemory())),
+                   OutputFormat::NormalMessage);
+}
+
+void NimCompilerBuildStep::stdError(const QString &line)
+{
+    // The table after the build replaces the raw log
+    if (m_fingerprintLogging && m_fingerprintParser.addLine(line))
+        return;
+    AbstractProcessStep::stdError(line);
+}
+
+void NimCompilerBuildStep::reportRebuildCauses()
+{
+    const QList<NimRebuiltUnit> units = m_fingerprintParser.units();
+    if (units.isEmpty()) {
+        emit addOutput(tr("Nothing was rebuilt."), OutputFormat::NormalMessage);
+        return;
+    }
+
+    QStringList lines;
+    lines << tr("Why units were rebuilt:");
+    for (const NimRebuiltUnit &unit : units) {
+        const QString reason = unit.dependency.isEmpty()
+                ? unit.cause : tr("dependency %1 was rebuilt").arg(unit.dependency);
+        lines << QString("  %1\t%2").arg(unit.displayName(), -30)
+                 .arg(reason.isEmpty() ? tr("unknown") : reason);
+    }
+
+    const QList<NimRebuildCause> causes = m_fingerprintParser.rootCauses();
+    lines << tr("Root causes:");
+    for (const NimRebuildCause &cause : causes) {
+        QString flag;
+        if (cause.units > 1 && (cause.buildScript || cause.environment)) {
+            flag = cause.buildScript ? tr(" [cascading build script]") : tr(" [cascading env var]");
+            ++m_cascadeCounts[cause.cause];
+        }
+        lines << tr("  %n units\t%1%2", nullptr, cause.units).arg(cause.cause, flag);
+    }
+
+    // Across builds, the build scripts and environment variables that most
+    // often invalidate more than their own unit
+    QList<QPair<int, QString>> frequent;
+    for (auto it = m_cascadeCounts.cbegin(); it != m_cascadeCounts.cend(); ++it)
+        frequent.append({it.value(), it.key()});
+    std::sort(frequent.begin(), frequent.end(), std::greater<QPair<int, QString>>());
+    if (!frequent.isEmpty()) {
+        lines << tr("Most frequent cascading causes:");
+        for (const QPair<int, QString> &cause : frequent.mid(0, 5))
+            lines << tr("  %n builds\t%1", nullptr, cause.first).arg(cause.second);
+    }
+    emit addOutput(lines.join('\n'), OutputFormat::NormalMessage);
+}
+
 BuildStepConfigWidget *NimCompilerBuildStep::createConfigWidget()
 {
     auto widget = new NimCompilerBuildStepConfigWidget(this);
@@ -188,6 +585,15 @@ bool NimCompilerBuildStep::fromMap(const QVariantMap &map)
 {
     AbstractProcessStep::fromMap(map);
     m_userCompilerOptions = map[Constants::C_NIMCOMPILERBUILDSTEP_USERCOMPILEROPTIONS].toString().split('|');
+    m_adaptiveJobs = map.value(Constants::C_NIMCOMPILERBUILDSTEP_ADAPTIVEJOBS, true).toBool();
+    m_selectiveClean = map.value(Constants::C_NIMCOMPILERBUILDSTEP_SELECTIVECLEAN, false).toBool();
+    m_explainRebuilds = map.value(Constants::C_NIMCOMPILERBUILDSTEP_EXPLAINREBUILDS, false).toBool();
+    m_unitTimings = map.value(Constants::C_NIMCOMPILERBUILDSTEP_UNITTIMINGS, false).toBool();
+    m_remarkCrates = map.value(Constants::C_NIMCOMPILERBUILDSTEP_REMARKCRATES).toStringList();
+    m_cascadeCounts.clear();
+    const QVariantMap counts = map.value(Constants::C_NIMCOMPILERBUILDSTEP_REBUILDCAUSES).toMap();
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it)
+        m_cascadeCounts.insert(it.key(), it.value().toInt());
     updateProcessParameters();
     return true;
 }
@@ -196,6 +602,15 @@ QVariantMap NimCompilerBuildStep::toMap() const
 {
     QVariantMap result = AbstractProcessStep::toMap();
     result[Constants::C_NIMCOMPILERBUILDSTEP_USERCOMPILEROPTIONS] = m_userCompilerOptions.join('|');
+    result[Constants::C_NIMCOMPILERBUILDSTEP_ADAPTIVEJOBS] = m_adaptiveJobs;
+    result[Constants::C_NIMCOMPILERBUILDSTEP_SELECTIVECLEAN] = m_selectiveClean;
+    result[Constants::C_NIMCOMPILERBUILDSTEP_EXPLAINREBUILDS] = m_explainRebuilds;
+    result[Constants::C_NIMCOMPILERBUILDSTEP_UNITTIMINGS] = m_unitTimings;
+    result[Constants::C_NIMCOMPILERBUILDSTEP_REMARKCRATES] = m_remarkCrates;
+    QVariantMap counts;
+    for (auto it = m_cascadeCounts.cbegin(); it != m_cascadeCounts.cend(); ++it)
+        counts.insert(it.key(), it.value());
+    result[Constants::C_NIMCOMPILERBUILDSTEP_REBUILDCAUSES] = counts;
     return result;
 }
 
@@ -211,11 +626,109 @@ void NimCompilerBuildStep::setUserCompilerOptions(const QStringList &options)
     updateProcessParameters();
 }
 
+bool NimCompilerBuildStep::adaptiveJobs() const
+{
+    return m_adaptiveJobs;
+}
+
+void NimCompilerBuildStep::setAdaptiveJobs(bool adaptiveJobs)
+{
+    if (m_adaptiveJobs == adaptiveJobs)
+        return;
+    m_adaptiveJobs = adaptiveJobs;
+    emit adaptiveJobsChanged(adaptiveJobs);
+}
+
+bool NimCompilerBuildStep::selectiveClean() const
+{
+    return m_selectiveClean;
+}
+
+void NimCompilerBuildStep::setSelectiveClean(bool selectiveClean)
+{
+    if (m_selectiveClean == selectiveClean)
+        return;
+    m_selectiveClean = selectiveClean;
+    emit selectiveCleanChanged(selectiveClean);
+    updateProcessParameters();
+}
+
+bool NimCompilerBuildStep::explainRebuilds() const
+{
+    return m_explainRebuilds;
+}
+
+void NimCompilerBuildStep::setExplainRebuilds(bool explainRebuilds)
+{
+    if (m_explainRebuilds == explainRebuilds)
+        return;
+    m_explainRebuilds = explainRebuilds;
+    emit explainRebuildsChanged(explainRebuilds);
+    updateProcessParameters();
+}
+
+bool NimCompilerBuildStep::unitTimings() const
+{
+    return m_unitTimings;
+}
+
+void NimCompilerBuildStep::setUnitTimings(bool unitTimings)
+{
+    if (m_unitTimings == unitTimings)
+        return;
+    m_unitTimings = unitTimings;
+    emit unitTimingsChanged(unitTimings);
+    updateProcessParameters();
+}
+
+QStringList NimCompilerBuildStep::remarkCrates() const
+{
+    return m_remarkCrates;
+}
+
+void NimCompilerBuildStep::setRemarkCrates(const QStringList &crates)
+{
+    if (m_remarkCrates == crates)
+        return;
+    m_remarkCrates = crates;
+    emit remarkCratesChanged(crates);
+    updateProcessParameters();
+}
+
+FilePath NimCompilerBuildStep::remarksDirectory() const
+{
+    auto bc = qobject_cast<NimBuildConfiguration *>(buildConfiguration());
+    QTC_ASSERT(bc, return FilePath());
+    return NimRustcWrapper::logFile(bc->effectiveTargetDirectory(), "remarks");
+}
+
+// The wrapper only adds the remark options when a crate compiles, removing
+// the fingerprints of crates without remarks yet makes cargo compile them
+void NimCompilerBuildStep::recompileRemarkCrates()
+{
+    auto bc = qobject_cast<NimBuildConfiguration *>(buildConfiguration());
+    QTC_ASSERT(bc, return);
+    const QString profile = bc->nimBuildType() == NimBuildConfiguration::Release ? "release" : "debug";
+    QDir fingerprints(bc->effectiveTargetDirectory().pathAppended(profile + "/.fingerprint").toString());
+    const QStringList units = fingerprints.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &crate : m_remarkCrates) {
+        if (remarksDirectory().pathAppended(crate + ".remarks").exists())
+            continue;
+        for (const QString &unit : units) {
+            // Named <package>-<hash>, packages may use dashes where crates have underscores
+            const QString package = unit.left(unit.lastIndexOf('-'));
+            if (QString(package).replace('-', '_') == crate)
+                QDir(fingerprints.filePath(unit)).removeRecursively();
+        }
+    }
+}
+
 void NimCompilerBuildStep::updateProcessParameters()
 {
+    // The command has the --config arguments of the environment
+    updateEnvironment();
     updateCommand();
     updateWorkingDirectory();
-    updateEnvironment();
     emit processParametersChanged();
 }
 
@@ -226,38 +739,300 @@ void NimCompilerBuildStep::updateWorkingDirectory()
     processParameters()->setWorkingDirectory(bc->buildDirectory());
 }
 
-void NimCompilerBuildStep::updateCommand()
+CommandLine NimCompilerBuildStep::cargoCommand(const QString &subcommand) const
 {
     auto bc = qobject_cast<NimBuildConfiguration *>(buildConfiguration());
-    QTC_ASSERT(bc, return);
+    QTC_ASSERT(bc, return {});
 
-    QTC_ASSERT(target(), return);
-    QTC_ASSERT(target()->kit(), return);
+    QTC_ASSERT(target(), return {});
+    QTC_ASSERT(target()->kit(), return {});
     Kit *kit = target()->kit();
     auto tc = ToolChainKitAspect::toolChain(kit, Constants::C_NIMLANGUAGE_ID);
-    QTC_ASSERT(tc, return);
+    QTC_ASSERT(tc, return {});
 
     CommandLine cmd{tc->compilerCommand()};
 
+    bool replaced = subcommand.isEmpty();
     for (const QString &arg : m_userCompilerOptions) {
-        if (!arg.isEmpty())
-            cmd.addArg(arg);
+        if (arg.isEmpty())
+            continue;
+        if (!replaced && !arg.startsWith('-')) {
+            cmd.addArg(subcommand);
+            replaced = true;
+            continue;
+        }
+        cmd.addArg(arg);
     }
+    if (!replaced)
+        cmd.addArg(subcommand);
 
     if (bc->nimBuildType() == NimBuildConfiguration::Release)
         cmd.addArg("--release");
 
-    cmd.addArg("--target-dir=" + bc->buildDirectory().toString());
+    cmd.addArg("--target-dir=" + bc->effectiveTargetDirectory().toString());
     cmd.addArg("--manifest-path=" + bc->project()->projectFilePath().toString());
+    cmd.addArgs(m_configArguments);
+    return cmd;
+}
+
+Environment NimCompilerBuildStep::cargoEnvironment()
+{
+    // The rustc wrapper's caches and the logs are for complete builds only.
+    // What changes the artifacts, like the debug information, stays.
+    static const QStringList stepVariables = {"RUSTC_WRAPPER", "RUST_CREATOR_TIMINGS_LOG",
+                                              "RUST_CREATOR_REMARK_CRATES", "RUST_CREATOR_REMARKS_DIR",
+                                              "RUST_CREATOR_ARTIFACT_CACHE", "RUST_CREATOR_CACHE_LOG",
+                                              "RUST_CREATOR_CACHE_MAX_MIB", "RUST_CREATOR_LINK_LOG",
+                                              "CARGO_LOG"};
+    Environment env = processParameters()->environment();
+    QTC_ASSERT(buildConfiguration(), return env);
+    const Environment configured = buildConfiguration()->environment();
+    for (const QString &variable : stepVariables) {
+        if (!configured.hasKey(variable))
+            env.unset(variable);
+    }
+    return env;
+}
+
+void NimCompilerBuildStep::updateCommand()
+{
+    CommandLine cmd = cargoCommand(QString());
+    QTC_ASSERT(!cmd.executable().isEmpty(), return);
+    auto bc = static_cast<NimBuildConfiguration *>(buildConfiguration());
+
+    // Only remove the workspace members, keep the compiled dependencies
+    if (m_selectiveClean && id() == Constants::C_NIMCOMPILERCLEANSTEP_ID) {
+        for (const QString &member : static_cast<NimProject *>(project())->workspaceMembers())
+            cmd.addArgs({"-p", member});
+    }
+
+    const NimResourceLimits limits = bc->resourceLimits();
+    m_isolated = limits.enabled && NimCgroupScope::isAvailable();
+    if (m_isolated)
+        cmd = m_cgroupScope.wrap(cmd, limits);
 
     processParameters()->setCommandLine(cmd);
 }
 
 void NimCompilerBuildStep::updateEnvironment()
 {
-    auto bc = buildConfiguration();
+    auto bc = qobject_cast<NimBuildConfiguration *>(buildConfiguration());
     QTC_ASSERT(bc, return);
-    processParameters()->setEnvironment(bc->environment());
+
+    Environment env = bc->environment();
+    const bool canWrap = id() == Constants::C_NIMCOMPILERBUILDSTEP_ID && !env.hasKey("RUSTC_WRAPPER");
+    m_artifactCache = bc->sharedArtifactCache() && canWrap;
+    m_unitTimingsLogged = m_unitTimings && canWrap;
+    m_remarksLogged = !m_remarkCrates.isEmpty() && canWrap;
+    if (m_artifactCache || m_unitTimingsLogged || m_remarksLogged)
+        env.set("RUSTC_WRAPPER", NimRustcWrapper::installedPath().toString());
+    if (m_unitTimingsLogged)
+        env.set("RUST_CREATOR_TIMINGS_LOG", unitTimingsLog().toString());
+    if (m_remarksLogged) {
+        env.set("RUST_CREATOR_REMARK_CRATES", m_remarkCrates.join(' '));
+        env.set("RUST_CREATOR_REMARKS_DIR", remarksDirectory().toString());
+    }
+    if (m_artifactCache) {
+        env.set("RUST_CREATOR_ARTIFACT_CACHE", NimRustcWrapper::artifactCacheDirectory().toString());
+        env.set("RUST_CREATOR_CACHE_LOG", artifactCacheLog().toString());
+        env.set("RUST_CREATOR_CACHE_MAX_MIB", QString::number(ARTIFACT_CACHE_MAX_MIB));
+    }
+
+    m_fingerprintLogging = m_explainRebuilds
+            && id() == Constants::C_NIMCOMPILERBUILDSTEP_ID
+            && !env.hasKey("CARGO_LOG");
+    if (m_fingerprintLogging)
+        env.set("CARGO_LOG", "cargo::core::compiler::fingerprint=info");
+
+    // Limited debug information has the line tables and the inlined functions
+    if (bc->releaseDebugInfo() && bc->nimBuildType() == NimBuildConfiguration::Release
+            && !env.hasKey("CARGO_PROFILE_RELEASE_DEBUG")) {
+        env.set("CARGO_PROFILE_RELEASE_DEBUG", "1");
+    }
+
+    QStringList rustFlags;
+    m_linkerReport.clear();
+    m_linkTimesLogged = false;
+    m_configArguments.clear();
+    if (id() == Constants::C_NIMCOMPILERBUILDSTEP_ID) {
+        const QString linker = bc->linkerExecutable();
+        if (!linker.isEmpty() && env.searchInPath(linker).isEmpty())
+            m_linkerReport = tr("%1 was not found, linking with the default linker.").arg(linker);
+        else
+            rustFlags = bc->linkerRustFlags().split(' ', QString::SkipEmptyParts);
+        m_linkTimesLogged = bc->measureLinkTime();
+    }
+    if (rustFlags.isEmpty() && !m_linkTimesLogged) {
+        processParameters()->setEnvironment(env);
+        return;
+    }
+
+    // The linker and the flags are per target, so that the configured ones
+    // stay in effect
+    auto tc = ToolChainKitAspect::toolChain(target()->kit(), Constants::C_NIMLANGUAGE_ID);
+    QString triple = explicitTarget(m_userCompilerOptions);
+    if (triple.isEmpty() && tc) {
+        const QFuture<QString> host = hostTriple(tc->compilerCommand(), env);
+        if (!host.isFinished()) {
+            // The parameters are updated again once rustc has answered
+            m_hostTripleWatcher.setFuture(host);
+            m_linkerReport = tr("The target triple is not known yet, linking with the default linker.");
+            m_linkTimesLogged = false;
+            processParameters()->setEnvironment(env);
+            return;
+        }
+        triple = host.result();
+    }
+    if (triple.isEmpty()) {
+        m_linkerReport = tr("The target triple is unknown, linking with the default linker.");
+        m_linkTimesLogged = false;
+        processParameters()->setEnvironment(env);
+        return;
+    }
+    const FilePath projectDirectory = project()->projectDirectory();
+    const QString prefix = "CARGO_TARGET_" + triple.toUpper().replace('-', '_').replace('.', '_');
+    const QString targetKey = "target." + triple;
+    if (m_linkTimesLogged) {
+        const QList<QStringList> configured = cargoConfigValues(projectDirectory, env, targetKey + ".linker");
+        QString linker = env.value(prefix + "_LINKER");
+        if (linker.isEmpty() && !configured.isEmpty() && !configured.first().isEmpty())
+            linker = configured.first().first();
+        if (!linker.isEmpty())
+            env.set("RUST_CREATOR_LINKER", linker);
+        env.set(prefix + "_LINKER", NimRustcWrapper::linkerWrapperPath().toString());
+        env.set("RUST_CREATOR_LINK_LOG", linkTimesLog().toString());
+    }
+    if (rustFlags.isEmpty()) {
+        processParameters()->setEnvironment(env);
+        return;
+    }
+
+    // Flags from the environment replace the configured ones, add to them there
+    if (env.hasKey("CARGO_ENCODED_RUSTFLAGS") || env.hasKey("RUSTFLAGS")) {
+        QStringList flags = env.hasKey("CARGO_ENCODED_RUSTFLAGS")
+                ? env.value("CARGO_ENCODED_RUSTFLAGS").split(QChar(0x1f), QString::SkipEmptyParts)
+                : env.value("RUSTFLAGS").split(QRegularExpression("\\s+"), QString::SkipEmptyParts);
+        flags << rustFlags;
+        env.set("CARGO_ENCODED_RUSTFLAGS", flags.join(QChar(0x1f)));
+        processParameters()->setEnvironment(env);
+        return;
+    }
+    // cargo joins target rustflags from all sources, but ignores build.rustflags
+    // once there are any
+    if (!env.hasKey(prefix + "_RUSTFLAGS")
+            && cargoConfigValues(projectDirectory, env, targetKey + ".rustflags").isEmpty()) {
+        QList<QStringList> buildFlags = cargoConfigValues(projectDirectory, env, "build.rustflags");
+        if (env.hasKey("CARGO_BUILD_RUSTFLAGS"))
+            buildFlags.prepend({env.value("CARGO_BUILD_RUSTFLAGS")});
+        if (!buildFlags.isEmpty()) {
+            QStringList flags = buildFlags.first();
+            // A string rather than an array is split at whitespace
+            if (flags.size() == 1)
+                flags = flags.first().split(QRegularExpression("\\s+"), QString::SkipEmptyParts);
+            rustFlags = flags + rustFlags;
+        }
+    }
+    m_configArguments = QStringList{"--config",
+                                    QString("target.\"%1\".rustflags=%2").arg(triple, tomlArray(rustFlags))};
+    processParameters()->setEnvironment(env);
+}
+
+QStringList NimCompilerBuildStep::cargoConfigArguments() const
+{
+    return m_configArguments;
+}
+
+FilePath NimCompilerBuildStep::artifactCacheLog() const
+{
+    auto bc = qobject_cast<NimBuildConfiguration *>(buildConfiguration());
+    QTC_ASSERT(bc, return FilePath());
+    return NimRustcWrapper::logFile(bc->effectiveTargetDirectory(), "artifact-cache.log");
+}
+
+FilePath NimCompilerBuildStep::unitTimingsLog() const
+{
+    auto bc = qobject_cast<NimBuildConfiguration *>(buildConfiguration());
+    QTC_ASSERT(bc, return FilePath());
+    return NimRustcWrapper::logFile(bc->effectiveTargetDirectory(), "unit-timings.log");
+}
+
+FilePath NimCompilerBuildStep::linkTimesLog() const
+{
+    auto bc = qobject_cast<NimBuildConfiguration *>(buildConfiguration());
+    QTC_ASSERT(bc, return FilePath());
+    return NimRustcWrapper::logFile(bc->effectiveTargetDirectory(), "link-times.log");
+}
+
+void NimCompilerBuildStep::reportLinkTimes()
+{
+    auto bc = qobject_cast<NimBuildConfiguration *>(buildConfiguration());
+    QTC_ASSERT(bc, return);
+
+    const QList<NimLinkTime> links = NimLinkTimes::fromLog(linkTimesLog(), bc->linkerName());
+    if (links.isEmpty()) {
+        emit addOutput(tr("Nothing was linked."), OutputFormat::NormalMessage);
+        return;
+    }
+    const QList<NimLinkTime> history = bc->linkTimeHistory();
+    double linkSeconds = 0;
+    for (const NimLinkTime &link : links) {
+        linkSeconds += link.seconds;
+        emit addOutput(tr("Linked %1 with %2 in %3 s.")
+                           .arg(link.target, link.linker).arg(link.seconds, 0, 'f', 2),
+                       OutputFormat::NormalMessage);
+        const QString regression = NimLinkTimes::regression(history, link);
+        if (!regression.isEmpty())
+            emit addOutput(regression, OutputFormat::ErrorMessage);
+    }
+    const double buildSeconds = m_buildTimer.elapsed() / 1000.0;
+    emit addOutput(tr("Linking took %1 s of the %2 s build.")
+                       .arg(linkSeconds, 0, 'f', 2).arg(buildSeconds, 0, 'f', 1),
+                   OutputFormat::NormalMessage);
+    bc->addLinkTimes(links);
+}
+
+void NimCompilerBuildStep::applyAdaptiveJobs()
+{
+    m_jobsReport.clear();
+    if (!m_adaptiveJobs || id() != Constants::C_NIMCOMPILERBUILDSTEP_ID)
+        return;
+
+    auto bc = qobject_cast<NimBuildConfiguration *>(buildConfiguration());
+    QTC_ASSERT(bc, return);
+
+    Environment env = processParameters()->environment();
+    const bool explicitJobs = Utils::anyOf(m_userCompilerOptions, [](const QString &arg) {
+        return arg.startsWith("-j") || arg.startsWith("--jobs");
+    });
+    if (explicitJobs || env.hasKey("CARGO_BUILD_JOBS")) {
+        m_jobsReport = tr("Parallel jobs are set explicitly, not adapting them to available memory.");
+        return;
+    }
+
+    const QMap<QString, qint64> peaks = bc->crateMemoryPeaks();
+    if (peaks.isEmpty()) {
+        m_jobsReport = tr("No memory usage recorded for this build configuration yet, "
+                          "using the default number of parallel jobs.");
+        return;
+    }
+
+    const qint64 available = NimBuildMemoryMonitor::availableMemory();
+    const int maxJobs = QThread::idealThreadCount();
+    QString limitingCrate;
+    const int jobs = NimBuildMemoryMonitor::recommendedJobs(peaks, available, maxJobs, &limitingCrate);
+
+    env.set("CARGO_BUILD_JOBS", QString::number(jobs));
+    processParameters()->setEnvironment(env);
+
+    if (limitingCrate.isEmpty()) {
+        m_jobsReport = tr("Using %1 parallel jobs, %2 MiB of memory available.")
+                           .arg(jobs).arg(NimUtils::toMiB(available));
+    } else {
+        m_jobsReport = tr("Limiting the build to %1 parallel jobs: %2 MiB of memory available, "
+                          "crate \"%3\" needed up to %4 MiB.")
+                           .arg(jobs).arg(NimUtils::toMiB(available))
+                           .arg(limitingCrate).arg(NimUtils::toMiB(peaks.value(limitingCrate)));
+    }
 }
 
 // NimCompilerBuildStepFactory
@@ -25,11 +25,21 @@
 
 #pragma once
 
+#include "nimbuildmemorymonitor.h"
+#include "nimcgroupscope.h"
+#include "nimfingerprintparser.h"
+#include "nimtargetdirectory.h"
+
 #include <projectexplorer/abstractprocessstep.h>
 #include <projectexplorer/buildconfiguration.h>
 #include <projectexplorer/buildstep.h>
 #include <projectexplorer/buildsteplist.h>
 
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+
+#include <functional>
+
 namespace Nim {
 
 class NimCompilerBuildStep : public ProjectExplorer::AbstractProcessStep
@@ -38,6 +48,7 @@ class NimCompilerBuildStep : public ProjectExplorer::AbstractProcessStep
 
 public:
     NimCompilerBuildStep(ProjectExplorer::BuildStepList *parentList, Core::Id id);
+    ~NimCompilerBuildStep() override;
 
     bool init() override;
     ProjectExplorer::BuildStepConfigWidget *createConfigWidget() override;
@@ -48,17 +59,90 @@ public:
     QStringList userCompilerOptions() const;
     void setUserCompilerOptions(const QStringList &options);
 
+    bool adaptiveJobs() const;
+    void setAdaptiveJobs(bool adaptiveJobs);
+
+    bool selectiveClean() const;
+    void setSelectiveClean(bool selectiveClean);
+
+    bool explainRebuilds() const;
+    void setExplainRebuilds(bool explainRebuilds);
+
+    bool unitTimings() const;
+    void setUnitTimings(bool unitTimings);
+
+    // Crates compiled with LLVM's optimization remarks, which the rustc
+    // wrapper writes to the remarks directory
+    QStringList remarkCrates() const;
+    void setRemarkCrates(const QStringList &crates);
+    Utils::FilePath remarksDirectory() const;
+
+    // The build's cargo command with another subcommand (or the configured
+    // one if empty) and its environment, without the resource limits
+    Utils::CommandLine cargoCommand(const QString &subcommand) const;
+    Utils::Environment cargoEnvironment();
+    // The --config arguments with the target's linker flags, which other cargo
+    // commands need to reuse the build's artifacts
+    QStringList cargoConfigArguments() const;
+
 signals:
     void userCompilerOptionsChanged(const QStringList &options);
+    void adaptiveJobsChanged(bool adaptiveJobs);
+    void selectiveCleanChanged(bool selectiveClean);
+    void explainRebuildsChanged(bool explainRebuilds);
+    void unitTimingsChanged(bool unitTimings);
+    void remarkCratesChanged(const QStringList &crates);
     void processParametersChanged();
 
+protected:
+    void doRun() override;
+    void doCancel() override;
+    void finish(bool success) override;
+    void processStarted() override;
+    void processFinished(int exitCode, QProcess::ExitStatus status) override;
+    void stdError(const QString &line) override;
+
 private:
+    void startProcess();
+    void measureTargetDirectory(const std::function<void(const NimTargetDirectoryUsage &)> &handler);
     void updateProcessParameters();
     void updateCommand();
     void updateWorkingDirectory();
     void updateEnvironment();
+    void applyAdaptiveJobs();
+    Utils::FilePath artifactCacheLog() const;
+    Utils::FilePath unitTimingsLog() const;
+    Utils::FilePath linkTimesLog() const;
+    void reportLinkTimes();
+    void reportRebuildCauses();
+    void recompileRemarkCrates();
 
     QStringList m_userCompilerOptions;
+    bool m_adaptiveJobs = true;
+    QString m_jobsReport;
+    QString m_linkerReport;
+    QFutureWatcher<QString> m_hostTripleWatcher;
+    QStringList m_configArguments;
+    NimBuildMemoryMonitor m_memoryMonitor;
+    NimCgroupScope m_cgroupScope;
+    bool m_isolated = false;
+    bool m_selectiveClean = false;
+    bool m_artifactCache = false;
+    bool m_explainRebuilds = false;
+    bool m_unitTimings = false;
+    bool m_unitTimingsLogged = false;
+    QStringList m_remarkCrates;
+    bool m_remarksLogged = false;
+    int m_unitTimingsBefore = 0;
+    bool m_fingerprintLogging = false;
+    bool m_linkTimesLogged = false;
+    NimFingerprintParser m_fingerprintParser;
+    QMap<QString, int> m_cascadeCounts; // builds in which a cause rebuilt more than one unit
+    NimTargetDirectoryUsage m_usageBeforeClean;
+    QFutureWatcher<NimTargetDirectoryUsage> m_usageWatcher;
+    QMetaObject::Connection m_usageConnection;
+    QElapsedTimer m_buildTimer;
+    QMetaObject::Connection m_targetDirectoryConnection;
 };
 
 class NimCompilerBuildStepFactory : public ProjectExplorer::BuildStepFactory
@@ -37,6 +37,8 @@
 #include <utils/qtcassert.h>
 #include <utils/qtcprocess.h>
 
+#include <QRegularExpression>
+
 using namespace ProjectExplorer;
 using namespace Utils;
 
@@ -62,6 +64,25 @@ NimCompilerBuildStepConfigWidget::NimCompilerBuildStepConfigWidget(NimCompilerBu
     // Connect UI signals
     connect(m_ui->additionalArgumentsLineEdit, &QLineEdit::textEdited,
             this, &NimCompilerBuildStepConfigWidget::onAdditionalArgumentsTextEdited);
+    connect(m_ui->adaptiveJobsCheckBox, &QCheckBox::toggled,
+            m_buildStep, &NimCompilerBuildStep::setAdaptiveJobs);
+
+    connect(m_ui->selectiveCleanCheckBox, &QCheckBox::toggled,
+            m_buildStep, &NimCompilerBuildStep::setSelectiveClean);
+    connect(m_ui->explainRebuildsCheckBox, &QCheckBox::toggled,
+            m_buildStep, &NimCompilerBuildStep::setExplainRebuilds);
+    connect(m_ui->unitTimingsCheckBox, &QCheckBox::toggled,
+            m_buildStep, &NimCompilerBuildStep::setUnitTimings);
+    connect(m_ui->remarkCratesLineEdit, &QLineEdit::textEdited,
+            this, &NimCompilerBuildStepConfigWidget::onRemarkCratesTextEdited);
+
+    // Memory-adaptive parallelism only applies to builds, selective clean to cleans
+    m_ui->adaptiveJobsCheckBox->setVisible(m_buildStep->id() == Constants::C_NIMCOMPILERBUILDSTEP_ID);
+    m_ui->explainRebuildsCheckBox->setVisible(m_buildStep->id() == Constants::C_NIMCOMPILERBUILDSTEP_ID);
+    m_ui->unitTimingsCheckBox->setVisible(m_buildStep->id() == Constants::C_NIMCOMPILERBUILDSTEP_ID);
+    m_ui->remarkCratesLabel->setVisible(m_buildStep->id() == Constants::C_NIMCOMPILERBUILDSTEP_ID);
+    m_ui->remarkCratesLineEdit->setVisible(m_buildStep->id() == Constants::C_NIMCOMPILERBUILDSTEP_ID);
+    m_ui->selectiveCleanCheckBox->setVisible(m_buildStep->id() == Constants::C_NIMCOMPILERCLEANSTEP_ID);
 
     updateUi();
 }
@@ -72,6 +93,11 @@ void NimCompilerBuildStepConfigWidget::updateUi()
 {
     updateCommandLineText();
     updateAdditionalArgumentsLineEdit();
+    updateAdaptiveJobsCheckBox();
+    updateSelectiveCleanCheckBox();
+    updateExplainRebuildsCheckBox();
+    updateUnitTimingsCheckBox();
+    updateRemarkCratesLineEdit();
 }
 
 void NimCompilerBuildStepConfigWidget::onAdditionalArgumentsTextEdited(const QString &text)
@@ -79,6 +105,15 @@ void NimCompilerBuildStepConfigWidget::onAdditionalArgumentsTextEdited(const QSt
     m_buildStep->setUserCompilerOptions(text.split(QChar::Space));
 }
 
+// rustc knows crates by their names with underscores
+void NimCompilerBuildStepConfigWidget::onRemarkCratesTextEdited(const QString &text)
+{
+    QStringList crates = text.split(QRegularExpression("[\\s,]+"), QString::SkipEmptyParts);
+    for (QString &crate : crates)
+        crate.replace('-', '_');
+    m_buildStep->setRemarkCrates(crates);
+}
+
 void NimCompilerBuildStepConfigWidget::updateCommandLineText()
 {
     ProcessParameters *parameters = m_buildStep->processParameters();
@@ -95,5 +130,32 @@ void NimCompilerBuildStepConfigWidget::updateAdditionalArgumentsLineEdit()
     m_ui->additionalArgumentsLineEdit->setText(text);
 }
 
+void NimCompilerBuildStepConfigWidget::updateAdaptiveJobsCheckBox()
+{
+    m_ui->adaptiveJobsCheckBox->setChecked(m_buildStep->adaptiveJobs());
+}
+
+void NimCompilerBuildStepConfigWidget::updateSelectiveCleanCheckBox()
+{
+    m_ui->selectiveCleanCheckBox->setChecked(m_buildStep->selectiveClean());
+}
+
+void NimCompilerBuildStepConfigWidget::updateExplainRebuildsCheckBox()
+{
+    m_ui->explainRebuildsCheckBox->setChecked(m_buildStep->explainRebuilds());
+}
+
+void NimCompilerBuildStepConfigWidget::updateUnitTimingsCheckBox()
+{
+    m_ui->unitTimingsCheckBox->setChecked(m_buildStep->unitTimings());
+}
+
+void NimCompilerBuildStepConfigWidget::updateRemarkCratesLineEdit()
+{
+    // Keep what is being typed, like a trailing space
+    if (!m_ui->remarkCratesLineEdit->hasFocus())
+        m_ui->remarkCratesLineEdit->setText(m_buildStep->remarkCrates().join(' '));
+}
+
 }
 
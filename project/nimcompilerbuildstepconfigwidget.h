@@ -45,8 +45,14 @@ private:
     void updateUi();
     void updateCommandLineText();
     void updateAdditionalArgumentsLineEdit();
+    void updateAdaptiveJobsCheckBox();
+    void updateSelectiveCleanCheckBox();
+    void updateExplainRebuildsCheckBox();
+    void updateUnitTimingsCheckBox();
+    void updateRemarkCratesLineEdit();
 
     void onAdditionalArgumentsTextEdited(const QString &text);
+    void onRemarkCratesTextEdited(const QString &text);
 
     NimCompilerBuildStep *m_buildStep;
     QScopedPointer<Ui::NimCompilerBuildStepConfigWidget> m_ui;
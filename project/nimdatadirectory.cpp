@@ -0,0 +1,80 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimdatadirectory.h"
+
+#include <projectexplorer/buildconfiguration.h>
+#include <projectexplorer/project.h>
+#include <projectexplorer/runconfiguration.h>
+#include <projectexplorer/target.h>
+#include <utils/qtcassert.h>
+
+#include <QRegularExpression>
+
+using namespace ProjectExplorer;
+using namespace Utils;
+
+namespace Nim {
+
+static FilePath projectDataDirectory(const Project *project)
+{
+    return project->projectDirectory().pathAppended(".qtc/rust");
+}
+
+FilePath NimDataDirectory::forBuildConfiguration(const BuildConfiguration *buildConfiguration)
+{
+    QTC_ASSERT(buildConfiguration, return FilePath());
+    // Build configurations of different kits often have the same name
+    const Target *target = buildConfiguration->target();
+    return projectDataDirectory(target->project())
+            .pathAppended(fileName(target->displayName() + '-' + buildConfiguration->displayName()));
+}
+
+FilePath NimDataDirectory::forRunConfiguration(RunConfiguration *runConfiguration, const QString &kind,
+                                               const QString &suffix)
+{
+    QTC_ASSERT(runConfiguration, return FilePath());
+    const BuildConfiguration *buildConfiguration = runConfiguration->target()->activeBuildConfiguration();
+    const FilePath base = buildConfiguration ? forBuildConfiguration(buildConfiguration)
+                                             : projectDataDirectory(runConfiguration->target()->project());
+    return base.pathAppended(kind + '/' + fileName(runConfiguration->displayName()) + suffix);
+}
+
+FilePath NimDataDirectory::besideBuildDirectory(const BuildConfiguration *buildConfiguration,
+                                                const QString &purpose)
+{
+    QTC_ASSERT(buildConfiguration, return FilePath());
+    return FilePath::fromString(buildConfiguration->buildDirectory().toString() + '-' + purpose);
+}
+
+QString NimDataDirectory::fileName(const QString &name)
+{
+    QString result = name;
+    result.replace(QRegularExpression("[^A-Za-z0-9_.-]"), "_");
+    return result;
+}
+
+} // namespace Nim
@@ -0,0 +1,62 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include <utils/fileutils.h>
+
+namespace ProjectExplorer {
+class BuildConfiguration;
+class RunConfiguration;
+}
+
+namespace Nim {
+
+// Where the measurements and histories of a build configuration are kept.
+// The build directory is cargo's target directory, which cargo clean deletes
+// and the branch snapshots swap, so they live in the project instead:
+//   <project>/.qtc/rust/<kit>-<build configuration>/
+class NimDataDirectory
+{
+public:
+    static Utils::FilePath forBuildConfiguration(const ProjectExplorer::BuildConfiguration *buildConfiguration);
+
+    // <data directory>/<kind>/<run configuration><suffix>, in the project's
+    // data directory when the target has no build configuration
+    static Utils::FilePath forRunConfiguration(ProjectExplorer::RunConfiguration *runConfiguration,
+                                               const QString &kind,
+                                               const QString &suffix = QString());
+
+    // For worktrees and extra target directories, which are too large to
+    // keep with the data: <build directory>-<purpose>
+    static Utils::FilePath besideBuildDirectory(const ProjectExplorer::BuildConfiguration *buildConfiguration,
+                                                const QString &purpose);
+
+    // A name that can be used as a file name
+    static QString fileName(const QString &name);
+};
+
+} // namespace Nim
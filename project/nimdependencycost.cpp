@@ -0,0 +1,400 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimdependencycost.h"
+
+#include "nimbuildconfiguration.h"
+
+#include "../nimconstants.h"
+
+#include <coreplugin/messagemanager.h>
+#include <projectexplorer/kitinformation.h>
+#include <projectexplorer/project.h>
+#include <projectexplorer/toolchain.h>
+#include <utils/algorithm.h>
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QSet>
+
+#include <algorithm>
+
+using namespace ProjectExplorer;
+using namespace Utils;
+
+namespace Nim {
+
+const int TOP_CRATES = 20;
+const int MAX_REQUIRED_BY = 3;
+
+static QString packageKey(const QString &name, const QString &version)
+{
+    return name + ' ' + version;
+}
+
+static QString featureList(const QStringList &features)
+{
+    return '[' + features.join(", ") + ']';
+}
+
+// Package ids to "name version"
+static QHash<QString, QString> packageKeys(const QJsonDocument &metadata)
+{
+    QHash<QString, QString> keys;
+    for (const QJsonValue &package : metadata["packages"].toArray())
+        keys.insert(package["id"].toString(), packageKey(package["name"].toString(), package["version"].toString()));
+    return keys;
+}
+
+QList<NimCrateCost> NimDependencyCost::crateCosts(const QList<NimUnitTiming> &timings,
+                                                  const QJsonDocument &metadata)
+{
+    QSet<QString> workspacePackages;
+    for (const QJsonValue &package : metadata["packages"].toArray()) {
+        if (package["source"].isNull())
+            workspacePackages.insert(packageKey(package["name"].toString(), package["version"].toString()));
+    }
+    const QHash<QString, QString> keys = packageKeys(metadata);
+    QSet<QString> resolvedPackages;
+    for (const QJsonValue &node : metadata["resolve"]["nodes"].toArray())
+        resolvedPackages.insert(keys.value(node["id"].toString()));
+
+    // Build scripts and libraries of a package count together, per feature set
+    QMap<QString, NimCrateCost> costs;
+    for (const NimUnitTiming &timing : timings) {
+        // The log keeps units of versions that have been updated since
+        if (!resolvedPackages.isEmpty() && !resolvedPackages.contains(packageKey(timing.package, timing.version)))
+            continue;
+        const QString key = packageKey(timing.package, timing.version) + ' ' + timing.features.join(',');
+        NimCrateCost &cost = costs[key];
+        cost.package = timing.package;
+        cost.version = timing.version;
+        cost.features = timing.features;
+        cost.thirdParty = !workspacePackages.contains(packageKey(timing.package, timing.version));
+        cost.cpuSeconds += timing.cpuSeconds;
+        ++cost.units;
+    }
+
+    QList<NimCrateCost> result = costs.values();
+    std::sort(result.begin(), result.end(), [](const NimCrateCost &a, const NimCrateCost &b) {
+        return a.cpuSeconds > b.cpuSeconds;
+    });
+    return result;
+}
+
+QList<NimDuplicateCrate> NimDependencyCost::duplicates(const QList<NimCrateCost> &costs,
+                                                       const QJsonDocument &metadata)
+{
+    // The versions in the dependency graph, and who depends on which package.
+    // The packages list also has those of the lock file that nothing uses.
+    QHash<QString, QString> names;
+    QHash<QString, QString> versionsById;
+    for (const QJsonValue &package : metadata["packages"].toArray()) {
+        const QString id = package["id"].toString();
+        names.insert(id, package["name"].toString());
+        versionsById.insert(id, package["version"].toString());
+    }
+    const QHash<QString, QString> keys = packageKeys(metadata);
+    QMultiHash<QString, QString> versions;
+    QHash<QString, QStringList> requiredBy;
+    for (const QJsonValue &node : metadata["resolve"]["nodes"].toArray()) {
+        const QString id = node["id"].toString();
+        versions.insert(names.value(id), versionsById.value(id));
+        const QString dependent = keys.value(id);
+        for (const QJsonValue &dependency : node["dependencies"].toArray()) {
+            QStringList &list = requiredBy[keys.value(dependency.toString())];
+            if (!list.contains(dependent))
+                list.append(dependent);
+        }
+    }
+
+    QHash<QString, QList<NimCrateCost>> costsByPackage;
+    for (const NimCrateCost &cost : costs)
+        costsByPackage[cost.package].append(cost);
+
+    QList<NimDuplicateCrate> result;
+    const QStringList packages = versions.uniqueKeys();
+    for (const QString &package : packages) {
+        QStringList packageVersions = versions.values(package);
+        packageVersions.removeDuplicates();
+        const QList<NimCrateCost> packageCosts = costsByPackage.value(package);
+        // The graph also has the dependencies of other platforms, only the
+        // versions that were compiled count once compile times are recorded
+        if (!costs.isEmpty()) {
+            packageVersions = Utils::filtered(packageVersions, [&packageCosts](const QString &version) {
+                return Utils::contains(packageCosts, [&version](const NimCrateCost &cost) {
+                    return cost.version == version;
+                });
+            });
+        }
+
+        const auto extraCost = [](const QList<NimCrateCost> &variants) {
+            double total = 0;
+            double largest = 0;
+            for (const NimCrateCost &cost : variants) {
+                total += cost.cpuSeconds;
+                largest = qMax(largest, cost.cpuSeconds);
+            }
+            return total - largest;
+        };
+
+        if (packageVersions.size() > 1) {
+            std::sort(packageVersions.begin(), packageVersions.end());
+            NimDuplicateCrate duplicate;
+            duplicate.package = package;
+            duplicate.reason = QCoreApplication::translate("Nim::NimDependencyCost",
+                                                           "duplicate semver versions");
+            duplicate.variants = packageVersions;
+            for (const QString &version : qAsConst(packageVersions)) {
+                const QStringList dependents = requiredBy.value(packageKey(package, version));
+                duplicate.requiredBy << QString("%1: %2").arg(version)
+                                        .arg(dependents.mid(0, MAX_REQUIRED_BY).join(", "));
+            }
+            duplicate.extraCpuSeconds = extraCost(packageCosts);
+            result.append(duplicate);
+        }
+
+        // Feature unification failed when one version was built with several feature sets
+        for (const QString &version : qAsConst(packageVersions)) {
+            const QList<NimCrateCost> variants = Utils::filtered(packageCosts, [&version](const NimCrateCost &cost) {
+                return cost.version == version;
+            });
+            if (variants.size() < 2)
+                continue;
+            NimDuplicateCrate duplicate;
+            duplicate.package = packageKey(package, version);
+            duplicate.reason = QCoreApplication::translate("Nim::NimDependencyCost",
+                                                           "divergent feature sets");
+            for (const NimCrateCost &variant : variants)
+                duplicate.variants << featureList(variant.features);
+            duplicate.requiredBy = requiredBy.value(packageKey(package, version)).mid(0, MAX_REQUIRED_BY);
+            duplicate.extraCpuSeconds = extraCost(variants);
+            result.append(duplicate);
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const NimDuplicateCrate &a, const NimDuplicateCrate &b) {
+        return a.extraCpuSeconds > b.extraCpuSeconds;
+    });
+    return result;
+}
+
+// NimDependencyCostReport
+
+NimDependencyCostReport::NimDependencyCostReport(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_sequence, &NimCommandSequence::message, this, [](const QString &message) {
+        Core::MessageManager::write(message);
+    });
+}
+
+bool NimDependencyCostReport::isRunning() const
+{
+    return m_sequence.isRunning();
+}
+
+void NimDependencyCostReport::run(NimBuildConfiguration *buildConfiguration)
+{
+    if (isRunning() || !buildConfiguration)
+        return;
+    ToolChain *toolChain = ToolChainKitAspect::toolChain(buildConfiguration->target()->kit(),
+                                                         Constants::C_NIMLANGUAGE_ID);
+    if (!toolChain)
+        return;
+    m_buildConfiguration = buildConfiguration;
+
+    // Unlike the project scanner, this needs the whole dependency graph
+    const CommandLine metadata{toolChain->compilerCommand(),
+                               {"metadata", "--format-version", "1", "--manifest-path",
+                                buildConfiguration->project()->projectFilePath().toString()}};
+    m_sequence.setWorkingDirectory(buildConfiguration->project()->projectDirectory());
+    m_sequence.setEnvironment(buildConfiguration->environment());
+    m_sequence.addCommand(metadata, [this](const NimCommandResult &result) {
+        if (result.success())
+            report(result.standardOutput);
+    });
+    Core::MessageManager::write(tr("Resolving the dependency graph..."));
+    m_sequence.start();
+}
+
+void NimDependencyCostReport::report(const QByteArray &metadata)
+{
+    if (!m_buildConfiguration)
+        return;
+
+    const QJsonDocument document = QJsonDocument::fromJson(metadata);
+    const FilePath log = NimRustcWrapper::logFile(m_buildConfiguration->effectiveTargetDirectory(),
+                                                  "unit-timings.log");
+    const QList<NimCrateCost> costs = NimDependencyCost::crateCosts(NimUnitTiming::fromLog(log),
+                                                                    document);
+    QStringList lines;
+    if (costs.isEmpty()) {
+        lines << tr("No compile times recorded yet. Enable \"Record compile time per unit\" "
+                    "in the build step and rebuild the project from scratch.");
+    } else {
+        double total = 0;
+        double thirdParty = 0;
+        for (const NimCrateCost &cost : costs) {
+            total += cost.cpuSeconds;
+            if (cost.thirdParty)
+                thirdParty += cost.cpuSeconds;
+        }
+        lines << tr("Compile CPU time: %1 s in total, %2 s in third-party crates.")
+                 .arg(total, 0, 'f', 1).arg(thirdParty, 0, 'f', 1);
+        int shown = 0;
+        for (const NimCrateCost &cost : costs) {
+            if (!cost.thirdParty)
+                continue;
+            if (++shown > TOP_CRATES)
+                break;
+            lines << QString("  %1 s %2%\t%3 %4 %5")
+                     .arg(cost.cpuSeconds, 7, 'f', 1)
+                     .arg(total > 0 ? qRound(100 * cost.cpuSeconds / total) : 0, 3)
+                     .arg(cost.package, cost.version, featureList(cost.features));
+        }
+    }
+
+    const QList<NimDuplicateCrate> duplicates = NimDependencyCost::duplicates(costs, document);
+    if (!duplicates.isEmpty()) {
+        lines << tr("Compiled more than once:");
+        for (const NimDuplicateCrate &duplicate : duplicates) {
+            lines << tr("  %1 (%2, %3 s extra): %4")
+                     .arg(duplicate.package, duplicate.reason)
+                     .arg(duplicate.extraCpuSeconds, 0, 'f', 1)
+                     .arg(duplicate.variants.join(" / "));
+            if (!duplicate.requiredBy.isEmpty())
+                lines << tr("      required by %1").arg(duplicate.requiredBy.join("; "));
+        }
+    }
+    Core::MessageManager::write(lines.join('\n'));
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QTest>
+
+namespace Nim {
+
+void RustPlugin::testDependencyCost()
+{
+    // app uses rand 0.8 and legacy, which still uses rand 0.7. serde is built
+    // with and without derive, winapi only on Windows. getrandom 0.1 is a
+    // leftover of the lock file.
+    const QJsonDocument metadata = QJsonDocument::fromJson(R"({
+        "packages": [
+            {"id": "app 0.1.0 (path+file:///w)", "name": "app", "version": "0.1.0", "source": null},
+            {"id": "legacy 1.0.0 (registry)", "name": "legacy", "version": "1.0.0", "source": "registry"},
+            {"id": "rand 0.7.3 (registry)", "name": "rand", "version": "0.7.3", "source": "registry"},
+            {"id": "rand 0.8.5 (registry)", "name": "rand", "version": "0.8.5", "source": "registry"},
+            {"id": "serde 1.0.190 (registry)", "name": "serde", "version": "1.0.190", "source": "registry"},
+            {"id": "winapi 0.2.8 (registry)", "name": "winapi", "version": "0.2.8", "source": "registry"},
+            {"id": "winapi 0.3.9 (registry)", "name": "winapi", "version": "0.3.9", "source": "registry"},
+            {"id": "getrandom 0.1.16 (registry)", "name": "getrandom", "version": "0.1.16", "source": "registry"}
+        ],
+        "resolve": {"nodes": [
+            {"id": "app 0.1.0 (path+file:///w)", "dependencies": [
+                "legacy 1.0.0 (registry)", "rand 0.8.5 (registry)", "serde 1.0.190 (registry)"]},
+            {"id": "legacy 1.0.0 (registry)", "dependencies": [
+                "rand 0.7.3 (registry)", "serde 1.0.190 (registry)", "winapi 0.2.8 (registry)"]},
+            {"id": "rand 0.7.3 (registry)", "dependencies": []},
+            {"id": "rand 0.8.5 (registry)", "dependencies": ["winapi 0.3.9 (registry)"]},
+            {"id": "serde 1.0.190 (registry)", "dependencies": []},
+            {"id": "winapi 0.2.8 (registry)", "dependencies": []},
+            {"id": "winapi 0.3.9 (registry)", "dependencies": []}
+        ]}
+    })");
+    QVERIFY(!metadata.isNull());
+
+    const auto timing = [](const QString &package, const QString &version, const QString &crate,
+                           const QStringList &features, double cpuSeconds) {
+        NimUnitTiming result;
+        result.package = package;
+        result.version = version;
+        result.crate = crate;
+        result.features = features;
+        result.cpuSeconds = cpuSeconds;
+        return result;
+    };
+    const QList<NimUnitTiming> timings{
+        timing("app", "0.1.0", "app", {}, 2),
+        timing("legacy", "1.0.0", "legacy", {}, 0.5),
+        timing("rand", "0.7.3", "rand", {}, 3),
+        timing("rand", "0.8.5", "rand", {"std"}, 5),
+        timing("serde", "1.0.190", "serde", {"derive", "std"}, 4),
+        timing("serde", "1.0.190", "serde", {"std"}, 1.5),
+        timing("serde", "1.0.190", "build_script_build", {"std"}, 0.25),
+        timing("getrandom", "0.1.16", "getrandom", {}, 1)};
+
+    const QList<NimCrateCost> costs = NimDependencyCost::crateCosts(timings, metadata);
+    QStringList costLines;
+    for (const NimCrateCost &cost : costs) {
+        costLines << QString("%1 %2 %3 %4 s, %5 units%6").arg(cost.package, cost.version)
+                     .arg(featureList(cost.features)).arg(cost.cpuSeconds).arg(cost.units)
+                     .arg(cost.thirdParty ? QString() : QString(", workspace"));
+    }
+    QCOMPARE(costLines, QStringList({"rand 0.8.5 [std] 5 s, 1 units",
+                                     "serde 1.0.190 [derive, std] 4 s, 1 units",
+                                     "rand 0.7.3 [] 3 s, 1 units",
+                                     "app 0.1.0 [] 2 s, 1 units, workspace",
+                                     "serde 1.0.190 [std] 1.75 s, 2 units",
+                                     "legacy 1.0.0 [] 0.5 s, 1 units"}));
+
+    const auto duplicateLines = [](const QList<NimDuplicateCrate> &duplicates) {
+        QStringList result;
+        for (const NimDuplicateCrate &duplicate : duplicates) {
+            result << QString("%1: %2 %3 (%4) %5 s").arg(duplicate.package, duplicate.reason,
+                                                        duplicate.variants.join(" "),
+                                                        duplicate.requiredBy.join("; "))
+                      .arg(duplicate.extraCpuSeconds);
+        }
+        return result;
+    };
+    QCOMPARE(duplicateLines(NimDependencyCost::duplicates(costs, metadata)),
+             QStringList({"rand: duplicate semver versions 0.7.3 0.8.5 "
+                          "(0.7.3: legacy 1.0.0; 0.8.5: app 0.1.0) 3 s",
+                          "serde 1.0.190: divergent feature sets [derive, std] [std] "
+                          "(app 0.1.0; legacy 1.0.0) 1.75 s"}));
+
+    // Without compile times, every version in the graph counts
+    QStringList graphDuplicates = duplicateLines(NimDependencyCost::duplicates({}, metadata));
+    graphDuplicates.sort();
+    QCOMPARE(graphDuplicates,
+             QStringList({"rand: duplicate semver versions 0.7.3 0.8.5 "
+                          "(0.7.3: legacy 1.0.0; 0.8.5: app 0.1.0) 0 s",
+                          "winapi: duplicate semver versions 0.2.8 0.3.9 "
+                          "(0.2.8: legacy 1.0.0; 0.3.9: rand 0.8.5) 0 s"}));
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
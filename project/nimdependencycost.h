@@ -0,0 +1,90 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include "nimcommandsequence.h"
+#include "nimrustcwrapper.h"
+
+#include <QJsonDocument>
+#include <QObject>
+#include <QPointer>
+
+namespace Nim {
+
+class NimBuildConfiguration;
+
+class NimCrateCost
+{
+public:
+    QString package;
+    QString version;
+    QStringList features;
+    bool thirdParty = true;
+    double cpuSeconds = 0;
+    int units = 0;
+};
+
+class NimDuplicateCrate
+{
+public:
+    QString package;
+    QString reason;
+    QStringList variants;  // versions or feature sets
+    QStringList requiredBy;
+    double extraCpuSeconds = 0;
+};
+
+// Attributes the compile CPU time recorded by the rustc wrapper to crates and
+// feature sets, and finds crates compiled more than once because several
+// semver versions are resolved or because they end up with different features.
+class NimDependencyCost
+{
+public:
+    static QList<NimCrateCost> crateCosts(const QList<NimUnitTiming> &timings,
+                                          const QJsonDocument &metadata);
+    static QList<NimDuplicateCrate> duplicates(const QList<NimCrateCost> &costs,
+                                               const QJsonDocument &metadata);
+};
+
+class NimDependencyCostReport : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NimDependencyCostReport(QObject *parent = nullptr);
+
+    bool isRunning() const;
+    void run(NimBuildConfiguration *buildConfiguration);
+
+private:
+    void report(const QByteArray &metadata);
+
+    QPointer<NimBuildConfiguration> m_buildConfiguration;
+    NimCommandSequence m_sequence;
+};
+
+} // namespace Nim
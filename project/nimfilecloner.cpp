@@ -0,0 +1,253 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimfilecloner.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
+using namespace Utils;
+
+namespace Nim {
+
+#ifdef Q_OS_UNIX
+static bool copyData(int in, int out, qint64 size)
+{
+#ifdef Q_OS_LINUX
+    qint64 remaining = size;
+    while (remaining > 0) {
+        const ssize_t copied = ::copy_file_range(in, nullptr, out, nullptr, size_t(remaining), 0);
+        if (copied < 0) {
+            // Not supported across these filesystems, fall back to read/write
+            if (remaining == size && (errno == EXDEV || errno == ENOSYS || errno == EINVAL
+                                      || errno == EOPNOTSUPP))
+                break;
+            return false;
+        }
+        if (copied == 0)
+            return true;
+        remaining -= copied;
+    }
+    if (remaining == 0)
+        return true;
+#endif
+    char buffer[64 * 1024];
+    for (;;) {
+        const ssize_t bytesRead = ::read(in, buffer, sizeof(buffer));
+        if (bytesRead < 0)
+            return false;
+        if (bytesRead == 0)
+            return true;
+        for (ssize_t written = 0; written < bytesRead; ) {
+            const ssize_t n = ::write(out, buffer + written, size_t(bytesRead - written));
+            if (n < 0)
+                return false;
+            written += n;
+        }
+    }
+}
+#endif
+
+bool NimFileCloner::cloneFile(const QString &source, const QString &destination, bool *reflinked)
+{
+    *reflinked = false;
+#ifdef Q_OS_UNIX
+    const QByteArray sourcePath = QFile::encodeName(source);
+    const QByteArray destinationPath = QFile::encodeName(destination);
+
+    struct stat st;
+    if (::lstat(sourcePath.constData(), &st) != 0)
+        return false;
+
+    if (S_ISLNK(st.st_mode)) {
+        QByteArray target(int(st.st_size) + 1, '\0');
+        const ssize_t length = ::readlink(sourcePath.constData(), target.data(), size_t(target.size()));
+        if (length < 0)
+            return false;
+        target.truncate(int(length));
+        ::unlink(destinationPath.constData());
+        return ::symlink(target.constData(), destinationPath.constData()) == 0;
+    }
+
+    const int in = ::open(sourcePath.constData(), O_RDONLY | O_CLOEXEC);
+    if (in < 0)
+        return false;
+    const int out = ::open(destinationPath.constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                           st.st_mode & 07777);
+    if (out < 0) {
+        ::close(in);
+        return false;
+    }
+
+    bool ok = false;
+#ifdef Q_OS_LINUX
+    ok = ::ioctl(out, FICLONE, in) == 0;
+    *reflinked = ok;
+#endif
+    if (!ok)
+        ok = copyData(in, out, st.st_size);
+    if (ok) {
+        const struct timespec times[2] = {st.st_atim, st.st_mtim};
+        ok = ::futimens(out, times) == 0;
+    }
+    ::close(in);
+    ::close(out);
+    return ok;
+#else
+    QFile::remove(destination);
+    if (!QFile::copy(source, destination))
+        return false;
+    QFile file(destination);
+    return file.open(QIODevice::ReadWrite)
+            && file.setFileTime(QFileInfo(source).lastModified(), QFileDevice::FileModificationTime);
+#endif
+}
+
+static void addStatistics(NimCloneStatistics *statistics, const NimCloneStatistics &child)
+{
+    statistics->files += child.files;
+    statistics->reflinkedFiles += child.reflinkedFiles;
+    statistics->copiedFiles += child.copiedFiles;
+    statistics->bytes += child.bytes;
+    statistics->ok = statistics->ok && child.ok;
+}
+
+NimCloneStatistics NimFileCloner::cloneTree(const FilePath &source, const FilePath &destination)
+{
+    NimCloneStatistics statistics;
+    if (!QDir().mkpath(destination.toString())) {
+        statistics.ok = false;
+        return statistics;
+    }
+
+    const QFileInfoList entries
+            = QDir(source.toString()).entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot
+                                                    | QDir::Hidden | QDir::System);
+    for (const QFileInfo &entry : entries) {
+        const FilePath target = destination.pathAppended(entry.fileName());
+        if (entry.isDir() && !entry.isSymLink()) {
+            addStatistics(&statistics, cloneTree(FilePath::fromFileInfo(entry), target));
+            continue;
+        }
+
+        bool reflinked = false;
+        if (!cloneFile(entry.filePath(), target.toString(), &reflinked)) {
+            statistics.ok = false;
+            continue;
+        }
+        ++statistics.files;
+        ++(reflinked ? statistics.reflinkedFiles : statistics.copiedFiles);
+        if (!entry.isSymLink())
+            statistics.bytes += entry.size();
+    }
+
+#ifdef Q_OS_UNIX
+    // Directory mtimes matter less, but keep them for a faithful copy
+    struct stat st;
+    if (::stat(QFile::encodeName(source.toString()).constData(), &st) == 0) {
+        const struct timespec times[2] = {st.st_atim, st.st_mtim};
+        ::utimensat(AT_FDCWD, QFile::encodeName(destination.toString()).constData(), times, 0);
+    }
+#endif
+    return statistics;
+}
+
+NimCloneStatistics NimFileCloner::syncTree(const FilePath &source, const FilePath &destination,
+                                           const QStringList &deferredNames,
+                                           const std::atomic_bool *canceled)
+{
+    NimCloneStatistics statistics;
+    if (!QDir().mkpath(destination.toString())) {
+        statistics.ok = false;
+        return statistics;
+    }
+
+    QFileInfoList entries
+            = QDir(source.toString()).entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot
+                                                    | QDir::Hidden | QDir::System);
+    std::stable_partition(entries.begin(), entries.end(), [&deferredNames](const QFileInfo &entry) {
+        return !deferredNames.contains(entry.fileName());
+    });
+
+    for (const QFileInfo &entry : qAsConst(entries)) {
+        if (canceled && *canceled) {
+            statistics.ok = false;
+            break;
+        }
+        const FilePath target = destination.pathAppended(entry.fileName());
+        if (entry.isDir() && !entry.isSymLink()) {
+            addStatistics(&statistics, syncTree(FilePath::fromFileInfo(entry), target,
+                                                deferredNames, canceled));
+            continue;
+        }
+
+        const QFileInfo existing = target.toFileInfo();
+        if (existing.exists() && existing.size() == entry.size()
+                && existing.lastModified() == entry.lastModified()) {
+            continue;
+        }
+        bool reflinked = false;
+        if (!cloneFile(entry.filePath(), target.toString(), &reflinked)) {
+            statistics.ok = false;
+            continue;
+        }
+        ++statistics.files;
+        ++(reflinked ? statistics.reflinkedFiles : statistics.copiedFiles);
+        if (!entry.isSymLink())
+            statistics.bytes += entry.size();
+    }
+    return statistics;
+}
+
+qint64 NimFileCloner::freeBytes(const FilePath &path)
+{
+#ifdef Q_OS_UNIX
+    struct statvfs st;
+    if (::statvfs(QFile::encodeName(path.toString()).constData(), &st) != 0)
+        return 0;
+    return qint64(st.f_bavail) * qint64(st.f_frsize);
+#else
+    Q_UNUSED(path)
+    return 0;
+#endif
+}
+
+} // namespace Nim
@@ -0,0 +1,69 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include <utils/fileutils.h>
+
+#include <atomic>
+
+namespace Nim {
+
+class NimCloneStatistics
+{
+public:
+    int files = 0;
+    int reflinkedFiles = 0;  // shared extents, no data copied
+    int copiedFiles = 0;     // copy_file_range or plain read/write
+    qint64 bytes = 0;        // apparent size of all files
+    bool ok = true;
+};
+
+// Copies directory trees preserving modes and modification times, which Cargo
+// relies on for its freshness checks. Files are cloned with FICLONE where the
+// filesystem supports it (btrfs, XFS, bcachefs) so that a copy only costs
+// metadata, and fall back to copy_file_range, which lets the kernel copy
+// in-place on NFS and other filesystems with server-side copy.
+class NimFileCloner
+{
+public:
+    static NimCloneStatistics cloneTree(const Utils::FilePath &source,
+                                        const Utils::FilePath &destination);
+    static bool cloneFile(const QString &source, const QString &destination, bool *reflinked);
+
+    // Copies files that are missing or differ in size or modification time,
+    // never deletes anything. Entries named in deferredNames are handled
+    // after their siblings, so that an interrupted sync leaves them stale.
+    static NimCloneStatistics syncTree(const Utils::FilePath &source,
+                                       const Utils::FilePath &destination,
+                                       const QStringList &deferredNames = {},
+                                       const std::atomic_bool *canceled = nullptr);
+
+    // Free bytes on the filesystem holding path, to measure the real cost of a copy
+    static qint64 freeBytes(const Utils::FilePath &path);
+};
+
+} // namespace Nim
@@ -0,0 +1,362 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimfingerprintparser.h"
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QRegularExpression>
+#include <QSet>
+
+#include <algorithm>
+
+namespace Nim {
+
+const char BUILD_SCRIPT_TARGET[] = "build-script-build";
+const char BUILD_SCRIPT_CRATE[] = "build_script_build";
+
+static QString tr(const char *text)
+{
+    return QCoreApplication::translate("Nim::NimFingerprintParser", text);
+}
+
+static QString crateName(const QString &target)
+{
+    return QString(target).replace('-', '_');
+}
+
+QString NimRebuiltUnit::displayName() const
+{
+    if (buildScript)
+        return tr("%1 (build script)").arg(package);
+    if (crateName(target) == crateName(package))
+        return package;
+    return QString("%1 (%2)").arg(package, target);
+}
+
+static QString firstCapture(const QString &text, const QStringList &patterns)
+{
+    for (const QString &pattern : patterns) {
+        const QRegularExpressionMatch match = QRegularExpression(pattern).match(text);
+        if (match.hasMatch())
+            return match.captured(1);
+    }
+    return QString();
+}
+
+bool NimFingerprintParser::addLine(const QString &line)
+{
+    if (!line.contains("cargo::core::compiler::fingerprint"))
+        return false;
+
+    // Tracing format: the unit is part of the span on every line
+    static const QRegularExpression spanPattern(
+                R"(package_id=(\S+) v\S+(?: \([^)]*\))?\s+target="([^"]+)")");
+    // env_logger format: a header line, then indented details
+    static const QRegularExpression headerPattern(
+                R"(fingerprint (?:error|dirty) for (\S+) v\S+.*?(?:name: "|_target\(")([^"]+)")");
+
+    QRegularExpressionMatch match = spanPattern.match(line);
+    const bool inSpan = match.hasMatch();
+    if (inSpan) {
+        m_currentUnit = unitIndex(match.captured(1), match.captured(2));
+    } else {
+        match = headerPattern.match(line);
+        if (match.hasMatch()) {
+            m_currentUnit = unitIndex(match.captured(1), match.captured(2));
+            if (!m_pendingCause.isEmpty())
+                setCause(&m_units[m_currentUnit], m_pendingCause);
+            m_pendingCause.clear();
+            return true;
+        }
+    }
+
+    static const QRegularExpression reasonPattern(R"(\b(dirty|err|stale): (.*)$)");
+    match = reasonPattern.match(line);
+    if (!match.hasMatch())
+        return true;
+    const QString reason = match.captured(2).trimmed();
+    // Without a span the stale file is logged before the header of its unit
+    if (!inSpan && match.captured(1) == "stale") {
+        if (m_pendingCause.isEmpty())
+            m_pendingCause = reason;
+    } else if (m_currentUnit >= 0) {
+        setCause(&m_units[m_currentUnit], reason);
+    }
+    return true;
+}
+
+void NimFingerprintParser::clear()
+{
+    m_units.clear();
+    m_unitIndexes.clear();
+    m_currentUnit = -1;
+    m_pendingCause.clear();
+}
+
+QList<NimRebuiltUnit> NimFingerprintParser::units() const
+{
+    return m_units;
+}
+
+int NimFingerprintParser::unitIndex(const QString &package, const QString &target)
+{
+    const QString key = package + '/' + target;
+    auto it = m_unitIndexes.constFind(key);
+    if (it != m_unitIndexes.constEnd())
+        return it.value();
+
+    NimRebuiltUnit unit;
+    unit.package = package;
+    unit.target = target;
+    unit.buildScript = target == BUILD_SCRIPT_TARGET;
+    m_unitIndexes.insert(key, m_units.size());
+    m_units.append(unit);
+    return m_units.size() - 1;
+}
+
+void NimFingerprintParser::setCause(NimRebuiltUnit *unit, const QString &message)
+{
+    // Keep the first specific reason, Cargo logs the generic ones first
+    if (!unit->cause.isEmpty() || !unit->dependency.isEmpty())
+        return;
+
+    const QString dependency = firstCapture(message, {
+        R"(StaleDependency \{ name: "([^"]+)")",
+        R"(StaleDepFingerprint \{ name: "([^"]+)")",
+        R"(UnitDependencyInfoChanged \{.*new_name: "([^"]+)")",
+        R"(current dependency `?([^`\s]+)`? .*(?:newer|changed))"
+    });
+    if (!dependency.isEmpty()) {
+        unit->dependency = dependency;
+        return;
+    }
+
+    const QString variable = firstCapture(message, {
+        R"(EnvVarChanged \{ name: "([^"]+)")",
+        R"(ChangedEnv \{ var: "([^"]+)")",
+        R"(env var `([^`]+)` changed)"
+    });
+    if (!variable.isEmpty()) {
+        unit->cause = tr("env var %1").arg(variable);
+        return;
+    }
+
+    const QString file = firstCapture(message, {
+        R"(ChangedFile \{.*stale: "([^"]+)")",
+        R"(^changed "([^"]+)")"
+    });
+    if (!file.isEmpty()) {
+        unit->cause = unit->buildScript ? tr("rerun-if-changed %1").arg(file)
+                                        : tr("file changed: %1").arg(file);
+        return;
+    }
+
+    static const QList<QPair<QString, const char *>> kinds = {
+        {"MissingFile", QT_TRANSLATE_NOOP("Nim::NimFingerprintParser", "not built yet")},
+        {"failed to read", QT_TRANSLATE_NOOP("Nim::NimFingerprintParser", "not built yet")},
+        {"RustflagsChanged", QT_TRANSLATE_NOOP("Nim::NimFingerprintParser", "RUSTFLAGS changed")},
+        {"RUSTFLAGS has changed", QT_TRANSLATE_NOOP("Nim::NimFingerprintParser", "RUSTFLAGS changed")},
+        {"RustcChanged", QT_TRANSLATE_NOOP("Nim::NimFingerprintParser", "rustc changed")},
+        {"FeaturesChanged", QT_TRANSLATE_NOOP("Nim::NimFingerprintParser", "features changed")},
+        {"DeclaredFeaturesChanged", QT_TRANSLATE_NOOP("Nim::NimFingerprintParser", "features changed")},
+        {"ProfileConfigurationChanged", QT_TRANSLATE_NOOP("Nim::NimFingerprintParser", "profile changed")},
+        {"TargetConfigurationChanged", QT_TRANSLATE_NOOP("Nim::NimFingerprintParser", "target configuration changed")},
+        {"ConfigSettingsChanged", QT_TRANSLATE_NOOP("Nim::NimFingerprintParser", "cfg settings changed")},
+        {"PathToSourceChanged", QT_TRANSLATE_NOOP("Nim::NimFingerprintParser", "source path changed")},
+        {"PrecalculatedComponentsChanged", QT_TRANSLATE_NOOP("Nim::NimFingerprintParser", "package version changed")},
+        {"LocalLengthsChanged", QT_TRANSLATE_NOOP("Nim::NimFingerprintParser", "rerun-if declarations changed")},
+        {"RerunIfChangedOutput", QT_TRANSLATE_NOOP("Nim::NimFingerprintParser", "rerun-if declarations changed")},
+        {"EnvVarsChanged", QT_TRANSLATE_NOOP("Nim::NimFingerprintParser", "environment changed")},
+        {"Forced", QT_TRANSLATE_NOOP("Nim::NimFingerprintParser", "forced")},
+    };
+    for (const QPair<QString, const char *> &kind : kinds) {
+        if (message.contains(kind.first)) {
+            unit->cause = tr(kind.second);
+            return;
+        }
+    }
+
+    // "current filesystem status shows we're outdated" and the like are
+    // followed by the details
+    if (message.startsWith("FsStatusOutdated") || message.contains("outdated")
+            || message.startsWith("NothingObvious")) {
+        return;
+    }
+    unit->cause = message.section(QRegularExpression("[ ({]"), 0, 0);
+}
+
+QList<NimRebuildCause> NimFingerprintParser::rootCauses() const
+{
+    // Who depends on whom, by the crate name Cargo logs for stale dependencies
+    QHash<QString, QList<int>> dependents;
+    for (int i = 0; i < m_units.size(); ++i) {
+        const NimRebuiltUnit &unit = m_units.at(i);
+        if (unit.dependency.isEmpty())
+            continue;
+        const QString key = unit.dependency == BUILD_SCRIPT_CRATE
+                ? unit.package + '/' + BUILD_SCRIPT_CRATE : unit.dependency;
+        dependents[key].append(i);
+    }
+    const auto keyOf = [](const NimRebuiltUnit &unit) {
+        return unit.buildScript ? unit.package + '/' + BUILD_SCRIPT_CRATE : crateName(unit.target);
+    };
+
+    QMap<QString, NimRebuildCause> causes;
+    for (const NimRebuiltUnit &unit : m_units) {
+        if (unit.cause.isEmpty())
+            continue;
+
+        QSet<int> affected;
+        QList<QString> queue = {keyOf(unit)};
+        while (!queue.isEmpty()) {
+            for (int dependent : dependents.value(queue.takeFirst())) {
+                if (affected.contains(dependent))
+                    continue;
+                affected.insert(dependent);
+                queue.append(keyOf(m_units.at(dependent)));
+            }
+        }
+
+        const QString label = unit.buildScript
+                ? tr("build script of %1: %2").arg(unit.package, unit.cause) : unit.cause;
+        NimRebuildCause &cause = causes[label];
+        if (cause.cause.isEmpty()) {
+            cause.cause = label;
+            cause.origin = unit.displayName();
+            cause.buildScript = unit.buildScript;
+            cause.environment = unit.cause.startsWith(tr("env var"))
+                    || unit.cause == tr("RUSTFLAGS changed");
+        }
+        cause.units += 1 + affected.size();
+    }
+
+    QList<NimRebuildCause> result = causes.values();
+    std::stable_sort(result.begin(), result.end(), [](const NimRebuildCause &a, const NimRebuildCause &b) {
+        return a.units > b.units;
+    });
+    return result;
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QTest>
+
+namespace Nim {
+
+void RustPlugin::testFingerprintParser_data()
+{
+    QTest::addColumn<QStringList>("lines");
+    QTest::addColumn<QStringList>("units");
+    QTest::addColumn<QStringList>("rootCauses");
+
+    // Cargo 1.52 and later
+    const auto tracing = [](const QString &package, const QString &target, const QString &message) {
+        return QString("   0.120843s  INFO prepare_target{force=false package_id=%1 v0.1.0 (/tmp/w/%1) "
+                       "target=\"%2\"}: cargo::core::compiler::fingerprint: %3")
+                .arg(package, target, message);
+    };
+    // Older releases
+    const auto envLogger = [](const QString &message) {
+        return "[2020-05-01T10:00:00Z INFO  cargo::core::compiler::fingerprint] " + message;
+    };
+
+    QTest::newRow("tracing, changed file")
+            << QStringList({"   Compiling foo v0.1.0 (/tmp/w/foo)",
+                            tracing("foo", "foo", "stale: changed \"/tmp/w/foo/src/lib.rs\""),
+                            tracing("foo", "foo", "          (vs) \"/tmp/w/target/debug/.fingerprint/foo-1/dep-lib-foo\""),
+                            tracing("foo", "foo", "dirty: FsStatusOutdated(StaleItem(ChangedFile { "
+                                                  "reference: \"/tmp/w/target/debug/.fingerprint/foo-1/dep-lib-foo\", "
+                                                  "stale: \"/tmp/w/foo/src/lib.rs\" }))"),
+                            tracing("bar", "bar", "dirty: UnitDependencyInfoChanged { old_name: \"foo\", "
+                                                  "old_fingerprint: 1, new_name: \"foo\", new_fingerprint: 2 }"),
+                            tracing("app", "app", "dirty: StaleDepFingerprint { name: \"bar\" }")})
+            << QStringList({"foo: file changed: /tmp/w/foo/src/lib.rs", "bar <- foo", "app <- bar"})
+            << QStringList({"file changed: /tmp/w/foo/src/lib.rs (foo): 3"});
+
+    QTest::newRow("tracing, build script environment")
+            << QStringList({tracing("sys", "build-script-build", "dirty: EnvVarChanged { name: \"SYS_LIB_DIR\", "
+                                                                 "old_value: None, new_value: Some(\"/opt/sys\") }"),
+                            tracing("sys", "sys", "dirty: StaleDepFingerprint { name: \"build_script_build\" }"),
+                            tracing("app", "app", "dirty: StaleDepFingerprint { name: \"sys\" }")})
+            << QStringList({"sys (build script): env var SYS_LIB_DIR", "sys <- build_script_build", "app <- sys"})
+            << QStringList({"build script of sys: env var SYS_LIB_DIR (sys (build script)): 3"});
+
+    QTest::newRow("env_logger, changed file")
+            << QStringList({envLogger("stale: changed \"/tmp/w/src/lib.rs\""),
+                            envLogger("          (vs) \"/tmp/w/target/debug/.fingerprint/w-1/dep-lib-w\""),
+                            envLogger("fingerprint error for w v0.1.0 (/tmp/w)/Build/Target::lib_target(\"w\", "
+                                      "[\"lib\"], \"/tmp/w/src/lib.rs\", Edition2018)"),
+                            envLogger("    err: current filesystem status shows we're outdated"),
+                            envLogger("fingerprint error for w v0.1.0 (/tmp/w)/Build/Target::bin_target(\"w-cli\", "
+                                      "\"/tmp/w/src/bin/cli.rs\", None, Edition2018)"),
+                            envLogger("    err: current dependency `w` is newer than the target")})
+            << QStringList({"w: file changed: /tmp/w/src/lib.rs", "w (w-cli) <- w"})
+            << QStringList({"file changed: /tmp/w/src/lib.rs (w): 2"});
+
+    QTest::newRow("env_logger, build script environment")
+            << QStringList({envLogger("fingerprint dirty for sys v0.2.0/RunCustomBuild/TargetInner { "
+                                      "name: \"build-script-build\", doc: false }"),
+                            envLogger("    dirty: EnvVarChanged { name: \"SYS_LIB_DIR\", old_value: None, "
+                                      "new_value: Some(\"/opt/sys\") }")})
+            << QStringList({"sys (build script): env var SYS_LIB_DIR"})
+            << QStringList({"build script of sys: env var SYS_LIB_DIR (sys (build script)): 1"});
+
+    QTest::newRow("other output")
+            << QStringList({"   Compiling foo v0.1.0 (/tmp/w/foo)", "warning: unused variable: `x`"})
+            << QStringList() << QStringList();
+}
+
+void RustPlugin::testFingerprintParser()
+{
+    QFETCH(QStringList, lines);
+    QFETCH(QStringList, units);
+    QFETCH(QStringList, rootCauses);
+
+    NimFingerprintParser parser;
+    for (const QString &line : qAsConst(lines))
+        parser.addLine(line);
+
+    QStringList parsedUnits;
+    for (const NimRebuiltUnit &unit : parser.units()) {
+        parsedUnits << (unit.dependency.isEmpty() ? unit.displayName() + ": " + unit.cause
+                                                  : unit.displayName() + " <- " + unit.dependency);
+    }
+    QCOMPARE(parsedUnits, units);
+
+    QStringList parsedCauses;
+    for (const NimRebuildCause &cause : parser.rootCauses())
+        parsedCauses << QString("%1 (%2): %3").arg(cause.cause, cause.origin).arg(cause.units);
+    QCOMPARE(parsedCauses, rootCauses);
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
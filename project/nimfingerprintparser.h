@@ -0,0 +1,84 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include <QList>
+#include <QMap>
+#include <QString>
+
+namespace Nim {
+
+// One unit Cargo decided to rebuild and the first reason it logged
+class NimRebuiltUnit
+{
+public:
+    QString package;
+    QString target;
+    bool buildScript = false;
+    QString cause;      // e.g. "env var FOO" or "file changed: src/lib.rs"
+    QString dependency; // set instead of a cause if a dependency was rebuilt
+
+    QString displayName() const;
+};
+
+class NimRebuildCause
+{
+public:
+    QString cause;
+    QString origin;     // the unit the cause was found for
+    bool buildScript = false;
+    bool environment = false;
+    int units = 0;      // the origin and everything rebuilt because of it
+};
+
+// Parses the output of CARGO_LOG=cargo::core::compiler::fingerprint=info,
+// both the tracing format of current Cargo and the env_logger format of
+// older releases.
+class NimFingerprintParser
+{
+public:
+    // Returns false if the line is not a fingerprint log line
+    bool addLine(const QString &line);
+    void clear();
+
+    QList<NimRebuiltUnit> units() const;
+
+    // Causes found for units without a stale dependency, with the number of
+    // units rebuilt transitively because of them, most expensive first
+    QList<NimRebuildCause> rootCauses() const;
+
+private:
+    int unitIndex(const QString &package, const QString &target);
+    void setCause(NimRebuiltUnit *unit, const QString &message);
+
+    QList<NimRebuiltUnit> m_units;
+    QMap<QString, int> m_unitIndexes;
+    int m_currentUnit = -1;
+    QString m_pendingCause;
+};
+
+} // namespace Nim
@@ -0,0 +1,54 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimgit.h"
+
+#include <QProcess>
+
+using namespace Utils;
+
+namespace Nim {
+
+const int GIT_TIMEOUT_MS = 30000;
+
+QByteArray NimGit::run(const FilePath &workingDirectory, const QStringList &arguments)
+{
+    QProcess git;
+    git.setWorkingDirectory(workingDirectory.toString());
+    git.start("git", arguments);
+    if (!git.waitForFinished(GIT_TIMEOUT_MS) || git.exitStatus() != QProcess::NormalExit
+            || git.exitCode() != 0) {
+        return QByteArray();
+    }
+    return git.readAllStandardOutput();
+}
+
+QString NimGit::output(const FilePath &workingDirectory, const QStringList &arguments)
+{
+    return QString::fromUtf8(run(workingDirectory, arguments)).trimmed();
+}
+
+} // namespace Nim
@@ -0,0 +1,207 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimlinktimes.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QMap>
+#include <QRegularExpression>
+
+#include <algorithm>
+
+using namespace Utils;
+
+namespace Nim {
+
+const int REGRESSION_WINDOW = 10;
+const int MIN_REGRESSION_HISTORY = 3;
+const double REGRESSION_FACTOR = 1.25;
+const double MIN_REGRESSION_SECONDS = 0.2;
+
+QVariantMap NimLinkTime::toMap() const
+{
+    QVariantMap map;
+    map["target"] = target;
+    map["linker"] = linker;
+    map["seconds"] = seconds;
+    map["success"] = success;
+    map["finished"] = finished;
+    return map;
+}
+
+NimLinkTime NimLinkTime::fromMap(const QVariantMap &map)
+{
+    NimLinkTime link;
+    link.target = map["target"].toString();
+    link.linker = map["linker"].toString();
+    link.seconds = map["seconds"].toDouble();
+    link.success = map["success"].toBool();
+    link.finished = map["finished"].toDateTime();
+    return link;
+}
+
+QList<NimLinkTime> NimLinkTimes::fromLog(const FilePath &logFile, const QString &linker)
+{
+    // e.g. target/debug/deps/server-1f2e3d4c5b6a7988 or libmacros-0a1b2c3d4e5f6789.so
+    static const QRegularExpression hashSuffix("-[0-9a-f]{16}(?=\\.|$)");
+    QList<NimLinkTime> result;
+    QFile file(logFile.toString());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return result;
+    const QDateTime finished = QDateTime::currentDateTime();
+    while (!file.atEnd()) {
+        const QList<QByteArray> fields = file.readLine().trimmed().split('\t');
+        if (fields.size() != 3)
+            continue;
+        NimLinkTime link;
+        link.target = FilePath::fromString(QString::fromLocal8Bit(fields.at(0))).fileName();
+        link.target.remove(hashSuffix);
+        if (link.target.isEmpty() || link.target.startsWith("build_script_"))
+            continue;
+        link.linker = linker;
+        link.seconds = fields.at(1).toDouble();
+        link.success = fields.at(2) == "0";
+        link.finished = finished;
+        result.append(link);
+    }
+    return result;
+}
+
+static double median(QList<double> values)
+{
+    std::sort(values.begin(), values.end());
+    const int middle = values.size() / 2;
+    return values.size() % 2 ? values.at(middle) : (values.at(middle - 1) + values.at(middle)) / 2;
+}
+
+QString NimLinkTimes::regression(const QList<NimLinkTime> &history, const NimLinkTime &link)
+{
+    if (!link.success)
+        return QString();
+    QList<double> recent;
+    for (auto it = history.crbegin(); it != history.crend() && recent.size() < REGRESSION_WINDOW; ++it) {
+        if (it->success && it->target == link.target && it->linker == link.linker)
+            recent.append(it->seconds);
+    }
+    if (recent.size() < MIN_REGRESSION_HISTORY)
+        return QString();
+    const double typical = median(recent);
+    if (link.seconds < typical * REGRESSION_FACTOR || link.seconds - typical < MIN_REGRESSION_SECONDS)
+        return QString();
+    return QCoreApplication::translate("Nim::NimLinkTimes",
+                                       "Linking %1 took %2 s, %3% more than the median of its "
+                                       "last %4 links with %5.")
+            .arg(link.target).arg(link.seconds, 0, 'f', 2)
+            .arg(qRound(100 * (link.seconds / typical - 1))).arg(recent.size()).arg(link.linker);
+}
+
+QStringList NimLinkTimes::summary(const QList<NimLinkTime> &history)
+{
+    QMap<QPair<QString, QString>, QList<NimLinkTime>> links;
+    for (const NimLinkTime &link : history) {
+        if (link.success)
+            links[{link.target, link.linker}].append(link);
+    }
+
+    QStringList lines;
+    for (auto it = links.cbegin(); it != links.cend(); ++it) {
+        const QList<NimLinkTime> &targetLinks = it.value();
+        QList<double> seconds;
+        for (const NimLinkTime &link : targetLinks)
+            seconds.append(link.seconds);
+        lines << QCoreApplication::translate("Nim::NimLinkTimes",
+                                             "%1 with %2: %3 links since %4, first %5 s, "
+                                             "median %6 s, latest %7 s.")
+                 .arg(it.key().first, it.key().second).arg(targetLinks.size())
+                 .arg(targetLinks.first().finished.toString(Qt::ISODate))
+                 .arg(targetLinks.first().seconds, 0, 'f', 2)
+                 .arg(median(seconds), 0, 'f', 2)
+                 .arg(targetLinks.last().seconds, 0, 'f', 2);
+    }
+    return lines;
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace Nim {
+
+void RustPlugin::testLinkTimes()
+{
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    const FilePath logFile = FilePath::fromString(directory.filePath("link-times.log"));
+    QFile file(logFile.toString());
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("/tmp/w/target/debug/deps/server-1f2e3d4c5b6a7988\t1.50\t0\n"
+               "/tmp/w/target/debug/build/foo-0123456789abcdef/build_script_build-0123456789abcdef\t0.30\t0\n"
+               "/tmp/w/target/debug/deps/libmacros-0a1b2c3d4e5f6789.so\t0.80\t1\n"
+               "not a link\n");
+    file.close();
+    const QList<NimLinkTime> links = NimLinkTimes::fromLog(logFile, "lld");
+    QCOMPARE(links.size(), 2);
+    QCOMPARE(links.at(0).target, QString("server"));
+    QCOMPARE(links.at(0).linker, QString("lld"));
+    QCOMPARE(links.at(0).seconds, 1.5);
+    QVERIFY(links.at(0).success);
+    QCOMPARE(links.at(1).target, QString("libmacros.so"));
+    QVERIFY(!links.at(1).success);
+
+    const auto link = [](const QString &target, const QString &linker, double seconds, bool success = true) {
+        NimLinkTime result;
+        result.target = target;
+        result.linker = linker;
+        result.seconds = seconds;
+        result.success = success;
+        return result;
+    };
+    const QList<NimLinkTime> history = {link("server", "lld", 1.0), link("server", "lld", 1.1),
+                                        link("server", "lld", 0.9), link("server", "lld", 5.0, false),
+                                        link("server", "lld", 1.0), link("tiny", "lld", 0.1),
+                                        link("tiny", "lld", 0.1), link("tiny", "lld", 0.1),
+                                        link("client", "lld", 1.0), link("client", "lld", 1.0)};
+    QCOMPARE(NimLinkTimes::regression(history, link("server", "lld", 1.5)),
+             QString("Linking server took 1.50 s, 50% more than the median of its last 4 links with lld."));
+    // Within the usual spread
+    QVERIFY(NimLinkTimes::regression(history, link("server", "lld", 1.2)).isEmpty());
+    // Failed links and other linkers do not count
+    QVERIFY(NimLinkTimes::regression(history, link("server", "lld", 3.0, false)).isEmpty());
+    QVERIFY(NimLinkTimes::regression(history, link("server", "mold", 3.0)).isEmpty());
+    // Too little time to notice, too few links to tell
+    QVERIFY(NimLinkTimes::regression(history, link("tiny", "lld", 0.25)).isEmpty());
+    QVERIFY(NimLinkTimes::regression(history, link("client", "lld", 3.0)).isEmpty());
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
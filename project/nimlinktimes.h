@@ -0,0 +1,64 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include <utils/fileutils.h>
+
+#include <QDateTime>
+#include <QVariantMap>
+
+namespace Nim {
+
+class NimLinkTime
+{
+public:
+    QString target;  // output file name without Cargo's metadata hash
+    QString linker;
+    double seconds = 0;
+    bool success = true;
+    QDateTime finished;
+
+    QVariantMap toMap() const;
+    static NimLinkTime fromMap(const QVariantMap &map);
+};
+
+// Link times recorded by scripts/linker-wrapper.sh and their history
+class NimLinkTimes
+{
+public:
+    // The links of one build, build scripts left out
+    static QList<NimLinkTime> fromLog(const Utils::FilePath &logFile, const QString &linker);
+
+    // A warning if link is much slower than the recent links of the same
+    // target with the same linker, empty otherwise
+    static QString regression(const QList<NimLinkTime> &history, const NimLinkTime &link);
+
+    // One line per target and linker: count, first, median and latest time
+    static QStringList summary(const QList<NimLinkTime> &history);
+};
+
+} // namespace Nim
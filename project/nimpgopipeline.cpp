@@ -0,0 +1,388 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimpgopipeline.h"
+
+#include "nimbuildconfiguration.h"
+#include "nimcargomessages.h"
+#include "nimdatadirectory.h"
+#include "nimrunconfiguration.h"
+
+#include "../nimconstants.h"
+
+#include <coreplugin/messagemanager.h>
+#include <projectexplorer/kitinformation.h>
+#include <projectexplorer/project.h>
+#include <projectexplorer/runcontrol.h>
+#include <projectexplorer/target.h>
+#include <projectexplorer/toolchain.h>
+#include <utils/algorithm.h>
+#include <utils/hostosinfo.h>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <numeric>
+
+using namespace ProjectExplorer;
+using namespace Utils;
+
+namespace Nim {
+
+const int BENCHMARK_RUNS = 3;
+const int MAX_CACHED_PROFILES = 4;
+
+NimPgoPipeline::NimPgoPipeline(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_sequence, &NimCommandSequence::message, this, [](const QString &message) {
+        Core::MessageManager::write(message);
+    });
+}
+
+bool NimPgoPipeline::isRunning() const
+{
+    return m_sequence.isRunning();
+}
+
+static void hashSources(const QDir &directory, const QString &buildDirectory,
+                        QCryptographicHash &hash, const QDir &projectDirectory)
+{
+    const QFileInfoList entries = directory.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot,
+                                                          QDir::Name);
+    for (const QFileInfo &entry : entries) {
+        if (entry.isDir()) {
+            // Cargo's default target directory also holds generated sources, and
+            // the data directory and the directories next to the build
+            // directory have copies of them
+            const QString path = entry.absoluteFilePath();
+            if (entry.fileName() != "target" && !entry.fileName().startsWith('.')
+                    && path != buildDirectory && !path.startsWith(buildDirectory + '-')) {
+                hashSources(QDir(path), buildDirectory, hash, projectDirectory);
+            }
+            continue;
+        }
+        if (entry.suffix() != "rs" && entry.fileName() != "Cargo.toml" && entry.fileName() != "Cargo.lock")
+            continue;
+        QFile file(entry.absoluteFilePath());
+        if (!file.open(QIODevice::ReadOnly))
+            continue;
+        hash.addData(projectDirectory.relativeFilePath(entry.absoluteFilePath()).toUtf8());
+        hash.addData("\0", 1);
+        hash.addData(&file);
+    }
+}
+
+QString NimPgoPipeline::sourceHash(const FilePath &projectDirectory, const FilePath &buildDirectory)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const QDir root(projectDirectory.toString());
+    hashSources(root, QDir(buildDirectory.toString()).absolutePath(), hash, root);
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+FilePath NimPgoPipeline::stateDirectory() const
+{
+    return NimDataDirectory::forBuildConfiguration(m_buildConfiguration).pathAppended("pgo");
+}
+
+FilePath NimPgoPipeline::workDirectory() const
+{
+    return NimDataDirectory::besideBuildDirectory(m_buildConfiguration, "pgo");
+}
+
+FilePath NimPgoPipeline::profileFile() const
+{
+    return stateDirectory().pathAppended("profiles/" + m_sourceHash + ".profdata");
+}
+
+static QJsonObject readState(const FilePath &path)
+{
+    QFile file(path.toString());
+    if (!file.open(QIODevice::ReadOnly))
+        return QJsonObject();
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+bool NimPgoPipeline::isTrained() const
+{
+    const QJsonObject state = readState(stateDirectory().pathAppended("state.json"));
+    return state["sourceHash"].toString() == m_sourceHash && state["trained"].toBool();
+}
+
+void NimPgoPipeline::setTrained(bool trained)
+{
+    QJsonObject state;
+    state["sourceHash"] = m_sourceHash;
+    state["trained"] = trained;
+    QFile file(stateDirectory().pathAppended("state.json").toString());
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        file.write(QJsonDocument(state).toJson());
+}
+
+void NimPgoPipeline::run(NimBuildConfiguration *buildConfiguration)
+{
+    if (isRunning() || !buildConfiguration)
+        return;
+    ToolChain *toolChain = ToolChainKitAspect::toolChain(buildConfiguration->target()->kit(),
+                                                         Constants::C_NIMLANGUAGE_ID);
+    if (!toolChain) {
+        Core::MessageManager::write(tr("Profile-guided optimization needs a Rust tool chain."));
+        return;
+    }
+
+    m_buildConfiguration = buildConfiguration;
+    m_cargo = toolChain->compilerCommand();
+    m_sourceHash = sourceHash(buildConfiguration->project()->projectDirectory(),
+                              buildConfiguration->buildDirectory());
+    m_instrumentedExecutable.clear();
+    m_optimizedExecutable.clear();
+    m_baselineExecutable.clear();
+    m_optimizedSeconds.clear();
+    m_baselineSeconds.clear();
+    QDir().mkpath(stateDirectory().pathAppended("profiles").toString());
+
+    if (profileFile().exists()) {
+        Core::MessageManager::write(tr("Using the cached profile of the sources %1.")
+                                        .arg(m_sourceHash.left(12)));
+        addOptimizedBuilds();
+    } else if (isTrained()) {
+        Core::MessageManager::write(tr("Resuming profile-guided optimization with the training "
+                                       "profiles of an earlier run."));
+        addMerge();
+    } else {
+        Core::MessageManager::write(tr("Building an instrumented binary for profile-guided optimization..."));
+        setTrained(false);
+        addBuild("instrumented",
+                 "-Cprofile-generate=" + workDirectory().pathAppended("raw").toString(),
+                 &m_instrumentedExecutable);
+        m_sequence.addAction([this] { addTraining(); });
+    }
+    m_sequence.start();
+}
+
+void NimPgoPipeline::addBuild(const QString &name, const QString &rustFlags, FilePath *executable)
+{
+    const FilePath projectDirectory = m_buildConfiguration->project()->projectDirectory();
+    Environment environment = m_buildConfiguration->environment();
+    const QString flags = environment.value("RUSTFLAGS");
+    if (!rustFlags.isEmpty())
+        environment.set("RUSTFLAGS", flags.isEmpty() ? rustFlags : flags + ' ' + rustFlags);
+    m_sequence.addAction([this, environment, projectDirectory] {
+        m_sequence.setEnvironment(environment);
+        m_sequence.setWorkingDirectory(projectDirectory);
+    });
+
+    // Profile-guided optimization only pays off for optimized code
+    CommandLine build(m_cargo, {"build", "--release"});
+    build.addArg("--target-dir=" + workDirectory().pathAppended(name).toString());
+    build.addArg("--manifest-path=" + m_buildConfiguration->project()->projectFilePath().toString());
+    build.addArg("--message-format=json-render-diagnostics");
+    const QString binaryName = m_buildConfiguration->outFilePath().fileName();
+    m_sequence.addCommand(build, [executable, binaryName](const NimCommandResult &result) {
+        *executable = NimCargoMessages::binary(NimCargoMessages::executables(result.standardOutput),
+                                               binaryName).path;
+    });
+    m_sequence.addAction([this, executable, name] {
+        if (executable->isEmpty()) {
+            Core::MessageManager::write(tr("The %1 build produced no binary to run.").arg(name));
+            m_sequence.cancel();
+        }
+    });
+}
+
+// The run configurations with their own executable replaced by the given one
+static QList<Runnable> runnables(Target *target, bool training, const FilePath &executable)
+{
+    QList<RunConfiguration *> configurations;
+    if (training) {
+        configurations = Utils::filtered(target->runConfigurations(), [](RunConfiguration *rc) {
+            return qobject_cast<NimPgoTrainingRunConfiguration *>(rc) != nullptr;
+        });
+    }
+    if (configurations.isEmpty() && target->activeRunConfiguration())
+        configurations.append(target->activeRunConfiguration());
+
+    QList<Runnable> result;
+    for (RunConfiguration *configuration : configurations) {
+        Runnable runnable = configuration->runnable();
+        runnable.executable = executable;
+        if (runnable.workingDirectory.isEmpty())
+            runnable.workingDirectory = target->project()->projectDirectory().toString();
+        result.append(runnable);
+    }
+    return result;
+}
+
+void NimPgoPipeline::addTraining()
+{
+    if (!m_buildConfiguration)
+        return;
+    const QList<Runnable> trainingRuns = runnables(m_buildConfiguration->target(), true,
+                                                   m_instrumentedExecutable);
+    if (trainingRuns.isEmpty()) {
+        Core::MessageManager::write(tr("There is no run configuration to train with. Add a "
+                                       "\"PGO Training Run\" or select a run configuration."));
+        return;
+    }
+
+    const FilePath rawDirectory = workDirectory().pathAppended("raw");
+    m_sequence.addAction([rawDirectory] { QDir(rawDirectory.toString()).removeRecursively(); });
+    for (const Runnable &runnable : trainingRuns) {
+        m_sequence.addAction([this, runnable] {
+            Core::MessageManager::write(tr("Training with %1 %2...")
+                                            .arg(runnable.executable.toUserOutput(),
+                                                 runnable.commandLineArguments));
+            m_sequence.setEnvironment(runnable.environment);
+            m_sequence.setWorkingDirectory(FilePath::fromString(runnable.workingDirectory));
+        });
+        CommandLine command(runnable.executable);
+        command.addArgs(runnable.commandLineArguments, CommandLine::Raw);
+        m_sequence.addCommand(command);
+    }
+    m_sequence.addAction([this] {
+        setTrained(true);
+        addMerge();
+    });
+}
+
+static FilePath findProfdata(const FilePath &sysroot)
+{
+    // Shipped with the llvm-tools-preview rustup component
+    const QString toolName = HostOsInfo::withExecutableSuffix("llvm-profdata");
+    const QDir rustlib(sysroot.pathAppended("lib/rustlib").toString());
+    for (const QString &host : rustlib.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        const FilePath candidate = FilePath::fromString(rustlib.filePath(host + "/bin/" + toolName));
+        if (candidate.exists())
+            return candidate;
+    }
+    return Environment::systemEnvironment().searchInPath(toolName);
+}
+
+void NimPgoPipeline::addMerge()
+{
+    if (!m_buildConfiguration)
+        return;
+    FilePath rustc = m_cargo.parentDir().pathAppended(HostOsInfo::withExecutableSuffix("rustc"));
+    if (!rustc.exists())
+        rustc = FilePath::fromString("rustc");
+
+    const FilePath rawDirectory = workDirectory().pathAppended("raw");
+    const FilePath partial = profileFile().stringAppended(".partial");
+    m_sequence.setEnvironment(m_buildConfiguration->environment());
+    m_sequence.addCommand({rustc, {"--print", "sysroot"}},
+                          [this, rawDirectory, partial](const NimCommandResult &result) {
+        const FilePath profdata = findProfdata(FilePath::fromString(
+                                                   QString::fromLocal8Bit(result.standardOutput).trimmed()));
+        if (profdata.isEmpty()) {
+            Core::MessageManager::write(tr("llvm-profdata was not found. Install it with "
+                                           "\"rustup component add llvm-tools-preview\" and "
+                                           "run the pipeline again to continue."));
+            m_sequence.cancel();
+            return;
+        }
+        m_sequence.addCommand({profdata, {"merge", "-o", partial.toString(), rawDirectory.toString()}});
+        m_sequence.addAction([this, partial] {
+            QFile::rename(partial.toString(), profileFile().toString());
+
+            QDir profiles(profileFile().parentDir().toString());
+            const QFileInfoList cached = profiles.entryInfoList({"*.profdata"}, QDir::Files, QDir::Time);
+            for (const QFileInfo &old : cached.mid(MAX_CACHED_PROFILES))
+                QFile::remove(old.absoluteFilePath());
+            addOptimizedBuilds();
+        });
+    });
+}
+
+void NimPgoPipeline::addOptimizedBuilds()
+{
+    if (!m_buildConfiguration)
+        return;
+    Core::MessageManager::write(tr("Building with the merged profile and, for comparison, without..."));
+    addBuild("optimized", "-Cprofile-use=" + profileFile().toString(), &m_optimizedExecutable);
+    addBuild("baseline", QString(), &m_baselineExecutable);
+    m_sequence.addAction([this] { addBenchmark(); });
+}
+
+void NimPgoPipeline::addBenchmark()
+{
+    if (!m_buildConfiguration)
+        return;
+    const QList<Runnable> optimized = runnables(m_buildConfiguration->target(), false,
+                                                m_optimizedExecutable);
+    const QList<Runnable> baseline = runnables(m_buildConfiguration->target(), false,
+                                               m_baselineExecutable);
+    if (optimized.isEmpty() || baseline.isEmpty()) {
+        report();
+        return;
+    }
+
+    // Alternate between the binaries so that drift affects both alike
+    m_sequence.addAction([this, runnable = optimized.first()] {
+        Core::MessageManager::write(tr("Measuring the speed-up with %1...")
+                                        .arg(runnable.commandLineArguments.isEmpty()
+                                                 ? runnable.executable.fileName()
+                                                 : runnable.commandLineArguments));
+        m_sequence.setEnvironment(runnable.environment);
+        m_sequence.setWorkingDirectory(FilePath::fromString(runnable.workingDirectory));
+    });
+    for (int i = 0; i < BENCHMARK_RUNS; ++i) {
+        for (const Runnable &runnable : {optimized.first(), baseline.first()}) {
+            QList<double> *seconds = runnable.executable == m_optimizedExecutable
+                    ? &m_optimizedSeconds : &m_baselineSeconds;
+            CommandLine command(runnable.executable);
+            command.addArgs(runnable.commandLineArguments, CommandLine::Raw);
+            m_sequence.addCommand(command, [seconds](const NimCommandResult &result) {
+                seconds->append(result.seconds);
+            });
+        }
+    }
+    m_sequence.addAction([this] { report(); });
+}
+
+static double mean(const QList<double> &values)
+{
+    return values.isEmpty() ? 0 : std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+}
+
+void NimPgoPipeline::report()
+{
+    QStringList lines;
+    lines << tr("Profile-guided optimization finished, the optimized binary is %1.")
+             .arg(m_optimizedExecutable.toUserOutput());
+    const double optimized = mean(m_optimizedSeconds);
+    const double baseline = mean(m_baselineSeconds);
+    if (optimized > 0 && baseline > 0) {
+        lines << tr("Mean run time: %1 s with the profile, %2 s without, a speed-up of %3x.")
+                 .arg(optimized, 0, 'f', 3).arg(baseline, 0, 'f', 3)
+                 .arg(baseline / optimized, 0, 'f', 2);
+    }
+    Core::MessageManager::write(lines.join('\n'));
+}
+
+} // namespace Nim
@@ -0,0 +1,87 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include "nimcommandsequence.h"
+
+#include <QObject>
+#include <QPointer>
+
+namespace Nim {
+
+class NimBuildConfiguration;
+
+// Profile-guided optimization of the release build: builds an instrumented
+// binary, runs the PGO training run configurations with it, merges the raw
+// profiles with llvm-profdata and builds with the merged profile. Finally
+// the active run configuration is run with the optimized binary and with one
+// built without profile to show the speed-up.
+//
+// The pipeline keeps its state in <data directory>/pgo. Merged profiles are
+// cached there by a hash of the sources, and a pipeline that was canceled or
+// failed continues where it stopped when it is run again on unchanged
+// sources. The raw profiles and the target directories of the pipeline's
+// builds are in <build directory>-pgo, where cargo clean does not reach them.
+class NimPgoPipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NimPgoPipeline(QObject *parent = nullptr);
+
+    bool isRunning() const;
+    void run(NimBuildConfiguration *buildConfiguration);
+
+    static QString sourceHash(const Utils::FilePath &projectDirectory,
+                              const Utils::FilePath &buildDirectory);
+
+private:
+    void addBuild(const QString &name, const QString &rustFlags, Utils::FilePath *executable);
+    void addTraining();
+    void addMerge();
+    void addOptimizedBuilds();
+    void addBenchmark();
+    void report();
+
+    Utils::FilePath stateDirectory() const;
+    Utils::FilePath workDirectory() const;
+    Utils::FilePath profileFile() const;
+    bool isTrained() const;
+    void setTrained(bool trained);
+
+    QPointer<NimBuildConfiguration> m_buildConfiguration;
+    NimCommandSequence m_sequence;
+    Utils::FilePath m_cargo;
+    QString m_sourceHash;
+    Utils::FilePath m_instrumentedExecutable;
+    Utils::FilePath m_optimizedExecutable;
+    Utils::FilePath m_baselineExecutable;
+    QList<double> m_optimizedSeconds;
+    QList<double> m_baselineSeconds;
+};
+
+} // namespace Nim
@@ -0,0 +1,426 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimprofilevariants.h"
+
+#include "nimbuildconfiguration.h"
+#include "nimdatadirectory.h"
+#include "nimutils.h"
+
+#include "../nimconstants.h"
+
+#include <coreplugin/messagemanager.h>
+#include <projectexplorer/kitinformation.h>
+#include <projectexplorer/project.h>
+#include <projectexplorer/runconfiguration.h>
+#include <projectexplorer/runcontrol.h>
+#include <projectexplorer/target.h>
+#include <projectexplorer/toolchain.h>
+#include <utils/algorithm.h>
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QLocale>
+#include <QRegularExpression>
+
+#include <algorithm>
+#include <numeric>
+
+using namespace ProjectExplorer;
+using namespace Utils;
+
+namespace Nim {
+
+const int RUNTIME_RUNS = 3;
+
+// NimProfileVariant
+
+QList<NimProfileVariant> NimProfileVariant::parse(const QString &text, QString *errorMessage)
+{
+    static const QRegularExpression keyPattern("^[a-z][a-z-]*$");
+    QList<NimProfileVariant> result;
+    const QStringList lines = text.split('\n');
+    for (int i = 0; i < lines.size(); ++i) {
+        const QString line = lines.at(i).trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+        const int colon = line.indexOf(':');
+        NimProfileVariant variant;
+        variant.name = line.left(colon).trimmed();
+        if (colon < 0 || variant.name.isEmpty()) {
+            if (errorMessage)
+                *errorMessage = QCoreApplication::translate("Nim::NimProfileVariant",
+                                                            "Line %1: expected \"name: key=value ...\".").arg(i + 1);
+            return {};
+        }
+        for (const QString &setting : line.mid(colon + 1).split(' ', QString::SkipEmptyParts)) {
+            const int equals = setting.indexOf('=');
+            const QString key = setting.left(equals);
+            if (equals < 0 || !keyPattern.match(key).hasMatch()) {
+                if (errorMessage)
+                    *errorMessage = QCoreApplication::translate("Nim::NimProfileVariant",
+                                                                "Line %1: \"%2\" is not a key=value profile setting.")
+                                        .arg(i + 1).arg(setting);
+                return {};
+            }
+            variant.settings.append({key, setting.mid(equals + 1)});
+        }
+        if (Utils::anyOf(result, Utils::equal(&NimProfileVariant::name, variant.name))) {
+            if (errorMessage)
+                *errorMessage = QCoreApplication::translate("Nim::NimProfileVariant",
+                                                            "Line %1: there already is a variant \"%2\".")
+                                    .arg(i + 1).arg(variant.name);
+            return {};
+        }
+        result.append(variant);
+    }
+    return result;
+}
+
+QString NimProfileVariant::defaultVariants()
+{
+    return QString("baseline:\n"
+                   "thin-lto: lto=thin\n"
+                   "fat-lto: lto=fat codegen-units=1\n"
+                   "native: target-cpu=native\n");
+}
+
+void NimProfileVariant::applyTo(Environment &environment, const QString &profile) const
+{
+    const QString prefix = "CARGO_PROFILE_" + profile.toUpper().replace('-', '_') + '_';
+    for (const QPair<QString, QString> &setting : settings) {
+        if (setting.first == "target-cpu") {
+            const QString flag = "-C target-cpu=" + setting.second;
+            const QString flags = environment.value("RUSTFLAGS");
+            environment.set("RUSTFLAGS", flags.isEmpty() ? flag : flags + ' ' + flag);
+        } else {
+            environment.set(prefix + setting.first.toUpper().replace('-', '_'), setting.second);
+        }
+    }
+}
+
+// NimProfileVariantBenchmark
+
+NimProfileVariantBenchmark::NimProfileVariantBenchmark(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_sequence, &NimCommandSequence::message, this, [](const QString &message) {
+        Core::MessageManager::write(message);
+    });
+}
+
+bool NimProfileVariantBenchmark::isRunning() const
+{
+    return m_sequence.isRunning();
+}
+
+void NimProfileVariantBenchmark::run(NimBuildConfiguration *buildConfiguration)
+{
+    if (isRunning() || !buildConfiguration)
+        return;
+    ToolChain *toolChain = ToolChainKitAspect::toolChain(buildConfiguration->target()->kit(),
+                                                         Constants::C_NIMLANGUAGE_ID);
+    if (!toolChain) {
+        Core::MessageManager::write(tr("Comparing profile variants needs a Rust tool chain."));
+        return;
+    }
+    QString errorMessage;
+    const QList<NimProfileVariant> variants = NimProfileVariant::parse(buildConfiguration->profileVariants(),
+                                                                       &errorMessage);
+    if (variants.isEmpty()) {
+        Core::MessageManager::write(errorMessage.isEmpty()
+                                        ? tr("No profile variants are defined in the build settings.")
+                                        : tr("Invalid profile variants: %1").arg(errorMessage));
+        return;
+    }
+
+    m_buildConfiguration = buildConfiguration;
+    m_workload = Workload(buildConfiguration->profileVariantWorkload());
+    m_results.clear();
+
+    // cargo bench uses the bench profile, which inherits from release
+    const bool release = buildConfiguration->nimBuildType() == NimBuildConfiguration::Release;
+    const QString profile = m_workload == BenchmarkWorkload ? "bench" : release ? "release" : "dev";
+    const QString profileDirectory = m_workload == BenchmarkWorkload || release ? "release" : "debug";
+    const FilePath projectDirectory = buildConfiguration->project()->projectDirectory();
+    const FilePath root = NimUtils::crateRoot(projectDirectory);
+    const Environment baseEnvironment = buildConfiguration->environment();
+    const QString binaryName = buildConfiguration->outFilePath().fileName();
+
+    m_sequence.setWorkingDirectory(projectDirectory);
+    for (int i = 0; i < variants.size(); ++i) {
+        const NimProfileVariant variant = variants.at(i);
+        const FilePath targetDirectory = NimDataDirectory::besideBuildDirectory(buildConfiguration, "variants")
+                .pathAppended(NimDataDirectory::fileName(variant.name));
+        NimProfileVariantResult result;
+        result.name = variant.name;
+        m_results.append(result);
+
+        CommandLine build(toolChain->compilerCommand());
+        if (m_workload == BenchmarkWorkload)
+            build.addArgs({"bench", "--no-run"});
+        else
+            build.addArg("build");
+        if (m_workload == RunConfigurationWorkload && release)
+            build.addArg("--release");
+        build.addArg("--target-dir=" + targetDirectory.toString());
+        build.addArg("--manifest-path=" + buildConfiguration->project()->projectFilePath().toString());
+        build.addArg("--message-format=json-render-diagnostics");
+
+        // The full build also covers the dependencies, which depend on the profile as well
+        m_sequence.addAction([this, variant, profile, baseEnvironment, targetDirectory, profileDirectory] {
+            Core::MessageManager::write(tr("Building profile variant \"%1\"...").arg(variant.name));
+            Environment environment = baseEnvironment;
+            variant.applyTo(environment, profile);
+            m_sequence.setEnvironment(environment);
+            QDir(targetDirectory.pathAppended(profileDirectory).toString()).removeRecursively();
+        });
+        // A variant that does not build is left out, the others are still compared
+        m_sequence.addCommand(build, [this, i, binaryName](const NimCommandResult &result) {
+            NimProfileVariantResult &variantResult = m_results[i];
+            if (!result.success()) {
+                variantResult.failed = true;
+                Core::MessageManager::write(tr("Profile variant \"%1\" failed to build, "
+                                               "leaving it out of the comparison.")
+                                                .arg(variantResult.name));
+                return;
+            }
+            variantResult.fullBuildSeconds = result.seconds;
+            const QList<NimCargoExecutable> executables
+                    = NimCargoMessages::executables(result.standardOutput);
+            if (m_workload == BenchmarkWorkload) {
+                for (const NimCargoExecutable &executable : executables) {
+                    if (executable.test)
+                        variantResult.benches.append(executable.path);
+                }
+            } else {
+                variantResult.executable = NimCargoMessages::binary(executables, binaryName).path;
+                if (!variantResult.executable.isEmpty())
+                    variantResult.binarySize = variantResult.executable.toFileInfo().size();
+            }
+        }, true);
+        if (!root.isEmpty()) {
+            m_sequence.addAction([root] {
+                QFile file(root.toString());
+                if (file.open(QIODevice::ReadWrite))
+                    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+            });
+            m_sequence.addCommand(build, [this, i](const NimCommandResult &result) {
+                NimProfileVariantResult &variantResult = m_results[i];
+                if (variantResult.failed)
+                    return;
+                if (result.success())
+                    variantResult.rebuildSeconds = result.seconds;
+                else
+                    variantResult.failed = true;
+            }, true);
+        }
+    }
+    m_sequence.addAction([this] { addRuns(); });
+
+    Core::MessageManager::write(tr("Comparing %n profile variant(s) of the %1 profile...", nullptr,
+                                   variants.size()).arg(profile));
+    m_sequence.start();
+}
+
+void NimProfileVariantBenchmark::addRuns()
+{
+    if (!m_buildConfiguration)
+        return;
+
+    Environment environment = m_buildConfiguration->environment();
+    FilePath workingDirectory = m_buildConfiguration->project()->projectDirectory();
+    QString arguments;
+    if (m_workload == RunConfigurationWorkload) {
+        if (RunConfiguration *runConfiguration = m_buildConfiguration->target()->activeRunConfiguration()) {
+            const Runnable runnable = runConfiguration->runnable();
+            environment = runnable.environment;
+            arguments = runnable.commandLineArguments;
+            if (!runnable.workingDirectory.isEmpty())
+                workingDirectory = FilePath::fromString(runnable.workingDirectory);
+        }
+    }
+    m_sequence.addAction([this, environment, workingDirectory] {
+        Core::MessageManager::write(tr("Running each profile variant %n time(s)...", nullptr,
+                                       RUNTIME_RUNS));
+        m_sequence.setEnvironment(environment);
+        m_sequence.setWorkingDirectory(workingDirectory);
+    });
+
+    // Alternate between the variants so that drift affects all of them alike
+    for (int run = 0; run < RUNTIME_RUNS; ++run) {
+        for (int i = 0; i < m_results.size(); ++i) {
+            NimProfileVariantResult &result = m_results[i];
+            if (result.failed)
+                continue;
+            if (m_workload == BenchmarkWorkload) {
+                if (result.benches.isEmpty())
+                    continue;
+                result.runSeconds.append(0);
+                for (const FilePath &bench : qAsConst(result.benches)) {
+                    m_sequence.addCommand(CommandLine(bench, QStringList("--bench")), [this, i, run](const NimCommandResult &r) {
+                        m_results[i].runSeconds[run] += r.seconds;
+                    });
+                }
+            } else if (!result.executable.isEmpty()) {
+                CommandLine command(result.executable);
+                command.addArgs(arguments, CommandLine::Raw);
+                m_sequence.addCommand(command, [this, i](const NimCommandResult &r) {
+                    m_results[i].runSeconds.append(r.seconds);
+                });
+            }
+        }
+    }
+    m_sequence.addAction([this] { report(); });
+}
+
+static QString seconds(double value)
+{
+    return value < 0 ? QString("-") : QString::number(value, 'f', 2) + " s";
+}
+
+void NimProfileVariantBenchmark::report()
+{
+    const QLocale locale;
+    const QString row("%1  %2  %3  %4  %5  %6");
+    QStringList lines;
+    lines << row.arg(tr("Variant"), -16).arg(tr("Full build"), 10).arg(tr("Rebuild"), 10)
+                 .arg(tr("Binary"), 10).arg(tr("Run (mean)"), 10).arg(tr("Run (best)"), 10);
+
+    const NimProfileVariantResult *fastestRun = nullptr;
+    const NimProfileVariantResult *fastestBuild = nullptr;
+    const NimProfileVariantResult *smallest = nullptr;
+    QHash<const NimProfileVariantResult *, double> means;
+    for (const NimProfileVariantResult &result : qAsConst(m_results)) {
+        if (result.failed) {
+            lines << row.arg(result.name, -16).arg(tr("failed"), 10).arg("-", 10).arg("-", 10)
+                         .arg("-", 10).arg("-", 10);
+            continue;
+        }
+        double mean = -1;
+        double best = -1;
+        if (!result.runSeconds.isEmpty()) {
+            mean = std::accumulate(result.runSeconds.begin(), result.runSeconds.end(), 0.0)
+                    / result.runSeconds.size();
+            best = *std::min_element(result.runSeconds.begin(), result.runSeconds.end());
+            means.insert(&result, mean);
+            if (!fastestRun || mean < means.value(fastestRun))
+                fastestRun = &result;
+        }
+        if (result.fullBuildSeconds >= 0
+                && (!fastestBuild || result.fullBuildSeconds < fastestBuild->fullBuildSeconds)) {
+            fastestBuild = &result;
+        }
+        if (result.binarySize >= 0 && (!smallest || result.binarySize < smallest->binarySize))
+            smallest = &result;
+
+        const QString size = result.binarySize < 0 ? QString("-")
+                                                   : locale.formattedDataSize(result.binarySize);
+        lines << row.arg(result.name, -16).arg(seconds(result.fullBuildSeconds), 10)
+                     .arg(seconds(result.rebuildSeconds), 10).arg(size, 10)
+                     .arg(seconds(mean), 10).arg(seconds(best), 10);
+    }
+
+    if (m_workload == RunConfigurationWorkload && !smallest)
+        lines << tr("No binary of the active run configuration was found in the build output.");
+    if (fastestRun)
+        lines << tr("Fastest at run time: %1.").arg(fastestRun->name);
+    if (fastestBuild)
+        lines << tr("Fastest to build: %1.").arg(fastestBuild->name);
+    if (smallest)
+        lines << tr("Smallest binary: %1.").arg(smallest->name);
+    Core::MessageManager::write(lines.join('\n'));
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QTest>
+
+namespace Nim {
+
+void RustPlugin::testProfileVariants()
+{
+    QString errorMessage;
+    const QList<NimProfileVariant> variants = NimProfileVariant::parse(
+                "# compared against the plain profile\n"
+                "baseline:\n"
+                "\n"
+                "  fat-lto:  lto=fat   codegen-units=1 \n"
+                "native: target-cpu=native opt-level=3\n", &errorMessage);
+    QVERIFY(errorMessage.isEmpty());
+    QCOMPARE(variants.size(), 3);
+    QCOMPARE(variants.at(0).name, QString("baseline"));
+    QVERIFY(variants.at(0).settings.isEmpty());
+    QCOMPARE(variants.at(1).name, QString("fat-lto"));
+    QCOMPARE(variants.at(1).settings, (QList<QPair<QString, QString>>{{"lto", "fat"},
+                                                                       {"codegen-units", "1"}}));
+    QCOMPARE(NimProfileVariant::parse(NimProfileVariant::defaultVariants()).size(), 4);
+
+    // Errors name the line and leave no variants
+    QVERIFY(NimProfileVariant::parse("baseline:\nlto=fat\n", &errorMessage).isEmpty());
+    QVERIFY(errorMessage.startsWith("Line 2:"));
+    QVERIFY(NimProfileVariant::parse(": lto=fat\n", &errorMessage).isEmpty());
+    QVERIFY(errorMessage.startsWith("Line 1:"));
+    QVERIFY(NimProfileVariant::parse("fast: lto\n", &errorMessage).isEmpty());
+    QVERIFY(errorMessage.contains("\"lto\""));
+    QVERIFY(NimProfileVariant::parse("fast: LTO=fat\n", &errorMessage).isEmpty());
+    QVERIFY(errorMessage.contains("\"LTO=fat\""));
+    QVERIFY(NimProfileVariant::parse("fast: lto=thin\n# again\nfast: lto=fat\n",
+                                     &errorMessage).isEmpty());
+    QCOMPARE(errorMessage, QString("Line 3: there already is a variant \"fast\"."));
+
+    // target-cpu is a code generation option, appended to the existing RUSTFLAGS
+    Environment environment(QStringList{"RUSTFLAGS=-C debuginfo=1"});
+    variants.at(2).applyTo(environment, "bench");
+    QCOMPARE(environment.value("RUSTFLAGS"), QString("-C debuginfo=1 -C target-cpu=native"));
+    QCOMPARE(environment.value("CARGO_PROFILE_BENCH_OPT_LEVEL"), QString("3"));
+    QVERIFY(!environment.hasKey("CARGO_PROFILE_BENCH_TARGET_CPU"));
+
+    Environment empty(QStringList{});
+    variants.at(2).applyTo(empty, "dev");
+    QCOMPARE(empty.value("RUSTFLAGS"), QString("-C target-cpu=native"));
+    QCOMPARE(empty.value("CARGO_PROFILE_DEV_OPT_LEVEL"), QString("3"));
+
+    Environment release(QStringList{});
+    variants.at(1).applyTo(release, "release");
+    QCOMPARE(release.value("CARGO_PROFILE_RELEASE_LTO"), QString("fat"));
+    QCOMPARE(release.value("CARGO_PROFILE_RELEASE_CODEGEN_UNITS"), QString("1"));
+    QVERIFY(!release.hasKey("RUSTFLAGS"));
+
+    // Custom profiles may contain dashes, which are not valid in variable names
+    Environment custom(QStringList{});
+    variants.at(1).applyTo(custom, "release-lto");
+    QCOMPARE(custom.value("CARGO_PROFILE_RELEASE_LTO_LTO"), QString("fat"));
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
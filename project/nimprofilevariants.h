@@ -0,0 +1,97 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include "nimcargomessages.h"
+#include "nimcommandsequence.h"
+
+#include <utils/environment.h>
+
+#include <QMap>
+#include <QObject>
+#include <QPointer>
+
+namespace Nim {
+
+class NimBuildConfiguration;
+
+// A set of Cargo profile overrides, written as one line of
+//   name: codegen-units=1 lto=fat opt-level=3 incremental=false target-cpu=native
+// Every key but target-cpu is a profile setting applied through a
+// CARGO_PROFILE_<PROFILE>_<KEY> environment variable, target-cpu goes to RUSTFLAGS.
+class NimProfileVariant
+{
+public:
+    QString name;
+    QList<QPair<QString, QString>> settings;
+
+    static QList<NimProfileVariant> parse(const QString &text, QString *errorMessage = nullptr);
+    static QString defaultVariants();
+
+    // profile is the Cargo profile name, e.g. "dev", "release" or "bench"
+    void applyTo(Utils::Environment &environment, const QString &profile) const;
+};
+
+class NimProfileVariantResult
+{
+public:
+    QString name;
+    Utils::FilePath executable;
+    Utils::FilePaths benches;
+    double fullBuildSeconds = -1;
+    double rebuildSeconds = -1;
+    qint64 binarySize = -1;
+    QList<double> runSeconds;
+    bool failed = false;
+};
+
+// Builds every profile variant of a build configuration in its own target
+// directory, from scratch and after touching the crate root, and then runs
+// the binary of the active run configuration or the benchmarks with each.
+class NimProfileVariantBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Workload { RunConfigurationWorkload = 0, BenchmarkWorkload };
+
+    explicit NimProfileVariantBenchmark(QObject *parent = nullptr);
+
+    bool isRunning() const;
+    void run(NimBuildConfiguration *buildConfiguration);
+
+private:
+    void addRuns();
+    void report();
+
+    QPointer<NimBuildConfiguration> m_buildConfiguration;
+    NimCommandSequence m_sequence;
+    QList<NimProfileVariantResult> m_results;
+    Workload m_workload = RunConfigurationWorkload;
+};
+
+} // namespace Nim
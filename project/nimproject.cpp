@@ -86,4 +86,24 @@ void NimProject::setExcludedFiles(const QStringList &excludedFiles)
     m_excludedFiles = excludedFiles;
 }
 
+QStringList NimProject::workspaceMembers() const
+{
+    return m_workspaceMembers;
+}
+
+void NimProject::setWorkspaceMembers(const QStringList &workspaceMembers)
+{
+    m_workspaceMembers = workspaceMembers;
+}
+
+QStringList NimProject::workspaceTargets() const
+{
+    return m_workspaceTargets;
+}
+
+void NimProject::setWorkspaceTargets(const QStringList &workspaceTargets)
+{
+    m_workspaceTargets = workspaceTargets;
+}
+
 } // namespace Nim
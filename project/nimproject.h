@@ -51,11 +51,19 @@ public:
     QStringList excludedFiles() const;
     void setExcludedFiles(const QStringList &excludedFiles);
 
+    QStringList workspaceMembers() const;
+    void setWorkspaceMembers(const QStringList &workspaceMembers);
+
+    QStringList workspaceTargets() const;
+    void setWorkspaceTargets(const QStringList &workspaceTargets);
+
 protected:
     // Keep for compatibility with Qt Creator 4.10
     RestoreResult fromMap(const QVariantMap &map, QString *errorMessage) final;
 
     QStringList m_excludedFiles;
+    QStringList m_workspaceMembers;
+    QStringList m_workspaceTargets;
 };
 
 } // namespace Nim
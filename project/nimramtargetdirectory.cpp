@@ -0,0 +1,410 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimramtargetdirectory.h"
+
+#include "nimbuildconfiguration.h"
+#include "nimtargetdirectory.h"
+#include "nimutils.h"
+
+#include "../nimconstants.h"
+
+#include <coreplugin/messagemanager.h>
+#include <projectexplorer/buildmanager.h>
+#include <projectexplorer/kitinformation.h>
+#include <projectexplorer/project.h>
+#include <projectexplorer/toolchain.h>
+#include <utils/qtcassert.h>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QtConcurrent>
+
+#include <numeric>
+
+#ifdef Q_OS_LINUX
+#include <sys/vfs.h>
+#include <unistd.h>
+#endif
+
+using namespace ProjectExplorer;
+using namespace Utils;
+
+namespace Nim {
+
+const char PARTIAL_SUFFIX[] = ".partial";
+const int DEFAULT_SIZE_LIMIT_MIB = 8192;
+const int IDLE_SYNC_DELAY_MS = 60 * 1000;
+const int BENCHMARK_RUNS = 3;
+
+static bool isTmpfs(const QString &path)
+{
+#ifdef Q_OS_LINUX
+    // From linux/magic.h
+    const long TMPFS_MAGIC = 0x01021994;
+    struct statfs st;
+    return !path.isEmpty() && ::statfs(QFile::encodeName(path).constData(), &st) == 0
+            && long(st.f_type) == TMPFS_MAGIC;
+#else
+    Q_UNUSED(path)
+    return false;
+#endif
+}
+
+static NimRamSyncResult syncInBackground(const FilePath &ram, const FilePath &persistent,
+                                         qint64 maxBytes, const std::atomic_bool *canceled)
+{
+    const NimBackgroundPriorityGuard guard;
+    NimRamSyncResult result;
+    // Fingerprints go last: if the sync is interrupted, Cargo considers the
+    // affected units dirty instead of trusting half-copied outputs
+    result.statistics = NimFileCloner::syncTree(ram, persistent, {".fingerprint"}, canceled);
+    if (!result.statistics.ok)
+        return result; // Only evict what has been persisted
+
+    // A starting build cancels the sync and waits for it, the eviction must
+    // not remove artifacts under it
+    QList<NimTargetArtifact> artifacts;
+    for (const NimTargetArtifact &artifact : NimTargetDirectory::collectArtifacts(ram)) {
+        if (*canceled)
+            return result;
+        artifacts.append(NimTargetDirectory::measured(artifact));
+    }
+    const NimTargetDirectoryReport report = NimTargetDirectory::summarize(artifacts);
+    if (report.totalBytes <= maxBytes || *canceled)
+        return result;
+
+    const QList<NimPruneCandidate> candidates
+            = NimTargetDirectory::evictionCandidates(report, maxBytes * 9 / 10);
+    result.evictedArtifacts = candidates.size();
+    result.evictedBytes = NimTargetDirectory::prune(candidates);
+    return result;
+}
+
+NimRamTargetDirectory::NimRamTargetDirectory(NimBuildConfiguration *buildConfiguration)
+    : QObject(buildConfiguration)
+    , m_buildConfiguration(buildConfiguration)
+    , m_sizeLimitMiB(DEFAULT_SIZE_LIMIT_MIB)
+{
+    m_idleTimer.setSingleShot(true);
+    m_idleTimer.setInterval(IDLE_SYNC_DELAY_MS);
+    connect(&m_idleTimer, &QTimer::timeout, this, &NimRamTargetDirectory::startSync);
+    connect(&m_restoreWatcher, &QFutureWatcherBase::finished,
+            this, &NimRamTargetDirectory::onRestoreFinished);
+    connect(&m_syncWatcher, &QFutureWatcherBase::finished,
+            this, &NimRamTargetDirectory::onSyncFinished);
+}
+
+NimRamTargetDirectory::~NimRamTargetDirectory()
+{
+    // The RAM copy survives until the next reboot, nothing is lost by
+    // interrupting the sync here
+    m_cancelSync = true;
+    m_syncWatcher.waitForFinished();
+    m_restoreWatcher.waitForFinished();
+}
+
+FilePath NimRamTargetDirectory::ramRoot()
+{
+    static const FilePath root = [] {
+#ifdef Q_OS_LINUX
+        // /dev/shm is shared by all users, the runtime directory is private
+        // but usually limited to a small fraction of the memory
+        QString path;
+        if (isTmpfs("/dev/shm"))
+            path = QString("/dev/shm/rust-creator-%1").arg(getuid());
+        else if (isTmpfs(QString::fromLocal8Bit(qgetenv("XDG_RUNTIME_DIR"))))
+            path = QString::fromLocal8Bit(qgetenv("XDG_RUNTIME_DIR")) + "/rust-creator";
+        if (path.isEmpty() || !QDir().mkpath(path))
+            return FilePath();
+        QFile::setPermissions(path, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+        return FilePath::fromString(path);
+#else
+        return FilePath();
+#endif
+    }();
+    return root;
+}
+
+bool NimRamTargetDirectory::isAvailable()
+{
+    return !ramRoot().isEmpty();
+}
+
+NimCloneStatistics NimRamTargetDirectory::copy(const FilePath &persistent, const FilePath &ram)
+{
+    const QString partial = ram.toString() + PARTIAL_SUFFIX;
+    QDir(partial).removeRecursively();
+    NimCloneStatistics statistics;
+    if (persistent.exists())
+        statistics = NimFileCloner::cloneTree(persistent, FilePath::fromString(partial));
+    else
+        statistics.ok = QDir().mkpath(partial);
+    if (statistics.ok)
+        statistics.ok = QDir().rename(partial, ram.toString());
+    if (!statistics.ok)
+        QDir(partial).removeRecursively();
+    return statistics;
+}
+
+bool NimRamTargetDirectory::isEnabled() const
+{
+    return m_enabled;
+}
+
+void NimRamTargetDirectory::setEnabled(bool enabled)
+{
+    if (m_enabled == enabled)
+        return;
+    m_enabled = enabled;
+    if (enabled) {
+        restore();
+    } else if (m_dirty) {
+        // Bring the build directory up to date before it is used again
+        m_idleTimer.stop();
+        startSync();
+    }
+}
+
+bool NimRamTargetDirectory::isActive() const
+{
+    return m_enabled && isAvailable() && !m_restoreFailed;
+}
+
+int NimRamTargetDirectory::sizeLimitMiB() const
+{
+    return m_sizeLimitMiB;
+}
+
+void NimRamTargetDirectory::setSizeLimitMiB(int sizeLimitMiB)
+{
+    m_sizeLimitMiB = sizeLimitMiB;
+}
+
+FilePath NimRamTargetDirectory::directory() const
+{
+    const FilePath buildDirectory = m_buildConfiguration->buildDirectory();
+    const QByteArray hash = QCryptographicHash::hash(buildDirectory.toString().toUtf8(),
+                                                     QCryptographicHash::Sha1).toHex().left(12);
+    return ramRoot().pathAppended(QString::fromLatin1(hash) + '-' + buildDirectory.fileName());
+}
+
+bool NimRamTargetDirectory::isBusy() const
+{
+    return m_restoreWatcher.isRunning() || m_syncWatcher.isRunning();
+}
+
+void NimRamTargetDirectory::cancelSync()
+{
+    m_idleTimer.stop();
+    m_cancelSync = true;
+}
+
+void NimRamTargetDirectory::buildStarted()
+{
+    cancelSync();
+}
+
+void NimRamTargetDirectory::buildFinished()
+{
+    // Builds went to the build directory, there is nothing to persist
+    if (!isActive())
+        return;
+    m_dirty = true;
+    m_idleTimer.start();
+}
+
+void NimRamTargetDirectory::restore()
+{
+    if (!m_enabled || !isAvailable() || isBusy())
+        return;
+    if (directory().exists()) {
+        m_restoreFailed = false;
+        return;
+    }
+    Core::MessageManager::write(tr("Copying %1 to %2...")
+                                    .arg(m_buildConfiguration->buildDirectory().toUserOutput(),
+                                         directory().toUserOutput()));
+    m_restoreWatcher.setFuture(QtConcurrent::run(&NimRamTargetDirectory::copy,
+                                                 m_buildConfiguration->buildDirectory(),
+                                                 directory()));
+}
+
+void NimRamTargetDirectory::startSync()
+{
+    // A branch switch persists the RAM copy itself
+    if (m_buildConfiguration->isTargetDirectoryBusy()
+            || BuildManager::isBuilding(m_buildConfiguration->project())) {
+        m_idleTimer.start();
+        return;
+    }
+    m_cancelSync = false;
+    m_syncWatcher.setFuture(QtConcurrent::run(syncInBackground, directory(),
+                                              m_buildConfiguration->buildDirectory(),
+                                              qint64(m_sizeLimitMiB) * 1024 * 1024,
+                                              &m_cancelSync));
+}
+
+void NimRamTargetDirectory::onRestoreFinished()
+{
+    const NimCloneStatistics statistics = m_restoreWatcher.result();
+    m_restoreFailed = !statistics.ok;
+    if (statistics.ok) {
+        Core::MessageManager::write(tr("RAM target directory ready: %1 files, %2 MiB.")
+                                        .arg(statistics.files).arg(NimUtils::toMiB(statistics.bytes)));
+    } else {
+        Core::MessageManager::write(tr("Could not copy %1 to %2, building in the build "
+                                       "directory instead until the RAM target directory is "
+                                       "enabled again.")
+                                        .arg(m_buildConfiguration->buildDirectory().toUserOutput(),
+                                             directory().toUserOutput()));
+    }
+    emit idle();
+}
+
+void NimRamTargetDirectory::onSyncFinished()
+{
+    const NimRamSyncResult result = m_syncWatcher.result();
+    if (result.statistics.ok) {
+        m_dirty = false;
+        if (result.statistics.files > 0) {
+            Core::MessageManager::write(tr("Persisted %1 files (%2 MiB) of the RAM target "
+                                           "directory to %3.")
+                                            .arg(result.statistics.files)
+                                            .arg(NimUtils::toMiB(result.statistics.bytes))
+                                            .arg(m_buildConfiguration->buildDirectory().toUserOutput()));
+        }
+        if (result.evictedArtifacts > 0) {
+            Core::MessageManager::write(tr("RAM target directory above %1 MiB, evicted %2 "
+                                           "artifacts (%3 MiB).")
+                                            .arg(m_sizeLimitMiB).arg(result.evictedArtifacts)
+                                            .arg(NimUtils::toMiB(result.evictedBytes)));
+        }
+    }
+    emit idle();
+}
+
+// NimTargetDirectoryBenchmark
+
+NimTargetDirectoryBenchmark::NimTargetDirectoryBenchmark(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_sequence, &NimCommandSequence::message, this, [](const QString &message) {
+        Core::MessageManager::write(message);
+    });
+}
+
+bool NimTargetDirectoryBenchmark::isRunning() const
+{
+    return m_sequence.isRunning();
+}
+
+static void touch(const FilePath &path)
+{
+    QFile file(path.toString());
+    if (file.open(QIODevice::ReadWrite))
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+}
+
+void NimTargetDirectoryBenchmark::run(NimBuildConfiguration *buildConfiguration)
+{
+    if (isRunning() || !buildConfiguration)
+        return;
+    if (!NimRamTargetDirectory::isAvailable()) {
+        Core::MessageManager::write(tr("No tmpfs available for a RAM target directory."));
+        return;
+    }
+    const FilePath root = NimUtils::crateRoot(buildConfiguration->project()->projectDirectory());
+    ToolChain *toolChain = ToolChainKitAspect::toolChain(buildConfiguration->target()->kit(),
+                                                         Constants::C_NIMLANGUAGE_ID);
+    if (root.isEmpty() || !toolChain) {
+        Core::MessageManager::write(tr("The benchmark needs a Rust tool chain and a package "
+                                       "with src/lib.rs or src/main.rs."));
+        return;
+    }
+
+    m_buildConfiguration = buildConfiguration;
+    m_seconds.clear();
+    m_sequence.setWorkingDirectory(buildConfiguration->project()->projectDirectory());
+    m_sequence.setEnvironment(buildConfiguration->environment());
+
+    NimRamTargetDirectory *ram = buildConfiguration->ramTargetDirectory();
+    const QList<QPair<QString, FilePath>> modes = {
+        {tr("Build directory"), buildConfiguration->buildDirectory()},
+        {tr("RAM target directory"), ram->directory()}
+    };
+    for (const QPair<QString, FilePath> &mode : modes) {
+        CommandLine build{toolChain->compilerCommand(), {"build"}};
+        if (buildConfiguration->nimBuildType() == NimBuildConfiguration::Release)
+            build.addArg("--release");
+        build.addArg("--target-dir=" + mode.second.toString());
+        build.addArg("--manifest-path=" + buildConfiguration->project()->projectFilePath().toString());
+
+        m_sequence.addCommand(build); // warm-up
+        for (int i = 0; i < BENCHMARK_RUNS; ++i) {
+            m_sequence.addAction([root] { touch(root); });
+            const QString name = mode.first;
+            m_sequence.addCommand(build, [this, name](const NimCommandResult &result) {
+                m_seconds[name].append(result.seconds);
+            });
+        }
+    }
+    const bool keepRamCopy = ram->isEnabled();
+    const FilePath ramDirectory = ram->directory();
+    m_sequence.addAction([this, keepRamCopy, ramDirectory] {
+        if (!keepRamCopy)
+            QDir(ramDirectory.toString()).removeRecursively();
+        report();
+    });
+
+    Core::MessageManager::write(tr("Benchmarking incremental rebuilds after touching %1...")
+                                    .arg(root.toUserOutput()));
+    m_sequence.start();
+}
+
+void NimTargetDirectoryBenchmark::report()
+{
+    QStringList lines;
+    QMap<QString, double> means;
+    for (auto it = m_seconds.cbegin(); it != m_seconds.cend(); ++it) {
+        const QList<double> &seconds = it.value();
+        if (seconds.isEmpty())
+            continue;
+        const double mean = std::accumulate(seconds.begin(), seconds.end(), 0.0) / seconds.size();
+        means.insert(it.key(), mean);
+        lines << tr("%1: %2 s mean, %3 s best of %4 rebuilds.")
+                 .arg(it.key()).arg(mean, 0, 'f', 2)
+                 .arg(*std::min_element(seconds.begin(), seconds.end()), 0, 'f', 2)
+                 .arg(seconds.size());
+    }
+    const double persistent = means.value(tr("Build directory"));
+    const double ram = means.value(tr("RAM target directory"));
+    if (persistent > 0 && ram > 0)
+        lines << tr("Speed-up of the RAM target directory: %1x.").arg(persistent / ram, 0, 'f', 2);
+    Core::MessageManager::write(lines.join('\n'));
+}
+
+} // namespace Nim
@@ -0,0 +1,128 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include "nimcommandsequence.h"
+#include "nimfilecloner.h"
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+#include <atomic>
+
+namespace Nim {
+
+class NimBuildConfiguration;
+
+class NimRamSyncResult
+{
+public:
+    NimCloneStatistics statistics;
+    qint64 evictedBytes = 0;
+    int evictedArtifacts = 0;
+};
+
+// Keeps the Cargo target directory of a build configuration on tmpfs. The
+// persistent build directory becomes a mirror that is brought up to date
+// when no build ran for a while, and seeds the RAM copy when it is missing,
+// e.g. after a reboot. The RAM copy is kept below a size limit by evicting
+// the least recently used artifacts after they have been persisted.
+class NimRamTargetDirectory : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NimRamTargetDirectory(NimBuildConfiguration *buildConfiguration);
+    ~NimRamTargetDirectory() override;
+
+    // A per-user directory on tmpfs, empty if there is none
+    static Utils::FilePath ramRoot();
+    static bool isAvailable();
+    // Clones the build directory into a RAM directory that does not exist yet
+    static NimCloneStatistics copy(const Utils::FilePath &persistent, const Utils::FilePath &ram);
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+    // Enabled, available and not failed to be copied from the build directory
+    bool isActive() const;
+
+    int sizeLimitMiB() const;
+    void setSizeLimitMiB(int sizeLimitMiB);
+
+    Utils::FilePath directory() const;
+
+    bool isBusy() const;
+    // Stops a sync to the build directory at the next file, a waiting build
+    // then only waits for the copy from the build directory
+    void cancelSync();
+    void buildStarted();
+    void buildFinished();
+
+signals:
+    void idle();
+
+private:
+    void restore();
+    void startSync();
+    void onRestoreFinished();
+    void onSyncFinished();
+
+    NimBuildConfiguration *m_buildConfiguration;
+    bool m_enabled = false;
+    bool m_restoreFailed = false;
+    int m_sizeLimitMiB;
+    bool m_dirty = false;
+    std::atomic_bool m_cancelSync{false};
+    QTimer m_idleTimer;
+    QFutureWatcher<NimCloneStatistics> m_restoreWatcher;
+    QFutureWatcher<NimRamSyncResult> m_syncWatcher;
+};
+
+// Compares incremental rebuild times of the persistent and the RAM target
+// directory: after a warm-up build, the crate root is touched and the
+// project rebuilt a few times in each.
+class NimTargetDirectoryBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NimTargetDirectoryBenchmark(QObject *parent = nullptr);
+
+    bool isRunning() const;
+    void run(NimBuildConfiguration *buildConfiguration);
+
+private:
+    void report();
+
+    QPointer<NimBuildConfiguration> m_buildConfiguration;
+    NimCommandSequence m_sequence;
+    QMap<QString, QList<double>> m_seconds;
+};
+
+} // namespace Nim
@@ -25,13 +25,16 @@
 
 #include "nimrunconfiguration.h"
 #include "nimbuildconfiguration.h"
+#include "nimcompilerbuildstep.h"
 
 #include "../nimconstants.h"
 
 #include <projectexplorer/buildsystem.h>
+#include <projectexplorer/kitinformation.h>
 #include <projectexplorer/localenvironmentaspect.h>
 #include <projectexplorer/runconfigurationaspects.h>
 #include <projectexplorer/runcontrol.h>
+#include <projectexplorer/toolchain.h>
 
 #include <QDir>
 #include <QFileInfo>
@@ -41,37 +44,126 @@ using namespace Utils;
 
 namespace Nim {
 
-class NimRunConfiguration final : public RunConfiguration
+// NimRepeatedRunsAspect
+
+NimRepeatedRunsAspect::NimRepeatedRunsAspect()
+{
+    setSettingsKey(Constants::C_NIMRUNCONFIGURATION_REPEATEDRUNS);
+    setLabel(tr("Benchmark runs:"));
+    setToolTip(tr("How often \"Benchmark Repeated Runs\" runs the executable"));
+    setRange(1, 1000);
+    setValue(10);
+}
+
+// NimWarmupRunsAspect
+
+NimWarmupRunsAspect::NimWarmupRunsAspect()
+{
+    setSettingsKey(Constants::C_NIMRUNCONFIGURATION_WARMUPRUNS);
+    setLabel(tr("Warmup runs:"));
+    setToolTip(tr("Runs before the measured ones, which fill the caches"));
+    setRange(0, 100);
+    setValue(1);
+}
+
+// NimDropCachesAspect
+
+NimDropCachesAspect::NimDropCachesAspect()
+    : BaseBoolAspect(Constants::C_NIMRUNCONFIGURATION_DROPCACHES)
+{
+    setLabel(tr("Drop the page cache before every benchmark run"));
+    setToolTip(tr("Measures cold starts. Needs a sudo rule that lets you run "
+                  "\"/usr/bin/tee /proc/sys/vm/drop_caches\" without a password."));
+}
+
+// NimRunConfiguration
+
+NimRunConfiguration::NimRunConfiguration(Target *target, Core::Id id)
+    : RunConfiguration(target, id)
 {
-    Q_DECLARE_TR_FUNCTIONS(Nim::NimRunConfiguration)
-
-public:
-    NimRunConfiguration(Target *target, Core::Id id)
-        : RunConfiguration(target, id)
-    {
-        addAspect<LocalEnvironmentAspect>(target);
-        addAspect<ExecutableAspect>();
-        addAspect<ArgumentsAspect>();
-        addAspect<WorkingDirectoryAspect>();
-        addAspect<TerminalAspect>();
-
-        setDisplayName(tr("Current Build Target"));
-        setDefaultDisplayName(tr("Current Build Target"));
-
-        setUpdater([this, target] {
-            auto buildConfiguration = qobject_cast<NimBuildConfiguration *>(target->activeBuildConfiguration());
-            QTC_ASSERT(buildConfiguration, return);
-            const QFileInfo outFileInfo = buildConfiguration->outFilePath().toFileInfo();
-            aspect<ExecutableAspect>()->setExecutable(FilePath::fromString(outFileInfo.absoluteFilePath()));
-            const QString workingDirectory = outFileInfo.absoluteDir().absolutePath();
-            aspect<WorkingDirectoryAspect>()->setDefaultWorkingDirectory(FilePath::fromString(workingDirectory));
-        });
-
-        // Connect target signals
-        connect(target, &Target::buildSystemUpdated, this, &RunConfiguration::update);
-        update();
+    addAspect<LocalEnvironmentAspect>(target);
+    addAspect<ExecutableAspect>();
+    addAspect<ArgumentsAspect>();
+    addAspect<WorkingDirectoryAspect>();
+    addAspect<TerminalAspect>();
+    addAspect<NimRepeatedRunsAspect>();
+    addAspect<NimWarmupRunsAspect>();
+    addAspect<NimDropCachesAspect>();
+
+    setDisplayName(tr("Current Build Target"));
+    setDefaultDisplayName(tr("Current Build Target"));
+
+    setUpdater([this, target] {
+        auto buildConfiguration = qobject_cast<NimBuildConfiguration *>(target->activeBuildConfiguration());
+        QTC_ASSERT(buildConfiguration, return);
+        const QFileInfo outFileInfo = buildConfiguration->outFilePath().toFileInfo();
+        aspect<ExecutableAspect>()->setExecutable(FilePath::fromString(outFileInfo.absoluteFilePath()));
+        const QString workingDirectory = outFileInfo.absoluteDir().absolutePath();
+        aspect<WorkingDirectoryAspect>()->setDefaultWorkingDirectory(FilePath::fromString(workingDirectory));
+    });
+
+    // Connect target signals
+    connect(target, &Target::buildSystemUpdated, this, &RunConfiguration::update);
+    update();
+}
+
+// NimPgoTrainingRunConfiguration
+
+NimPgoTrainingRunConfiguration::NimPgoTrainingRunConfiguration(Target *target, Core::Id id)
+    : NimRunConfiguration(target, id)
+{
+    setDisplayName(tr("PGO Training Run"));
+    setDefaultDisplayName(tr("PGO Training Run"));
+}
+
+// NimBenchRunConfiguration
+
+NimBenchRunConfiguration::NimBenchRunConfiguration(Target *target, Core::Id id)
+    : RunConfiguration(target, id)
+{
+    addAspect<LocalEnvironmentAspect>(target);
+    addAspect<ExecutableAspect>();
+    addAspect<ArgumentsAspect>();
+    addAspect<WorkingDirectoryAspect>();
+
+    setUpdater([this, target] {
+        const BuildTargetInfo targetInfo = buildTargetInfo();
+        setDefaultDisplayName(tr("Benchmark %1").arg(targetInfo.displayName));
+        ToolChain *toolChain = ToolChainKitAspect::toolChain(target->kit(), Constants::C_NIMLANGUAGE_ID);
+        QTC_ASSERT(toolChain, return);
+        aspect<ExecutableAspect>()->setExecutable(toolChain->compilerCommand());
+        aspect<WorkingDirectoryAspect>()->setDefaultWorkingDirectory(targetInfo.workingDirectory);
+    });
+
+    connect(target, &Target::buildSystemUpdated, this, &RunConfiguration::update);
+    update();
+}
+
+Runnable NimBenchRunConfiguration::runnable() const
+{
+    Runnable runnable = RunConfiguration::runnable();
+    const BuildTargetInfo targetInfo = buildTargetInfo();
+    auto buildConfiguration = qobject_cast<NimBuildConfiguration *>(target()->activeBuildConfiguration());
+    NimCompilerBuildStep *buildStep = buildConfiguration ? buildConfiguration->nimCompilerBuildStep() : nullptr;
+    CommandLine command(runnable.executable, {"bench"});
+    // Shared with the builds, cargo bench builds with the bench profile
+    if (buildConfiguration)
+        command.addArg("--target-dir=" + buildConfiguration->effectiveTargetDirectory().toString());
+    command.addArgs({"--manifest-path=" + targetInfo.projectFilePath.toString(),
+                     "--bench", targetInfo.additionalData.toString()});
+    // With the flags and the environment of the builds, cargo reuses their
+    // dependencies instead of rebuilding everything in the shared target directory
+    if (buildStep)
+        command.addArgs(buildStep->cargoConfigArguments());
+    command.addArg("--");
+    command.addArgs(runnable.commandLineArguments, CommandLine::Raw);
+    runnable.commandLineArguments = command.arguments();
+    if (buildStep) {
+        runnable.environment = buildStep->cargoEnvironment();
+        runnable.environment.modify(aspect<EnvironmentAspect>()->userEnvironmentChanges());
     }
-};
+    return runnable;
+}
 
 // NimRunConfigurationFactory
 
@@ -81,4 +173,31 @@ NimRunConfigurationFactory::NimRunConfigurationFactory() : FixedRunConfiguration
     addSupportedProjectType(Constants::C_NIMPROJECT_ID);
 }
 
+// NimPgoTrainingRunConfigurationFactory
+
+NimPgoTrainingRunConfigurationFactory::NimPgoTrainingRunConfigurationFactory()
+    : FixedRunConfigurationFactory(NimPgoTrainingRunConfiguration::tr("PGO Training Run"))
+{
+    registerRunConfiguration<NimPgoTrainingRunConfiguration>(Constants::C_NIMPGOTRAININGRUNCONFIGURATION_ID);
+    addSupportedProjectType(Constants::C_NIMPROJECT_ID);
+}
+
+QList<RunConfigurationCreationInfo>
+NimPgoTrainingRunConfigurationFactory::availableCreators(Target *parent) const
+{
+    // Only added on request, the pipeline falls back to the active run configuration
+    QList<RunConfigurationCreationInfo> creators = FixedRunConfigurationFactory::availableCreators(parent);
+    for (RunConfigurationCreationInfo &creator : creators)
+        creator.creationMode = RunConfigurationCreationInfo::ManualCreationOnly;
+    return creators;
+}
+
+// NimBenchRunConfigurationFactory
+
+NimBenchRunConfigurationFactory::NimBenchRunConfigurationFactory()
+{
+    registerRunConfiguration<NimBenchRunConfiguration>(Constants::C_NIMBENCHRUNCONFIGURATION_ID);
+    addSupportedProjectType(Constants::C_NIMPROJECT_ID);
+}
+
 } // Nim
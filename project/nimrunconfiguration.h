@@ -23,16 +23,89 @@
 **
 ****************************************************************************/
 
+
 #pragma once
 
+#include <projectexplorer/projectconfigurationaspects.h>
 #include <projectexplorer/runconfiguration.h>
 
 namespace Nim {
 
+// Settings of the repeated-run benchmark, see NimRepeatedRunner
+class NimRepeatedRunsAspect final : public ProjectExplorer::BaseIntegerAspect
+{
+    Q_OBJECT
+
+public:
+    NimRepeatedRunsAspect();
+};
+
+class NimWarmupRunsAspect final : public ProjectExplorer::BaseIntegerAspect
+{
+    Q_OBJECT
+
+public:
+    NimWarmupRunsAspect();
+};
+
+class NimDropCachesAspect final : public ProjectExplorer::BaseBoolAspect
+{
+    Q_OBJECT
+
+public:
+    NimDropCachesAspect();
+};
+
+class NimRunConfiguration : public ProjectExplorer::RunConfiguration
+{
+    Q_OBJECT
+
+public:
+    NimRunConfiguration(ProjectExplorer::Target *target, Core::Id id);
+};
+
+// Runs the build target like NimRunConfiguration, and is run with the
+// instrumented binary to train profile-guided optimization
+class NimPgoTrainingRunConfiguration final : public NimRunConfiguration
+{
+    Q_OBJECT
+
+public:
+    NimPgoTrainingRunConfiguration(ProjectExplorer::Target *target, Core::Id id);
+};
+
+// Runs cargo bench for one bench target, the arguments go to the benchmark
+// binary. Its results are recorded by NimBenchRunner.
+class NimBenchRunConfiguration final : public ProjectExplorer::RunConfiguration
+{
+    Q_OBJECT
+
+public:
+    NimBenchRunConfiguration(ProjectExplorer::Target *target, Core::Id id);
+
+    ProjectExplorer::Runnable runnable() const final;
+};
+
 class NimRunConfigurationFactory final : public ProjectExplorer::FixedRunConfigurationFactory
 {
 public:
     NimRunConfigurationFactory();
 };
 
+class NimPgoTrainingRunConfigurationFactory final : public ProjectExplorer::FixedRunConfigurationFactory
+{
+public:
+    NimPgoTrainingRunConfigurationFactory();
+
+    QList<ProjectExplorer::RunConfigurationCreationInfo>
+    availableCreators(ProjectExplorer::Target *parent) const override;
+};
+
+// One bench run configuration per bench target
+class NimBenchRunConfigurationFactory final : public ProjectExplorer::RunConfigurationFactory
+{
+public:
+    NimBenchRunConfigurationFactory();
+};
+
 } // Nim
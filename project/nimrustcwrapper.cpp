@@ -0,0 +1,157 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "nimrustcwrapper.h"
+
+#include <utils/qtcassert.h>
+
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+using namespace Utils;
+
+namespace Nim {
+
+static QString cacheLocation()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/rust-creator";
+}
+
+NimArtifactCacheStatistics NimArtifactCacheStatistics::fromLog(const FilePath &logFile)
+{
+    NimArtifactCacheStatistics result;
+    QFile file(logFile.toString());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return result;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        if (line.startsWith("hit "))
+            ++result.hits;
+        else if (line.startsWith("miss "))
+            ++result.misses;
+    }
+    return result;
+}
+
+QList<NimUnitTiming> NimUnitTiming::fromLog(const FilePath &logFile)
+{
+    QList<NimUnitTiming> result;
+    QHash<QString, int> indexes;
+    QFile file(logFile.toString());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return result;
+    while (!file.atEnd()) {
+        const QStringList fields = QString::fromUtf8(file.readLine()).trimmed().split('\t');
+        if (fields.size() != 7)
+            continue;
+        NimUnitTiming timing;
+        timing.package = fields.at(0);
+        timing.version = fields.at(1);
+        timing.crate = fields.at(2);
+        timing.crateTypes = fields.at(3);
+        timing.features = fields.at(4).split(' ', QString::SkipEmptyParts);
+        timing.features.sort();
+        timing.cpuSeconds = fields.at(5).toDouble();
+        timing.cached = fields.at(6) == "cached";
+
+        // A cache hit says nothing about the compile cost, keep what was measured
+        const QString key = QStringList({timing.package, timing.version, timing.crate,
+                                         timing.crateTypes, timing.features.join(',')}).join('\t');
+        const int index = indexes.value(key, -1);
+        if (index < 0) {
+            indexes.insert(key, result.size());
+            result.append(timing);
+        } else if (!timing.cached || result.at(index).cached) {
+            result[index] = timing;
+        }
+    }
+    return result;
+}
+
+bool NimUnitTiming::writeLog(const FilePath &logFile, const QList<NimUnitTiming> &timings)
+{
+    QSaveFile file(logFile.toString());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    for (const NimUnitTiming &timing : timings) {
+        const QStringList fields = {timing.package, timing.version, timing.crate, timing.crateTypes,
+                                    timing.features.join(' '), QString::number(timing.cpuSeconds, 'f', 3),
+                                    timing.cached ? "cached" : "compiled"};
+        file.write(fields.join('\t').toUtf8() + '\n');
+    }
+    return file.commit();
+}
+
+FilePath NimRustcWrapper::installedScript(const QString &name)
+{
+    static QHash<QString, FilePath> installed;
+    if (installed.contains(name))
+        return installed.value(name);
+
+    QFile resource(":/rust/scripts/" + name);
+    QTC_ASSERT(resource.open(QIODevice::ReadOnly), return FilePath());
+    const QByteArray script = resource.readAll();
+
+    const QString path = cacheLocation() + '/' + name;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.readAll() != script) {
+        file.close();
+        QDir().mkpath(cacheLocation());
+        QTC_ASSERT(file.open(QIODevice::WriteOnly | QIODevice::Truncate), return FilePath());
+        file.write(script);
+    }
+    file.close();
+    file.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner
+                        | QFile::ReadGroup | QFile::ExeGroup
+                        | QFile::ReadOther | QFile::ExeOther);
+
+    installed.insert(name, FilePath::fromString(path));
+    return installed.value(name);
+}
+
+FilePath NimRustcWrapper::installedPath()
+{
+    return installedScript("rustc-wrapper.sh");
+}
+
+FilePath NimRustcWrapper::linkerWrapperPath()
+{
+    return installedScript("linker-wrapper.sh");
+}
+
+FilePath NimRustcWrapper::artifactCacheDirectory()
+{
+    return FilePath::fromString(cacheLocation() + "/artifacts");
+}
+
+FilePath NimRustcWrapper::logFile(const FilePath &targetDirectory, const QString &name)
+{
+    return targetDirectory.pathAppended(".rust-creator/" + name);
+}
+
+} // namespace Nim
@@ -0,0 +1,74 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <utils/fileutils.h>
+
+namespace Nim {
+
+class NimArtifactCacheStatistics
+{
+public:
+    int hits = 0;
+    int misses = 0;
+
+    static NimArtifactCacheStatistics fromLog(const Utils::FilePath &logFile);
+};
+
+// One line of the timings log written by the wrapper
+class NimUnitTiming
+{
+public:
+    QString package;
+    QString version;
+    QString crate;
+    QString crateTypes;
+    QStringList features;
+    double cpuSeconds = 0;
+    bool cached = false;
+
+    // The latest entry of every unit, earlier builds included
+    static QList<NimUnitTiming> fromLog(const Utils::FilePath &logFile);
+    // Replaces the log with the given entries
+    static bool writeLog(const Utils::FilePath &logFile, const QList<NimUnitTiming> &timings);
+};
+
+// The RUSTC_WRAPPER script shipped with the plugin, see scripts/rustc-wrapper.sh
+class NimRustcWrapper
+{
+public:
+    // Extracts a script of the plugin's resources to the cache directory
+    static Utils::FilePath installedScript(const QString &name);
+    static Utils::FilePath installedPath();
+    // The linker driver wrapper timing links, see scripts/linker-wrapper.sh
+    static Utils::FilePath linkerWrapperPath();
+    static Utils::FilePath artifactCacheDirectory();
+
+    // Per target directory files the wrapper writes to during a build
+    static Utils::FilePath logFile(const Utils::FilePath &targetDirectory, const QString &name);
+};
+
+} // namespace Nim
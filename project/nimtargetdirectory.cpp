@@ -0,0 +1,662 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "nimtargetdirectory.h"
+
+#include "nimbuildconfiguration.h"
+#include "nimproject.h"
+#include "nimutils.h"
+
+#include "../nimconstants.h"
+
+#include <coreplugin/icore.h>
+#include <coreplugin/messagemanager.h>
+#include <projectexplorer/buildmanager.h>
+#include <projectexplorer/kitinformation.h>
+#include <projectexplorer/target.h>
+#include <projectexplorer/toolchain.h>
+#include <utils/algorithm.h>
+
+#include <QDirIterator>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QMessageBox>
+#include <QRegularExpression>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <functional>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace ProjectExplorer;
+using namespace Utils;
+
+namespace Nim {
+
+const char KIND_FINGERPRINT[] = "fingerprint";
+const char KIND_DEPS[] = "deps";
+const char KIND_BUILD_SCRIPT[] = "build-script";
+const char KIND_INCREMENTAL[] = "incremental";
+const char KIND_EXAMPLES[] = "examples";
+const char KIND_OUTPUT[] = "output";
+const char KIND_DOC[] = "doc";
+const char KIND_OTHER[] = "other";
+
+const int DEFAULT_MAX_AGE_DAYS = 30;
+const int TOP_CRATES = 15;
+
+static QString normalizedCrateName(const QString &name)
+{
+    return QString(name).replace('-', '_');
+}
+
+// Cargo metadata hashes are 16 hex digits, incremental directories use a
+// shorter base36 suffix. Anything else after the last dash is part of the name.
+static bool looksLikeHash(const QString &text)
+{
+    if (text.size() < 10)
+        return false;
+    return Utils::allOf(text, [](const QChar &c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z');
+    });
+}
+
+static void parseUnitName(QString name, QString *crate, QString *hash)
+{
+    static const QStringList libraryExtensions = {"rlib", "rmeta", "so", "a", "dylib"};
+    const int dot = name.indexOf('.');
+    const bool isLibrary = dot > 0 && libraryExtensions.contains(name.mid(dot + 1));
+    if (dot > 0)
+        name.truncate(dot);
+    const int dash = name.lastIndexOf('-');
+    if (dash > 0 && looksLikeHash(name.mid(dash + 1))) {
+        *hash = name.mid(dash + 1);
+        name.truncate(dash);
+    }
+    if (isLibrary && name.startsWith("lib"))
+        name.remove(0, 3);
+    *crate = name;
+}
+
+static NimTargetArtifact makeArtifact(const QFileInfo &info, const QString &profile, const QString &kind)
+{
+    NimTargetArtifact artifact;
+    artifact.path = info.filePath();
+    artifact.profile = profile;
+    artifact.kind = kind;
+    artifact.lastModified = info.lastModified();
+    if (kind != KIND_OTHER)
+        parseUnitName(info.fileName(), &artifact.crate, &artifact.unitHash);
+    return artifact;
+}
+
+static QFileInfoList entries(const QString &path, QDir::Filters filters = QDir::AllEntries)
+{
+    return QDir(path).entryInfoList(filters | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System);
+}
+
+static bool isProfileDirectory(const QFileInfo &info)
+{
+    return info.isDir() && QFileInfo::exists(info.filePath() + "/.fingerprint");
+}
+
+static void collectProfile(const QFileInfo &profileDir, const QString &profile,
+                           QList<NimTargetArtifact> *artifacts)
+{
+    static const QMap<QString, QString> unitDirectories = {
+        {".fingerprint", KIND_FINGERPRINT},
+        {"deps", KIND_DEPS},
+        {"build", KIND_BUILD_SCRIPT},
+        {"examples", KIND_EXAMPLES}
+    };
+
+    for (const QFileInfo &entry : entries(profileDir.filePath())) {
+        const QString name = entry.fileName();
+        if (entry.isDir() && unitDirectories.contains(name)) {
+            for (const QFileInfo &unit : entries(entry.filePath()))
+                artifacts->append(makeArtifact(unit, profile, unitDirectories.value(name)));
+        } else if (entry.isDir() && name == "incremental") {
+            // One artifact per compilation session, named after its crate directory
+            for (const QFileInfo &crateDir : entries(entry.filePath(), QDir::Dirs)) {
+                const NimTargetArtifact crate = makeArtifact(crateDir, profile, KIND_INCREMENTAL);
+                for (const QFileInfo &session : entries(crateDir.filePath())) {
+                    NimTargetArtifact artifact = crate;
+                    artifact.path = session.filePath();
+                    artifact.lastModified = session.lastModified();
+                    artifacts->append(artifact);
+                }
+            }
+        } else {
+            artifacts->append(makeArtifact(entry, profile, KIND_OUTPUT));
+        }
+    }
+}
+
+NimBackgroundPriorityGuard::NimBackgroundPriorityGuard()
+    : m_priority(QThread::currentThread()->priority())
+{
+    QThread::currentThread()->setPriority(QThread::IdlePriority);
+#ifdef Q_OS_LINUX
+    m_ioPriority = syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, 0);
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+#endif
+}
+
+NimBackgroundPriorityGuard::~NimBackgroundPriorityGuard()
+{
+    QThread::currentThread()->setPriority(m_priority == QThread::InheritPriority
+                                          ? QThread::NormalPriority : m_priority);
+#ifdef Q_OS_LINUX
+    if (m_ioPriority >= 0)
+        syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, m_ioPriority);
+#endif
+}
+
+static qint64 allocatedBytes(const QString &path, bool skipHardLinks, bool *isDirectory)
+{
+#ifdef Q_OS_UNIX
+    struct stat st;
+    if (::lstat(QFile::encodeName(path).constData(), &st) != 0)
+        return 0;
+    *isDirectory = S_ISDIR(st.st_mode);
+    // Final outputs are hard links to files in deps/, don't count them twice
+    if (skipHardLinks && !*isDirectory && st.st_nlink > 1)
+        return 0;
+    return qint64(st.st_blocks) * 512;
+#else
+    Q_UNUSED(skipHardLinks)
+    const QFileInfo info(path);
+    *isDirectory = info.isDir();
+    return *isDirectory ? 0 : info.size();
+#endif
+}
+
+static qint64 diskUsage(const QString &path, bool skipHardLinks)
+{
+    bool isDirectory = false;
+    qint64 bytes = allocatedBytes(path, skipHardLinks, &isDirectory);
+    if (!isDirectory)
+        return bytes;
+
+    QDirIterator it(path, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext())
+        bytes += allocatedBytes(it.next(), false, &isDirectory);
+    return bytes;
+}
+
+static NimTargetArtifact measureArtifact(const NimTargetArtifact &artifact)
+{
+    const NimBackgroundPriorityGuard guard;
+    return NimTargetDirectory::measured(artifact);
+}
+
+// Walking a large target directory takes long as well, so the listing runs in
+// the background and the measurement is spread over the thread pool from there
+static QList<NimTargetArtifact> scanInBackground(const FilePath &targetDirectory)
+{
+    QList<NimTargetArtifact> artifacts;
+    {
+        const NimBackgroundPriorityGuard guard;
+        artifacts = NimTargetDirectory::collectArtifacts(targetDirectory);
+    }
+    return QtConcurrent::blockingMapped(artifacts, measureArtifact);
+}
+
+static qint64 pruneInBackground(const QList<NimPruneCandidate> &candidates)
+{
+    const NimBackgroundPriorityGuard guard;
+    return NimTargetDirectory::prune(candidates);
+}
+
+NimTargetDirectoryUsage NimTargetDirectory::usage(const FilePath &targetDirectory)
+{
+    NimTargetDirectoryUsage result;
+    QDirIterator it(targetDirectory.toString(),
+                    QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System | QDir::NoSymLinks,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        if (info.isDir()) {
+            if (info.dir().dirName() == ".fingerprint")
+                ++result.compiledUnits;
+        } else {
+            result.bytes += info.size();
+        }
+    }
+    return result;
+}
+
+NimTargetArtifact NimTargetDirectory::measured(const NimTargetArtifact &artifact)
+{
+    NimTargetArtifact result = artifact;
+    result.bytes = diskUsage(artifact.path, artifact.kind == KIND_OUTPUT);
+    return result;
+}
+
+QList<NimTargetArtifact> NimTargetDirectory::collectArtifacts(const FilePath &targetDirectory)
+{
+    QList<NimTargetArtifact> artifacts;
+    for (const QFileInfo &entry : entries(targetDirectory.toString())) {
+        if (isProfileDirectory(entry)) {
+            collectProfile(entry, entry.fileName(), &artifacts);
+        } else if (entry.isDir() && entry.fileName() == "doc") {
+            for (const QFileInfo &crate : entries(entry.filePath()))
+                artifacts.append(makeArtifact(crate, QString(), KIND_DOC));
+        } else if (entry.isDir() && Utils::anyOf(entries(entry.filePath(), QDir::Dirs), isProfileDirectory)) {
+            // Cross compilation: <target-dir>/<triple>/<profile>
+            for (const QFileInfo &profile : entries(entry.filePath(), QDir::Dirs)) {
+                if (isProfileDirectory(profile))
+                    collectProfile(profile, entry.fileName() + '/' + profile.fileName(), &artifacts);
+                else
+                    artifacts.append(makeArtifact(profile, entry.fileName(), KIND_OTHER));
+            }
+        } else {
+            artifacts.append(makeArtifact(entry, QString(), KIND_OTHER));
+        }
+    }
+    return artifacts;
+}
+
+NimTargetDirectoryReport NimTargetDirectory::summarize(const QList<NimTargetArtifact> &artifacts)
+{
+    NimTargetDirectoryReport report;
+    report.artifacts = artifacts;
+    for (const NimTargetArtifact &artifact : artifacts) {
+        report.totalBytes += artifact.bytes;
+        report.bytesByCrate[artifact.crate.isEmpty() ? QString("(none)") : artifact.crate] += artifact.bytes;
+        report.bytesByProfile[artifact.profile.isEmpty() ? QString("(none)") : artifact.profile] += artifact.bytes;
+        report.bytesByKind[artifact.kind] += artifact.bytes;
+    }
+    return report;
+}
+
+QMap<QString, int> NimTargetDirectory::lockedCrates(const FilePath &cargoLock)
+{
+    QMap<QString, int> result;
+    QFile file(cargoLock.toString());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return result;
+
+    static const QRegularExpression nameLine("^name\\s*=\\s*\"([^\"]+)\"");
+    bool inPackage = false;
+    while (!file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (line.startsWith('['))
+            inPackage = line == "[[package]]";
+        if (!inPackage)
+            continue;
+        const QRegularExpressionMatch match = nameLine.match(line);
+        if (match.hasMatch())
+            ++result[normalizedCrateName(match.captured(1))];
+    }
+    return result;
+}
+
+QMap<QString, QStringList> NimTargetDirectory::libraryNames(const QJsonDocument &metadata)
+{
+    static const QStringList libraryKinds = {"lib", "rlib", "dylib", "cdylib", "staticlib", "proc-macro"};
+    QMap<QString, QStringList> result;
+    for (const QJsonValue &package : metadata["packages"].toArray()) {
+        QStringList &names = result[normalizedCrateName(package["name"].toString())];
+        for (const QJsonValue &target : package["targets"].toArray()) {
+            const QJsonArray kinds = target["kind"].toArray();
+            if (Utils::anyOf(libraryKinds, [&kinds](const QString &kind) { return kinds.contains(kind); }))
+                names.append(normalizedCrateName(target["name"].toString()));
+        }
+    }
+    return result;
+}
+
+QList<NimPruneCandidate> NimTargetDirectory::pruneCandidates(const NimTargetDirectoryReport &report,
+                                                             const QMap<QString, int> &lockedCrates,
+                                                             const QMap<QString, QStringList> &libraryNames,
+                                                             const QStringList &workspaceTargets,
+                                                             int maxAgeDays)
+{
+    static const QStringList unitKinds = {KIND_FINGERPRINT, KIND_DEPS, KIND_BUILD_SCRIPT,
+                                          KIND_INCREMENTAL, KIND_EXAMPLES};
+
+    // Fingerprints and build scripts are named after the package, compiled
+    // libraries after their target
+    const bool checkLocked = !lockedCrates.isEmpty();
+    QSet<QString> knownCrates;
+    for (auto it = lockedCrates.cbegin(); it != lockedCrates.cend(); ++it) {
+        knownCrates.insert(it.key());
+        for (const QString &library : libraryNames.value(it.key()))
+            knownCrates.insert(library);
+    }
+    for (const QString &target : workspaceTargets)
+        knownCrates.insert(normalizedCrateName(target));
+
+    // Incremental sessions compete within their crate directory, compiled
+    // units with every other unit of the same crate, kind and profile
+    const auto groupKey = [](const NimTargetArtifact &artifact) {
+        QString key = artifact.profile + '/' + artifact.kind + '/' + artifact.crate;
+        if (artifact.kind == KIND_INCREMENTAL)
+            key += '-' + artifact.unitHash;
+        return key;
+    };
+
+    QHash<QString, QDateTime> newest;
+    for (const NimTargetArtifact &artifact : report.artifacts) {
+        if (!unitKinds.contains(artifact.kind) || artifact.crate.isEmpty())
+            continue;
+        QDateTime &date = newest[groupKey(artifact)];
+        if (!date.isValid() || artifact.lastModified > date)
+            date = artifact.lastModified;
+    }
+
+    const QDateTime now = QDateTime::currentDateTime();
+    QList<NimPruneCandidate> result;
+    for (const NimTargetArtifact &artifact : report.artifacts) {
+        if (!unitKinds.contains(artifact.kind) || artifact.crate.isEmpty())
+            continue;
+        const bool superseded = artifact.lastModified < newest.value(groupKey(artifact));
+        const qint64 ageDays = artifact.lastModified.daysTo(now);
+
+        if (artifact.kind == KIND_INCREMENTAL && superseded) {
+            result.append({artifact, QCoreApplication::translate("Nim::NimTargetDirectory",
+                                                                 "superseded incremental session")});
+        } else if (checkLocked && !knownCrates.contains(normalizedCrateName(artifact.crate))
+                   && ageDays >= 1) {
+            result.append({artifact, QCoreApplication::translate("Nim::NimTargetDirectory",
+                                                                 "not in Cargo.lock")});
+        } else if (superseded && ageDays >= maxAgeDays) {
+            result.append({artifact, QCoreApplication::translate("Nim::NimTargetDirectory",
+                                                                 "superseded, unused for %n days",
+                                                                 nullptr, int(ageDays))});
+        }
+    }
+    return result;
+}
+
+QList<NimPruneCandidate> NimTargetDirectory::evictionCandidates(const NimTargetDirectoryReport &report,
+                                                                qint64 maxBytes)
+{
+    QList<NimPruneCandidate> result;
+    qint64 excess = report.totalBytes - maxBytes;
+    if (excess <= 0)
+        return result;
+
+    static const QStringList unitKinds = {KIND_FINGERPRINT, KIND_DEPS, KIND_BUILD_SCRIPT};
+    QList<NimTargetArtifact> sessions;
+    QHash<QString, QList<NimTargetArtifact>> units;
+    QHash<QString, QDateTime> unitLastUsed;
+    for (const NimTargetArtifact &artifact : report.artifacts) {
+        if (artifact.kind == KIND_INCREMENTAL) {
+            sessions.append(artifact);
+        } else if (unitKinds.contains(artifact.kind) && !artifact.unitHash.isEmpty()) {
+            const QString key = artifact.profile + '/' + artifact.unitHash;
+            units[key].append(artifact);
+            QDateTime &lastUsed = unitLastUsed[key];
+            if (!lastUsed.isValid() || artifact.lastModified > lastUsed)
+                lastUsed = artifact.lastModified;
+        }
+    }
+
+    // Incremental sessions only speed up rebuilds of workspace crates, they
+    // go first. Compiled units are removed as a whole, fingerprint included.
+    std::sort(sessions.begin(), sessions.end(), [](const NimTargetArtifact &a, const NimTargetArtifact &b) {
+        return a.lastModified < b.lastModified;
+    });
+    for (const NimTargetArtifact &session : qAsConst(sessions)) {
+        if (excess <= 0)
+            return result;
+        result.append({session, QCoreApplication::translate("Nim::NimTargetDirectory",
+                                                            "least recently used incremental session")});
+        excess -= session.bytes;
+    }
+
+    QStringList keys = unitLastUsed.keys();
+    std::sort(keys.begin(), keys.end(), [&unitLastUsed](const QString &a, const QString &b) {
+        return unitLastUsed.value(a) < unitLastUsed.value(b);
+    });
+    for (const QString &key : qAsConst(keys)) {
+        if (excess <= 0)
+            break;
+        for (const NimTargetArtifact &artifact : units.value(key)) {
+            result.append({artifact, QCoreApplication::translate("Nim::NimTargetDirectory",
+                                                                 "least recently used compiled unit")});
+            excess -= artifact.bytes;
+        }
+    }
+    return result;
+}
+
+qint64 NimTargetDirectory::prune(const QList<NimPruneCandidate> &candidates)
+{
+    qint64 freed = 0;
+    for (const NimPruneCandidate &candidate : candidates) {
+        const QFileInfo info(candidate.artifact.path);
+        const bool removed = info.isDir() && !info.isSymLink()
+                ? QDir(info.filePath()).removeRecursively()
+                : QFile::remove(info.filePath());
+        if (removed)
+            freed += candidate.artifact.bytes;
+    }
+    return freed;
+}
+
+// NimTargetDirectoryCollector
+
+NimTargetDirectoryCollector::NimTargetDirectoryCollector(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_sequence, &NimCommandSequence::message, this, [](const QString &message) {
+        Core::MessageManager::write(message);
+    });
+    connect(&m_scanWatcher, &QFutureWatcherBase::finished,
+            this, &NimTargetDirectoryCollector::onScanFinished);
+    connect(&m_pruneWatcher, &QFutureWatcherBase::finished,
+            this, &NimTargetDirectoryCollector::onPruneFinished);
+}
+
+bool NimTargetDirectoryCollector::isRunning() const
+{
+    return m_sequence.isRunning() || m_scanWatcher.isRunning() || m_pruneWatcher.isRunning();
+}
+
+void NimTargetDirectoryCollector::run(NimBuildConfiguration *buildConfiguration)
+{
+    if (isRunning() || !buildConfiguration)
+        return;
+    m_buildConfiguration = buildConfiguration;
+    m_metadata = QJsonDocument();
+
+    // The workspace root with Cargo.lock and the library names of the
+    // dependencies. Without them, only superseded artifacts are pruned.
+    ToolChain *toolChain = ToolChainKitAspect::toolChain(buildConfiguration->target()->kit(),
+                                                         Constants::C_NIMLANGUAGE_ID);
+    if (!toolChain) {
+        startScan();
+        return;
+    }
+    const CommandLine metadata{toolChain->compilerCommand(),
+                               {"metadata", "--format-version", "1", "--offline", "--manifest-path",
+                                buildConfiguration->project()->projectFilePath().toString()}};
+    m_sequence.setWorkingDirectory(buildConfiguration->project()->projectDirectory());
+    m_sequence.setEnvironment(buildConfiguration->environment());
+    m_sequence.addCommand(metadata, [this](const NimCommandResult &result) {
+        if (result.success())
+            m_metadata = QJsonDocument::fromJson(result.standardOutput);
+    }, true);
+    m_sequence.addAction([this] { startScan(); });
+    m_sequence.start();
+}
+
+void NimTargetDirectoryCollector::startScan()
+{
+    if (!m_buildConfiguration)
+        return;
+    const FilePath targetDirectory = m_buildConfiguration->effectiveTargetDirectory();
+    Core::MessageManager::write(tr("Scanning %1...").arg(targetDirectory.toUserOutput()));
+    m_scanWatcher.setFuture(QtConcurrent::run(scanInBackground, targetDirectory));
+}
+
+void NimTargetDirectoryCollector::onScanFinished()
+{
+    if (!m_buildConfiguration)
+        return;
+
+    const NimTargetDirectoryReport report = NimTargetDirectory::summarize(m_scanWatcher.result());
+    m_bytesBefore = report.totalBytes;
+
+    QStringList lines;
+    lines << tr("Target directory %1: %2 MiB in %3 entries.")
+             .arg(m_buildConfiguration->effectiveTargetDirectory().toUserOutput())
+             .arg(NimUtils::toMiB(report.totalBytes)).arg(report.artifacts.size());
+
+    const auto appendTable = [&lines](const QString &title, const QMap<QString, qint64> &bytes, int limit) {
+        QList<QPair<qint64, QString>> rows;
+        for (auto it = bytes.cbegin(); it != bytes.cend(); ++it)
+            rows.append({it.value(), it.key()});
+        std::sort(rows.begin(), rows.end(), std::greater<QPair<qint64, QString>>());
+        lines << title;
+        for (const QPair<qint64, QString> &row : rows.mid(0, limit))
+            lines << QString("  %1 MiB\t%2").arg(NimUtils::toMiB(row.first), 8).arg(row.second);
+    };
+    appendTable(tr("By profile:"), report.bytesByProfile, -1);
+    appendTable(tr("By artifact kind:"), report.bytesByKind, -1);
+    appendTable(tr("Largest crates:"), report.bytesByCrate, TOP_CRATES);
+
+    // Workspace members share the Cargo.lock of the workspace root
+    auto project = static_cast<NimProject *>(m_buildConfiguration->project());
+    QMap<QString, int> lockedCrates;
+    if (!m_metadata.isNull()) {
+        const FilePath workspaceRoot = FilePath::fromString(m_metadata["workspace_root"].toString());
+        lockedCrates = NimTargetDirectory::lockedCrates(workspaceRoot.pathAppended("Cargo.lock"));
+    }
+    if (lockedCrates.isEmpty()) {
+        lines << tr("Cargo.lock or the dependency graph could not be read, artifacts of crates "
+                    "that are no longer locked are kept.");
+    }
+    const QList<NimPruneCandidate> candidates
+            = NimTargetDirectory::pruneCandidates(report, lockedCrates,
+                                                  NimTargetDirectory::libraryNames(m_metadata),
+                                                  project->workspaceTargets(),
+                                                  DEFAULT_MAX_AGE_DAYS);
+
+    QMap<QString, qint64> prunableBytes;
+    qint64 totalPrunable = 0;
+    for (const NimPruneCandidate &candidate : candidates) {
+        prunableBytes[candidate.reason] += candidate.artifact.bytes;
+        totalPrunable += candidate.artifact.bytes;
+    }
+    appendTable(tr("Stale artifacts:"), prunableBytes, -1);
+    Core::MessageManager::write(lines.join('\n'));
+
+    if (candidates.isEmpty())
+        return;
+
+    const QMessageBox::StandardButton answer
+            = QMessageBox::question(Core::ICore::dialogParent(),
+                                    tr("Prune Target Directory"),
+                                    tr("Remove %n stale artifacts (%1 MiB)?", nullptr, candidates.size())
+                                        .arg(NimUtils::toMiB(totalPrunable)));
+    if (answer != QMessageBox::Yes || !m_buildConfiguration)
+        return;
+    // A build or a copy of the target directory may have started while the question was open
+    if (BuildManager::isBuilding(project) || m_buildConfiguration->isTargetDirectoryBusy()) {
+        Core::MessageManager::write(tr("The target directory is in use by a build, prune it "
+                                       "again when the build has finished."));
+        return;
+    }
+
+    m_buildConfiguration->setTargetDirectoryPruning(true);
+    m_pruneWatcher.setFuture(QtConcurrent::run(pruneInBackground, candidates));
+}
+
+void NimTargetDirectoryCollector::onPruneFinished()
+{
+    if (m_buildConfiguration)
+        m_buildConfiguration->setTargetDirectoryPruning(false);
+    const qint64 freed = m_pruneWatcher.result();
+    Core::MessageManager::write(tr("Target directory pruned: %1 MiB before, %2 MiB after.")
+                                    .arg(NimUtils::toMiB(m_bytesBefore))
+                                    .arg(NimUtils::toMiB(m_bytesBefore - freed)));
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QTest>
+
+namespace Nim {
+
+void RustPlugin::testTargetDirectoryPrune()
+{
+    const QDateTime old = QDateTime::currentDateTime().addDays(-2);
+    const auto artifact = [&old](const QString &kind, const QString &crate, const QString &hash) {
+        NimTargetArtifact result;
+        result.path = "debug/" + kind + '/' + crate + '-' + hash;
+        result.profile = "debug";
+        result.kind = kind;
+        result.crate = crate;
+        result.unitHash = hash;
+        result.lastModified = old;
+        return result;
+    };
+    const NimTargetDirectoryReport report = NimTargetDirectory::summarize(
+                {artifact(KIND_DEPS, "md5", "0123456789abcdef"),
+                 artifact(KIND_FINGERPRINT, "md-5", "0123456789abcdef"),
+                 artifact(KIND_DEPS, "app", "fedcba9876543210"),
+                 artifact(KIND_DEPS, "removed", "00112233445566aa")});
+
+    const QJsonDocument metadata = QJsonDocument::fromJson(R"({"packages": [
+        {"name": "md-5", "targets": [{"name": "md5", "kind": ["lib"]}]},
+        {"name": "app", "targets": [{"name": "app", "kind": ["bin"]}]}
+    ]})");
+    const QMap<QString, QStringList> libraryNames = NimTargetDirectory::libraryNames(metadata);
+    QCOMPARE(libraryNames.value("md_5"), QStringList("md5"));
+
+    QMap<QString, int> lockedCrates;
+    lockedCrates["md_5"] = 1;
+    lockedCrates["app"] = 1;
+    QList<NimPruneCandidate> candidates = NimTargetDirectory::pruneCandidates(report, lockedCrates,
+                                                                              libraryNames, {"app"}, 30);
+    QCOMPARE(candidates.size(), 1);
+    QCOMPARE(candidates.first().artifact.crate, QString("removed"));
+
+    // Without Cargo.lock, every crate could still be in use
+    candidates = NimTargetDirectory::pruneCandidates(report, {}, libraryNames, {"app"}, 30);
+    QVERIFY(candidates.isEmpty());
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
@@ -0,0 +1,155 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include "nimcommandsequence.h"
+
+#include <utils/fileutils.h>
+
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QJsonDocument>
+#include <QMap>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QThread>
+
+namespace Nim {
+
+class NimBuildConfiguration;
+
+// Lowers the CPU and I/O priority of the current thread for its lifetime,
+// for background work on target directories that must not slow down builds
+class NimBackgroundPriorityGuard
+{
+public:
+    NimBackgroundPriorityGuard();
+    ~NimBackgroundPriorityGuard();
+
+private:
+#ifdef Q_OS_LINUX
+    // From linux/ioprio.h, which is not always installed
+    enum { IOPRIO_WHO_PROCESS = 1, IOPRIO_CLASS_IDLE = 3, IOPRIO_CLASS_SHIFT = 13 };
+    long m_ioPriority = -1;
+#endif
+    QThread::Priority m_priority;
+};
+
+class NimTargetDirectoryUsage
+{
+public:
+    qint64 bytes = 0;
+    int compiledUnits = 0; // one .fingerprint entry per compiled unit
+};
+
+// A top-level entry of a profile directory, e.g. one compiled unit in deps/
+// or one incremental compilation session
+class NimTargetArtifact
+{
+public:
+    QString path;
+    QString profile;
+    QString kind;
+    QString crate;
+    QString unitHash;
+    QDateTime lastModified;
+    qint64 bytes = 0;
+};
+
+class NimTargetDirectoryReport
+{
+public:
+    QList<NimTargetArtifact> artifacts;
+    qint64 totalBytes = 0;
+    QMap<QString, qint64> bytesByCrate;
+    QMap<QString, qint64> bytesByProfile;
+    QMap<QString, qint64> bytesByKind;
+};
+
+class NimPruneCandidate
+{
+public:
+    NimTargetArtifact artifact;
+    QString reason;
+};
+
+class NimTargetDirectory
+{
+public:
+    static NimTargetDirectoryUsage usage(const Utils::FilePath &targetDirectory);
+
+    static QList<NimTargetArtifact> collectArtifacts(const Utils::FilePath &targetDirectory);
+    static NimTargetArtifact measured(const NimTargetArtifact &artifact);
+    static NimTargetDirectoryReport summarize(const QList<NimTargetArtifact> &artifacts);
+
+    // Crate names (with dashes normalized to underscores) and the number of
+    // versions of each locked in Cargo.lock
+    static QMap<QString, int> lockedCrates(const Utils::FilePath &cargoLock);
+    // The library target names of the packages in cargo metadata by package
+    // name, both normalized. Units in deps/ are named after the library,
+    // which can differ from the package, like md5 from md-5.
+    static QMap<QString, QStringList> libraryNames(const QJsonDocument &metadata);
+
+    // Without locked crates, nothing is removed for not being in Cargo.lock
+    static QList<NimPruneCandidate> pruneCandidates(const NimTargetDirectoryReport &report,
+                                                    const QMap<QString, int> &lockedCrates,
+                                                    const QMap<QString, QStringList> &libraryNames,
+                                                    const QStringList &workspaceTargets,
+                                                    int maxAgeDays);
+    // Least recently used artifacts to remove to shrink below maxBytes
+    static QList<NimPruneCandidate> evictionCandidates(const NimTargetDirectoryReport &report,
+                                                       qint64 maxBytes);
+    static qint64 prune(const QList<NimPruneCandidate> &candidates);
+};
+
+// Scans a target directory in the background with idle CPU and I/O
+// priority, reports where the disk space goes and offers to remove stale
+// artifacts.
+class NimTargetDirectoryCollector : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NimTargetDirectoryCollector(QObject *parent = nullptr);
+
+    bool isRunning() const;
+    void run(NimBuildConfiguration *buildConfiguration);
+
+private:
+    void startScan();
+    void onScanFinished();
+    void onPruneFinished();
+
+    QPointer<NimBuildConfiguration> m_buildConfiguration;
+    NimCommandSequence m_sequence;
+    QJsonDocument m_metadata;
+    QFutureWatcher<QList<NimTargetArtifact>> m_scanWatcher;
+    QFutureWatcher<qint64> m_pruneWatcher;
+    qint64 m_bytesBefore = 0;
+};
+
+} // namespace Nim
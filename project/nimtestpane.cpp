@@ -0,0 +1,380 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimtestpane.h"
+
+#include "nimbuildconfiguration.h"
+
+#include "../profiler/nimbenchmarks.h"
+
+#include <coreplugin/messagemanager.h>
+#include <projectexplorer/project.h>
+#include <projectexplorer/session.h>
+#include <projectexplorer/target.h>
+#include <utils/theme/theme.h>
+
+#include <QComboBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QSplitter>
+#include <QStackedWidget>
+#include <QToolButton>
+#include <QTreeWidget>
+
+#include <algorithm>
+
+using namespace ProjectExplorer;
+using namespace Utils;
+
+namespace Nim {
+
+static NimTestPane *m_instance = nullptr;
+
+enum TestColumn { TestNameColumn, ResultColumn, DurationColumn, AverageColumn };
+const int OutputRole = Qt::UserRole;
+const int OutcomeRole = Qt::UserRole + 1;
+
+enum SlowestTestColumn { SlowestNameColumn, SlowestAverageColumn, SlowestLatestColumn, RunsColumn, BinaryColumn };
+const int MAX_SLOWEST_TESTS = 50;
+
+enum View { AllTestsView, FailedTestsView, SlowestTestsView };
+
+static QString formatSeconds(double seconds)
+{
+    return seconds < 0 ? QString() : NimBenchmarks::formatDuration(seconds * 1e9);
+}
+
+static QString outcomeText(NimTestResult::Outcome outcome)
+{
+    switch (outcome) {
+    case NimTestResult::Running:
+        return NimTestPane::tr("Running");
+    case NimTestResult::Passed:
+        return NimTestPane::tr("Passed");
+    case NimTestResult::Failed:
+        return NimTestPane::tr("Failed");
+    case NimTestResult::Ignored:
+        return NimTestPane::tr("Ignored");
+    default:
+        return QString();
+    }
+}
+
+NimTestPane::NimTestPane()
+    : m_stack(new QStackedWidget)
+    , m_splitter(new QSplitter)
+    , m_tests(new QTreeWidget)
+    , m_output(new QPlainTextEdit)
+    , m_slowestTests(new QTreeWidget)
+    , m_runButton(new QToolButton)
+    , m_rerunFailedButton(new QToolButton)
+    , m_stopButton(new QToolButton)
+    , m_viewComboBox(new QComboBox)
+    , m_summaryLabel(new QLabel)
+{
+    m_instance = this;
+
+    m_tests->setHeaderLabels({tr("Test"), tr("Result"), tr("Duration"), tr("Average")});
+    m_tests->setUniformRowHeights(true);
+    m_tests->header()->setSectionResizeMode(TestNameColumn, QHeaderView::Stretch);
+    m_tests->header()->setStretchLastSection(false);
+    m_output->setReadOnly(true);
+    m_output->setPlaceholderText(tr("The output of the selected failed test"));
+    m_splitter->addWidget(m_tests);
+    m_splitter->addWidget(m_output);
+    m_splitter->setStretchFactor(0, 2);
+    m_splitter->setStretchFactor(1, 1);
+    m_slowestTests->setHeaderLabels({tr("Test"), tr("Average"), tr("Latest"), tr("Runs"), tr("Binary")});
+    m_slowestTests->setRootIsDecorated(false);
+    m_slowestTests->setUniformRowHeights(true);
+    m_slowestTests->header()->setSectionResizeMode(SlowestNameColumn, QHeaderView::Stretch);
+    m_slowestTests->header()->setStretchLastSection(false);
+    m_stack->addWidget(m_splitter);
+    m_stack->addWidget(m_slowestTests);
+
+    m_runButton->setText(tr("Run All"));
+    m_runButton->setToolTip(tr("Build and run the tests of the startup project"));
+    m_rerunFailedButton->setText(tr("Rerun Failed"));
+    m_rerunFailedButton->setToolTip(tr("Build and run the tests that failed in the previous run"));
+    m_stopButton->setText(tr("Stop"));
+    m_viewComboBox->addItems({tr("All Tests"), tr("Failed Tests"), tr("Slowest Tests")});
+    m_viewComboBox->setSizeAdjustPolicy(QComboBox::AdjustToContents);
+    updateButtons();
+
+    connect(m_runButton, &QToolButton::clicked, this, [this] { runTests(false); });
+    connect(m_rerunFailedButton, &QToolButton::clicked, this, [this] { runTests(true); });
+    connect(m_stopButton, &QToolButton::clicked, &m_runner, &NimTestRunner::stop);
+    connect(m_viewComboBox, QOverload<int>::of(&QComboBox::activated), this, &NimTestPane::updateFilter);
+    connect(m_tests, &QTreeWidget::currentItemChanged, this, &NimTestPane::showOutput);
+
+    connect(&m_runner, &NimTestRunner::started, this, &NimTestPane::showTests);
+    connect(&m_runner, &NimTestRunner::resultChanged, this, &NimTestPane::updateResult);
+    connect(&m_runner, &NimTestRunner::finished, this, [this](int passed, int failed, int ignored) {
+        m_summaryLabel->setText(tr("%1 passed, %2 failed, %3 ignored").arg(passed).arg(failed).arg(ignored));
+        if (m_buildConfiguration)
+            m_durations = NimTestDurations::read(NimTestDurations::file(m_buildConfiguration));
+        updateSlowestTests();
+        updateButtons();
+        if (failed > 0)
+            flash();
+    });
+    connect(&m_runner, &NimTestRunner::message, this, [](const QString &message) {
+        Core::MessageManager::write(message);
+    });
+}
+
+NimTestPane::~NimTestPane()
+{
+    m_instance = nullptr;
+    delete m_stack;
+    qDeleteAll(toolBarWidgets());
+}
+
+NimTestPane *NimTestPane::instance()
+{
+    return m_instance;
+}
+
+void NimTestPane::runTests(bool failedOnly)
+{
+    if (m_runner.isRunning())
+        return;
+    Project *project = SessionManager::startupProject();
+    auto buildConfiguration = project && project->activeTarget()
+            ? qobject_cast<NimBuildConfiguration *>(project->activeTarget()->activeBuildConfiguration())
+            : nullptr;
+    if (!buildConfiguration) {
+        Core::MessageManager::write(tr("Running tests needs a Rust project with a build configuration."));
+        return;
+    }
+    m_buildConfiguration = buildConfiguration;
+    m_durations = NimTestDurations::read(NimTestDurations::file(buildConfiguration));
+    m_runner.run(buildConfiguration, failedOnly);
+    if (m_runner.isRunning()) {
+        m_summaryLabel->setText(tr("Building..."));
+        popup(IOutputPane::NoModeSwitch);
+    }
+    updateButtons();
+}
+
+void NimTestPane::showTests(const QVector<NimTestResult> &tests)
+{
+    m_tests->clear();
+    m_output->clear();
+    m_items.clear();
+    m_binaryItems.clear();
+    m_testCount = tests.size();
+    m_finishedCount = 0;
+    m_failedCount = 0;
+    for (const NimTestResult &test : tests) {
+        QTreeWidgetItem *&binaryItem = m_binaryItems[test.binary];
+        if (!binaryItem) {
+            binaryItem = new QTreeWidgetItem(m_tests, {test.binary});
+            binaryItem->setExpanded(tests.size() < 100);
+        }
+        auto item = new QTreeWidgetItem(binaryItem, {test.name});
+        item->setToolTip(TestNameColumn, test.name);
+        item->setData(TestNameColumn, OutcomeRole, int(test.outcome));
+        item->setText(AverageColumn, formatSeconds(NimTestDurations::mean(m_durations.value(test.key()))));
+        item->setTextAlignment(DurationColumn, Qt::AlignRight);
+        item->setTextAlignment(AverageColumn, Qt::AlignRight);
+        m_items.insert(test.key(), item);
+    }
+    m_summaryLabel->setText(tr("0 of %1 tests").arg(m_testCount));
+    updateFilter();
+}
+
+void NimTestPane::updateResult(const NimTestResult &result)
+{
+    QTreeWidgetItem *item = m_items.value(result.key());
+    if (!item)
+        return;
+    const auto previous = NimTestResult::Outcome(item->data(TestNameColumn, OutcomeRole).toInt());
+    const bool wasFinished = previous == NimTestResult::Passed || previous == NimTestResult::Failed
+            || previous == NimTestResult::Ignored;
+    const bool isFinished = result.outcome == NimTestResult::Passed || result.outcome == NimTestResult::Failed
+            || result.outcome == NimTestResult::Ignored;
+    m_finishedCount += int(isFinished) - int(wasFinished);
+    m_failedCount += int(result.outcome == NimTestResult::Failed) - int(previous == NimTestResult::Failed);
+
+    item->setData(TestNameColumn, OutcomeRole, int(result.outcome));
+    item->setData(TestNameColumn, OutputRole, result.output);
+    item->setText(ResultColumn, outcomeText(result.outcome));
+    item->setText(DurationColumn, formatSeconds(result.seconds));
+    if (result.outcome == NimTestResult::Failed) {
+        item->setForeground(ResultColumn, creatorTheme()->color(Theme::TextColorError));
+        item->parent()->setExpanded(true);
+        item->parent()->setForeground(TestNameColumn, creatorTheme()->color(Theme::TextColorError));
+    }
+    if (m_viewComboBox->currentIndex() == FailedTestsView)
+        updateFilter();
+    if (m_tests->currentItem() == item)
+        showOutput(item);
+    m_summaryLabel->setText(tr("%1 of %2 tests, %3 failed").arg(m_finishedCount).arg(m_testCount)
+                                .arg(m_failedCount));
+}
+
+void NimTestPane::updateFilter()
+{
+    const int view = m_viewComboBox->currentIndex();
+    if (view == SlowestTestsView) {
+        updateSlowestTests();
+        m_stack->setCurrentWidget(m_slowestTests);
+        return;
+    }
+    m_stack->setCurrentWidget(m_splitter);
+    for (int i = 0; i < m_tests->topLevelItemCount(); ++i) {
+        QTreeWidgetItem *binaryItem = m_tests->topLevelItem(i);
+        bool anyVisible = false;
+        for (int j = 0; j < binaryItem->childCount(); ++j) {
+            QTreeWidgetItem *item = binaryItem->child(j);
+            const bool visible = view == AllTestsView
+                    || item->data(TestNameColumn, OutcomeRole).toInt() == NimTestResult::Failed;
+            item->setHidden(!visible);
+            anyVisible = anyVisible || visible;
+        }
+        binaryItem->setHidden(!anyVisible);
+    }
+}
+
+void NimTestPane::updateSlowestTests()
+{
+    m_slowestTests->clear();
+    QStringList keys = m_durations.keys();
+    std::sort(keys.begin(), keys.end(), [this](const QString &a, const QString &b) {
+        return NimTestDurations::mean(m_durations.value(a)) > NimTestDurations::mean(m_durations.value(b));
+    });
+    for (const QString &key : keys.mid(0, MAX_SLOWEST_TESTS)) {
+        const QVector<double> seconds = m_durations.value(key);
+        if (seconds.isEmpty())
+            continue;
+        auto item = new QTreeWidgetItem(m_slowestTests);
+        item->setText(SlowestNameColumn, key.section('\t', 1));
+        item->setToolTip(SlowestNameColumn, key.section('\t', 1));
+        item->setText(SlowestAverageColumn, formatSeconds(NimTestDurations::mean(seconds)));
+        item->setText(SlowestLatestColumn, formatSeconds(seconds.last()));
+        item->setText(RunsColumn, QString::number(seconds.size()));
+        item->setText(BinaryColumn, key.section('\t', 0, 0));
+        for (int column = SlowestAverageColumn; column <= RunsColumn; ++column)
+            item->setTextAlignment(column, Qt::AlignRight);
+    }
+}
+
+void NimTestPane::updateButtons()
+{
+    const bool running = m_runner.isRunning();
+    m_runButton->setEnabled(!running);
+    m_rerunFailedButton->setEnabled(!running && m_runner.hasFailedTests());
+    m_stopButton->setEnabled(running);
+}
+
+void NimTestPane::showOutput(QTreeWidgetItem *item)
+{
+    m_output->setPlainText(item ? item->data(TestNameColumn, OutputRole).toString() : QString());
+}
+
+QWidget *NimTestPane::outputWidget(QWidget *parent)
+{
+    m_stack->setParent(parent);
+    return m_stack;
+}
+
+QList<QWidget *> NimTestPane::toolBarWidgets() const
+{
+    return {m_runButton, m_rerunFailedButton, m_stopButton, m_viewComboBox, m_summaryLabel};
+}
+
+QString NimTestPane::displayName() const
+{
+    return tr("Rust Tests");
+}
+
+int NimTestPane::priorityInStatusBar() const
+{
+    return 5;
+}
+
+void NimTestPane::clearContents()
+{
+    m_tests->clear();
+    m_output->clear();
+    m_items.clear();
+    m_binaryItems.clear();
+    m_summaryLabel->clear();
+}
+
+void NimTestPane::visibilityChanged(bool visible)
+{
+    if (!visible || m_buildConfiguration)
+        return;
+    Project *project = SessionManager::startupProject();
+    if (!project || !project->activeTarget())
+        return;
+    if (auto buildConfiguration = qobject_cast<NimBuildConfiguration *>(
+                project->activeTarget()->activeBuildConfiguration())) {
+        m_durations = NimTestDurations::read(NimTestDurations::file(buildConfiguration));
+        updateSlowestTests();
+    }
+}
+
+void NimTestPane::setFocus()
+{
+    m_tests->setFocus();
+}
+
+bool NimTestPane::hasFocus() const
+{
+    return m_tests->hasFocus();
+}
+
+bool NimTestPane::canFocus() const
+{
+    return true;
+}
+
+bool NimTestPane::canNavigate() const
+{
+    return false;
+}
+
+bool NimTestPane::canNext() const
+{
+    return false;
+}
+
+bool NimTestPane::canPrevious() const
+{
+    return false;
+}
+
+void NimTestPane::goToNext()
+{}
+
+void NimTestPane::goToPrev()
+{}
+
+} // namespace Nim
@@ -0,0 +1,105 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include "nimtestrunner.h"
+
+#include <coreplugin/ioutputpane.h>
+
+QT_BEGIN_NAMESPACE
+class QComboBox;
+class QLabel;
+class QPlainTextEdit;
+class QSplitter;
+class QStackedWidget;
+class QToolButton;
+class QTreeWidget;
+class QTreeWidgetItem;
+QT_END_NAMESPACE
+
+namespace Nim {
+
+// Runs the tests of the startup project with NimTestRunner and shows their
+// results as they come in, grouped by test binary, with the output of the
+// selected failed test, and the tests that took longest on average
+class NimTestPane : public Core::IOutputPane
+{
+    Q_OBJECT
+
+public:
+    NimTestPane();
+    ~NimTestPane() override;
+
+    static NimTestPane *instance();
+
+    // In the active build configuration of the startup project
+    void runTests(bool failedOnly);
+
+    QWidget *outputWidget(QWidget *parent) override;
+    QList<QWidget *> toolBarWidgets() const override;
+    QString displayName() const override;
+    int priorityInStatusBar() const override;
+    void clearContents() override;
+    void visibilityChanged(bool visible) override;
+    void setFocus() override;
+    bool hasFocus() const override;
+    bool canFocus() const override;
+    bool canNavigate() const override;
+    bool canNext() const override;
+    bool canPrevious() const override;
+    void goToNext() override;
+    void goToPrev() override;
+
+private:
+    void showTests(const QVector<NimTestResult> &tests);
+    void updateResult(const NimTestResult &result);
+    void updateFilter();
+    void updateSlowestTests();
+    void updateButtons();
+    void showOutput(QTreeWidgetItem *item);
+
+    NimTestRunner m_runner;
+    QPointer<NimBuildConfiguration> m_buildConfiguration;
+    QHash<QString, QVector<double>> m_durations;
+    QHash<QString, QTreeWidgetItem *> m_items;
+    QHash<QString, QTreeWidgetItem *> m_binaryItems;
+    int m_testCount = 0;
+    int m_finishedCount = 0;
+    int m_failedCount = 0;
+    QStackedWidget *m_stack;
+    QSplitter *m_splitter;
+    QTreeWidget *m_tests;
+    QPlainTextEdit *m_output;
+    QTreeWidget *m_slowestTests;
+    QToolButton *m_runButton;
+    QToolButton *m_rerunFailedButton;
+    QToolButton *m_stopButton;
+    QComboBox *m_viewComboBox;
+    QLabel *m_summaryLabel;
+};
+
+} // namespace Nim
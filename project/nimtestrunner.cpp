@@ -0,0 +1,510 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimtestrunner.h"
+
+#include "nimbuildconfiguration.h"
+#include "nimcargomessages.h"
+#include "nimcompilerbuildstep.h"
+#include "nimdatadirectory.h"
+
+#include <projectexplorer/project.h>
+#include <utils/qtcassert.h>
+
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+
+#include <algorithm>
+#include <numeric>
+
+using namespace ProjectExplorer;
+using namespace Utils;
+
+namespace Nim {
+
+const int MAX_DURATIONS = 10;
+// For tests that have not run before
+const double DEFAULT_TEST_SECONDS = 0.01;
+
+// NimTestDurations
+
+FilePath NimTestDurations::file(const NimBuildConfiguration *buildConfiguration)
+{
+    return NimDataDirectory::forBuildConfiguration(buildConfiguration).pathAppended("tests/durations");
+}
+
+QHash<QString, QVector<double>> NimTestDurations::read(const FilePath &path)
+{
+    QHash<QString, QVector<double>> durations;
+    QFile file(path.toString());
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return durations;
+    while (!file.atEnd()) {
+        const QStringList fields = QString::fromUtf8(file.readLine()).trimmed().split('\t');
+        if (fields.size() != 3)
+            continue;
+        QVector<double> &seconds = durations[fields.at(0) + '\t' + fields.at(1)];
+        for (const QString &value : fields.at(2).split(',', QString::SkipEmptyParts))
+            seconds.append(value.toDouble());
+    }
+    return durations;
+}
+
+bool NimTestDurations::write(const FilePath &path, const QHash<QString, QVector<double>> &durations)
+{
+    QDir().mkpath(path.parentDir().toString());
+    QFile file(path.toString());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+    QByteArray contents;
+    for (auto it = durations.cbegin(); it != durations.cend(); ++it) {
+        QByteArrayList values;
+        for (double seconds : it.value().mid(qMax(0, it.value().size() - MAX_DURATIONS)))
+            values << QByteArray::number(seconds, 'g', 6);
+        contents += it.key().toUtf8() + '\t' + values.join(',') + '\n';
+    }
+    return file.write(contents) == contents.size();
+}
+
+double NimTestDurations::mean(const QVector<double> &seconds)
+{
+    if (seconds.isEmpty())
+        return -1;
+    return std::accumulate(seconds.begin(), seconds.end(), 0.0) / seconds.size();
+}
+
+// NimTestRunner
+
+NimTestRunner::NimTestRunner(QObject *parent)
+    : QObject(parent)
+{
+    qRegisterMetaType<NimTestResult>();
+    connect(&m_sequence, &NimCommandSequence::message, this, &NimTestRunner::message);
+    connect(&m_sequence, &NimCommandSequence::finished, this, [this](bool success) {
+        if (success || !m_running)
+            return;
+        emit message(tr("The tests could not be built."));
+        m_running = false;
+        emit finished(0, 0, 0);
+    });
+}
+
+NimTestRunner::~NimTestRunner()
+{
+    m_sequence.cancel();
+    for (QProcess *process : m_shards.keys()) {
+        process->disconnect(this);
+        process->kill();
+        process->waitForFinished(1000);
+        delete process;
+    }
+}
+
+bool NimTestRunner::isRunning() const
+{
+    return m_running;
+}
+
+bool NimTestRunner::hasFailedTests() const
+{
+    return !m_failed.isEmpty();
+}
+
+void NimTestRunner::run(NimBuildConfiguration *buildConfiguration, bool failedOnly)
+{
+    if (isRunning() || !buildConfiguration)
+        return;
+    NimCompilerBuildStep *buildStep = buildConfiguration->nimCompilerBuildStep();
+    if (!buildStep) {
+        emit message(tr("Running tests needs a build step."));
+        return;
+    }
+    if (failedOnly && m_failed.isEmpty()) {
+        emit message(tr("No test failed in the previous run."));
+        return;
+    }
+
+    m_buildConfiguration = buildConfiguration;
+    m_failedOnly = failedOnly;
+    m_canceled = false;
+    m_running = true;
+    m_binaries.clear();
+    m_queue.clear();
+    m_results.clear();
+    m_durations = NimTestDurations::read(NimTestDurations::file(buildConfiguration));
+    m_environment = buildConfiguration->environment();
+    // libtest's JSON report is unstable, this makes stable toolchains accept it
+    m_environment.set("RUSTC_BOOTSTRAP", "1");
+
+    CommandLine build = buildStep->cargoCommand("test");
+    build.addArgs({"--no-run", "--message-format=json-render-diagnostics"});
+    emit message(tr("Building the tests..."));
+    m_sequence.setWorkingDirectory(buildConfiguration->project()->projectDirectory());
+    m_sequence.setEnvironment(buildStep->cargoEnvironment());
+    m_sequence.addCommand(build, [this](const NimCommandResult &result) {
+        if (result.success())
+            listTests(result.standardOutput);
+    });
+    m_sequence.start();
+}
+
+void NimTestRunner::stop()
+{
+    if (!m_running)
+        return;
+    m_canceled = true;
+    m_queue.clear();
+    if (m_sequence.isRunning()) {
+        m_sequence.cancel();
+        m_running = false;
+        emit finished(0, 0, 0);
+        return;
+    }
+    // The shards finish one by one, the last one finishes the run
+    for (QProcess *process : m_shards.keys())
+        process->kill();
+}
+
+void NimTestRunner::listTests(const QByteArray &cargoMessages)
+{
+    m_sequence.addAction([this] { m_sequence.setEnvironment(m_environment); });
+    for (const NimCargoExecutable &executable : NimCargoMessages::executables(cargoMessages)) {
+        if (!executable.test)
+            continue;
+        Binary binary;
+        binary.packageDirectory = executable.manifestPath.parentDir();
+        binary.name = QString("%1/%2 (%3)").arg(binary.packageDirectory.fileName(), executable.name,
+                                                executable.kinds.value(0));
+        binary.path = executable.path;
+        const int index = m_binaries.size();
+        m_binaries.append(binary);
+        // Optional, binaries with their own harness may not list anything
+        m_sequence.addCommand(CommandLine(executable.path, {"--list", "--format", "terse"}),
+                              [this, index](const NimCommandResult &result) {
+            if (!result.success())
+                return;
+            for (const QByteArray &line : result.standardOutput.split('\n')) {
+                if (line.endsWith(": test"))
+                    m_binaries[index].tests.append(QString::fromUtf8(line.left(line.size() - 6)));
+            }
+        }, true);
+    }
+    m_sequence.addAction([this] { schedule(); });
+}
+
+QVector<QStringList> NimTestRunner::shard(const QStringList &tests, const QHash<QString, double> &seconds,
+                                          int shardCount)
+{
+    QStringList order = tests;
+    std::stable_sort(order.begin(), order.end(), [&seconds](const QString &a, const QString &b) {
+        return seconds.value(a) > seconds.value(b);
+    });
+    QVector<QStringList> shards(qMin(shardCount, int(tests.size())));
+    QVector<double> load(shards.size(), 0);
+    for (const QString &test : qAsConst(order)) {
+        int least = 0;
+        for (int i = 1; i < shards.size(); ++i) {
+            if (load.at(i) < load.at(least)
+                    || (load.at(i) == load.at(least) && shards.at(i).size() < shards.at(least).size())) {
+                least = i;
+            }
+        }
+        shards[least].append(test);
+        load[least] += seconds.value(test);
+    }
+    return shards;
+}
+
+void NimTestRunner::schedule()
+{
+    const int jobs = qMax(1, QThread::idealThreadCount());
+    QVector<NimTestResult> planned;
+    for (int index = 0; index < m_binaries.size(); ++index) {
+        const Binary &binary = m_binaries.at(index);
+        QStringList tests;
+        QHash<QString, double> seconds;
+        for (const QString &test : binary.tests) {
+            NimTestResult result;
+            result.binary = binary.name;
+            result.name = test;
+            if (m_failedOnly && !m_failed.contains(result.key()))
+                continue;
+            const double mean = NimTestDurations::mean(m_durations.value(result.key()));
+            tests.append(test);
+            seconds.insert(test, mean >= 0 ? mean : DEFAULT_TEST_SECONDS);
+            m_results.insert(result.key(), result);
+            planned.append(result);
+        }
+        for (const QStringList &shardTests : shard(tests, seconds, jobs)) {
+            Shard shard;
+            shard.binary = index;
+            shard.tests = shardTests;
+            for (const QString &test : shardTests)
+                shard.seconds += seconds.value(test);
+            m_queue.append(shard);
+        }
+    }
+    std::stable_sort(m_queue.begin(), m_queue.end(), [](const Shard &a, const Shard &b) {
+        return a.seconds > b.seconds;
+    });
+
+    if (planned.isEmpty()) {
+        emit message(m_failedOnly ? tr("None of the failed tests exists anymore.") : tr("No tests were found."));
+        m_running = false;
+        emit finished(0, 0, 0);
+        return;
+    }
+    emit message(tr("Running %n test(s) in %1 shard(s), %2 at a time...", nullptr, planned.size())
+                     .arg(m_queue.size()).arg(jobs));
+    emit started(planned);
+    startShards();
+}
+
+void NimTestRunner::startShards()
+{
+    const int jobs = qMax(1, QThread::idealThreadCount());
+    while (!m_canceled && m_shards.size() < jobs && !m_queue.isEmpty()) {
+        const Shard shard = m_queue.takeFirst();
+        const Binary &binary = m_binaries.at(shard.binary);
+        Environment environment = m_environment;
+        environment.set("CARGO_MANIFEST_DIR", binary.packageDirectory.toString());
+
+        auto process = new QProcess(this);
+        process->setProcessEnvironment(environment.toProcessEnvironment());
+        // Like cargo test, which runs tests in their package directory
+        process->setWorkingDirectory(binary.packageDirectory.toString());
+        connect(process, &QProcess::readyReadStandardOutput, this, [this, process] { readShard(process); });
+        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+                this, [this, process](int exitCode, QProcess::ExitStatus status) {
+            // libtest exits with 101 when tests failed
+            if (status != QProcess::NormalExit)
+                finishShard(process, tr("The test process crashed."));
+            else if (exitCode != 0 && exitCode != 101)
+                finishShard(process, tr("The test process exited with code %1.").arg(exitCode));
+            else
+                finishShard(process, QString());
+        });
+        connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error) {
+            if (error == QProcess::FailedToStart)
+                finishShard(process, tr("Could not start the test process: %1").arg(process->errorString()));
+        });
+        m_shards.insert(process, shard);
+        process->start(binary.path.toString(),
+                       QStringList{"-Z", "unstable-options", "--format", "json", "--report-time",
+                                   "--test-threads=1", "--exact"} + shard.tests);
+    }
+    if (m_shards.isEmpty())
+        finish();
+}
+
+bool NimTestRunner::parseEvent(const QByteArray &line, NimTestEvent *event)
+{
+    if (!line.startsWith('{'))
+        return false;
+    const QJsonObject object = QJsonDocument::fromJson(line).object();
+    event->type = object["type"].toString();
+    event->event = object["event"].toString();
+    event->name = object["name"].toString();
+    // A number, or a string like "0.012s" in older toolchains
+    const QJsonValue time = object["exec_time"];
+    event->seconds = -1;
+    if (time.isDouble()) {
+        event->seconds = time.toDouble();
+    } else if (time.isString()) {
+        QString value = time.toString();
+        if (value.endsWith('s'))
+            value.chop(1);
+        bool ok = false;
+        const double seconds = value.toDouble(&ok);
+        if (ok)
+            event->seconds = seconds;
+    }
+    event->output = object["stdout"].toString();
+    const QString message = object["message"].toString();
+    if (!message.isEmpty())
+        event->output += (event->output.isEmpty() || event->output.endsWith('\n') ? "" : "\n") + message;
+    return !event->type.isEmpty() && !event->event.isEmpty();
+}
+
+void NimTestRunner::readShard(QProcess *process)
+{
+    auto it = m_shards.find(process);
+    if (it == m_shards.end())
+        return;
+    it->buffer += process->readAllStandardOutput();
+    int newline;
+    while ((newline = it->buffer.indexOf('\n')) >= 0) {
+        const QByteArray line = it->buffer.left(newline);
+        it->buffer.remove(0, newline + 1);
+        NimTestEvent event;
+        if (parseEvent(line, &event))
+            handleEvent(*it, event);
+    }
+}
+
+void NimTestRunner::handleEvent(const Shard &shard, const NimTestEvent &event)
+{
+    if (event.type != "test")
+        return;
+    auto it = m_results.find(m_binaries.at(shard.binary).name + '\t' + event.name);
+    if (it == m_results.end())
+        return;
+    if (event.event == "started") {
+        it->outcome = NimTestResult::Running;
+    } else if (event.event == "ok") {
+        it->outcome = NimTestResult::Passed;
+    } else if (event.event == "failed") {
+        it->outcome = NimTestResult::Failed;
+        it->output = event.output;
+    } else if (event.event == "ignored") {
+        it->outcome = NimTestResult::Ignored;
+    } else {
+        return;
+    }
+    it->seconds = event.seconds;
+    emit resultChanged(*it);
+}
+
+void NimTestRunner::finishShard(QProcess *process, const QString &error)
+{
+    if (!m_shards.contains(process))
+        return;
+    readShard(process);
+    const Shard shard = m_shards.take(process);
+    const QString standardError = QString::fromLocal8Bit(process->readAllStandardError()).trimmed();
+    process->disconnect(this);
+    process->deleteLater();
+
+    // Tests that crashed the process, and those it did not get to
+    for (const QString &test : shard.tests) {
+        auto it = m_results.find(m_binaries.at(shard.binary).name + '\t' + test);
+        if (it == m_results.end() || (it->outcome != NimTestResult::NotRun && it->outcome != NimTestResult::Running))
+            continue;
+        if (m_canceled) {
+            it->outcome = NimTestResult::NotRun;
+        } else {
+            const QString reason = error.isEmpty() ? tr("The test process did not report the test.") : error;
+            it->output = it->outcome == NimTestResult::Running
+                    ? reason : tr("Not run, the test process ended before. %1").arg(reason);
+            if (!standardError.isEmpty())
+                it->output += '\n' + standardError;
+            it->outcome = NimTestResult::Failed;
+        }
+        emit resultChanged(*it);
+    }
+    startShards();
+}
+
+void NimTestRunner::finish()
+{
+    if (!m_running)
+        return;
+    int passed = 0;
+    int failed = 0;
+    int ignored = 0;
+    for (const NimTestResult &result : qAsConst(m_results)) {
+        switch (result.outcome) {
+        case NimTestResult::Passed:
+            ++passed;
+            m_failed.remove(result.key());
+            break;
+        case NimTestResult::Failed:
+            ++failed;
+            m_failed.insert(result.key());
+            break;
+        case NimTestResult::Ignored:
+            ++ignored;
+            break;
+        default:
+            break;
+        }
+        const bool ran = result.outcome == NimTestResult::Passed || result.outcome == NimTestResult::Failed;
+        if (ran && result.seconds >= 0)
+            m_durations[result.key()].append(result.seconds);
+    }
+    // A complete run replaces the failed tests of the previous one
+    if (!m_failedOnly && !m_canceled) {
+        m_failed.clear();
+        for (const NimTestResult &result : qAsConst(m_results)) {
+            if (result.outcome == NimTestResult::Failed)
+                m_failed.insert(result.key());
+        }
+    }
+    if (m_buildConfiguration)
+        NimTestDurations::write(NimTestDurations::file(m_buildConfiguration), m_durations);
+
+    m_running = false;
+    emit message(m_canceled ? tr("Tests stopped: %1 passed, %2 failed, %3 ignored.")
+                                  .arg(passed).arg(failed).arg(ignored)
+                            : tr("Tests finished: %1 passed, %2 failed, %3 ignored.")
+                                  .arg(passed).arg(failed).arg(ignored));
+    emit finished(passed, failed, ignored);
+}
+
+} // namespace Nim
+
+#ifdef WITH_TESTS
+
+#include "../nimplugin.h"
+
+#include <QTest>
+
+namespace Nim {
+
+void RustPlugin::testTestRunner()
+{
+    NimTestEvent event;
+    QVERIFY(NimTestRunner::parseEvent(R"({ "type": "test", "event": "started", "name": "parse::empty" })",
+                                      &event));
+    QCOMPARE(event.event, QString("started"));
+    QCOMPARE(event.name, QString("parse::empty"));
+    QCOMPARE(event.seconds, -1.0);
+    QVERIFY(NimTestRunner::parseEvent(R"({ "type": "test", "name": "parse::nested", "event": "failed", )"
+                                      R"("exec_time": 0.25, "stdout": "thread panicked\n" })", &event));
+    QCOMPARE(event.event, QString("failed"));
+    QCOMPARE(event.seconds, 0.25);
+    QCOMPARE(event.output, QString("thread panicked\n"));
+    QVERIFY(NimTestRunner::parseEvent(R"({ "type": "test", "name": "a", "event": "ok", "exec_time": "0.012s" })",
+                                      &event));
+    QCOMPARE(event.seconds, 0.012);
+    QVERIFY(!NimTestRunner::parseEvent("running 2 tests", &event));
+
+    const QHash<QString, double> seconds = {{"slow", 4}, {"medium", 2}, {"fast1", 1}, {"fast2", 1}};
+    const QVector<QStringList> shards = NimTestRunner::shard({"fast1", "slow", "fast2", "medium"}, seconds, 2);
+    QCOMPARE(shards.size(), 2);
+    QCOMPARE(shards.at(0), QStringList({"slow"}));
+    QCOMPARE(shards.at(1), QStringList({"medium", "fast1", "fast2"}));
+    // Unknown durations are dealt evenly
+    QCOMPARE(NimTestRunner::shard({"a", "b", "c"}, {}, 8).size(), 3);
+    QCOMPARE(NimTestRunner::shard({"a", "b", "c", "d"}, {}, 2).at(1), QStringList({"b", "d"}));
+}
+
+} // namespace Nim
+
+#endif // WITH_TESTS
@@ -0,0 +1,153 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#pragma once
+
+#include "nimcommandsequence.h"
+
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QVector>
+
+namespace Nim {
+
+class NimBuildConfiguration;
+
+// One line of libtest's JSON report
+class NimTestEvent
+{
+public:
+    QString type;   // "suite" or "test"
+    QString event;  // "started", "ok", "failed", "ignored", "timeout"
+    QString name;
+    double seconds = -1;
+    QString output;
+};
+
+class NimTestResult
+{
+public:
+    enum Outcome { NotRun, Running, Passed, Failed, Ignored };
+
+    QString binary;  // <package>/<target> (<kind>)
+    QString name;
+    Outcome outcome = NotRun;
+    double seconds = -1;
+    QString output;
+
+    QString key() const { return binary + '\t' + name; }
+};
+
+// The durations of the latest runs of every test, in
+// <data directory>/tests/durations, one test per line:
+//   <binary> <test> <seconds>,<seconds>,...
+class NimTestDurations
+{
+public:
+    static Utils::FilePath file(const NimBuildConfiguration *buildConfiguration);
+    // By NimTestResult::key(), oldest run first
+    static QHash<QString, QVector<double>> read(const Utils::FilePath &path);
+    static bool write(const Utils::FilePath &path, const QHash<QString, QVector<double>> &durations);
+    static double mean(const QVector<double> &seconds);
+};
+
+// Builds the tests of a project with cargo test --no-run, lists the tests
+// of every test binary and runs them in shards, one process per shard and
+// as many shards at a time as there are cores. Every shard runs some tests
+// of a binary with libtest's JSON report, which is streamed into results.
+// The tests are dealt to the shards by their recorded durations, the
+// longest first, and the shards start with the longest.
+class NimTestRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NimTestRunner(QObject *parent = nullptr);
+    ~NimTestRunner() override;
+
+    bool isRunning() const;
+    bool hasFailedTests() const;
+    // Runs only the tests that failed in the previous run if failedOnly
+    void run(NimBuildConfiguration *buildConfiguration, bool failedOnly);
+    void stop();
+
+    static bool parseEvent(const QByteArray &line, NimTestEvent *event);
+    // The longest test first into the shard with the least time so far
+    static QVector<QStringList> shard(const QStringList &tests, const QHash<QString, double> &seconds,
+                                      int shardCount);
+
+signals:
+    void started(const QVector<Nim::NimTestResult> &tests);
+    void resultChanged(const Nim::NimTestResult &result);
+    void finished(int passed, int failed, int ignored);
+    void message(const QString &message);
+
+private:
+    class Binary
+    {
+    public:
+        QString name;
+        Utils::FilePath path;
+        Utils::FilePath packageDirectory;
+        QStringList tests;
+    };
+
+    class Shard
+    {
+    public:
+        int binary = 0;
+        QStringList tests;
+        double seconds = 0;  // expected
+        QByteArray buffer;
+    };
+
+    void listTests(const QByteArray &cargoMessages);
+    void schedule();
+    void startShards();
+    void readShard(QProcess *process);
+    void handleEvent(const Shard &shard, const NimTestEvent &event);
+    void finishShard(QProcess *process, const QString &error);
+    void finish();
+
+    NimCommandSequence m_sequence;
+    QPointer<NimBuildConfiguration> m_buildConfiguration;
+    Utils::Environment m_environment;
+    QVector<Binary> m_binaries;
+    QVector<Shard> m_queue;
+    QHash<QProcess *, Shard> m_shards;
+    QHash<QString, NimTestResult> m_results;
+    QHash<QString, QVector<double>> m_durations;
+    QSet<QString> m_failed;
+    bool m_failedOnly = false;
+    bool m_running = false;
+    bool m_canceled = false;
+};
+
+} // namespace Nim
+
+Q_DECLARE_METATYPE(Nim::NimTestResult)
@@ -0,0 +1,48 @@
+/****************************************************************************
+**
+** Copyright (C) Filippo Cucchetto <filippocucchetto@gmail.com>
+** Contact: http://www.qt.io/licensing
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+
+#include "nimutils.h"
+
+using namespace Utils;
+
+namespace Nim {
+
+QString NimUtils::toMiB(qint64 bytes)
+{
+    return QString::number(bytes / (1024 * 1024));
+}
+
+FilePath NimUtils::crateRoot(const FilePath &projectDirectory)
+{
+    for (const QString &candidate : {"src/lib.rs", "src/main.rs"}) {
+        const FilePath path = projectDirectory.pathAppended(candidate);
+        if (path.exists())
+            return path;
+    }
+    return FilePath();
+}
+
+} // namespace Nim
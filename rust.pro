@@ -4,6 +4,8 @@ IDE_BUILD_TREE = $$QTC_BUILD
 DEFINES += \
     NIM_LIBRARY
 
+QT += concurrent
+
 RESOURCES += \
     nim.qrc
 
@@ -13,30 +15,114 @@ HEADERS += \
     nimplugin.h \
     nimconstants.h \
     project/nimbuildsystem.h \
+    project/nimcargomessages.h \
+    project/nimcgroupscope.h \
     project/nimproject.h \
     project/nimprojectnode.h \
+    project/nimramtargetdirectory.h \
+    project/nimbisection.h \
+    project/nimbranchsnapshots.h \
     project/nimbuildconfiguration.h \
     project/nimbuildconfigurationwidget.h \
+    project/nimbuildmemorymonitor.h \
     project/nimcompilerbuildstep.h \
+    project/nimcommandsequence.h \
+    project/nimdatadirectory.h \
+    project/nimdependencycost.h \
+    project/nimfilecloner.h \
+    project/nimfingerprintparser.h \
+    project/nimgit.h \
+    project/nimlinktimes.h \
+    project/nimpgopipeline.h \
+    project/nimprofilevariants.h \
     project/nimcompilerbuildstepconfigwidget.h \
     project/nimrunconfiguration.h \
+    project/nimrustcwrapper.h \
+    project/nimtargetdirectory.h \
+    project/nimtestpane.h \
+    project/nimtestrunner.h \
     settings/nimsettings.h \
     project/nimtoolchain.h \
     project/nimtoolchainfactory.h \
+    project/nimutils.h \
+    profiler/nimdwarf.h \
+    profiler/nimelffile.h \
+    profiler/nimflamegraph.h \
+    profiler/nimflamegraphwidget.h \
+    profiler/nimheapprofile.h \
+    profiler/nimhotlinemarks.h \
+    profiler/nimbenchmarks.h \
+    profiler/nimbenchmarkwidget.h \
+    profiler/nimbinarysize.h \
+    profiler/nimcodegen.h \
+    profiler/nimcodegenwidget.h \
+    profiler/nimcounters.h \
+    profiler/nimoptimizationremarks.h \
+    profiler/nimremarkmarks.h \
+    profiler/nimremarkswidget.h \
+    profiler/nimhotlines.h \
+    profiler/nimoffcpu.h \
+    profiler/nimperfrecorder.h \
+    profiler/nimprofilerpane.h \
+    profiler/nimrepeatedruns.h \
+    profiler/nimrustdemangler.h \
+    profiler/nimstackfolder.h \
 
 SOURCES += \
     nimplugin.cpp \
     project/nimbuildsystem.cpp \
+    project/nimcargomessages.cpp \
+    project/nimcgroupscope.cpp \
     project/nimproject.cpp \
     project/nimprojectnode.cpp \
+    project/nimramtargetdirectory.cpp \
+    project/nimbisection.cpp \
+    project/nimbranchsnapshots.cpp \
     project/nimbuildconfiguration.cpp \
     project/nimbuildconfigurationwidget.cpp \
+    project/nimbuildmemorymonitor.cpp \
     project/nimcompilerbuildstep.cpp \
+    project/nimcommandsequence.cpp \
+    project/nimdatadirectory.cpp \
+    project/nimdependencycost.cpp \
+    project/nimfilecloner.cpp \
+    project/nimfingerprintparser.cpp \
+    project/nimgit.cpp \
+    project/nimlinktimes.cpp \
+    project/nimpgopipeline.cpp \
+    project/nimprofilevariants.cpp \
     project/nimcompilerbuildstepconfigwidget.cpp \
     project/nimrunconfiguration.cpp \
+    project/nimrustcwrapper.cpp \
+    project/nimtargetdirectory.cpp \
+    project/nimtestpane.cpp \
+    project/nimtestrunner.cpp \
     settings/nimsettings.cpp \
     project/nimtoolchain.cpp \
     project/nimtoolchainfactory.cpp \
+    project/nimutils.cpp \
+    profiler/nimdwarf.cpp \
+    profiler/nimelffile.cpp \
+    profiler/nimflamegraph.cpp \
+    profiler/nimflamegraphwidget.cpp \
+    profiler/nimheapprofile.cpp \
+    profiler/nimhotlinemarks.cpp \
+    profiler/nimbenchmarks.cpp \
+    profiler/nimbenchmarkwidget.cpp \
+    profiler/nimbinarysize.cpp \
+    profiler/nimcodegen.cpp \
+    profiler/nimcodegenwidget.cpp \
+    profiler/nimcounters.cpp \
+    profiler/nimoptimizationremarks.cpp \
+    profiler/nimremarkmarks.cpp \
+    profiler/nimremarkswidget.cpp \
+    profiler/nimhotlines.cpp \
+    profiler/nimoffcpu.cpp \
+    profiler/nimperfrecorder.cpp \
+    profiler/nimprofilerpane.cpp \
+    profiler/nimrepeatedruns.cpp \
+    profiler/nimrustdemangler.cpp \
+    profiler/nimstackfolder.cpp \
 
 FORMS += \
     project/nimbuildconfigurationwidget.ui \
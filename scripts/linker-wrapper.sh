@@ -0,0 +1,36 @@
+#!/bin/sh
+#
+# Linker driver wrapper installed by the Rust plugin of Qt Creator and set as
+# the linker of the build target with CARGO_TARGET_<TRIPLE>_LINKER. Runs the
+# real linker driver and records how long every link took.
+#
+# Environment:
+#   RUST_CREATOR_LINKER    linker driver to run, the one configured for the
+#                          target before, "cc" when unset
+#   RUST_CREATOR_LINK_LOG  file receiving one tab separated line per link:
+#                          output file, wall-clock seconds, exit status
+
+linker=${RUST_CREATOR_LINKER:-cc}
+
+# rustc passes the arguments in a response file if they are too long
+output=
+previous=
+for arg in "$@"; do
+    [ "$previous" = "-o" ] && output=$arg
+    case $arg in
+    @*) [ -z "$output" ] && [ -f "${arg#@}" ] &&
+        output=$(awk 'previous == "-o" { gsub(/"/, ""); print; exit } { previous = $0 }' "${arg#@}") ;;
+    esac
+    previous=$arg
+done
+
+start=$(date +%s.%N)
+"$linker" "$@"
+status=$?
+end=$(date +%s.%N)
+
+if [ -n "$RUST_CREATOR_LINK_LOG" ]; then
+    seconds=$(awk -v a="$start" -v b="$end" 'BEGIN { printf "%.3f", b - a }')
+    printf '%s\t%s\t%s\n' "$output" "$seconds" "$status" >> "$RUST_CREATOR_LINK_LOG"
+fi
+exit $status
@@ -0,0 +1,274 @@
+#!/bin/sh
+#
+# RUSTC_WRAPPER installed by the Rust plugin of Qt Creator.
+#
+# Shares compiled third-party crates between target directories. A unit is
+# looked up by a key made of the rustc version, the arguments (with the target
+# directory replaced by a placeholder), the CARGO_* environment cargo passes
+# to rustc, the build script output and the package's sources: the checksum
+# of the downloaded .crate file for registry crates, the contents of the files
+# otherwise. Only crates from the cargo registry or from git checkouts are
+# cached, workspace members are always compiled. When the cache grows past
+# its limit, the least recently used entries are removed.
+#
+# Optionally records the CPU time of every compiled unit, and compiles
+# selected crates with LLVM's optimization remarks.
+#
+# Environment:
+#   RUST_CREATOR_ARTIFACT_CACHE  cache directory, caching is off when unset
+#   RUST_CREATOR_CACHE_LOG       file receiving one "hit|miss <crate>" line per unit
+#   RUST_CREATOR_CACHE_MAX_MIB   size limit of the cache, unlimited when unset
+#   RUST_CREATOR_TIMINGS_LOG     file receiving one tab separated line per unit:
+#                                package, version, crate, crate types, features,
+#                                CPU seconds, "compiled" or "cached"
+#   RUST_CREATOR_REMARK_CRATES   space separated crate names to compile with -C remark=all
+#   RUST_CREATOR_REMARKS_DIR     directory receiving the remarks of each of these crates
+#                                as <crate>.remarks, one of rustc's notes per line
+
+rustc=$1
+shift
+
+log() {
+    [ -n "$RUST_CREATOR_CACHE_LOG" ] && echo "$1 $crate_name" >> "$RUST_CREATOR_CACHE_LOG"
+}
+
+# Sets cpu_time to the user plus system time of all waited-for children so
+# far. "times" has to run in this shell, a command substitution would not
+# see them.
+read_cpu_time() {
+    cpu_time=0
+    times_file=$(mktemp) || return
+    times > "$times_file"
+    cpu_time=$(awk 'NR == 2 {
+        total = 0
+        for (i = 1; i <= 2; i++) {
+            split($i, parts, "m")
+            sub("s", "", parts[2])
+            total += parts[1] * 60 + parts[2]
+        }
+        printf "%.3f", total
+    }' "$times_file")
+    rm -f "$times_file"
+}
+
+# Logs the CPU time spent since $1 was read by read_cpu_time
+log_timing() {
+    [ -n "$RUST_CREATOR_TIMINGS_LOG" ] && [ -n "$crate_name" ] || return 0
+    read_cpu_time
+    cpu=$(awk -v a="$1" -v b="$cpu_time" 'BEGIN { printf "%.3f", b - a }')
+    printf '%s\t%s\t%s\t%s\t%s\t%s\t%s\n' "$CARGO_PKG_NAME" "$CARGO_PKG_VERSION" "$crate_name" \
+        "${crate_types# }" "${features# }" "$cpu" "$2" >> "$RUST_CREATOR_TIMINGS_LOG"
+}
+
+# Runs rustc without caching, does not return
+compile() {
+    if [ -z "$RUST_CREATOR_TIMINGS_LOG" ] || [ -z "$crate_name" ]; then
+        exec "$rustc" "$@"
+    fi
+    read_cpu_time
+    before=$cpu_time
+    "$rustc" "$@"
+    status=$?
+    [ "$status" = 0 ] && log_timing "$before" compiled
+    exit "$status"
+}
+
+# Runs rustc with optimization remarks, does not return. The remarks would
+# flood the build output, they go to the crate's file instead. Their
+# locations need at least the line tables.
+compile_with_remarks() {
+    remarks_file=$RUST_CREATOR_REMARKS_DIR/$crate_name.remarks
+    mkdir -p "$RUST_CREATOR_REMARKS_DIR" || compile "$@"
+    : > "$remarks_file.$$"
+    [ -z "$has_debuginfo" ] && set -- "$@" -C debuginfo=1
+    status_file=$(mktemp)
+    read_cpu_time
+    before=$cpu_time
+    { "$rustc" "$@" -C remark=all 2>&1 1>&3 3>&-; echo $? > "$status_file"; } 3>&1 \
+        | awk -v remarks="$remarks_file.$$" '
+            (/^note: / || /"level":"note"/) && / \((success|missed|analysis|failure)\): / {
+                print > remarks
+                next
+            }
+            { print > "/dev/stderr"; fflush("/dev/stderr") }'
+    status=$(cat "$status_file")
+    rm -f "$status_file"
+    if [ "$status" = 0 ]; then
+        log_timing "$before" compiled
+        mv -f "$remarks_file.$$" "$remarks_file"
+    else
+        rm -f "$remarks_file.$$"
+    fi
+    exit "$status"
+}
+
+# Replaces every occurrence of $1 by $2 on stdin
+replace() {
+    awk -v from="$1" -v to="$2" '{
+        out = ""
+        while ((i = index($0, from)) > 0) {
+            out = out substr($0, 1, i - 1) to
+            $0 = substr($0, i + length(from))
+        }
+        print out $0
+    }'
+}
+
+# Prints what identifies the sources of the package being compiled. A
+# registry package cannot change once published, the .crate file cargo
+# unpacked it from has the checksum Cargo.lock records.
+source_fingerprint() {
+    [ -n "$CARGO_MANIFEST_DIR" ] || return 0
+    case $CARGO_MANIFEST_DIR in
+        "$cargo_home"/registry/src/*)
+            crate_file=$cargo_home/registry/cache/${CARGO_MANIFEST_DIR#"$cargo_home"/registry/src/}.crate
+            if [ -f "$crate_file" ]; then
+                sha256sum < "$crate_file"
+                return
+            fi ;;
+    esac
+    (cd "$CARGO_MANIFEST_DIR" && find . -type f ! -name .cargo-ok -exec sha256sum {} + | sort)
+}
+
+# Removes the least recently used entries until the cache is below 90% of
+# its limit. Hits touch the complete marker of their entry. Checking the size
+# walks the cache, it happens at most every ten minutes and in one wrapper at
+# a time.
+evict() {
+    [ -n "$RUST_CREATOR_CACHE_MAX_MIB" ] || return 0
+    stamp=$cache/evicted
+    [ -n "$(find "$stamp" -mmin -10 2>/dev/null)" ] && return 0
+    touch "$stamp"
+    (
+        flock -n 9 || exit 0
+        limit=$((RUST_CREATOR_CACHE_MAX_MIB * 1024))
+        size=$(du -sk "$cache" | cut -f1)
+        [ "$size" -gt "$limit" ] || exit 0
+        target=$((limit / 10 * 9))
+        find "$cache" -mindepth 3 -maxdepth 3 -name complete -printf '%T@ %h\n' | sort -n |
+            while read -r time dir; do
+                [ "$size" -le "$target" ] && break
+                entry_size=$(du -sk "$dir" | cut -f1)
+                rm -rf "$dir" && size=$((size - entry_size))
+            done
+    ) 9> "$cache/evict.lock"
+}
+
+crate_name=
+crate_types=
+features=
+out_dir=
+extra_filename=
+has_debuginfo=
+src=
+prev=
+for arg in "$@"; do
+    case $prev in
+        --crate-name) crate_name=$arg ;;
+        --crate-type) crate_types="$crate_types $arg" ;;
+        --cfg) case $arg in feature=*) feature=${arg#feature=\"}; features="$features ${feature%\"}" ;; esac ;;
+        --out-dir) out_dir=$arg ;;
+        -C) case $arg in
+                extra-filename=*) extra_filename=${arg#extra-filename=} ;;
+                debuginfo=*) has_debuginfo=1 ;;
+            esac ;;
+    esac
+    case $arg in
+        *.rs) [ -z "$src" ] && src=$arg ;;
+    esac
+    prev=$arg
+done
+
+if [ -n "$crate_name" ] && [ -n "$RUST_CREATOR_REMARKS_DIR" ]; then
+    case " $RUST_CREATOR_REMARK_CRATES " in
+        *" $crate_name "*) compile_with_remarks "$@" ;;
+    esac
+fi
+
+cargo_home=${CARGO_HOME:-$HOME/.cargo}
+cacheable=
+case $src in
+    "$cargo_home"/registry/src/*|"$cargo_home"/git/checkouts/*) cacheable=1 ;;
+esac
+case " $crate_types " in
+    *" bin "*|*" dylib "*|*" cdylib "*|*" staticlib "*) cacheable= ;;
+esac
+if [ -z "$RUST_CREATOR_ARTIFACT_CACHE" ] || [ -z "$cacheable" ] \
+        || [ -z "$crate_name" ] || [ -z "$out_dir" ] || [ -z "$extra_filename" ]; then
+    compile "$@"
+fi
+
+cache=$RUST_CREATOR_ARTIFACT_CACHE
+target_root=$(dirname "$(dirname "$out_dir")")
+mkdir -p "$cache" || compile "$@"
+
+# rustc -vV is slow enough to be worth remembering per rustc binary
+rustc_id=$(printf '%s %s' "$(command -v "$rustc")" "$(stat -c %Y "$(command -v "$rustc")" 2>/dev/null)" \
+           | sha256sum | cut -c1-64)
+rustc_version_file=$cache/rustc-$rustc_id
+if [ ! -s "$rustc_version_file" ]; then
+    "$rustc" -vV > "$rustc_version_file.$$" 2>/dev/null && mv "$rustc_version_file.$$" "$rustc_version_file"
+    rm -f "$rustc_version_file.$$"
+fi
+
+key=$({
+    cat "$rustc_version_file"
+    printf '%s\n' "$@" | replace "$target_root" "@TARGET@"
+    env | grep -E '^CARGO_(PKG_|CRATE_|CFG_|FEATURE_|MANIFEST_|PRIMARY_)' | sort
+    if [ -n "$OUT_DIR" ] && [ -d "$OUT_DIR" ]; then
+        (cd "$OUT_DIR" && find . -type f -exec sha256sum {} + | sort)
+    fi
+    source_fingerprint
+} | sha256sum | cut -c1-64)
+
+entry=$cache/$(echo "$key" | cut -c1-2)/$key
+
+if [ -f "$entry/complete" ]; then
+    old_root=$(cat "$entry/target-root")
+    for file in "$entry"/files/*; do
+        name=$(basename "$file")
+        case $name in
+            *.d) replace "$old_root" "$target_root" < "$file" > "$out_dir/$name" ;;
+            *) cp --reflink=auto -p "$file" "$out_dir/$name" ;;
+        esac || compile "$@"
+    done
+    replace "$old_root" "$target_root" < "$entry/stderr" >&2
+    touch "$entry/complete"
+    log hit
+    read_cpu_time
+    log_timing "$cpu_time" cached
+    exit 0
+fi
+
+# Stream diagnostics to cargo while keeping a copy, cargo relies on the
+# artifact notifications for pipelining
+stderr_copy=$(mktemp)
+status_file=$(mktemp)
+read_cpu_time
+before=$cpu_time
+{ "$rustc" "$@" 2>&1 1>&3 3>&-; echo $? > "$status_file"; } 3>&1 | tee "$stderr_copy" >&2
+status=$(cat "$status_file")
+rm -f "$status_file"
+[ "$status" = 0 ] && log_timing "$before" compiled
+
+if [ "$status" = 0 ]; then
+    staging=$cache/staging.$$
+    mkdir -p "$staging/files"
+    stored=
+    for file in "$out_dir"/*"$extra_filename".* "$out_dir"/*"$extra_filename"; do
+        [ -f "$file" ] || continue
+        cp --reflink=auto -p "$file" "$staging/files/" && stored=1
+    done
+    cp "$stderr_copy" "$staging/stderr"
+    printf '%s' "$target_root" > "$staging/target-root"
+    touch "$staging/complete"
+    mkdir -p "$(dirname "$entry")"
+    if [ -z "$stored" ] || ! mv -T "$staging" "$entry" 2>/dev/null; then
+        rm -rf "$staging"
+    fi
+    log miss
+    evict
+fi
+
+rm -f "$stderr_copy"
+exit "$status"